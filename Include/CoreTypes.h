@@ -12,21 +12,31 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #if !defined(__cplusplus) || defined(CINTERFACE)
     #define C_STYLE
 #endif
 
-#ifdef SG_EXPORTS
-#define SG_API __declspec(novtable)
-#define SG_API_FUNC __declspec(dllexport)
+#if defined(_WIN32)
+    #ifdef SG_EXPORTS
+    #define SG_API __declspec(novtable)
+    #define SG_API_FUNC __declspec(dllexport)
+    #else
+    #define SG_API __declspec(novtable)
+    #define SG_API_FUNC __declspec(dllimport)
+    #endif
+
+    #define SG_CALL __stdcall
 #else
-#define SG_API __declspec(novtable)
-#define SG_API_FUNC __declspec(dllimport)
+    // Non-Windows builds compile only the interfaces (e.g. for headless back-ends)
+    #define SG_API
+    #define SG_API_FUNC
+    #define SG_CALL
 #endif
 
 #define SG_INTERFACE struct
 #define SG_DECLARE_CLASS(ClassName) typedef struct ClassName ClassName
-#define SG_CALL __stdcall
 
 #if defined(__cplusplus) && !defined(CINTERFACE)
 extern "C" {
@@ -41,10 +51,17 @@ typedef signed int          SgI32;
 typedef signed short        SgI16;
 typedef signed char         SgI8;
 
+#if defined(_MSC_VER)
 #define SG_U64_MAX 0xFFFFFFFFFFFFFFFFui64
 #define SG_U32_MAX 0xFFFFFFFFui32
 #define SG_U16_MAX 0xFFFFui16
 #define SG_U8_MAX 0xFFui8
+#else
+#define SG_U64_MAX 0xFFFFFFFFFFFFFFFFull
+#define SG_U32_MAX 0xFFFFFFFFu
+#define SG_U16_MAX ((SgU16)0xFFFFu)
+#define SG_U8_MAX ((SgU8)0xFFu)
+#endif
 
 #define SG_NULL 0x0ull
 
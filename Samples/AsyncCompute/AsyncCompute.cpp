@@ -40,9 +40,6 @@ AsyncComputeSample::AsyncComputeSample(U32 width, U32 height, wchar_t const* win
 
     , m_pSampler(SG_NULL)
 
-    , m_pCbsGfx{}
-    , m_pCbsCmp{}
-
     , m_pTexture(SG_NULL)
     , m_pTextureSRVs{}
     , m_pTextureUAVs{}
@@ -251,19 +248,8 @@ void AsyncComputeSample::LoadAssets()
             throw std::exception("Failed to create sampler");
     }
 
-    // Create sets of constant buffers for all frames to prevent data race
-    for (U32 i = 0; i < NumFrames; i++)
-    {
-        SG_BUFFER_DESC cbDesc;
-
-        cbDesc = FastBufferDesc::Constant((U32)sizeof(CommonParameters));
-        if (m_pDevice->CreateBuffer(&cbDesc, &m_pCbsGfx[i]) != SG_OK)
-            throw std::exception("Failed to create constant buffer");
-
-        cbDesc = FastBufferDesc::Constant((U32)sizeof(JulieSetParameters));
-        if (m_pDevice->CreateBuffer(&cbDesc, &m_pCbsCmp[i]) != SG_OK)
-            throw std::exception("Failed to create constant buffer");
-    }
+    // Constant buffers are taken from the per-frame ring to prevent data race, one slot per frame buffer
+    m_UploadRing.Init(m_pDevice, NumFrames);
 
     // Create vertex and index buffers
     {
@@ -307,11 +293,7 @@ void AsyncComputeSample::OnDestroy()
 
     SG_RELEASE(m_pTexture);
 
-    for (int i = 0; i < NumFrames; i++)
-    {
-        SG_RELEASE(m_pCbsGfx[i]);
-        SG_RELEASE(m_pCbsCmp[i]);
-    }
+    m_UploadRing.Destroy();
 
     SG_RELEASE(m_pSampler);
 
@@ -332,8 +314,6 @@ void AsyncComputeSample::OnDestroy()
 void AsyncComputeSample::OnUpdate()
 {
     // Set-up current frame context
-    m_FrameContext.pGfxCB = m_pCbsGfx[m_FrameIndex % NumFrames];
-    m_FrameContext.pCmpCB = m_pCbsCmp[m_FrameIndex % NumFrames];
     m_FrameContext.pSRV = m_pTextureSRVs[m_FrameIndex % NumSlices];
     m_FrameContext.pUAV = m_pTextureUAVs[(m_FrameIndex + 1) % NumSlices];
 
@@ -358,6 +338,7 @@ void AsyncComputeSample::OnUpdate()
 void AsyncComputeSample::OnRender()
 {
     m_pExecutionContext->BeginFrame();
+    m_UploadRing.BeginFrame();
 
     // Update buffers after frame has begun to prevent data race
     {
@@ -367,7 +348,7 @@ void AsyncComputeSample::OnRender()
             params.WorldTransform = XMMatrixRotationZ(m_CurrentAngle * 2);
             params.ViewProjection = m_Camera.GetViewProjection();
 
-            UploadBuffer(m_FrameContext.pGfxCB, &params, sizeof(params));
+            m_FrameContext.pGfxCB = m_UploadRing.AllocateConstants(&params, sizeof(params));
         }
 
         // Constant buffer for compute pass
@@ -377,7 +358,7 @@ void AsyncComputeSample::OnRender()
             params.InvTextureSizeY = 1.0f / m_Height;
             params.Angle = m_CurrentAngle;
 
-            UploadBuffer(m_FrameContext.pCmpCB, &params, sizeof(params));
+            m_FrameContext.pCmpCB = m_UploadRing.AllocateConstants(&params, sizeof(params));
         }
     }
 
@@ -13,6 +13,7 @@
 #pragma once
 
 #include "SGX/SGSample.h"
+#include "SGX/SGFrameUploadRing.h"
 #include <DirectXMath.h>
 
 class AsyncComputeSample : public ISGSample
@@ -72,8 +73,7 @@ private:
     ISGDepthStencilView* m_pDSView;
     ISGSampler* m_pSampler;
 
-    ISGBuffer* m_pCbsGfx[NumFrames];
-    ISGBuffer* m_pCbsCmp[NumFrames];
+    FrameUploadRing m_UploadRing;
 
     ISGTexture* m_pTexture;
     ISGShaderResourceView* m_pTextureSRVs[NumSlices];
@@ -87,8 +87,6 @@ private:
     FrameContext m_FrameContext;
 
     static_assert(NumSlices >= 2, "Number of texture slices must be greater or equal 2");
-    static_assert(_countof(m_pCbsGfx) == NumFrames, "Number of constant buffers for the graphics pass must be equal NumFrames");
-    static_assert(_countof(m_pCbsCmp) == NumFrames, "Number of constant buffers for the compute pass must be equal NumFrames");
     static_assert(_countof(m_pTextureSRVs) == NumSlices, "Number of texture SRVs must be equal NumSlices");
     static_assert(_countof(m_pTextureUAVs) == NumSlices, "Number of texture UAVs must be equal NumSlices");
 
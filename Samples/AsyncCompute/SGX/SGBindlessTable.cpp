@@ -0,0 +1,159 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGBindlessTable.h"
+
+#include <exception>
+
+namespace
+{
+    void SetViews(ISGCommandList* pCommandList, SgU32 paramIdx, SgU32 count, ISGShaderResourceView** ppViews)
+    {
+        pCommandList->SetShaderResources(paramIdx, 0, count, ppViews);
+    }
+
+    void SetViews(ISGCommandList* pCommandList, SgU32 paramIdx, SgU32 count, ISGUnorderedAccessView** ppViews)
+    {
+        pCommandList->SetUnorderedAccessViews(paramIdx, 0, count, ppViews);
+    }
+
+    void SetViews(ISGCommandList* pCommandList, SgU32 paramIdx, SgU32 count, ISGSampler** ppSamplers)
+    {
+        pCommandList->SetSamplers(paramIdx, 0, count, ppSamplers);
+    }
+}
+
+template <typename TView>
+BindlessTable<TView>::BindlessTable()
+    : m_pFallback(nullptr)
+    , m_Capacity(0)
+{
+}
+
+template <typename TView>
+BindlessTable<TView>::~BindlessTable()
+{
+    Destroy();
+}
+
+template <typename TView>
+void BindlessTable<TView>::Init(SgU32 capacity, TView* pFallback)
+{
+    if (pFallback == nullptr)
+        throw std::exception("Bindless table requires a fallback view");
+
+    Destroy();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_Capacity = capacity;
+    m_pFallback = pFallback;
+    m_pFallback->AddRef();
+
+    m_Views.reserve(capacity);
+}
+
+template <typename TView>
+void BindlessTable<TView>::Destroy()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (auto& it : m_Indices)
+        it.first->Release();
+
+    if (m_pFallback != nullptr)
+        m_pFallback->Release();
+
+    m_Views.clear();
+    m_FreeIndices.clear();
+    m_Indices.clear();
+    m_pFallback = nullptr;
+    m_Capacity = 0;
+}
+
+template <typename TView>
+SgU32 BindlessTable<TView>::Register(TView* pView)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto it = m_Indices.find(pView);
+    if (it != m_Indices.end())
+        return it->second;
+
+    SgU32 index;
+    if (!m_FreeIndices.empty())
+    {
+        index = m_FreeIndices.back();
+        m_FreeIndices.pop_back();
+    }
+    else if (m_Views.size() < m_Capacity)
+    {
+        index = static_cast<SgU32>(m_Views.size());
+        m_Views.push_back(nullptr);
+    }
+    else
+    {
+        return InvalidBindlessIndex;
+    }
+
+    pView->AddRef();
+    m_Views[index] = pView;
+    m_Indices.emplace(pView, index);
+
+    return index;
+}
+
+template <typename TView>
+void BindlessTable<TView>::Unregister(TView* pView)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto it = m_Indices.find(pView);
+    if (it == m_Indices.end())
+        return;
+
+    SgU32 const index = it->second;
+    m_Indices.erase(it);
+
+    m_Views[index] = m_pFallback;
+    m_FreeIndices.push_back(index);
+
+    pView->Release();
+}
+
+template <typename TView>
+SgU32 BindlessTable<TView>::GetBindlessIndex(TView* pView) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto it = m_Indices.find(pView);
+    return it != m_Indices.end() ? it->second : InvalidBindlessIndex;
+}
+
+template <typename TView>
+void BindlessTable<TView>::Bind(ISGCommandList* pCommandList, SgU32 paramIdx) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (!m_Views.empty())
+        SetViews(pCommandList, paramIdx, static_cast<SgU32>(m_Views.size()), const_cast<TView**>(m_Views.data()));
+}
+
+template <typename TView>
+SgU32 BindlessTable<TView>::GetCount() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return static_cast<SgU32>(m_Views.size());
+}
+
+template class BindlessTable<ISGShaderResourceView>;
+template class BindlessTable<ISGUnorderedAccessView>;
+template class BindlessTable<ISGSampler>;
@@ -0,0 +1,85 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "SGFrameUploadRing.h"
+
+///-------------------------------------------------------------------------------------------------
+/// Per-draw constants
+///
+/// Small constants of many draws (offsets, object and material indices) are packed as arrays
+/// into shared constant buffers of the frame, so they need neither a buffer per draw nor a
+/// rebinding for every draw. A draw finds its record by the draw index: the index stream holds
+/// 0, 1, 2... and is read per instance, so the startInstanceLocation argument of the draw selects
+/// the record:
+///
+///     cbuffer DrawConstants : register(b0) { float4 Offsets[MaxDraws]; };
+///     PSInput VSMain(float4 position : POSITION, uint drawIndex : DRAWINDEX)
+///
+/// A constant buffer view can't exceed 64 KB, so a batch continues in a new buffer of the ring when
+/// the current one is full. Every record returns its buffer with the draw index, draws rebind the
+/// buffer when it changes (StateFilterCommandList drops the rebinds of the same one).
+///
+/// Instanced draws take one record per instance. Draws of the vertex pipeline only, mesh and compute
+/// shaders have no input assembler.
+///-------------------------------------------------------------------------------------------------
+
+struct DrawConstantsAllocation
+{
+    ISGBuffer*  pBuffer;        // Owned by the ring
+    U32         DrawIndex;      // Index of the record in the buffer
+};
+
+class DrawConstants
+{
+public:
+    static const U32 DefaultMaxDraws = 4096;
+
+    DrawConstants();
+    ~DrawConstants();
+
+    DrawConstants(DrawConstants const&) = delete;
+    DrawConstants& operator=(DrawConstants const&) = delete;
+
+    // Creates the draw index stream, its upload is recorded into the command list
+    void            Init(ISGDevice* pDevice, ISGCommandList* pCommandList, U32 maxDraws = DefaultMaxDraws);
+    void            Destroy();
+
+    // Per instance element of the draw index, semantic DRAWINDEX
+    static SG_INPUT_ELEMENT_DESC GetInputElement(U32 inputSlot);
+
+    // Binds the draw index stream to the input slot of GetInputElement
+    void            SetDrawIndexBuffer(ISGCommandList* pCommandList, U32 inputSlot) const;
+
+    // Starts a batch of records, the size of a record is aligned to 16 bytes as HLSL arrays are.
+    // The first buffer is sized for expectedCount records, the following ones take 64 KB.
+    void            BeginBatch(FrameUploadRing& uploadRing, U32 recordSize, U32 expectedCount);
+
+    // Writes the next record of the batch, the draw index is passed as startInstanceLocation.
+    // Throws if the constants aren't initialized or the batch isn't started.
+    DrawConstantsAllocation Push(void const* pData);
+
+private:
+    static const U32 MaxBufferSize = 64 << 10;
+
+    ISGBuffer*      m_pDrawIndexBuffer;
+    U32             m_MaxDraws;
+
+    FrameUploadRing* m_pUploadRing;
+    ISGBuffer*      m_pBuffer;
+    U8*             m_pRecords;
+    U32             m_RecordSize;
+    U32             m_RecordStride;
+    U32             m_ExpectedCount;
+    U32             m_BufferCapacity;
+    U32             m_BufferCount;
+};
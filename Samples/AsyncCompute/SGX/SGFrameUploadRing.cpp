@@ -0,0 +1,191 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGFrameUploadRing.h"
+#include <cstring>
+
+FrameUploadRing::FrameUploadRing()
+    : m_pDevice(SG_NULL)
+    , m_FrameBufferIndex(0)
+    , m_PageSize(DefaultPageSize)
+{
+}
+
+FrameUploadRing::~FrameUploadRing()
+{
+    Destroy();
+}
+
+void FrameUploadRing::Init(ISGDevice* pDevice, U32 frameBuffers, U32 pageSize)
+{
+    Destroy();
+
+    m_pDevice = pDevice;
+    m_pDevice->AddRef();
+
+    m_PageSize = AlignValue(pageSize, SG_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    m_FrameBuffers.resize(frameBuffers > 0 ? frameBuffers : 1);
+    m_FrameBufferIndex = static_cast<U32>(m_FrameBuffers.size()) - 1;
+
+    for (FrameBuffer& frameBuffer : m_FrameBuffers)
+    {
+        frameBuffer.CurrentPage = 0;
+        frameBuffer.CurrentOffset = 0;
+        frameBuffer.AllocatedBytes = 0;
+
+        for (U32 i = 0; i < NumSizeClasses; i++)
+            frameBuffer.UsedConstantBuffers[i] = 0;
+    }
+}
+
+void FrameUploadRing::Destroy()
+{
+    auto releaseBuffers = [](std::vector<MappedBuffer>& buffers)
+    {
+        for (MappedBuffer& buffer : buffers)
+        {
+            buffer.pBuffer->Unmap();
+            buffer.pBuffer->Release();
+        }
+
+        buffers.clear();
+    };
+
+    for (FrameBuffer& frameBuffer : m_FrameBuffers)
+    {
+        releaseBuffers(frameBuffer.Pages);
+
+        for (U32 i = 0; i < NumSizeClasses; i++)
+            releaseBuffers(frameBuffer.ConstantBuffers[i]);
+    }
+
+    m_FrameBuffers.clear();
+    SG_RELEASE(m_pDevice);
+}
+
+void FrameUploadRing::BeginFrame()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // Slots follow the order of the execution context's frame buffers, the first frame takes slot #0
+    m_FrameBufferIndex = (m_FrameBufferIndex + 1) % m_FrameBuffers.size();
+
+    FrameBuffer& frameBuffer = m_FrameBuffers[m_FrameBufferIndex];
+    frameBuffer.CurrentPage = 0;
+    frameBuffer.CurrentOffset = 0;
+    frameBuffer.AllocatedBytes = 0;
+
+    for (U32 i = 0; i < NumSizeClasses; i++)
+        frameBuffer.UsedConstantBuffers[i] = 0;
+}
+
+FrameUploadRing::MappedBuffer FrameUploadRing::CreateMappedBuffer(SG_BUFFER_DESC const& desc)
+{
+    MappedBuffer buffer{};
+    buffer.Size = static_cast<U32>(desc.Size);
+
+    if (m_pDevice->CreateBuffer(&desc, &buffer.pBuffer) != SG_OK)
+        throw std::exception("Failed to create upload ring buffer");
+
+    // Upload heaps may stay mapped for the whole life of the resource
+    if (buffer.pBuffer->Map(reinterpret_cast<void**>(&buffer.pData)) != SG_OK)
+        throw std::exception("Failed to map upload ring buffer");
+
+    return buffer;
+}
+
+UploadAllocation FrameUploadRing::Allocate(U32 sizeBytes, U32 alignment)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    FrameBuffer& frameBuffer = m_FrameBuffers[m_FrameBufferIndex];
+
+    // Dedicated page for allocations that don't fit a regular one, it's kept in the pool as well
+    U32 const requiredPageSize = sizeBytes > m_PageSize ? AlignValue(sizeBytes, m_PageSize) : m_PageSize;
+
+    for (;;)
+    {
+        if (frameBuffer.CurrentPage == frameBuffer.Pages.size())
+            frameBuffer.Pages.push_back(CreateMappedBuffer(FastBufferDesc::Upload(requiredPageSize)));
+
+        MappedBuffer& page = frameBuffer.Pages[frameBuffer.CurrentPage];
+        U32 const offset = AlignValue(frameBuffer.CurrentOffset, alignment);
+
+        if (offset + sizeBytes <= page.Size)
+        {
+            frameBuffer.CurrentOffset = offset + sizeBytes;
+            frameBuffer.AllocatedBytes += sizeBytes;
+            return UploadAllocation{ page.pData + offset, page.pBuffer, offset, sizeBytes };
+        }
+
+        frameBuffer.CurrentPage++;
+        frameBuffer.CurrentOffset = 0;
+    }
+}
+
+ISGBuffer* FrameUploadRing::AllocateConstants(void const* pData, U32 sizeBytes)
+{
+    void* pCpuAddress = nullptr;
+    ISGBuffer* pBuffer = AllocateConstants(sizeBytes, &pCpuAddress);
+
+    memcpy(pCpuAddress, pData, sizeBytes);
+    return pBuffer;
+}
+
+ISGBuffer* FrameUploadRing::AllocateConstants(U32 sizeBytes, void** ppCpuAddress)
+{
+    U32 sizeClass = 0;
+    while (sizeClass < NumSizeClasses - 1 && (U32(SG_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT) << sizeClass) < sizeBytes)
+        sizeClass++;
+
+    U32 const classSize = U32(SG_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT) << sizeClass;
+    if (sizeBytes > classSize)
+        throw std::exception("Constant data exceeds 64 KB");
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    FrameBuffer& frameBuffer = m_FrameBuffers[m_FrameBufferIndex];
+    std::vector<MappedBuffer>& pool = frameBuffer.ConstantBuffers[sizeClass];
+    U32& used = frameBuffer.UsedConstantBuffers[sizeClass];
+
+    if (used == pool.size())
+        pool.push_back(CreateMappedBuffer(FastBufferDesc::Constant(classSize)));
+
+    MappedBuffer& buffer = pool[used++];
+    *ppCpuAddress = buffer.pData;
+    return buffer.pBuffer;
+}
+
+FrameUploadRingStats FrameUploadRing::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    FrameUploadRingStats stats{};
+
+    for (U32 i = 0; i < m_FrameBuffers.size(); i++)
+    {
+        FrameBuffer const& frameBuffer = m_FrameBuffers[i];
+        stats.Pages += static_cast<U32>(frameBuffer.Pages.size());
+
+        for (U32 sizeClass = 0; sizeClass < NumSizeClasses; sizeClass++)
+        {
+            stats.PooledConstantBuffers += static_cast<U32>(frameBuffer.ConstantBuffers[sizeClass].size());
+
+            if (i == m_FrameBufferIndex)
+                stats.ConstantBuffers += frameBuffer.UsedConstantBuffers[sizeClass];
+        }
+
+        if (i == m_FrameBufferIndex)
+            stats.AllocatedBytes = frameBuffer.AllocatedBytes;
+    }
+
+    return stats;
+}
@@ -0,0 +1,925 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGPipelineCache.h"
+#include <cstring>
+#include <deque>
+#include <fstream>
+
+namespace
+{
+    const U32 c_FileMagic = 0x43504753; // "SGPC"
+    const U32 c_FileVersion = 1;
+    const U32 c_NullString = 0xFFFFFFFF;
+    const U32 c_MaxStaticSamplers = 2032;
+
+    enum InputLayoutKind : U32
+    {
+        INPUT_LAYOUT_NONE = 0,
+        INPUT_LAYOUT_ELEMENTS = 1,
+        INPUT_LAYOUT_OPAQUE = 2
+    };
+
+    ///-------------------------------------------------------------------------------------------------
+    /// Serialization of descriptions
+    ///-------------------------------------------------------------------------------------------------
+    class BlobWriter
+    {
+    public:
+        BlobWriter(ByteBuffer& blob) : m_Blob(blob) {}
+
+        void Raw(void const* pData, size_t sizeBytes)
+        {
+            U8 const* pBytes = static_cast<U8 const*>(pData);
+            m_Blob.insert(m_Blob.end(), pBytes, pBytes + sizeBytes);
+        }
+
+        void U32Value(U32 value) { Raw(&value, sizeof(value)); }
+        void U64Value(U64 value) { Raw(&value, sizeof(value)); }
+
+        void String(char const* pString)
+        {
+            if (pString == SG_NULL)
+            {
+                U32Value(c_NullString);
+                return;
+            }
+
+            U32 const length = static_cast<U32>(strlen(pString));
+            U32Value(length);
+            Raw(pString, length + 1);
+        }
+
+        void ByteCode(SG_SHADER_BYTECODE const& byteCode)
+        {
+            U64 const sizeBytes = byteCode.pData != SG_NULL ? byteCode.SizeBytes : 0;
+            U64Value(sizeBytes);
+            Raw(byteCode.pData, static_cast<size_t>(sizeBytes));
+        }
+
+        void RootSignature(SG_ROOT_SIGNATURE_DESC const& desc)
+        {
+            U32Value(desc.Type);
+            U32Value(desc.Tabular.NumTables);
+
+            for (U32 i = 0; i < desc.Tabular.NumTables; i++)
+            {
+                SG_BINDING_TABLE_DESC const& table = desc.Tabular.pTables[i];
+                U32Value(table.ShaderVisibility);
+                Raw(&table.ConstantBuffers, sizeof(SG_BINDING_RANGE));
+                Raw(&table.SRVs, sizeof(SG_BINDING_RANGE));
+                Raw(&table.UAVs, sizeof(SG_BINDING_RANGE));
+                Raw(&table.AsSRVs, sizeof(SG_BINDING_RANGE));
+                Raw(&table.Samplers, sizeof(SG_BINDING_RANGE));
+
+                U32Value(table.NumStaticSamplers);
+                Raw(table.pStaticSamplers, table.NumStaticSamplers * sizeof(SG_STATIC_SAMPLER_DESC));
+            }
+        }
+
+        void RaytracingShader(SG_RAYTRACING_SHADER const& shader)
+        {
+            String(shader.pName);
+            ByteCode(shader.ByteCode);
+        }
+
+    private:
+        ByteBuffer& m_Blob;
+    };
+
+    class BlobReader
+    {
+    public:
+        BlobReader(ByteBuffer const& blob)
+            : m_pCurrent(blob.data())
+            , m_pEnd(blob.data() + blob.size())
+            , m_Failed(false)
+        {
+        }
+
+        bool IsValid() const { return !m_Failed && m_pCurrent == m_pEnd; }
+
+        void const* Raw(size_t sizeBytes)
+        {
+            if (m_Failed || size_t(m_pEnd - m_pCurrent) < sizeBytes)
+            {
+                m_Failed = true;
+                return SG_NULL;
+            }
+
+            void const* pData = m_pCurrent;
+            m_pCurrent += sizeBytes;
+            return pData;
+        }
+
+        template <typename T>
+        void Read(T& value)
+        {
+            // Blob fields are packed, copy to avoid unaligned loads
+            void const* pData = Raw(sizeof(T));
+            if (pData != SG_NULL)
+                memcpy(&value, pData, sizeof(T));
+            else
+                value = T{};
+        }
+
+        U32 U32Value() { U32 value; Read(value); return value; }
+        U64 U64Value() { U64 value; Read(value); return value; }
+
+        char const* String()
+        {
+            U32 const length = U32Value();
+            if (length == c_NullString)
+                return SG_NULL;
+
+            // The stored length isn't trusted, the string must end where it says
+            char const* pString = static_cast<char const*>(Raw(size_t(length) + 1));
+            if (pString != SG_NULL && pString[length] != '\0')
+            {
+                m_Failed = true;
+                return SG_NULL;
+            }
+
+            return pString;
+        }
+
+        SG_SHADER_BYTECODE ByteCode()
+        {
+            SG_SHADER_BYTECODE byteCode{};
+            byteCode.SizeBytes = static_cast<size_t>(U64Value());
+            byteCode.pData = byteCode.SizeBytes > 0 ? const_cast<void*>(Raw(byteCode.SizeBytes)) : SG_NULL;
+            return byteCode;
+        }
+
+        SG_RAYTRACING_SHADER RaytracingShader()
+        {
+            SG_RAYTRACING_SHADER shader{};
+            shader.pName = String();
+            shader.ByteCode = ByteCode();
+            return shader;
+        }
+
+    private:
+        U8 const*   m_pCurrent;
+        U8 const*   m_pEnd;
+        bool        m_Failed;
+    };
+
+    // Arrays referenced by a description restored from a blob
+    struct DescStorage
+    {
+        std::vector<SG_BINDING_TABLE_DESC>                  Tables;
+        std::deque<std::vector<SG_STATIC_SAMPLER_DESC>>     StaticSamplers;
+        std::vector<SG_RAYTRACING_HIT_GROUP>                HitGroups;
+        std::vector<SG_INPUT_ELEMENT_DESC>                  InputElements;
+    };
+
+    SG_ROOT_SIGNATURE_DESC ReadRootSignature(BlobReader& reader, DescStorage& storage)
+    {
+        SG_ROOT_SIGNATURE_DESC desc{};
+        desc.Type = static_cast<SG_ROOT_SIGNATURE_TYPE>(reader.U32Value());
+        desc.Tabular.NumTables = reader.U32Value();
+
+        if (desc.Tabular.NumTables > SG_MAX_ROOT_SIGNATURE_PARAMETERS)
+        {
+            reader.Raw(SIZE_MAX);
+            return desc;
+        }
+
+        storage.Tables.resize(desc.Tabular.NumTables);
+
+        for (SG_BINDING_TABLE_DESC& table : storage.Tables)
+        {
+            table.ShaderVisibility = static_cast<SG_SHADER_VISIBILITY>(reader.U32Value());
+            reader.Read(table.ConstantBuffers);
+            reader.Read(table.SRVs);
+            reader.Read(table.UAVs);
+            reader.Read(table.AsSRVs);
+            reader.Read(table.Samplers);
+
+            table.NumStaticSamplers = reader.U32Value();
+            if (table.NumStaticSamplers > c_MaxStaticSamplers)
+            {
+                reader.Raw(SIZE_MAX);
+                return desc;
+            }
+
+            storage.StaticSamplers.emplace_back(table.NumStaticSamplers);
+
+            for (SG_STATIC_SAMPLER_DESC& sampler : storage.StaticSamplers.back())
+                reader.Read(sampler);
+
+            table.pStaticSamplers = table.NumStaticSamplers > 0 ? storage.StaticSamplers.back().data() : SG_NULL;
+        }
+
+        desc.Tabular.pTables = storage.Tables.data();
+        return desc;
+    }
+
+    void WriteInputElements(BlobWriter& writer, U32 numElements, SG_INPUT_ELEMENT_DESC const* pInputElements)
+    {
+        writer.U32Value(numElements);
+
+        for (U32 i = 0; i < numElements; i++)
+        {
+            SG_INPUT_ELEMENT_DESC const& element = pInputElements[i];
+            writer.String(element.SemanticName);
+            writer.U32Value(element.SemanticIndex);
+            writer.U32Value(element.Format);
+            writer.U32Value(element.InputSlot);
+            writer.U32Value(element.AlignedByteOffset);
+            writer.U32Value(element.InputSlotClass);
+            writer.U32Value(element.InstanceDataStepRate);
+        }
+    }
+
+    void ReadInputElements(BlobReader& reader, std::vector<SG_INPUT_ELEMENT_DESC>& elements)
+    {
+        U32 const numElements = reader.U32Value();
+        if (numElements > 32)
+        {
+            reader.Raw(SIZE_MAX);
+            return;
+        }
+
+        elements.resize(numElements);
+
+        for (SG_INPUT_ELEMENT_DESC& element : elements)
+        {
+            element.SemanticName = reader.String();
+            element.SemanticIndex = reader.U32Value();
+            element.Format = static_cast<SG_FORMAT>(reader.U32Value());
+            element.InputSlot = reader.U32Value();
+            element.AlignedByteOffset = reader.U32Value();
+            element.InputSlotClass = static_cast<SG_INPUT_CLASSIFICATION>(reader.U32Value());
+            element.InstanceDataStepRate = reader.U32Value();
+        }
+    }
+}
+
+///-------------------------------------------------------------------------------------------------
+/// PipelineCache
+///-------------------------------------------------------------------------------------------------
+PipelineCache::PipelineCache(ISGDevice* pDevice)
+    : m_pDevice(pDevice)
+    , m_PendingJobs(0)
+    , m_Stats{}
+{
+    m_pDevice->AddRef();
+}
+
+PipelineCache::~PipelineCache()
+{
+    WaitForPendingJobs();
+
+    for (auto& it : m_Entries)
+    {
+        SG_RELEASE(it.second.pPipelineState);
+        SG_RELEASE(it.second.pInputLayout);
+    }
+
+    for (auto& it : m_InputLayouts)
+        SG_RELEASE(it.second.pInputLayout);
+
+    m_pDevice->Release();
+}
+
+U64 PipelineCache::ComputeHash(void const* pData, size_t sizeBytes)
+{
+    // FNV-1a
+    U8 const* pBytes = static_cast<U8 const*>(pData);
+    U64 hash = 0xCBF29CE484222325ull;
+
+    for (size_t i = 0; i < sizeBytes; i++)
+    {
+        hash ^= pBytes[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+SG_RESULT PipelineCache::CreateInputLayout(U32 numElements, SG_INPUT_ELEMENT_DESC const* pInputElements, ISGInputLayout** ppInputLayout)
+{
+    if (ppInputLayout == SG_NULL || (numElements > 0 && pInputElements == SG_NULL))
+        return SG_ERROR_INVALID_ARG;
+
+    ByteBuffer blob;
+    BlobWriter writer(blob);
+    WriteInputElements(writer, numElements, pInputElements);
+
+    U64 const key = ComputeHash(blob.data(), blob.size());
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto range = m_InputLayouts.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.Blob == blob)
+        {
+            it->second.pInputLayout->AddRef();
+            *ppInputLayout = it->second.pInputLayout;
+            return SG_OK;
+        }
+    }
+
+    // Input layout creation is cheap, it's done under the lock
+    ISGInputLayout* pInputLayout = SG_NULL;
+    SG_RESULT result = m_pDevice->CreateInputLayout(numElements, pInputElements, &pInputLayout);
+    if (result != SG_OK)
+        return result;
+
+    m_InputLayouts.emplace(key, InputLayoutEntry{ std::move(blob), pInputLayout });
+    m_InputLayoutKeys[pInputLayout] = key;
+
+    pInputLayout->AddRef();
+    *ppInputLayout = pInputLayout;
+    return SG_OK;
+}
+
+SG_RESULT PipelineCache::CreateGraphicsPipelineState(SG_GRAPHICS_PIPELINE_STATE_DESC const* pDesc, ISGPipelineState** ppPipelineState)
+{
+    if (pDesc == SG_NULL || ppPipelineState == SG_NULL)
+        return SG_ERROR_INVALID_ARG;
+
+    ByteBuffer blob;
+    bool const persistent = Serialize(*pDesc, blob);
+    return FindOrCreate(SG_PIPELINE_STATE_TYPE_GRAPHICS, std::move(blob), persistent ? SG_NULL : pDesc->pInputLayout, ppPipelineState, false);
+}
+
+SG_RESULT PipelineCache::CreateMeshPipelineState(SG_MESH_PIPELINE_STATE_DESC const* pDesc, ISGPipelineState** ppPipelineState)
+{
+    if (pDesc == SG_NULL || ppPipelineState == SG_NULL)
+        return SG_ERROR_INVALID_ARG;
+
+    ByteBuffer blob;
+    Serialize(*pDesc, blob);
+    return FindOrCreate(SG_PIPELINE_STATE_TYPE_MESH, std::move(blob), SG_NULL, ppPipelineState, false);
+}
+
+SG_RESULT PipelineCache::CreateComputePipelineState(SG_COMPUTE_PIPELINE_STATE_DESC const* pDesc, ISGPipelineState** ppPipelineState)
+{
+    if (pDesc == SG_NULL || ppPipelineState == SG_NULL)
+        return SG_ERROR_INVALID_ARG;
+
+    ByteBuffer blob;
+    Serialize(*pDesc, blob);
+    return FindOrCreate(SG_PIPELINE_STATE_TYPE_COMPUTE, std::move(blob), SG_NULL, ppPipelineState, false);
+}
+
+SG_RESULT PipelineCache::CreateRaytracingPipelineState(SG_RAYTRACING_PIPELINE_DESC const* pDesc, ISGPipelineState** ppPipelineState)
+{
+    if (pDesc == SG_NULL || ppPipelineState == SG_NULL)
+        return SG_ERROR_INVALID_ARG;
+
+    ByteBuffer blob;
+    Serialize(*pDesc, blob);
+    return FindOrCreate(SG_PIPELINE_STATE_TYPE_RAYTRACING, std::move(blob), SG_NULL, ppPipelineState, false);
+}
+
+AsyncPipelineStatePtr PipelineCache::CreateGraphicsPipelineStateAsync(SG_GRAPHICS_PIPELINE_STATE_DESC const* pDesc, ThreadPool& threadPool)
+{
+    return CreateAsync(SG_PIPELINE_STATE_TYPE_GRAPHICS, pDesc, pDesc != SG_NULL ? pDesc->pInputLayout : SG_NULL, threadPool);
+}
+
+AsyncPipelineStatePtr PipelineCache::CreateMeshPipelineStateAsync(SG_MESH_PIPELINE_STATE_DESC const* pDesc, ThreadPool& threadPool)
+{
+    return CreateAsync(SG_PIPELINE_STATE_TYPE_MESH, pDesc, SG_NULL, threadPool);
+}
+
+AsyncPipelineStatePtr PipelineCache::CreateComputePipelineStateAsync(SG_COMPUTE_PIPELINE_STATE_DESC const* pDesc, ThreadPool& threadPool)
+{
+    return CreateAsync(SG_PIPELINE_STATE_TYPE_COMPUTE, pDesc, SG_NULL, threadPool);
+}
+
+AsyncPipelineStatePtr PipelineCache::CreateRaytracingPipelineStateAsync(SG_RAYTRACING_PIPELINE_DESC const* pDesc, ThreadPool& threadPool)
+{
+    return CreateAsync(SG_PIPELINE_STATE_TYPE_RAYTRACING, pDesc, SG_NULL, threadPool);
+}
+
+template <typename TDesc>
+AsyncPipelineStatePtr PipelineCache::CreateAsync(SG_PIPELINE_STATE_TYPE type, TDesc const* pDesc, ISGInputLayout* pInputLayout, ThreadPool& threadPool)
+{
+    AsyncPipelineStatePtr pAsyncState = std::make_shared<AsyncPipelineState>();
+
+    if (pDesc == SG_NULL)
+    {
+        pAsyncState->Complete(SG_ERROR_INVALID_ARG, SG_NULL);
+        return pAsyncState;
+    }
+
+    // The description is copied into the blob, the caller's memory may be freed right after the call
+    ByteBuffer blob;
+    bool const persistent = Serialize(*pDesc, blob);
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_PendingJobs++;
+    }
+
+    // An input layout unknown to the cache is referenced by the blob, keep it alive until the job is done
+    if (!persistent && pInputLayout != SG_NULL)
+        pInputLayout->AddRef();
+
+    std::shared_ptr<ByteBuffer> pBlob = std::make_shared<ByteBuffer>(std::move(blob));
+
+    threadPool.Submit([this, type, pBlob, persistent, pInputLayout, pAsyncState]()
+    {
+        ISGPipelineState* pPipelineState = SG_NULL;
+        SG_RESULT result = FindOrCreate(type, std::move(*pBlob), persistent ? SG_NULL : pInputLayout, &pPipelineState, false);
+
+        if (!persistent && pInputLayout != SG_NULL)
+            pInputLayout->Release();
+
+        pAsyncState->Complete(result, pPipelineState);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (--m_PendingJobs == 0)
+            m_NoPendingJobs.notify_all();
+    });
+
+    return pAsyncState;
+}
+
+bool PipelineCache::Serialize(SG_GRAPHICS_PIPELINE_STATE_DESC const& desc, ByteBuffer& blob)
+{
+    BlobWriter writer(blob);
+    writer.RootSignature(desc.RootSignature);
+    writer.ByteCode(desc.PS);
+    writer.ByteCode(desc.VS);
+    writer.ByteCode(desc.DS);
+    writer.ByteCode(desc.HS);
+    writer.ByteCode(desc.GS);
+
+    if (desc.pInputLayout == SG_NULL)
+    {
+        writer.U32Value(INPUT_LAYOUT_NONE);
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto it = m_InputLayoutKeys.find(desc.pInputLayout);
+    if (it != m_InputLayoutKeys.end())
+    {
+        auto range = m_InputLayouts.equal_range(it->second);
+        for (auto layoutIt = range.first; layoutIt != range.second; ++layoutIt)
+        {
+            if (layoutIt->second.pInputLayout == desc.pInputLayout)
+            {
+                writer.U32Value(INPUT_LAYOUT_ELEMENTS);
+                writer.Raw(layoutIt->second.Blob.data(), layoutIt->second.Blob.size());
+                return true;
+            }
+        }
+    }
+
+    // The layout can't be restored from a file, the object identity is the key
+    writer.U32Value(INPUT_LAYOUT_OPAQUE);
+    writer.U64Value(reinterpret_cast<U64>(desc.pInputLayout));
+    return false;
+}
+
+bool PipelineCache::Serialize(SG_MESH_PIPELINE_STATE_DESC const& desc, ByteBuffer& blob)
+{
+    BlobWriter writer(blob);
+    writer.RootSignature(desc.RootSignature);
+    writer.ByteCode(desc.PS);
+    writer.ByteCode(desc.MS);
+    writer.ByteCode(desc.AS);
+    return true;
+}
+
+bool PipelineCache::Serialize(SG_COMPUTE_PIPELINE_STATE_DESC const& desc, ByteBuffer& blob)
+{
+    BlobWriter writer(blob);
+    writer.RootSignature(desc.RootSignature);
+    writer.ByteCode(desc.CS);
+    return true;
+}
+
+bool PipelineCache::Serialize(SG_RAYTRACING_PIPELINE_DESC const& desc, ByteBuffer& blob)
+{
+    BlobWriter writer(blob);
+    writer.RootSignature(desc.RootSignature);
+    writer.RaytracingShader(desc.RayGenShader);
+    writer.RaytracingShader(desc.MissShader);
+    writer.U32Value(desc.HitGroupCount);
+
+    for (U32 i = 0; i < desc.HitGroupCount; i++)
+    {
+        SG_RAYTRACING_HIT_GROUP const& hitGroup = desc.pHitGroups[i];
+        writer.U32Value(hitGroup.Type);
+        writer.RaytracingShader(hitGroup.ClosestHit);
+        writer.RaytracingShader(hitGroup.AnyHit);
+        writer.RaytracingShader(hitGroup.IntersectionShader);
+    }
+
+    writer.U32Value(desc.MaxPayloadSize);
+    writer.U32Value(desc.MaxAttributeSize);
+    writer.U32Value(desc.MaxRecursionDepth);
+    return true;
+}
+
+SG_RESULT PipelineCache::FindOrCreate(SG_PIPELINE_STATE_TYPE type, ByteBuffer&& blob, ISGInputLayout* pOpaqueLayout, ISGPipelineState** ppPipelineState, bool prewarm)
+{
+    U64 const key = ComputeHash(blob.data(), blob.size()) ^ type;
+
+    auto findEntry = [&]() -> ISGPipelineState*
+    {
+        auto range = m_Entries.equal_range(key);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second.Type == type && it->second.Blob == blob)
+                return it->second.pPipelineState;
+        }
+
+        return SG_NULL;
+    };
+
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
+        for (;;)
+        {
+            ISGPipelineState* pCached = findEntry();
+            if (pCached != SG_NULL)
+            {
+                if (!prewarm)
+                    m_Stats.Hits++;
+
+                pCached->AddRef();
+                *ppPipelineState = pCached;
+                return SG_OK;
+            }
+
+            if (prewarm)
+                break;
+
+            // A description being prewarmed isn't compiled twice, its key may also collide with another one
+            auto range = m_PrewarmJobs.equal_range(key);
+            auto job = range.first;
+            while (job != range.second && (job->second->Type != type || job->second->Blob != blob))
+                ++job;
+
+            if (job == range.second)
+                break;
+
+            // The caller may be a worker of the pool the job is queued to, a queued job is taken over
+            if (!job->second->IsRunning)
+            {
+                m_PrewarmJobs.erase(job);
+                break;
+            }
+
+            m_PrewarmDone.wait(lock);
+        }
+    }
+
+    // Compilation happens without the lock, other threads may hit the cache meanwhile
+    ISGPipelineState* pPipelineState = SG_NULL;
+    SG_RESULT result = CreateFromBlob(type, blob, pOpaqueLayout == SG_NULL, &pPipelineState);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (result != SG_OK)
+    {
+        if (prewarm)
+            m_Stats.LoadFailures++;
+
+        return result;
+    }
+
+    ISGPipelineState* pCached = findEntry();
+    if (pCached != SG_NULL)
+    {
+        // Another thread created the same pipeline state first
+        pPipelineState->Release();
+        pPipelineState = pCached;
+    }
+    else
+    {
+        // The layout stays alive while the entry keys on its address, so another layout can't take it
+        if (pOpaqueLayout != SG_NULL)
+            pOpaqueLayout->AddRef();
+
+        m_Entries.emplace(key, Entry{ type, std::move(blob), pOpaqueLayout == SG_NULL, pOpaqueLayout, pPipelineState });
+        m_Stats.Entries++;
+    }
+
+    if (prewarm)
+        m_Stats.Prewarmed++;
+    else
+        m_Stats.Misses++;
+
+    pPipelineState->AddRef();
+    *ppPipelineState = pPipelineState;
+    return SG_OK;
+}
+
+SG_RESULT PipelineCache::CreateFromBlob(SG_PIPELINE_STATE_TYPE type, ByteBuffer const& blob, bool persistent, ISGPipelineState** ppPipelineState)
+{
+    BlobReader reader(blob);
+    DescStorage storage;
+
+    switch (type)
+    {
+    case SG_PIPELINE_STATE_TYPE_GRAPHICS:
+        {
+            SG_GRAPHICS_PIPELINE_STATE_DESC desc{};
+            desc.RootSignature = ReadRootSignature(reader, storage);
+            desc.PS = reader.ByteCode();
+            desc.VS = reader.ByteCode();
+            desc.DS = reader.ByteCode();
+            desc.HS = reader.ByteCode();
+            desc.GS = reader.ByteCode();
+
+            ISGInputLayout* pInputLayout = SG_NULL;
+
+            switch (reader.U32Value())
+            {
+            case INPUT_LAYOUT_NONE:
+                break;
+            case INPUT_LAYOUT_ELEMENTS:
+                ReadInputElements(reader, storage.InputElements);
+                if (reader.IsValid() && CreateInputLayout(static_cast<U32>(storage.InputElements.size()), storage.InputElements.data(), &pInputLayout) != SG_OK)
+                    return SG_ERROR_INVALID_ARG;
+                break;
+            case INPUT_LAYOUT_OPAQUE:
+                // Never comes from a file, only from a live description
+                if (persistent)
+                    return SG_ERROR_INVALID_ARG;
+
+                pInputLayout = reinterpret_cast<ISGInputLayout*>(reader.U64Value());
+                pInputLayout->AddRef();
+                break;
+            default:
+                return SG_ERROR_INVALID_ARG;
+            }
+
+            if (!reader.IsValid())
+            {
+                SG_RELEASE(pInputLayout);
+                return SG_ERROR_INVALID_ARG;
+            }
+
+            desc.pInputLayout = pInputLayout;
+            SG_RESULT result = m_pDevice->CreateGraphicsPipelineState(&desc, ppPipelineState);
+
+            // The cache keeps its own reference to the input layout
+            SG_RELEASE(pInputLayout);
+            return result;
+        }
+    case SG_PIPELINE_STATE_TYPE_MESH:
+        {
+            SG_MESH_PIPELINE_STATE_DESC desc{};
+            desc.RootSignature = ReadRootSignature(reader, storage);
+            desc.PS = reader.ByteCode();
+            desc.MS = reader.ByteCode();
+            desc.AS = reader.ByteCode();
+
+            if (!reader.IsValid())
+                return SG_ERROR_INVALID_ARG;
+
+            return m_pDevice->CreateMeshPipelineState(&desc, ppPipelineState);
+        }
+    case SG_PIPELINE_STATE_TYPE_COMPUTE:
+        {
+            SG_COMPUTE_PIPELINE_STATE_DESC desc{};
+            desc.RootSignature = ReadRootSignature(reader, storage);
+            desc.CS = reader.ByteCode();
+
+            if (!reader.IsValid())
+                return SG_ERROR_INVALID_ARG;
+
+            return m_pDevice->CreateComputePipelineState(&desc, ppPipelineState);
+        }
+    case SG_PIPELINE_STATE_TYPE_RAYTRACING:
+        {
+            SG_RAYTRACING_PIPELINE_DESC desc{};
+            desc.RootSignature = ReadRootSignature(reader, storage);
+            desc.RayGenShader = reader.RaytracingShader();
+            desc.MissShader = reader.RaytracingShader();
+            desc.HitGroupCount = reader.U32Value();
+
+            if (desc.HitGroupCount > SG_MAX_HIT_GROUPS_COUNT)
+                return SG_ERROR_INVALID_ARG;
+
+            storage.HitGroups.resize(desc.HitGroupCount);
+            for (SG_RAYTRACING_HIT_GROUP& hitGroup : storage.HitGroups)
+            {
+                hitGroup.Type = static_cast<SG_HIT_GROUP_TYPE>(reader.U32Value());
+                hitGroup.ClosestHit = reader.RaytracingShader();
+                hitGroup.AnyHit = reader.RaytracingShader();
+                hitGroup.IntersectionShader = reader.RaytracingShader();
+            }
+
+            desc.pHitGroups = storage.HitGroups.empty() ? SG_NULL : storage.HitGroups.data();
+            desc.MaxPayloadSize = reader.U32Value();
+            desc.MaxAttributeSize = reader.U32Value();
+            desc.MaxRecursionDepth = reader.U32Value();
+
+            if (!reader.IsValid())
+                return SG_ERROR_INVALID_ARG;
+
+            return m_pDevice->CreateRaytracingPipelineState(&desc, ppPipelineState);
+        }
+    default:
+        return SG_ERROR_INVALID_ARG;
+    }
+}
+
+bool PipelineCache::LoadFromFile(char const* pFileName, ThreadPool& threadPool)
+{
+    ByteBuffer file;
+    if (!LoadBinaryFile(pFileName, file))
+        return false;
+
+    ByteBuffer::const_iterator current = file.begin();
+
+    auto read = [&](void* pDest, size_t sizeBytes) -> bool
+    {
+        if (size_t(file.end() - current) < sizeBytes)
+            return false;
+
+        memcpy(pDest, &*current, sizeBytes);
+        current += sizeBytes;
+        return true;
+    };
+
+    U32 header[3] = {};
+    if (!read(header, sizeof(header)) || header[0] != c_FileMagic || header[1] != c_FileVersion)
+        return false;
+
+    for (U32 i = 0; i < header[2]; i++)
+    {
+        U32 type = 0;
+        U64 blobSize = 0;
+
+        if (!read(&type, sizeof(type)) || !read(&blobSize, sizeof(blobSize)) || U64(file.end() - current) < blobSize)
+            return false;
+
+        PrewarmJobPtr pJob = std::make_shared<PrewarmJob>();
+        pJob->Type = static_cast<SG_PIPELINE_STATE_TYPE>(type);
+        pJob->Blob.assign(current, current + static_cast<size_t>(blobSize));
+        pJob->IsRunning = false;
+        current += static_cast<size_t>(blobSize);
+
+        U64 const key = ComputeHash(pJob->Blob.data(), pJob->Blob.size()) ^ type;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_PendingJobs++;
+            m_PrewarmJobs.emplace(key, pJob);
+        }
+
+        threadPool.Submit([this, key, pJob]()
+        {
+            auto findJob = [&]()
+            {
+                auto range = m_PrewarmJobs.equal_range(key);
+                for (auto it = range.first; it != range.second; ++it)
+                {
+                    if (it->second == pJob)
+                        return it;
+                }
+
+                return m_PrewarmJobs.end();
+            };
+
+            bool takenOver = false;
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                takenOver = findJob() == m_PrewarmJobs.end();
+                pJob->IsRunning = true;
+            }
+
+            // The blob is compared by waiting Create* calls while the job runs, it's copied
+            ISGPipelineState* pPipelineState = SG_NULL;
+            if (!takenOver && FindOrCreate(pJob->Type, ByteBuffer(pJob->Blob), SG_NULL, &pPipelineState, true) == SG_OK)
+                pPipelineState->Release();
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                if (!takenOver)
+                    m_PrewarmJobs.erase(findJob());
+
+                if (--m_PendingJobs == 0)
+                    m_NoPendingJobs.notify_all();
+            }
+
+            m_PrewarmDone.notify_all();
+        });
+    }
+
+    return current == file.end();
+}
+
+bool PipelineCache::SaveToFile(char const* pFileName) const
+{
+    std::ofstream file(pFileName, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    U32 numPersistent = 0;
+    for (auto const& it : m_Entries)
+        numPersistent += it.second.Persistent ? 1 : 0;
+
+    U32 const header[3] = { c_FileMagic, c_FileVersion, numPersistent };
+    file.write(reinterpret_cast<char const*>(header), sizeof(header));
+
+    for (auto const& it : m_Entries)
+    {
+        Entry const& entry = it.second;
+        if (!entry.Persistent)
+            continue;
+
+        U32 const type = entry.Type;
+        U64 const blobSize = entry.Blob.size();
+        file.write(reinterpret_cast<char const*>(&type), sizeof(type));
+        file.write(reinterpret_cast<char const*>(&blobSize), sizeof(blobSize));
+        file.write(reinterpret_cast<char const*>(entry.Blob.data()), entry.Blob.size());
+    }
+
+    return file.good();
+}
+
+void PipelineCache::WaitForPendingJobs()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_NoPendingJobs.wait(lock, [this]() { return m_PendingJobs == 0; });
+}
+
+PipelineCacheStats PipelineCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// AsyncPipelineState
+///-------------------------------------------------------------------------------------------------
+AsyncPipelineState::AsyncPipelineState()
+    : m_pPipelineState(SG_NULL)
+    , m_Result(SG_OK)
+    , m_IsReady(false)
+{
+}
+
+AsyncPipelineState::~AsyncPipelineState()
+{
+    SG_RELEASE(m_pPipelineState);
+}
+
+void AsyncPipelineState::Complete(SG_RESULT result, ISGPipelineState* pPipelineState)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Result = result;
+        m_pPipelineState = pPipelineState;
+        m_IsReady = true;
+    }
+
+    m_Ready.notify_all();
+}
+
+SG_RESULT AsyncPipelineState::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Ready.wait(lock, [this]() { return m_IsReady.load(); });
+    return m_Result;
+}
+
+SG_RESULT AsyncPipelineState::GetResult() const
+{
+    return m_IsReady ? m_Result : SG_ERROR_NOT_FOUND;
+}
+
+ISGPipelineState* AsyncPipelineState::Get() const
+{
+    return m_IsReady ? m_pPipelineState : SG_NULL;
+}
+
+bool SetAsyncPipelineState(ISGCommandList* pCommandList, AsyncPipelineState const* pAsyncState, ISGPipelineState* pFallback)
+{
+    ISGPipelineState* pPipelineState = pAsyncState != SG_NULL ? pAsyncState->Get() : SG_NULL;
+
+    if (pPipelineState == SG_NULL)
+        pPipelineState = pFallback;
+
+    if (pPipelineState == SG_NULL)
+        return false;
+
+    pCommandList->SetPipelineState(pPipelineState);
+    return true;
+}
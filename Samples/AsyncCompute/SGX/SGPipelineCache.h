@@ -0,0 +1,172 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "SGHelpers.h"
+#include "SGThreadPool.h"
+
+///-------------------------------------------------------------------------------------------------
+/// Pipeline state cache
+///
+/// Deduplicates pipeline states by a hash of their shader bytecode and root signature description
+/// and keeps the descriptions to be serialized into a file. Loading the file on the next launch
+/// queues every recorded pipeline state to the thread pool (prewarming), so later Create* calls
+/// are hits. A Create* call for a description which is being prewarmed waits for it, if the
+/// prewarm job hasn't started yet the call takes it over and compiles the description itself.
+/// Create*Async jobs may run on the pool the prewarm jobs are queued to, so a queued job is never
+/// waited for.
+///
+/// Input layouts are opaque objects, create them through the cache to make graphics pipeline
+/// states that use them persistent. A pipeline state with a layout unknown to the cache is keyed
+/// by the layout object, which the cache references for as long as the entry exists.
+///
+/// Create*Async variants return immediately with a pending pipeline state, compilation is done by
+/// the thread pool. A pending pipeline state is never bound: SetAsyncPipelineState either uses
+/// a fallback pipeline state or reports that the draw must be skipped.
+///-------------------------------------------------------------------------------------------------
+
+class AsyncPipelineState
+{
+public:
+    AsyncPipelineState();
+    ~AsyncPipelineState();
+
+    AsyncPipelineState(AsyncPipelineState const&) = delete;
+    AsyncPipelineState& operator=(AsyncPipelineState const&) = delete;
+
+    bool                IsReady() const { return m_IsReady; }
+
+    // Blocks until the compilation is done, returns its result
+    SG_RESULT           Wait();
+
+    // SG_ERROR_NOT_FOUND while pending
+    SG_RESULT           GetResult() const;
+
+    // nullptr while pending or if the compilation failed, the reference is kept by the object
+    ISGPipelineState*   Get() const;
+
+    void                Complete(SG_RESULT result, ISGPipelineState* pPipelineState);
+
+private:
+    ISGPipelineState*       m_pPipelineState;
+    SG_RESULT               m_Result;
+    std::atomic<bool>       m_IsReady;
+    std::mutex              m_Mutex;
+    std::condition_variable m_Ready;
+};
+
+typedef std::shared_ptr<AsyncPipelineState> AsyncPipelineStatePtr;
+
+// Sets the pipeline state if it's ready, otherwise sets pFallback (optional).
+// Returns false if nothing has been set, the following draw or dispatch must be skipped.
+bool SetAsyncPipelineState(ISGCommandList* pCommandList, AsyncPipelineState const* pAsyncState, ISGPipelineState* pFallback);
+
+struct PipelineCacheStats
+{
+    U32 Hits;
+    U32 Misses;
+    U32 Prewarmed;      // Pipeline states created by LoadFromFile
+    U32 LoadFailures;   // Entries of the file that couldn't be created (e.g. unsupported on the current adapter)
+    U32 Entries;
+};
+
+class PipelineCache
+{
+public:
+    PipelineCache(ISGDevice* pDevice);
+    ~PipelineCache();
+
+    PipelineCache(PipelineCache const&) = delete;
+    PipelineCache& operator=(PipelineCache const&) = delete;
+
+    // Same semantics as ISGDevice methods, the returned object is owned by the caller
+    SG_RESULT   CreateInputLayout(U32 numElements, SG_INPUT_ELEMENT_DESC const* pInputElements, ISGInputLayout** ppInputLayout);
+    SG_RESULT   CreateGraphicsPipelineState(SG_GRAPHICS_PIPELINE_STATE_DESC const* pDesc, ISGPipelineState** ppPipelineState);
+    SG_RESULT   CreateMeshPipelineState(SG_MESH_PIPELINE_STATE_DESC const* pDesc, ISGPipelineState** ppPipelineState);
+    SG_RESULT   CreateComputePipelineState(SG_COMPUTE_PIPELINE_STATE_DESC const* pDesc, ISGPipelineState** ppPipelineState);
+    SG_RESULT   CreateRaytracingPipelineState(SG_RAYTRACING_PIPELINE_DESC const* pDesc, ISGPipelineState** ppPipelineState);
+
+    // Non-blocking variants, the description is copied before returning
+    AsyncPipelineStatePtr CreateGraphicsPipelineStateAsync(SG_GRAPHICS_PIPELINE_STATE_DESC const* pDesc, ThreadPool& threadPool);
+    AsyncPipelineStatePtr CreateMeshPipelineStateAsync(SG_MESH_PIPELINE_STATE_DESC const* pDesc, ThreadPool& threadPool);
+    AsyncPipelineStatePtr CreateComputePipelineStateAsync(SG_COMPUTE_PIPELINE_STATE_DESC const* pDesc, ThreadPool& threadPool);
+    AsyncPipelineStatePtr CreateRaytracingPipelineStateAsync(SG_RAYTRACING_PIPELINE_DESC const* pDesc, ThreadPool& threadPool);
+
+    // Waits for every asynchronous compilation, is also called by the destructor
+    void        WaitForPendingJobs();
+
+    // Loads recorded descriptions and queues their pipeline states to the thread pool, returns once the
+    // file is read. Returns false if the file is missing or corrupted, entries before the damage are queued.
+    bool        LoadFromFile(char const* pFileName, ThreadPool& threadPool);
+    bool        SaveToFile(char const* pFileName) const;
+
+    PipelineCacheStats GetStats() const;
+
+    // Hash of a serialized description, is used as the cache key
+    static U64  ComputeHash(void const* pData, size_t sizeBytes);
+
+private:
+    struct Entry
+    {
+        SG_PIPELINE_STATE_TYPE  Type;
+        ByteBuffer              Blob;           // Serialized description
+        bool                    Persistent;     // False if it references an input layout unknown to the cache
+        ISGInputLayout*         pInputLayout;   // Layout unknown to the cache, the blob keys on its address
+        ISGPipelineState*       pPipelineState;
+    };
+
+    struct InputLayoutEntry
+    {
+        ByteBuffer              Blob;
+        ISGInputLayout*         pInputLayout;
+    };
+
+    // Description queued by LoadFromFile
+    struct PrewarmJob
+    {
+        SG_PIPELINE_STATE_TYPE  Type;
+        ByteBuffer              Blob;
+        bool                    IsRunning;      // A queued job may be taken over by a Create* call
+    };
+
+    typedef std::shared_ptr<PrewarmJob> PrewarmJobPtr;
+
+    // Return false if the description can't be restored from a file
+    bool        Serialize(SG_GRAPHICS_PIPELINE_STATE_DESC const& desc, ByteBuffer& blob);
+    bool        Serialize(SG_MESH_PIPELINE_STATE_DESC const& desc, ByteBuffer& blob);
+    bool        Serialize(SG_COMPUTE_PIPELINE_STATE_DESC const& desc, ByteBuffer& blob);
+    bool        Serialize(SG_RAYTRACING_PIPELINE_DESC const& desc, ByteBuffer& blob);
+
+    template <typename TDesc>
+    AsyncPipelineStatePtr CreateAsync(SG_PIPELINE_STATE_TYPE type, TDesc const* pDesc, ISGInputLayout* pInputLayout, ThreadPool& threadPool);
+
+    SG_RESULT   FindOrCreate(SG_PIPELINE_STATE_TYPE type, ByteBuffer&& blob, ISGInputLayout* pOpaqueLayout, ISGPipelineState** ppPipelineState, bool prewarm);
+    SG_RESULT   CreateFromBlob(SG_PIPELINE_STATE_TYPE type, ByteBuffer const& blob, bool persistent, ISGPipelineState** ppPipelineState);
+
+    ISGDevice*                                      m_pDevice;
+    std::unordered_multimap<U64, Entry>             m_Entries;
+    std::unordered_multimap<U64, InputLayoutEntry>  m_InputLayouts;
+    std::unordered_map<ISGInputLayout*, U64>        m_InputLayoutKeys;
+    mutable std::mutex                              m_Mutex;
+    std::condition_variable                         m_NoPendingJobs;
+    U32                                             m_PendingJobs;
+
+    // Prewarm jobs which are queued or running, by key
+    std::unordered_multimap<U64, PrewarmJobPtr>     m_PrewarmJobs;
+    std::condition_variable                         m_PrewarmDone;
+    PipelineCacheStats                              m_Stats;
+};
@@ -11,11 +11,14 @@
 //*********************************************************
 
 #include "SGSample.h"
+#include "SGNullDevice.h"
 
 void CreateForm(ISGSample* pSample, HWND* pHwnd);
 
 ISGSample::ISGSample(U32 width, U32 height, wchar_t const* windowName)
-    : m_hWnd(NULL)
+    : m_Headless(false)
+    , m_pHeadlessDevice(nullptr)
+    , m_hWnd(NULL)
     , m_Width(width)
     , m_Height(height)
     , m_Name(windowName)
@@ -49,8 +52,47 @@ int ISGSample::Run(int nCmdShow, SG_DEBUG_LEVELS debugLevel, SG_DEBUG_TOOLS debu
     return static_cast<int>(msg.wParam);
 }
 
+int ISGSample::RunHeadless(U32 frameCount)
+{
+    m_Headless = true;
+
+    OnInit();
+
+    if (m_pHeadlessDevice == nullptr)
+        throw std::exception("Headless sample must create its device by ISGSample::CreateDevice");
+
+    int exitCode = 0;
+    for (U32 frame = 0; frame < frameCount; frame++)
+    {
+        OnUpdate();
+        OnRender();
+
+        ISGExecutionContext* pExecutionContext = nullptr;
+        m_pHeadlessDevice->GetExecutionContext(&pExecutionContext);
+
+        NullFrameRecord const* pRecord = nullptr;
+        if (GetNullFrameRecord(pExecutionContext, &pRecord) == SG_OK)
+        {
+            NullFrameStats const& stats = pRecord->Stats;
+            std::cout << "Frame " << stats.FrameNumber << ": " << stats.CommandLists << " lists, "
+                << stats.Commands << " commands, " << stats.StreamBytes << " bytes" << std::endl;
+
+            if (stats.CommandLists == 0)
+                exitCode = 1;
+        }
+        pExecutionContext->Release();
+    }
+
+    OnDestroy();
+
+    return exitCode;
+}
+
 SG_RESULT ISGSample::GetVideoAdapter(ISGAdapter** ppAdapter)
 {
+    if (m_Headless)
+        return CreateNullAdapter(ppAdapter);
+
     U32 index = 0;
     ISGAdapter* pCandidate = nullptr;
 
@@ -63,6 +105,29 @@ SG_RESULT ISGSample::GetVideoAdapter(ISGAdapter** ppAdapter)
     return SG_ERROR_INTERNAL;
 }
 
+SG_RESULT ISGSample::CreateDevice(ISGAdapter* pAdapter, SG_DEVICE_DESC const* pDesc, ISGDevice** ppDevice)
+{
+    if (!m_Headless)
+        return SgCreateDevice(pAdapter, pDesc, ppDevice);
+
+    SG_RESULT result = CreateNullDevice(pAdapter, pDesc, ppDevice);
+    m_pHeadlessDevice = result == SG_OK ? *ppDevice : nullptr;
+    return result;
+}
+
+SG_RESULT ISGSample::CreateSwapChain(ISGExecutionContext* pExecutionContext, SgU8 queueIndex, SG_SWAP_CHAIN_DESC const* pDesc, ISGSwapChain** ppSwapChain)
+{
+    if (!m_Headless)
+        return SgCreateSwapChain(pExecutionContext, queueIndex, pDesc, ppSwapChain);
+
+    // There is no window to take the size from
+    SG_SWAP_CHAIN_DESC desc = *pDesc;
+    desc.Width = desc.Width != 0 ? desc.Width : m_Width;
+    desc.Height = desc.Height != 0 ? desc.Height : m_Height;
+
+    return CreateNullSwapChain(pExecutionContext, queueIndex, &desc, ppSwapChain);
+}
+
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
     ISGSample* pSample = reinterpret_cast<ISGSample*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
@@ -0,0 +1,148 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include "SGHelpers.h"
+
+///-------------------------------------------------------------------------------------------------
+/// Batched upload manager
+///
+/// Collects uploads to common resources into a batch: buffer data is suballocated from large
+/// staging pages and textures get a staging texture from a pool. Submit records the whole batch
+/// into a single command list with one copy per upload.
+///
+/// The library has no fences, so a batch is known to have landed when the frame buffer it was
+/// submitted in is begun again. Staging memory of landed batches is reused by later batches.
+/// Lists scheduled at later time indices of the same frame may consume the data right away.
+///-------------------------------------------------------------------------------------------------
+
+// 0 is never used by a submitted batch and is always complete
+typedef U64 UploadBatchId;
+
+struct UploadManagerStats
+{
+    U64 PendingBytes;       // Queued, not submitted yet
+    U64 InFlightBytes;      // Submitted, not landed yet
+    U32 Pages;              // Staging pages, both pooled and in use
+    U32 StagingTextures;    // Staging textures, both pooled and in use
+    U32 SubmittedBatches;
+};
+
+class UploadManager
+{
+public:
+    static const U32 DefaultPageSize = 16 << 20;
+
+    UploadManager();
+    ~UploadManager();
+
+    UploadManager(UploadManager const&) = delete;
+    UploadManager& operator=(UploadManager const&) = delete;
+
+    // frameBuffers must match SG_EXECUTION_CONTEXT_DESC::FrameBuffers
+    void            Init(ISGDevice* pDevice, U32 frameBuffers, U32 pageSize = DefaultPageSize);
+
+    // Execution context must be idle
+    void            Destroy();
+
+    // Call right after ISGExecutionContext::BeginFrame, retires landed batches
+    void            BeginFrame();
+
+    // Call after ISGExecutionContext::WaitForIdle, retires every submitted batch
+    void            OnIdle();
+
+    // Data is copied before returning, the copying itself isn't serialized between threads. Thread-safe.
+    void            QueueBufferUpload(ISGBuffer* pDestBuffer, U64 destOffset, void const* pSrcData, U32 dataSize);
+    void            QueueTextureUpload(ISGTexture* pDestTexture, ImageDesc const& sourceImage, ByteBuffer const& bitmap);
+
+    // Returns staging memory for the caller to fill, e.g. to decode data straight into it. Thread-safe.
+    void*           AllocateBufferUpload(ISGBuffer* pDestBuffer, U64 destOffset, U32 dataSize);
+
+    // Records queued uploads into the command list. If nothing is queued, nothing is recorded and the id of
+    // the last submitted batch is returned (0 before the first one), so waiting for it waits for every upload so far.
+    // Must not run concurrently with Queue* and AllocateBufferUpload calls, allocated memory must be filled already.
+    UploadBatchId   Submit(ISGCommandList* pCommandList);
+
+    // Schedules a command list for the batch. If nothing is queued, no list is scheduled and the id of the last
+    // submitted batch is returned like above. Returns 0 if scheduling failed.
+    UploadBatchId   Submit(ISGExecutionContext* pExecutionContext, SgU8 queueIndex, SgU16 timeIndex);
+
+    bool            IsComplete(UploadBatchId batchId) const;
+    UploadBatchId   GetLastCompletedBatch() const;
+
+    UploadManagerStats GetStats() const;
+
+private:
+    struct Page
+    {
+        ISGBuffer*  pBuffer;
+        U8*         pData;
+        U32         Size;
+    };
+
+    struct StagingTexture
+    {
+        ISGTexture*     pTexture;
+        SG_TEXTURE_DESC Desc;
+    };
+
+    struct BufferCopy
+    {
+        ISGBuffer*  pDestBuffer;
+        U64         DestOffset;
+        ISGBuffer*  pSrcBuffer;
+        U32         SrcOffset;
+        U32         Size;
+    };
+
+    struct TextureCopy
+    {
+        ISGTexture* pDestTexture;
+        ISGTexture* pSrcTexture;
+    };
+
+    struct Batch
+    {
+        UploadBatchId               Id;
+        U64                         FrameNumber;
+        U64                         Bytes;
+        std::vector<Page>           Pages;
+        std::vector<StagingTexture> StagingTextures;
+    };
+
+    U8*             AllocateStaging(U32 sizeBytes, ISGBuffer** ppBuffer, U32* pOffset);
+    StagingTexture  AcquireStagingTexture(SG_TEXTURE_DESC const& destDesc);
+    void            Retire(Batch& batch);
+    void            ReleaseCopies();
+
+    ISGDevice*                  m_pDevice;
+    U32                         m_FrameBuffers;
+    U32                         m_PageSize;
+    U64                         m_FrameNumber;
+
+    // Batch being recorded
+    std::vector<Page>           m_Pages;
+    U32                         m_CurrentOffset;
+    std::vector<StagingTexture> m_StagingTextures;
+    std::vector<BufferCopy>     m_BufferCopies;
+    std::vector<TextureCopy>    m_TextureCopies;
+    U64                         m_PendingBytes;
+
+    std::deque<Batch>           m_InFlight;
+    std::vector<Page>           m_FreePages;
+    std::vector<StagingTexture> m_FreeStagingTextures;
+    UploadBatchId               m_LastSubmitted;
+    UploadBatchId               m_LastCompleted;
+    mutable std::mutex          m_Mutex;
+};
@@ -0,0 +1,672 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "HelperChecks.h"
+#include "SGX/SGBindlessTable.h"
+#include "SGX/SGBufferHeap.h"
+#include "SGX/SGMipStreamer.h"
+#include "SGX/SGNullDevice.h"
+#include "SGX/SGParallelRecording.h"
+#include "SGX/SGPipelineCache.h"
+#include "SGX/SGResidency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    bool Report(char const* pCheck, bool passed)
+    {
+        std::cout << (passed ? "  passed: " : "  FAILED: ") << pCheck << std::endl;
+        return passed;
+    }
+
+    // Null device with a single graphics queue
+    struct NullDevice
+    {
+        static const U32 FrameBuffers = 2;
+
+        ISGAdapter*             pAdapter = SG_NULL;
+        ISGDevice*              pDevice = SG_NULL;
+        ISGExecutionContext*    pExecutionContext = SG_NULL;
+
+        // localBudgetLimit simulates a small video memory budget, 0 keeps the default one
+        explicit NullDevice(U64 localBudgetLimit = 0)
+        {
+            SG_EXECUTION_CONTEXT_DESC contextDesc = {};
+            contextDesc.FrameBuffers = FrameBuffers;
+            contextDesc.QueueCount = 1;
+            contextDesc.QueueTypes[0] = SG_QUEUE_TYPE_GRAPHICS;
+
+            SG_MEMORY_DEBUG_CONFIG memoryConfig = {};
+            memoryConfig.LocalBudgetLimit = localBudgetLimit;
+
+            SG_DEVICE_DESC deviceDesc = {};
+            deviceDesc.pExecutionContextDesc = &contextDesc;
+            deviceDesc.pMemoryDebugConfig = localBudgetLimit != 0 ? &memoryConfig : nullptr;
+
+            if (CreateNullAdapter(&pAdapter) == SG_OK && CreateNullDevice(pAdapter, &deviceDesc, &pDevice) == SG_OK)
+                pDevice->GetExecutionContext(&pExecutionContext);
+        }
+
+        ~NullDevice()
+        {
+            if (pExecutionContext != SG_NULL)
+                pExecutionContext->WaitForIdle();
+
+            SG_RELEASE(pExecutionContext);
+            SG_RELEASE(pDevice);
+            SG_RELEASE(pAdapter);
+        }
+
+        NullDevice(NullDevice const&) = delete;
+        NullDevice& operator=(NullDevice const&) = delete;
+
+        bool IsValid() const { return pExecutionContext != SG_NULL; }
+
+        // Begins a frame, records a single graphics list and ends the frame
+        template <typename TRecord>
+        void RunFrame(TRecord record)
+        {
+            pExecutionContext->BeginFrame();
+
+            ISGCommandList* pCommandList = nullptr;
+            if (pExecutionContext->ScheduleCommandList(0, 1, &pCommandList) == SG_OK)
+            {
+                record(pCommandList);
+                pExecutionContext->FinishCommandList(pCommandList);
+            }
+
+            pExecutionContext->EndFrame1(0, nullptr);
+        }
+    };
+}
+
+bool CheckMipStreamer()
+{
+    std::cout << "MipStreamer" << std::endl;
+
+    NullDevice device;
+    if (!Report("null device", device.IsValid()))
+        return false;
+
+    const U32 dropFrames = 3;
+    MipStreamer streamer;
+    streamer.Init(device.pDevice, NullDevice::FrameBuffers, 1 << 20, 64, dropFrames);
+
+    SG_TEXTURE_DESC desc = {};
+    desc.Type = SG_TEXTURE_TYPE_COMMON;
+    desc.BindFlags = SG_TEXTURE_BIND_FLAG_SHADER_RESOURCE;
+    desc.Dimension = SG_TEXTURE_DIMENSION_2D;
+    desc.Format = SG_FORMAT_R8G8B8A8_UNORM;
+    desc.Width = desc.Height = 2048;
+    desc.DepthOrArraySize = 1;
+    desc.MipLevels = 12;
+
+    StreamedTextureHandle handle = streamer.Register(desc, [](U32 mip, SG_MAPPED_SUBRESOURCE const& dest)
+    {
+        std::memset(dest.pData, static_cast<int>(mip), static_cast<size_t>(dest.RowPitch));
+    });
+
+    // The texture covers screenPixels across. The level of detail the shader gets is relative to the resident
+    // texture, whose mip 0 is GetResidentMip, and the shader adds the resident mip to report one of the full chain.
+    auto runFrames = [&](U32 screenPixels, U32 frameCount, U32& finestMip)
+    {
+        for (U32 frame = 0; frame < frameCount; ++frame)
+        {
+            device.RunFrame([&](ISGCommandList* pCommandList)
+            {
+                if (streamer.GetTexture(handle) != SG_NULL)
+                {
+                    U32 residentMip = streamer.GetResidentMip(handle);
+                    float lod = log2f(static_cast<float>(desc.Width >> residentMip) / screenPixels) + residentMip;
+                    U32 feedback = static_cast<U32>((std::max)(lod, 0.0f));
+                    streamer.ProcessFeedback(&feedback, 1);
+                }
+
+                streamer.Update(pCommandList);
+            });
+
+            finestMip = (std::min)(finestMip, streamer.GetResidentMip(handle));
+        }
+    };
+
+    bool passed = true;
+
+    // 256 pixels across need mip 3 of 2048 texels
+    U32 finestMip = UINT32_MAX;
+    runFrames(256, 8, finestMip);
+    std::cout << "  256 pixels: resident mip " << streamer.GetResidentMip(handle) << ", finest " << finestMip << std::endl;
+    passed &= Report("streams down to the needed mip and no further", streamer.GetResidentMip(handle) == 3 && finestMip == 3);
+
+    // Closer, 1024 pixels need mip 1
+    finestMip = UINT32_MAX;
+    runFrames(1024, 8, finestMip);
+    std::cout << "  1024 pixels: resident mip " << streamer.GetResidentMip(handle) << ", finest " << finestMip << std::endl;
+    passed &= Report("streams finer mips when the view comes closer", streamer.GetResidentMip(handle) == 1 && finestMip == 1);
+
+    // Away, 128 pixels need mip 4, finer ones are dropped one per frame after dropFrames
+    finestMip = UINT32_MAX;
+    runFrames(128, dropFrames + 8, finestMip);
+    std::cout << "  128 pixels: resident mip " << streamer.GetResidentMip(handle) << std::endl;
+    passed &= Report("drops mips the view no longer needs", streamer.GetResidentMip(handle) == 4);
+
+    streamer.Unregister(handle);
+    device.pExecutionContext->WaitForIdle();
+    streamer.Destroy();
+
+    return passed;
+}
+
+bool CheckAsyncPipelines()
+{
+    std::cout << "PipelineCache::Create*Async" << std::endl;
+
+    NullDevice device;
+    if (!Report("null device", device.IsValid()))
+        return false;
+
+    // A single worker, a blocking job keeps the following jobs queued until it's released
+    ThreadPool threadPool(1);
+
+    auto blockPool = [&threadPool]()
+    {
+        std::shared_ptr<std::promise<void>> pRelease = std::make_shared<std::promise<void>>();
+        std::shared_future<void> released = pRelease->get_future().share();
+        threadPool.Submit([released]() { released.wait(); });
+        return pRelease;
+    };
+
+    static const char c_ByteCode[] = "compute shader";
+
+    SG_COMPUTE_PIPELINE_STATE_DESC desc = {};
+    desc.CS.pData = const_cast<char*>(c_ByteCode);
+    desc.CS.SizeBytes = sizeof(c_ByteCode);
+
+    char const* pCacheFile = "HelperChecks.sgpc";
+    bool passed = true;
+
+    {
+        PipelineCache cache(device.pDevice);
+
+        std::shared_ptr<std::promise<void>> pRelease = blockPool();
+        AsyncPipelineStatePtr pPending = cache.CreateComputePipelineStateAsync(&desc, threadPool);
+        AsyncPipelineStatePtr pInvalid = cache.CreateComputePipelineStateAsync(nullptr, threadPool);
+
+        ISGPipelineState* pFallback = SG_NULL;
+        SG_COMPUTE_PIPELINE_STATE_DESC fallbackDesc = desc;
+        fallbackDesc.CS.SizeBytes--;
+        device.pDevice->CreateComputePipelineState(&fallbackDesc, &pFallback);
+
+        bool skipped = false;
+        bool fellBack = false;
+        device.RunFrame([&](ISGCommandList* pCommandList)
+        {
+            skipped = !SetAsyncPipelineState(pCommandList, pPending.get(), SG_NULL);
+            fellBack = SetAsyncPipelineState(pCommandList, pPending.get(), pFallback);
+        });
+
+        passed &= Report("a pending pipeline state is never bound", !pPending->IsReady() && pPending->GetResult() == SG_ERROR_NOT_FOUND && skipped && fellBack);
+        passed &= Report("an invalid description fails without a job", pInvalid->IsReady() && pInvalid->GetResult() == SG_ERROR_INVALID_ARG);
+
+        pRelease->set_value();
+        AsyncPipelineStatePtr pSecond = cache.CreateComputePipelineStateAsync(&desc, threadPool);
+
+        bool const compiled = pPending->Wait() == SG_OK && pSecond->Wait() == SG_OK && pPending->Get() != SG_NULL;
+        PipelineCacheStats stats = cache.GetStats();
+        passed &= Report("asynchronous compilations are shared by the cache", compiled && pSecond->Get() == pPending->Get() && stats.Misses == 1 && stats.Hits == 1);
+
+        cache.SaveToFile(pCacheFile);
+        SG_RELEASE(pFallback);
+    }
+
+    {
+        // The prewarm job is queued behind an asynchronous job for the same description on the only worker:
+        // the asynchronous job takes it over instead of waiting for it
+        PipelineCache cache(device.pDevice);
+
+        std::shared_ptr<std::promise<void>> pRelease = blockPool();
+        AsyncPipelineStatePtr pPending = cache.CreateComputePipelineStateAsync(&desc, threadPool);
+        bool const loaded = cache.LoadFromFile(pCacheFile, threadPool);
+        pRelease->set_value();
+
+        bool const compiled = pPending->Wait() == SG_OK;
+        cache.WaitForPendingJobs();
+
+        PipelineCacheStats stats = cache.GetStats();
+        passed &= Report("a queued prewarm job is taken over", loaded && compiled && stats.Misses == 1 && stats.Prewarmed == 0 && stats.Entries == 1);
+    }
+
+    std::remove(pCacheFile);
+    return passed;
+}
+
+bool CheckCommandListGroup(ThreadPool& threadPool)
+{
+    std::cout << "RecordCommandListGroup" << std::endl;
+
+    NullDevice device;
+    if (!Report("null device", device.IsValid()))
+        return false;
+
+    ISGExecutionContext* pExecutionContext = device.pExecutionContext;
+    NullFrameRecord const* pRecord = SG_NULL;
+
+    const SgU16 numLists = 8;
+    const SgU32 drawCount = 1000;
+    bool passed = true;
+
+    // Every sub-list sets its stencil reference in the prologue and draws its range of the items
+    pExecutionContext->BeginFrame();
+
+    SgU16 nextTimeIndex = RecordCommandListGroup(pExecutionContext, threadPool, 0, 1, numLists,
+        [](ISGCommandList* pCommandList, SgU32 listIndex)
+        {
+            pCommandList->SetStencilRef(static_cast<SgU8>(listIndex));
+        },
+        [](ISGCommandList* pCommandList, SgU32 listIndex)
+        {
+            SgU32 first = 0;
+            SgU32 count = 0;
+            GetCommandListGroupRange(drawCount, numLists, listIndex, &first, &count);
+
+            for (SgU32 i = first; i < first + count; ++i)
+                pCommandList->DrawInstanced(3, 1, i, 0);
+        });
+
+    pExecutionContext->EndFrame1(0, nullptr);
+    GetNullFrameRecord(pExecutionContext, &pRecord);
+
+    passed &= Report("the next free time index follows the group", nextTimeIndex == 1 + numLists);
+
+    // In the execution order, sub-lists start with their prologue and draw the items in order
+    bool ordered = pRecord->Lists.size() == numLists;
+    SgU32 nextDraw = 0;
+
+    for (size_t listIndex = 0; ordered && listIndex < pRecord->Lists.size(); ++listIndex)
+    {
+        NullScheduledList const& list = pRecord->Lists[listIndex];
+        NullCommand const* pCommand = list.pStream->First();
+
+        ordered = list.TimeIndex == 1 + listIndex && pCommand != SG_NULL && pCommand->Type == NullCommandType::SetStencilRef &&
+            pCommand->GetArg<SgU32>(0) == listIndex;
+
+        for (pCommand = ordered ? list.pStream->Next(pCommand) : SG_NULL; pCommand != SG_NULL; pCommand = list.pStream->Next(pCommand))
+        {
+            ordered &= pCommand->Type == NullCommandType::DrawInstanced && pCommand->GetArg<SgU32>(2) == nextDraw;
+            nextDraw++;
+        }
+    }
+
+    passed &= Report("sub-lists execute in the group order with their prologue", ordered && nextDraw == drawCount);
+
+    // Time index 0 and a group running past the last time index are rejected, no list stays scheduled
+    pExecutionContext->BeginFrame();
+
+    auto recordNothing = [](ISGCommandList*, SgU32) {};
+    SgU16 zeroResult = RecordCommandListGroup(pExecutionContext, threadPool, 0, 0, 2, nullptr, recordNothing);
+    SgU16 overflowResult = RecordCommandListGroup(pExecutionContext, threadPool, 0, 65520, 2, nullptr, recordNothing);
+
+    pExecutionContext->EndFrame1(0, nullptr);
+    GetNullFrameRecord(pExecutionContext, &pRecord);
+
+    passed &= Report("invalid groups fail without scheduling lists", zeroResult == 0 && overflowResult == 0 && pRecord->Lists.empty());
+
+    return passed;
+}
+
+bool CheckResidency()
+{
+    std::cout << "ResidencyManager" << std::endl;
+
+    // Eviction starts above 9 MB of the 10 MB budget and goes down to 7 MB
+    const U32 resourceSize = 2 << 20;
+    NullDevice device(10 << 20);
+    if (!Report("null device", device.IsValid()))
+        return false;
+
+    ResidencyManager residency;
+    residency.Init(device.pDevice, NullDevice::FrameBuffers, 0.9f, 0.2f, 3);
+
+    const U32 resourceCount = 5;
+    ISGBuffer* buffers[resourceCount] = {};
+    ResidencyHandle handles[resourceCount];
+    std::fill(handles, handles + resourceCount, InvalidResidencyHandle);
+    U32 evictCalls = 0;
+
+    // The first resource has a high priority, normal ones are evicted before it
+    auto registerResource = [&](U32 index)
+    {
+        handles[index] = residency.Register(resourceSize, index == 0 ? ResidencyPriority::High : ResidencyPriority::Normal,
+            [&, index]()
+            {
+                SG_BUFFER_DESC desc = FastBufferDesc::Structured(resourceSize, true, false, false);
+                device.pDevice->CreateBuffer(&desc, &buffers[index]);
+            },
+            [&, index]()
+            {
+                SG_RELEASE(buffers[index]);
+                evictCalls++;
+            });
+    };
+
+    auto runFrames = [&](U32 frameCount, U32 firstUsed, U32 usedCount)
+    {
+        for (U32 frame = 0; frame < frameCount; ++frame)
+        {
+            device.RunFrame([&](ISGCommandList*)
+            {
+                residency.BeginFrame();
+
+                for (U32 i = firstUsed; i < firstUsed + usedCount; ++i)
+                    residency.MakeResident(handles[i]);
+            });
+        }
+    };
+
+    auto countResident = [&]()
+    {
+        U32 count = 0;
+        for (ResidencyHandle handle : handles)
+            count += residency.IsResident(handle) ? 1 : 0;
+
+        return count;
+    };
+
+    bool passed = true;
+
+    // 8 MB are below the target
+    for (U32 i = 0; i < resourceCount - 1; ++i)
+        registerResource(i);
+
+    runFrames(4, 0, resourceCount - 1);
+    passed &= Report("nothing is evicted below the target", residency.GetStats().Evictions == 0 && countResident() == resourceCount - 1);
+
+    // 10 MB are over the target, but every resource is used by the frame
+    registerResource(resourceCount - 1);
+    runFrames(2, 0, resourceCount);
+
+    ResidencyStats stats = residency.GetStats();
+    passed &= Report("resources in use are never evicted", stats.Evictions == 0 && stats.OverBudgetFrames != 0);
+
+    // Only the last one is used, the others are evicted once idle for 3 frames: two normal ones go down to 6 MB
+    runFrames(3, resourceCount - 1, 1);
+
+    stats = residency.GetStats();
+    std::cout << "  " << stats.Evictions << " evicted, " << (stats.ResidentBytes >> 20) << " MB resident" << std::endl;
+    passed &= Report("idle resources are evicted down to the lower mark", stats.Evictions == 2 && evictCalls == 2 &&
+        stats.ResidentBytes <= (7u << 20) && residency.IsResident(handles[0]) && residency.IsResident(handles[resourceCount - 1]));
+
+    // Restoring an evicted resource takes the usage back to 8 MB, between the marks, which doesn't start another eviction
+    U32 evicted = 1;
+    while (residency.IsResident(handles[evicted]))
+        evicted++;
+
+    bool const restored = !residency.MakeResident(handles[evicted]) && residency.IsResident(handles[evicted]) && buffers[evicted] != SG_NULL;
+    runFrames(6, resourceCount - 1, 1);
+
+    stats = residency.GetStats();
+    passed &= Report("a restore doesn't start another eviction", restored && stats.Restores == 1 && stats.Evictions == 2 && countResident() == 4);
+
+    // Unregister evicts a resident resource, its handle is invalid then
+    U32 const callsBefore = evictCalls;
+    residency.Unregister(handles[0]);
+
+    bool threw = false;
+    try
+    {
+        residency.MakeResident(handles[0]);
+    }
+    catch (std::exception const&)
+    {
+        threw = true;
+    }
+
+    bool invalidThrew = false;
+    try
+    {
+        residency.MakeResident(InvalidResidencyHandle);
+    }
+    catch (std::exception const&)
+    {
+        invalidThrew = true;
+    }
+
+    passed &= Report("unregistered and invalid handles are rejected", evictCalls == callsBefore + 1 && buffers[0] == SG_NULL &&
+        !residency.IsResident(handles[0]) && !residency.IsResident(InvalidResidencyHandle) && threw && invalidThrew);
+
+    device.pExecutionContext->WaitForIdle();
+
+    for (U32 i = 1; i < resourceCount; ++i)
+        residency.Unregister(handles[i]);
+
+    residency.Destroy();
+    return passed;
+}
+
+bool CheckBindlessTable(ThreadPool& threadPool)
+{
+    std::cout << "BindlessTable" << std::endl;
+
+    NullDevice device;
+    if (!Report("null device", device.IsValid()))
+        return false;
+
+    // Views of 16-byte elements of one buffer, the last one is the fallback
+    const U32 viewCount = 65;
+    ISGBuffer* pBuffer = SG_NULL;
+    std::vector<ISGShaderResourceView*> views(viewCount, SG_NULL);
+
+    SG_BUFFER_DESC bufferDesc = FastBufferDesc::Structured(viewCount * 16, true, false, false);
+    device.pDevice->CreateBuffer(&bufferDesc, &pBuffer);
+
+    for (U32 i = 0; i < viewCount; ++i)
+    {
+        SG_SHADER_RESOURCE_VIEW_DESC viewDesc = FastViewDesc::AsStructuredBuffer(i, 1, 16);
+        device.pDevice->CreateShaderResourceView(pBuffer, &viewDesc, &views[i]);
+    }
+
+    ISGShaderResourceView* pFallback = views[viewCount - 1];
+
+    auto getRefCount = [](ISGShaderResourceView* pView)
+    {
+        pView->AddRef();
+        return pView->Release();
+    };
+
+    bool passed = true;
+
+    BindlessSRVTable table;
+    table.Init(4, pFallback);
+
+    SgU32 indices[5];
+    for (U32 i = 0; i < 5; ++i)
+        indices[i] = table.Register(views[i]);
+
+    passed &= Report("indices are given in order until the table is full", indices[0] == 0 && indices[1] == 1 && indices[2] == 2 &&
+        indices[3] == 3 && indices[4] == InvalidBindlessIndex && table.Register(views[1]) == 1);
+
+    // A freed index is given to the next view, and filled with the fallback until then
+    table.Unregister(views[1]);
+    bool const unregistered = table.GetBindlessIndex(views[1]) == InvalidBindlessIndex && getRefCount(views[1]) == 1;
+    bool const reused = table.Register(views[4]) == 1;
+    table.Unregister(views[2]);
+
+    passed &= Report("freed indices are reused", unregistered && reused && table.GetCount() == 4);
+
+    NullFrameRecord const* pRecord = SG_NULL;
+    device.RunFrame([&](ISGCommandList* pCommandList)
+    {
+        table.Bind(pCommandList, 2);
+    });
+    GetNullFrameRecord(device.pExecutionContext, &pRecord);
+
+    ISGShaderResourceView* const expected[4] = { views[0], views[4], pFallback, views[3] };
+    NullCommand const* pCommand = pRecord->Lists.size() == 1 ? pRecord->Lists[0].pStream->First() : SG_NULL;
+
+    passed &= Report("Bind writes the table with one ranged call", pCommand != SG_NULL && pCommand->Type == NullCommandType::SetShaderResources &&
+        pCommand->GetArg<SgU32>(0) == 2 && pCommand->GetArg<SgU32>(1) == 0 && pCommand->GetArg<SgU32>(2) == 4 &&
+        memcmp(pCommand->GetData(), expected, sizeof(expected)) == 0 && pRecord->Lists[0].pStream->Next(pCommand) == SG_NULL);
+
+    // Init starts over with an empty table, views registered concurrently get distinct indices
+    const U32 capacity = viewCount - 1;
+    table.Init(capacity, pFallback);
+
+    std::vector<SgU32> concurrentIndices(capacity, InvalidBindlessIndex);
+    threadPool.ParallelFor(capacity, [&](SgU32 i)
+    {
+        concurrentIndices[i] = table.Register(views[i]);
+    });
+
+    std::vector<bool> taken(capacity, false);
+    bool distinct = table.GetCount() == capacity;
+
+    for (SgU32 index : concurrentIndices)
+    {
+        distinct &= index < capacity && !taken[index];
+        if (distinct)
+            taken[index] = true;
+    }
+
+    passed &= Report("Init resets the table, concurrent registers get distinct indices", distinct);
+
+    table.Destroy();
+
+    bool released = true;
+    for (ISGShaderResourceView* pView : views)
+        released &= getRefCount(pView) == 1;
+
+    passed &= Report("Destroy releases the views", released);
+
+    for (ISGShaderResourceView*& pView : views)
+        SG_RELEASE(pView);
+
+    SG_RELEASE(pBuffer);
+    return passed;
+}
+
+bool CheckBufferHeap()
+{
+    std::cout << "BufferHeap" << std::endl;
+
+    NullDevice device;
+    if (!Report("null device", device.IsValid()))
+        return false;
+
+    // 8 allocations of 500 bytes fill a 4 KB page
+    const U32 pageSize = 4096;
+    const U32 allocationSize = 500;
+    const U32 allocationCount = 16;
+
+    BufferHeap heap;
+    heap.Init(device.pDevice, NullDevice::FrameBuffers, FastBufferDesc::Structured(0, true, false, false), pageSize);
+
+    std::vector<BufferAllocation> allocations(allocationCount);
+    U32 moves = 0;
+
+    for (U32 i = 0; i < allocationCount; ++i)
+    {
+        allocations[i] = heap.AllocateMovable(allocationSize, 4, [&, i](BufferAllocation const& moved)
+        {
+            allocations[i] = moved;
+            moves++;
+        });
+    }
+
+    U32 const firstPage = allocations[0].Page;
+    U32 const secondPage = allocations[allocationCount - 1].Page;
+    bool passed = true;
+
+    passed &= Report("allocations are placed in two pages", heap.GetStats().PageCount == 2 && firstPage != secondPage &&
+        allocations[7].Page == firstPage && allocations[8].Page == secondPage);
+
+    // Freed blocks are merged with their free neighbours
+    heap.Free(allocations[1]);
+    heap.Free(allocations[2]);
+    U64 const twoBlocks = heap.GetStats().LargestFreeRange;
+    heap.Free(allocations[0]);
+    U64 const threeBlocks = heap.GetStats().LargestFreeRange;
+
+    passed &= Report("freed neighbours are merged", twoBlocks == 2 * allocationSize && threeBlocks == 3 * allocationSize);
+
+    // Two allocations are left in the second page, Defragment moves them to the free blocks of the first one
+    for (U32 i = 10; i < allocationCount; ++i)
+        heap.Free(allocations[i]);
+
+    BufferAllocation const oldAllocations[2] = { allocations[8], allocations[9] };
+    NullFrameRecord const* pRecord = SG_NULL;
+    U64 movedBytes = 0;
+
+    device.RunFrame([&](ISGCommandList* pCommandList)
+    {
+        heap.BeginFrame();
+        movedBytes = heap.Defragment(pCommandList, 1 << 20);
+    });
+    GetNullFrameRecord(device.pExecutionContext, &pRecord);
+
+    bool copied = pRecord->Lists.size() == 1 && pRecord->Lists[0].pStream->GetCommandCount() == 2;
+    NullCommand const* pCommand = copied ? pRecord->Lists[0].pStream->First() : SG_NULL;
+
+    for (U32 i = 0; copied && i < 2; ++i, pCommand = pRecord->Lists[0].pStream->Next(pCommand))
+    {
+        BufferAllocation const& moved = allocations[8 + i];
+
+        copied = pCommand->Type == NullCommandType::CopyBufferRegion && moved.Page == firstPage &&
+            pCommand->GetArg<ISGBuffer*>(0) == moved.pBuffer && pCommand->GetArg<U64>(1) == moved.Offset &&
+            pCommand->GetArg<ISGBuffer*>(2) == oldAllocations[i].pBuffer && pCommand->GetArg<U64>(3) == oldAllocations[i].Offset &&
+            pCommand->GetArg<U64>(4) == allocationSize;
+    }
+
+    passed &= Report("movable allocations are relocated by copies", movedBytes == 2 * allocationSize && moves == 2 && copied);
+
+    // The old blocks are freed once the frame of the copies retires, the emptied page once the frame which freed them does
+    U32 frames = 0;
+    while (frames < 8 && heap.GetStats().PageCount == 2)
+    {
+        device.RunFrame([&](ISGCommandList*)
+        {
+            heap.BeginFrame();
+        });
+        frames++;
+    }
+
+    BufferHeapStats stats = heap.GetStats();
+    std::cout << "  page released " << frames << " frames after the moves" << std::endl;
+    passed &= Report("the emptied page is released after the frames in flight", frames == 2 * NullDevice::FrameBuffers &&
+        stats.PageCount == 1 && stats.ReclaimedBytes == pageSize);
+
+    for (U32 i = 3; i < 10; ++i)
+        heap.Free(allocations[i]);
+
+    device.pExecutionContext->WaitForIdle();
+    heap.Destroy();
+    return passed;
+}
+
+int RunHelperChecks()
+{
+    ThreadPool threadPool;
+
+    bool passed = CheckMipStreamer();
+    passed &= CheckAsyncPipelines();
+    passed &= CheckCommandListGroup(threadPool);
+    passed &= CheckResidency();
+    passed &= CheckBindlessTable(threadPool);
+    passed &= CheckBufferHeap();
+
+    std::cout << (passed ? "All helper checks passed" : "Some helper checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,50 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+class ThreadPool;
+
+///-------------------------------------------------------------------------------------------------
+/// Checks of the SGX helpers
+///
+/// Run by "-check" after the meshlet checks. Helpers of the samples' helper layer which need a
+/// device are driven on the null back-end (see SGX/SGNullDevice.h) through a few frames, no GPU
+/// is needed. Helpers the sample doesn't use itself are checked here too.
+///-------------------------------------------------------------------------------------------------
+
+// MipStreamer fed the way the shader of SGMipStreamer.h reports the level of detail: streaming
+// stops at the mip the view needs and finer mips are dropped when it moves away
+bool CheckMipStreamer();
+
+// PipelineCache::Create*Async: pending pipeline states are never bound, compilations of the same
+// description are shared, and a prewarm job queued behind an asynchronous job is taken over
+bool CheckAsyncPipelines();
+
+// RecordCommandListGroup: sub-lists recorded on the pool execute in the group order, each one
+// starting with its prologue, and invalid groups leave no list scheduled
+bool CheckCommandListGroup(ThreadPool& threadPool);
+
+// ResidencyManager on a 10 MB budget: resources in use are never evicted, idle ones are evicted
+// down to the lower mark by priority, restores between the marks don't start another eviction,
+// and unregistered or invalid handles are rejected
+bool CheckResidency();
+
+// BindlessTable: indices are kept and reused, Bind writes the table with one ranged call with the
+// fallback in free indices, Init resets the table and concurrent registers get distinct indices
+bool CheckBindlessTable(ThreadPool& threadPool);
+
+// BufferHeap: freed blocks are merged, Defragment relocates the movable allocations of a page by
+// copies, and the emptied page is released only after the frames in flight
+bool CheckBufferHeap();
+
+// Runs every check, returns the exit code of the process
+int RunHelperChecks();
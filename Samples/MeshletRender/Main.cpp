@@ -15,6 +15,10 @@
 //*********************************************************
 
 #include "MeshletRender.h"
+#include "MeshletChecks.h"
+#include "HelperChecks.h"
+#include <cstdlib>
+#include <cstring>
 
 #ifdef _DEBUG
     #pragma comment(lib, "../../Lib/SGLib_D3D12_dev.lib")
@@ -24,8 +28,21 @@
     #define DEBUG_LEVEL SG_DEBUG_DISABLED
 #endif
 
-int main()
+int main(int argc, char** argv)
 {
+    // "-check" verifies the CPU meshlet tools on procedural meshes and the helpers on the null back-end
+    if (argc > 1 && strcmp(argv[1], "-check") == 0)
+    {
+        int meshletResult = RunMeshletChecks();
+        int helperResult = RunHelperChecks();
+        return meshletResult != 0 ? meshletResult : helperResult;
+    }
+
     MeshletRender sample(1280, 720, L"Meshlet render sample");
+
+    // "-null [frames]" renders on the null back-end, e.g. on build machines without a GPU
+    if (argc > 1 && strcmp(argv[1], "-null") == 0)
+        return sample.RunHeadless(argc > 2 ? static_cast<U32>(atoi(argv[2])) : 100);
+
     return sample.Run(1, DEBUG_LEVEL, SG_DEBUG_TOOL_NONE);
 }
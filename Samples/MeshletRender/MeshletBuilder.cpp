@@ -0,0 +1,615 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "MeshletBuilder.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    const uint32_t c_invalid = uint32_t(-1);
+
+    // Cones wider than this are useless for culling, their meshlets are never rejected
+    const float c_minConeDot = 0.1f;
+
+    struct Float3
+    {
+        float x, y, z;
+
+        Float3 operator+(Float3 const& o) const { return { x + o.x, y + o.y, z + o.z }; }
+        Float3 operator-(Float3 const& o) const { return { x - o.x, y - o.y, z - o.z }; }
+        Float3 operator*(float s) const { return { x * s, y * s, z * s }; }
+    };
+
+    inline float Dot(Float3 const& a, Float3 const& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    inline Float3 Cross(Float3 const& a, Float3 const& b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    inline float Length(Float3 const& a)
+    {
+        return std::sqrt(Dot(a, a));
+    }
+
+    inline uint8_t QuantizeUnorm8(float value)
+    {
+        return static_cast<uint8_t>((std::min)(255.0f, (std::max)(0.0f, std::round(value * 255.0f))));
+    }
+
+    ///---------------------------------------------------------------------------------------------
+    /// Working set of a single mesh, it's reused by every subset
+    ///---------------------------------------------------------------------------------------------
+
+    class SubsetBuilder
+    {
+    public:
+        SubsetBuilder(MeshletBuildInput const& input, MeshletBuildDesc const& desc, MeshletBuildOutput& output)
+            : m_Input(input)
+            , m_Desc(desc)
+            , m_Output(output)
+            , m_LiveTriangles(input.VertexCount, 0)
+            , m_CacheTime(input.VertexCount, 0)
+            , m_AdjacencyBegin(input.VertexCount, c_invalid)
+            , m_AdjacencyEnd(input.VertexCount, 0)
+            , m_LocalIndex(input.VertexCount, c_invalid)
+        {
+        }
+
+        void Build(uint32_t firstIndex, uint32_t indexCount)
+        {
+            ReadTriangles(firstIndex, indexCount);
+            BuildAdjacency();
+            OrderTriangles();
+            BuildMeshlets();
+
+            // Every triangle has been emitted and live counts are back to zero, only adjacency is left to reset
+            for (uint32_t vertex : m_Triangles)
+                m_AdjacencyBegin[vertex] = c_invalid;
+        }
+
+    private:
+        Float3 GetPosition(uint32_t vertex) const
+        {
+            Float3 position;
+            std::memcpy(&position, m_Input.pPositions + static_cast<size_t>(vertex) * m_Input.PositionStride, sizeof(position));
+            return position;
+        }
+
+        void ReadTriangles(uint32_t firstIndex, uint32_t indexCount)
+        {
+            m_Triangles.resize(indexCount);
+
+            for (uint32_t i = 0; i < indexCount; ++i)
+            {
+                if (m_Input.IndexSize == 4)
+                    m_Triangles[i] = static_cast<const uint32_t*>(m_Input.pIndices)[firstIndex + i];
+                else
+                    m_Triangles[i] = static_cast<const uint16_t*>(m_Input.pIndices)[firstIndex + i];
+            }
+        }
+
+        // Compressed lists of triangles of every vertex, only vertices of the subset are touched
+        void BuildAdjacency()
+        {
+            for (uint32_t vertex : m_Triangles)
+                m_LiveTriangles[vertex]++;
+
+            uint32_t offset = 0;
+            for (uint32_t vertex : m_Triangles)
+            {
+                if (m_AdjacencyBegin[vertex] == c_invalid)
+                {
+                    m_AdjacencyBegin[vertex] = offset;
+                    m_AdjacencyEnd[vertex] = offset;
+                    offset += m_LiveTriangles[vertex];
+                }
+            }
+
+            m_Adjacency.resize(offset);
+
+            const uint32_t triangleCount = static_cast<uint32_t>(m_Triangles.size() / 3);
+            for (uint32_t t = 0; t < triangleCount; ++t)
+            {
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    uint32_t vertex = m_Triangles[t * 3 + k];
+                    m_Adjacency[m_AdjacencyEnd[vertex]++] = t;
+                }
+            }
+        }
+
+        uint32_t AdjacencyBegin(uint32_t vertex) const { return m_AdjacencyBegin[vertex]; }
+        uint32_t AdjacencyEnd(uint32_t vertex) const { return m_AdjacencyEnd[vertex]; }
+
+        // Tipsify: Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+        void OrderTriangles()
+        {
+            const uint32_t triangleCount = static_cast<uint32_t>(m_Triangles.size() / 3);
+            const uint32_t cacheSize = m_Desc.CacheSize;
+
+            m_Order.clear();
+            m_Order.reserve(triangleCount);
+            m_Emitted.assign(triangleCount, false);
+            m_DeadEnd.clear();
+
+            if (triangleCount == 0)
+                return;
+
+            uint32_t timestamp = cacheSize + 1;
+            uint32_t cursor = 0;
+            uint32_t fanning = m_Triangles[0];
+
+            while (fanning != c_invalid)
+            {
+                m_Candidates.clear();
+
+                for (uint32_t a = AdjacencyBegin(fanning); a < AdjacencyEnd(fanning); ++a)
+                {
+                    uint32_t t = m_Adjacency[a];
+                    if (m_Emitted[t])
+                        continue;
+
+                    m_Emitted[t] = true;
+                    m_Order.push_back(t);
+
+                    for (uint32_t k = 0; k < 3; ++k)
+                    {
+                        uint32_t vertex = m_Triangles[t * 3 + k];
+
+                        m_DeadEnd.push_back(vertex);
+                        m_Candidates.push_back(vertex);
+                        m_LiveTriangles[vertex]--;
+
+                        if (timestamp - m_CacheTime[vertex] > cacheSize)
+                            m_CacheTime[vertex] = timestamp++;
+                    }
+                }
+
+                // The best next fanning vertex stays in the cache, and has triangles left
+                fanning = c_invalid;
+                int64_t bestPriority = -1;
+
+                for (uint32_t vertex : m_Candidates)
+                {
+                    if (m_LiveTriangles[vertex] == 0)
+                        continue;
+
+                    int64_t priority = 0;
+                    if (timestamp - m_CacheTime[vertex] + 2 * m_LiveTriangles[vertex] <= cacheSize)
+                        priority = timestamp - m_CacheTime[vertex];
+
+                    if (priority > bestPriority)
+                    {
+                        bestPriority = priority;
+                        fanning = vertex;
+                    }
+                }
+
+                // Dead end: recently used vertices first, then any vertex of the subset
+                while (fanning == c_invalid && !m_DeadEnd.empty())
+                {
+                    uint32_t vertex = m_DeadEnd.back();
+                    m_DeadEnd.pop_back();
+
+                    if (m_LiveTriangles[vertex] > 0)
+                        fanning = vertex;
+                }
+
+                while (fanning == c_invalid && cursor < m_Triangles.size())
+                {
+                    uint32_t vertex = m_Triangles[cursor++];
+                    if (m_LiveTriangles[vertex] > 0)
+                        fanning = vertex;
+                }
+            }
+
+            for (uint32_t vertex : m_Triangles)
+                m_CacheTime[vertex] = 0;
+        }
+
+        uint32_t CountNewVertices(uint32_t t) const
+        {
+            uint32_t count = 0;
+            for (uint32_t k = 0; k < 3; ++k)
+                count += m_LocalIndex[m_Triangles[t * 3 + k]] == c_invalid ? 1 : 0;
+
+            return count;
+        }
+
+        float DistanceToCenter(uint32_t t) const
+        {
+            Float3 offset = m_Centroids[t] - m_CenterSum * (1.0f / m_MeshletVertices.size());
+            return Dot(offset, offset);
+        }
+
+        void AddTriangle(uint32_t t)
+        {
+            m_Used[t] = true;
+
+            uint32_t local[3];
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                uint32_t vertex = m_Triangles[t * 3 + k];
+
+                if (m_LocalIndex[vertex] == c_invalid)
+                {
+                    m_LocalIndex[vertex] = static_cast<uint32_t>(m_MeshletVertices.size());
+                    m_MeshletVertices.push_back(vertex);
+                    m_CenterSum = m_CenterSum + GetPosition(vertex);
+
+                    // Every triangle is a candidate of a meshlet once
+                    for (uint32_t a = AdjacencyBegin(vertex); a < AdjacencyEnd(vertex); ++a)
+                    {
+                        uint32_t candidate = m_Adjacency[a];
+                        if (!m_Used[candidate] && m_CandidateOf[candidate] != m_MeshletNumber)
+                        {
+                            m_CandidateOf[candidate] = m_MeshletNumber;
+                            m_Candidates.push_back(candidate);
+                        }
+                    }
+                }
+
+                local[k] = m_LocalIndex[vertex];
+            }
+
+            PackedTriangle triangle;
+            triangle.i0 = local[0];
+            triangle.i1 = local[1];
+            triangle.i2 = local[2];
+            m_MeshletTriangles.push_back(triangle);
+            m_MeshletTriangleIds.push_back(t);
+        }
+
+        // Adjacent triangles that fit: no new vertices first, then fewer new vertices, then closer ones
+        uint32_t PickAdjacentTriangle()
+        {
+            uint32_t best = c_invalid;
+            uint32_t bestNewVertices = 4;
+            float bestDistance = 0.0f;
+
+            for (size_t i = 0; i < m_Candidates.size();)
+            {
+                uint32_t t = m_Candidates[i];
+                if (m_Used[t])
+                {
+                    m_Candidates[i] = m_Candidates.back();
+                    m_Candidates.pop_back();
+                    continue;
+                }
+
+                ++i;
+
+                uint32_t newVertices = CountNewVertices(t);
+                if (m_MeshletVertices.size() + newVertices > m_Desc.MaxVertices || newVertices > bestNewVertices)
+                    continue;
+
+                if (newVertices == 0)
+                    return t;
+
+                float distance = DistanceToCenter(t);
+                if (newVertices < bestNewVertices || distance < bestDistance)
+                {
+                    best = t;
+                    bestNewVertices = newVertices;
+                    bestDistance = distance;
+                }
+            }
+
+            return best;
+        }
+
+        void BuildMeshlets()
+        {
+            const uint32_t triangleCount = static_cast<uint32_t>(m_Triangles.size() / 3);
+
+            m_Used.assign(triangleCount, false);
+            m_CandidateOf.assign(triangleCount, c_invalid);
+            m_Centroids.resize(triangleCount);
+
+            for (uint32_t t = 0; t < triangleCount; ++t)
+            {
+                Float3 sum = GetPosition(m_Triangles[t * 3]) + GetPosition(m_Triangles[t * 3 + 1]) + GetPosition(m_Triangles[t * 3 + 2]);
+                m_Centroids[t] = sum * (1.0f / 3.0f);
+            }
+            m_Candidates.clear();
+
+            uint32_t cursor = 0;
+
+            while (true)
+            {
+                while (cursor < triangleCount && m_Used[m_Order[cursor]])
+                    cursor++;
+
+                if (cursor == triangleCount)
+                    break;
+
+                AddTriangle(m_Order[cursor]);
+
+                while (m_MeshletTriangles.size() < m_Desc.MaxPrimitives)
+                {
+                    uint32_t t = PickAdjacentTriangle();
+
+                    // Nothing adjacent fits, the cache-friendly order is the next best source of locality
+                    if (t == c_invalid && m_Candidates.empty())
+                    {
+                        while (cursor < triangleCount && m_Used[m_Order[cursor]])
+                            cursor++;
+
+                        if (cursor < triangleCount && m_MeshletVertices.size() + CountNewVertices(m_Order[cursor]) <= m_Desc.MaxVertices)
+                            t = m_Order[cursor];
+                    }
+
+                    if (t == c_invalid)
+                        break;
+
+                    AddTriangle(t);
+                }
+
+                FlushMeshlet();
+            }
+        }
+
+        void FlushMeshlet()
+        {
+            Meshlet meshlet;
+            meshlet.VertCount = static_cast<uint32_t>(m_MeshletVertices.size());
+            meshlet.VertOffset = static_cast<uint32_t>(m_Output.UniqueVertexIndices.size() / m_Input.IndexSize);
+            meshlet.PrimCount = static_cast<uint32_t>(m_MeshletTriangles.size());
+            meshlet.PrimOffset = static_cast<uint32_t>(m_Output.PrimitiveIndices.size());
+
+            m_Output.Meshlets.push_back(meshlet);
+            m_Output.CullingData.push_back(ComputeCullData());
+
+            for (uint32_t vertex : m_MeshletVertices)
+            {
+                uint8_t bytes[4];
+                std::memcpy(bytes, &vertex, sizeof(bytes));
+
+                // Indices are little-endian, 16-bit ones are the low halves
+                m_Output.UniqueVertexIndices.insert(m_Output.UniqueVertexIndices.end(), bytes, bytes + m_Input.IndexSize);
+                m_LocalIndex[vertex] = c_invalid;
+            }
+
+            m_Output.PrimitiveIndices.insert(m_Output.PrimitiveIndices.end(), m_MeshletTriangles.begin(), m_MeshletTriangles.end());
+
+            m_MeshletVertices.clear();
+            m_MeshletTriangles.clear();
+            m_MeshletTriangleIds.clear();
+            m_Candidates.clear();
+            m_CenterSum = {};
+            m_MeshletNumber++;
+        }
+
+        CullData ComputeCullData() const
+        {
+            CullData cull = {};
+
+            // Ritter's bounding sphere
+            Float3 first = GetPosition(m_MeshletVertices[0]);
+
+            auto farthest = [&](Float3 const& from)
+            {
+                Float3 result = from;
+                float maxDistance = -1.0f;
+
+                for (uint32_t vertex : m_MeshletVertices)
+                {
+                    Float3 p = GetPosition(vertex);
+                    float distance = Dot(p - from, p - from);
+
+                    if (distance > maxDistance)
+                    {
+                        maxDistance = distance;
+                        result = p;
+                    }
+                }
+
+                return result;
+            };
+
+            Float3 a = farthest(first);
+            Float3 b = farthest(a);
+
+            Float3 center = (a + b) * 0.5f;
+            float radius = Length(b - a) * 0.5f;
+
+            for (uint32_t vertex : m_MeshletVertices)
+            {
+                Float3 p = GetPosition(vertex);
+                float distance = Length(p - center);
+
+                if (distance > radius)
+                {
+                    float grownRadius = (radius + distance) * 0.5f;
+                    center = center + (p - center) * ((grownRadius - radius) / distance);
+                    radius = grownRadius;
+                }
+            }
+
+            // Float error of the growth is covered by a tiny margin
+            cull.BoundingSphere = { center.x, center.y, center.z, radius * 1.0001f };
+
+            // Normal cone
+            std::vector<Float3> normals;
+            normals.reserve(m_MeshletTriangleIds.size());
+
+            Float3 axisSum = {};
+            for (uint32_t t : m_MeshletTriangleIds)
+            {
+                Float3 p0 = GetPosition(m_Triangles[t * 3]);
+                Float3 normal = Cross(GetPosition(m_Triangles[t * 3 + 1]) - p0, GetPosition(m_Triangles[t * 3 + 2]) - p0);
+
+                float length = Length(normal);
+                if (length == 0.0f)
+                    continue;
+
+                normals.push_back(normal * (1.0f / length));
+                axisSum = axisSum + normals.back();
+            }
+
+            cull.NormalCone[3] = 0xff;
+
+            float axisLength = Length(axisSum);
+            if (normals.empty() || axisLength == 0.0f)
+                return cull;
+
+            // The runtime uses the quantized axis, so the cone is fit to it
+            Float3 axis = axisSum * (1.0f / axisLength);
+            cull.NormalCone[0] = QuantizeUnorm8(axis.x * 0.5f + 0.5f);
+            cull.NormalCone[1] = QuantizeUnorm8(axis.y * 0.5f + 0.5f);
+            cull.NormalCone[2] = QuantizeUnorm8(axis.z * 0.5f + 0.5f);
+
+            axis = { cull.NormalCone[0] / 255.0f * 2.0f - 1.0f, cull.NormalCone[1] / 255.0f * 2.0f - 1.0f, cull.NormalCone[2] / 255.0f * 2.0f - 1.0f };
+            axisLength = Length(axis);
+            if (axisLength == 0.0f)
+                return cull;
+
+            axis = axis * (1.0f / axisLength);
+
+            float minDot = 1.0f;
+            for (Float3 const& normal : normals)
+                minDot = (std::min)(minDot, Dot(axis, normal));
+
+            if (minDot <= c_minConeDot)
+                return cull;
+
+            // -cos(a + 90) = sin(a), it's rounded up to stay conservative
+            float cutoff = std::sqrt(1.0f - minDot * minDot);
+            float quantizedCutoff = std::ceil(cutoff * 255.0f);
+            if (quantizedCutoff >= 255.0f)
+                return cull;
+
+            cull.NormalCone[3] = static_cast<uint8_t>(quantizedCutoff);
+
+            // Apex is where the cone's side touches every triangle's plane
+            float maxT = 0.0f;
+            for (size_t i = 0, n = 0; i < m_MeshletTriangleIds.size(); ++i)
+            {
+                uint32_t t = m_MeshletTriangleIds[i];
+                Float3 p0 = GetPosition(m_Triangles[t * 3]);
+                Float3 edgeNormal = Cross(GetPosition(m_Triangles[t * 3 + 1]) - p0, GetPosition(m_Triangles[t * 3 + 2]) - p0);
+
+                if (Length(edgeNormal) == 0.0f)
+                    continue;
+
+                Float3 const& normal = normals[n++];
+                float t0 = Dot(center - p0, normal) / Dot(axis, normal);
+                maxT = (std::max)(maxT, t0);
+            }
+
+            cull.ApexOffset = maxT;
+            return cull;
+        }
+
+        MeshletBuildInput const&    m_Input;
+        MeshletBuildDesc const&     m_Desc;
+        MeshletBuildOutput&         m_Output;
+
+        // Per vertex, sized by the vertex count of the mesh
+        std::vector<uint32_t>       m_LiveTriangles;
+        std::vector<uint32_t>       m_CacheTime;
+        std::vector<uint32_t>       m_AdjacencyBegin;
+        std::vector<uint32_t>       m_AdjacencyEnd;
+        std::vector<uint32_t>       m_LocalIndex;
+
+        // Per triangle of the subset
+        std::vector<uint32_t>       m_Triangles;
+        std::vector<uint32_t>       m_Adjacency;
+        std::vector<uint32_t>       m_Order;
+        std::vector<bool>           m_Emitted;
+        std::vector<bool>           m_Used;
+        std::vector<uint32_t>       m_DeadEnd;
+        std::vector<uint32_t>       m_Candidates;
+        std::vector<uint32_t>       m_CandidateOf;
+        std::vector<Float3>         m_Centroids;
+
+        // Meshlet being built
+        std::vector<uint32_t>       m_MeshletVertices;
+        std::vector<PackedTriangle> m_MeshletTriangles;
+        std::vector<uint32_t>       m_MeshletTriangleIds;
+        Float3                      m_CenterSum = {};
+        uint32_t                    m_MeshletNumber = 0;
+    };
+}
+
+bool BuildMeshlets(MeshletBuildInput const& input, MeshletBuildDesc const& desc, MeshletBuildOutput& output)
+{
+    output = {};
+
+    if (input.IndexSize != 2 && input.IndexSize != 4)
+        return false;
+
+    if (input.pIndices == nullptr || input.pPositions == nullptr || input.IndexCount % 3 != 0 || input.PositionStride < 3 * sizeof(float))
+        return false;
+
+    // 10-bit triangle indices
+    if (desc.MaxVertices < 3 || desc.MaxVertices > 1024 || desc.MaxPrimitives == 0 || desc.CacheSize == 0)
+        return false;
+
+    for (uint32_t i = 0; i < input.IndexCount; ++i)
+    {
+        uint32_t index = input.IndexSize == 4 ? static_cast<const uint32_t*>(input.pIndices)[i] : static_cast<const uint16_t*>(input.pIndices)[i];
+        if (index >= input.VertexCount)
+            return false;
+    }
+
+    Subset whole = { 0, input.IndexCount };
+    const Subset* pSubsets = input.IndexSubsetCount > 0 ? input.pIndexSubsets : &whole;
+    const uint32_t subsetCount = input.IndexSubsetCount > 0 ? input.IndexSubsetCount : 1;
+
+    for (uint32_t i = 0; i < subsetCount; ++i)
+    {
+        if (pSubsets[i].Offset % 3 != 0 || pSubsets[i].Count % 3 != 0 || pSubsets[i].Offset > input.IndexCount || pSubsets[i].Count > input.IndexCount - pSubsets[i].Offset)
+            return false;
+    }
+
+    SubsetBuilder builder(input, desc, output);
+
+    for (uint32_t i = 0; i < subsetCount; ++i)
+    {
+        uint32_t firstMeshlet = static_cast<uint32_t>(output.Meshlets.size());
+        builder.Build(pSubsets[i].Offset, pSubsets[i].Count);
+
+        output.MeshletSubsets.push_back({ firstMeshlet, static_cast<uint32_t>(output.Meshlets.size()) - firstMeshlet });
+    }
+
+    return true;
+}
+
+bool BuildMeshlets(const MeshletBuildInput* pInputs, uint32_t count, MeshletBuildDesc const& desc, MeshletBuildOutput* pOutputs, ThreadPool* pThreadPool)
+{
+    std::atomic<bool> succeeded(true);
+
+    auto buildMesh = [&](uint32_t i)
+    {
+        if (!BuildMeshlets(pInputs[i], desc, pOutputs[i]))
+            succeeded = false;
+    };
+
+    if (pThreadPool != nullptr)
+    {
+        pThreadPool->ParallelFor(count, buildMesh);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            buildMesh(i);
+    }
+
+    return succeeded;
+}
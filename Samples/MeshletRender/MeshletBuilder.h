@@ -0,0 +1,67 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "Model.h"
+
+///-------------------------------------------------------------------------------------------------
+/// CPU meshlet builder
+///
+/// Splits an indexed triangle list into meshlets of the layout used by Mesh: Meshlet records,
+/// unique vertex indices of IndexSize bytes and 10-bit packed triangles, plus cull data.
+///
+/// Triangles of every subset are ordered for the vertex cache first (Tipsify). Meshlets are then
+/// grown greedily over triangle adjacency: triangles that add no new vertices are taken first,
+/// others by the distance to the meshlet's center, so meshlets stay compact. When a meshlet has
+/// no adjacent triangle left, it continues with the next triangle of the cache-friendly order.
+///-------------------------------------------------------------------------------------------------
+
+struct MeshletBuildDesc
+{
+    // Limits of the mesh shader outputs, vertex indices of a triangle are 10 bits
+    uint32_t MaxVertices = 64;
+    uint32_t MaxPrimitives = 126;
+
+    // Vertex cache size assumed by the triangle ordering
+    uint32_t CacheSize = 16;
+};
+
+struct MeshletBuildInput
+{
+    const void*     pIndices;
+    uint32_t        IndexCount;
+    uint32_t        IndexSize;          // 2 or 4
+
+    const uint8_t*  pPositions;         // float3 at every PositionStride bytes
+    uint32_t        PositionStride;
+    uint32_t        VertexCount;
+
+    // Meshlets don't cross subsets, the whole index buffer is a single subset if there's none
+    const Subset*   pIndexSubsets;
+    uint32_t        IndexSubsetCount;
+};
+
+struct MeshletBuildOutput
+{
+    std::vector<Meshlet>        Meshlets;
+    std::vector<Subset>         MeshletSubsets;
+    std::vector<uint8_t>        UniqueVertexIndices;    // IndexSize bytes per index
+    std::vector<PackedTriangle> PrimitiveIndices;
+    std::vector<CullData>       CullingData;
+};
+
+// Returns false if the input or limits are invalid
+bool BuildMeshlets(MeshletBuildInput const& input, MeshletBuildDesc const& desc, MeshletBuildOutput& output);
+
+// Builds meshlets of several meshes, meshes are processed by the thread pool if it's provided
+bool BuildMeshlets(const MeshletBuildInput* pInputs, uint32_t count, MeshletBuildDesc const& desc, MeshletBuildOutput* pOutputs,
+    ThreadPool* pThreadPool = nullptr);
@@ -0,0 +1,496 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "MeshletChecks.h"
+#include "MeshletBuilder.h"
+#include "MeshletCuller.h"
+#include "MeshletLod.h"
+#include "MeshletPacker.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <tuple>
+
+namespace
+{
+    const float c_pi = 3.14159265f;
+
+    struct ProceduralMesh
+    {
+        std::vector<float>      Positions;      // float3
+        std::vector<uint32_t>   Indices;
+
+        uint32_t GetVertexCount() const { return static_cast<uint32_t>(Positions.size() / 3); }
+        uint32_t GetTriangleCount() const { return static_cast<uint32_t>(Indices.size() / 3); }
+    };
+
+    // Latitude-longitude grid of a sphere, open at the seam, degenerate triangles at the poles
+    ProceduralMesh CreateSphereGrid(uint32_t width, uint32_t height, float radius)
+    {
+        ProceduralMesh mesh;
+        for (uint32_t y = 0; y <= height; ++y)
+        {
+            for (uint32_t x = 0; x <= width; ++x)
+            {
+                float theta = c_pi * y / height;
+                float phi = 2.0f * c_pi * x / width;
+                mesh.Positions.push_back(radius * sinf(theta) * cosf(phi));
+                mesh.Positions.push_back(radius * cosf(theta));
+                mesh.Positions.push_back(radius * sinf(theta) * sinf(phi));
+            }
+        }
+
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                uint32_t a = y * (width + 1) + x;
+                uint32_t b = a + 1;
+                uint32_t c = a + width + 1;
+                uint32_t d = c + 1;
+                mesh.Indices.insert(mesh.Indices.end(), { a, c, b, b, c, d });
+            }
+        }
+
+        return mesh;
+    }
+
+    // Closed surface, every edge is shared by two triangles
+    ProceduralMesh CreateTorus(uint32_t width, uint32_t height, float majorRadius, float minorRadius)
+    {
+        ProceduralMesh mesh;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float u = 2.0f * c_pi * x / width;
+                float v = 2.0f * c_pi * y / height;
+                float r = majorRadius + minorRadius * cosf(v);
+                mesh.Positions.push_back(r * cosf(u));
+                mesh.Positions.push_back(minorRadius * sinf(v));
+                mesh.Positions.push_back(r * sinf(u));
+            }
+        }
+
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                uint32_t a = y * width + x;
+                uint32_t b = y * width + (x + 1) % width;
+                uint32_t c = ((y + 1) % height) * width + x;
+                uint32_t d = ((y + 1) % height) * width + (x + 1) % width;
+                mesh.Indices.insert(mesh.Indices.end(), { a, c, b, b, c, d });
+            }
+        }
+
+        return mesh;
+    }
+
+    std::array<float, 3> GetPosition(ProceduralMesh const& mesh, uint32_t vertex)
+    {
+        return { mesh.Positions[vertex * 3], mesh.Positions[vertex * 3 + 1], mesh.Positions[vertex * 3 + 2] };
+    }
+
+    bool IsFrontFacing(ProceduralMesh const& mesh, uint32_t const (&triangle)[3], float const (&viewPosition)[3])
+    {
+        auto p0 = GetPosition(mesh, triangle[0]);
+        auto p1 = GetPosition(mesh, triangle[1]);
+        auto p2 = GetPosition(mesh, triangle[2]);
+
+        float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+
+        float d = n[0] * (viewPosition[0] - p0[0]) + n[1] * (viewPosition[1] - p0[1]) + n[2] * (viewPosition[2] - p0[2]);
+        return d > 1e-4f;
+    }
+
+    double GetSeconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool Report(char const* pCheck, bool passed)
+    {
+        std::cout << (passed ? "  passed: " : "  FAILED: ") << pCheck << std::endl;
+        return passed;
+    }
+}
+
+bool CheckMeshletBuilder(ThreadPool& threadPool)
+{
+    std::cout << "BuildMeshlets" << std::endl;
+
+    ProceduralMesh mesh = CreateSphereGrid(1024, 512, 10.0f);
+    uint32_t triangleCount = mesh.GetTriangleCount();
+
+    // Two subsets, meshlets mustn't cross the boundary
+    uint32_t firstSubsetSize = triangleCount / 2 * 3;
+    Subset subsets[] = { { 0, firstSubsetSize }, { firstSubsetSize, static_cast<uint32_t>(mesh.Indices.size()) - firstSubsetSize } };
+
+    MeshletBuildInput input = {};
+    input.pIndices = mesh.Indices.data();
+    input.IndexCount = static_cast<uint32_t>(mesh.Indices.size());
+    input.IndexSize = 4;
+    input.pPositions = reinterpret_cast<const uint8_t*>(mesh.Positions.data());
+    input.PositionStride = 3 * sizeof(float);
+    input.VertexCount = mesh.GetVertexCount();
+    input.pIndexSubsets = subsets;
+    input.IndexSubsetCount = _countof(subsets);
+
+    MeshletBuildDesc desc;
+    MeshletBuildOutput output;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!Report("build", BuildMeshlets(input, desc, output)))
+        return false;
+    double seconds = GetSeconds(start);
+
+    uint32_t meshletCount = static_cast<uint32_t>(output.Meshlets.size());
+    std::cout << "  " << triangleCount << " triangles, " << meshletCount << " meshlets, "
+        << triangleCount / seconds / 1e6 << "M triangles/s on one thread" << std::endl;
+
+    bool passed = true;
+    const uint32_t* pUniqueVertexIndices = reinterpret_cast<const uint32_t*>(output.UniqueVertexIndices.data());
+
+    // Triangle set, limits and subsets
+    std::vector<std::array<uint32_t, 3>> sourceTriangles;
+    std::vector<std::array<uint32_t, 3>> meshletTriangles;
+    for (uint32_t t = 0; t < triangleCount; ++t)
+        sourceTriangles.push_back({ mesh.Indices[t * 3], mesh.Indices[t * 3 + 1], mesh.Indices[t * 3 + 2] });
+
+    bool withinLimits = true;
+    bool spheresContainVertices = true;
+    uint64_t vertexSum = 0;
+    for (uint32_t m = 0; m < meshletCount; ++m)
+    {
+        Meshlet const& meshlet = output.Meshlets[m];
+        withinLimits &= meshlet.VertCount <= desc.MaxVertices && meshlet.PrimCount <= desc.MaxPrimitives;
+        vertexSum += meshlet.VertCount;
+
+        for (uint32_t p = 0; p < meshlet.PrimCount; ++p)
+        {
+            PackedTriangle triangle = output.PrimitiveIndices[meshlet.PrimOffset + p];
+            withinLimits &= triangle.i0 < meshlet.VertCount && triangle.i1 < meshlet.VertCount && triangle.i2 < meshlet.VertCount;
+            meshletTriangles.push_back({ pUniqueVertexIndices[meshlet.VertOffset + triangle.i0],
+                pUniqueVertexIndices[meshlet.VertOffset + triangle.i1], pUniqueVertexIndices[meshlet.VertOffset + triangle.i2] });
+        }
+
+        auto const& sphere = output.CullingData[m].BoundingSphere;
+        for (uint32_t v = 0; v < meshlet.VertCount; ++v)
+        {
+            auto p = GetPosition(mesh, pUniqueVertexIndices[meshlet.VertOffset + v]);
+            float dx = p[0] - sphere.x, dy = p[1] - sphere.y, dz = p[2] - sphere.z;
+            spheresContainVertices &= sqrtf(dx * dx + dy * dy + dz * dz) <= sphere.w * 1.00001f;
+        }
+    }
+
+    std::sort(sourceTriangles.begin(), sourceTriangles.end());
+    std::sort(meshletTriangles.begin(), meshletTriangles.end());
+
+    std::cout << "  " << double(vertexSum) / meshletCount << " vertices and " << double(triangleCount) / meshletCount
+        << " triangles per meshlet" << std::endl;
+
+    passed &= Report("triangle set is preserved", sourceTriangles == meshletTriangles);
+    passed &= Report("meshlets are within the limits", withinLimits);
+    passed &= Report("bounding spheres contain their vertices", spheresContainVertices);
+
+    uint32_t subsetMeshlets = 0;
+    for (Subset const& subset : output.MeshletSubsets)
+        subsetMeshlets += subset.Count;
+    passed &= Report("meshlet subsets", output.MeshletSubsets.size() == _countof(subsets) && subsetMeshlets == meshletCount);
+
+    // Normal cones from random view points, the frustum is disabled so only cones cull
+    MeshletBounds bounds;
+    bounds.Build(output.CullingData.data(), meshletCount);
+
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> coordinate(-30.0f, 30.0f);
+    std::vector<uint32_t> visible(meshletCount);
+    std::vector<bool> isVisible(meshletCount);
+    uint32_t culledMeshlets = 0;
+    uint32_t wronglyCulledTriangles = 0;
+
+    const float identity[4][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } };
+    for (uint32_t view = 0; view < 200; ++view)
+    {
+        float viewPosition[3] = { coordinate(random), coordinate(random), coordinate(random) };
+
+        MeshletCullView cullView = MeshletCullView::Create(identity, viewPosition);
+        for (auto& plane : cullView.Planes)
+        {
+            plane[0] = plane[1] = plane[2] = 0.0f;
+            plane[3] = 1.0f;
+        }
+
+        uint32_t visibleCount = CullMeshlets(bounds, cullView, 0, meshletCount, visible.data());
+        std::fill(isVisible.begin(), isVisible.end(), false);
+        for (uint32_t i = 0; i < visibleCount; ++i)
+            isVisible[visible[i]] = true;
+
+        for (uint32_t m = 0; m < meshletCount; ++m)
+        {
+            if (isVisible[m])
+                continue;
+
+            culledMeshlets++;
+
+            Meshlet const& meshlet = output.Meshlets[m];
+            for (uint32_t p = 0; p < meshlet.PrimCount; ++p)
+            {
+                PackedTriangle packed = output.PrimitiveIndices[meshlet.PrimOffset + p];
+                uint32_t triangle[3] = { pUniqueVertexIndices[meshlet.VertOffset + packed.i0],
+                    pUniqueVertexIndices[meshlet.VertOffset + packed.i1], pUniqueVertexIndices[meshlet.VertOffset + packed.i2] };
+
+                if (IsFrontFacing(mesh, triangle, viewPosition))
+                    wronglyCulledTriangles++;
+            }
+        }
+    }
+
+    std::cout << "  " << culledMeshlets << " meshlets culled by cones over 200 views" << std::endl;
+    passed &= Report("cones cull no front-facing triangle", wronglyCulledTriangles == 0);
+
+    // 16-bit indices of several meshes built by the thread pool
+    std::vector<uint16_t> indices16;
+    for (uint32_t index : mesh.Indices)
+    {
+        if (indices16.size() == 60000 * 3)
+            break;
+        indices16.push_back(static_cast<uint16_t>(index < 65536 ? index : 0));
+    }
+
+    const uint32_t meshCount = 8;
+    MeshletBuildInput input16 = {};
+    input16.pIndices = indices16.data();
+    input16.IndexCount = static_cast<uint32_t>(indices16.size());
+    input16.IndexSize = 2;
+    input16.pPositions = input.pPositions;
+    input16.PositionStride = input.PositionStride;
+    input16.VertexCount = (std::min)(input.VertexCount, 65536u);
+
+    std::vector<MeshletBuildInput> inputs(meshCount, input16);
+    std::vector<MeshletBuildOutput> outputs(meshCount);
+
+    start = std::chrono::steady_clock::now();
+    bool built = BuildMeshlets(inputs.data(), meshCount, desc, outputs.data(), &threadPool);
+    seconds = GetSeconds(start);
+
+    std::cout << "  " << meshCount << " meshes of 16-bit indices: " << meshCount * indices16.size() / 3 / seconds / 1e6
+        << "M triangles/s on " << threadPool.GetThreadCount() << " threads" << std::endl;
+
+    bool identical = built;
+    for (uint32_t i = 1; i < meshCount && identical; ++i)
+        identical = outputs[i].UniqueVertexIndices == outputs[0].UniqueVertexIndices && outputs[i].Meshlets.size() == outputs[0].Meshlets.size();
+    passed &= Report("meshes built in parallel are identical", identical);
+
+    return passed;
+}
+
+bool CheckMeshletLod(ThreadPool& threadPool)
+{
+    std::cout << "BuildMeshletLod" << std::endl;
+
+    ProceduralMesh mesh = CreateTorus(512, 256, 10.0f, 3.0f);
+
+    MeshletBuildInput input = {};
+    input.pIndices = mesh.Indices.data();
+    input.IndexCount = static_cast<uint32_t>(mesh.Indices.size());
+    input.IndexSize = 4;
+    input.pPositions = reinterpret_cast<const uint8_t*>(mesh.Positions.data());
+    input.PositionStride = 3 * sizeof(float);
+    input.VertexCount = mesh.GetVertexCount();
+
+    MeshletLodBuildDesc desc;
+    MeshletLodMesh lod;
+
+    auto start = std::chrono::steady_clock::now();
+    if (!Report("build", BuildMeshletLod(input, desc, lod, &threadPool)))
+        return false;
+    double seconds = GetSeconds(start);
+
+    const uint32_t clusterCount = static_cast<uint32_t>(lod.Clusters.size());
+    std::cout << "  " << mesh.GetTriangleCount() << " triangles, " << clusterCount << " meshlets in " << lod.LevelCount
+        << " levels, built in " << seconds << "s" << std::endl;
+
+    bool passed = true;
+
+    // A group is identified by its sphere and error, stored identically in its children and the meshlets it produced
+    typedef std::tuple<float, float, float, float, float> GroupKey;
+    std::map<GroupKey, std::vector<uint32_t>> groupMeshlets;
+    bool monotonic = true;
+    for (uint32_t i = 0; i < clusterCount; ++i)
+    {
+        MeshletLodCluster const& cluster = lod.Clusters[i];
+        if (cluster.Level > 0)
+            groupMeshlets[GroupKey(cluster.LodSphere[0], cluster.LodSphere[1], cluster.LodSphere[2], cluster.LodSphere[3], cluster.Error)].push_back(i);
+
+        monotonic &= cluster.ParentError == FLT_MAX || cluster.ParentError >= cluster.Error;
+    }
+    passed &= Report("errors grow towards the roots", monotonic);
+
+    std::vector<const std::vector<uint32_t>*> parentMeshlets(clusterCount, nullptr);
+    bool linked = true;
+    for (uint32_t i = 0; i < clusterCount; ++i)
+    {
+        MeshletLodCluster const& cluster = lod.Clusters[i];
+        if (cluster.ParentError == FLT_MAX)
+            continue;
+
+        auto it = groupMeshlets.find(GroupKey(cluster.ParentSphere[0], cluster.ParentSphere[1], cluster.ParentSphere[2], cluster.ParentSphere[3], cluster.ParentError));
+        if (it == groupMeshlets.end())
+        {
+            linked = false;
+            continue;
+        }
+
+        parentMeshlets[i] = &it->second;
+        for (uint32_t parent : it->second)
+            linked &= parent > i;
+    }
+    if (!Report("every parent group produced meshlets", linked))
+        return false;
+
+    MeshletPackDesc packDesc;
+    packDesc.MaxVertices = desc.Meshlets.MaxVertices;
+    packDesc.MaxPrimitives = desc.Meshlets.MaxPrimitives;
+
+    std::vector<uint32_t> selected(clusterCount);
+    std::vector<uint32_t> selectedSerial(clusterCount);
+    std::vector<uint32_t> packTable(GetMeshletPackTableSize(clusterCount) * 2);
+    std::vector<bool> isSelected(clusterCount);
+    std::vector<uint32_t> minCover(clusterCount), maxCover(clusterCount);
+
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> coordinate(-60.0f, 60.0f);
+    std::uniform_real_distribution<float> threshold(0.0f, 8.0f);
+
+    uint32_t minSelected = UINT32_MAX, maxSelected = 0;
+    bool parallelMatches = true;
+    bool leavesCoveredOnce = true;
+    bool closed = true;
+    bool packed = true;
+    double selectionSeconds = 0.0;
+
+    const uint32_t viewCount = 40;
+    for (uint32_t v = 0; v < viewCount; ++v)
+    {
+        MeshletLodView view;
+        for (float& x : view.ViewPosition)
+            x = coordinate(random);
+        view.ProjectionScale = 1080.0f / (2.0f * tanf(0.4f));
+        view.ErrorThreshold = v == 0 ? 0.0f : v == 1 ? FLT_MAX : threshold(random);
+
+        start = std::chrono::steady_clock::now();
+        uint32_t selectedCount = SelectMeshletLod(lod, view, selected.data(), &threadPool);
+        selectionSeconds += GetSeconds(start);
+
+        uint32_t serialCount = SelectMeshletLod(lod, view, selectedSerial.data());
+        parallelMatches &= serialCount == selectedCount && std::equal(selected.begin(), selected.begin() + selectedCount, selectedSerial.begin());
+
+        minSelected = (std::min)(minSelected, selectedCount);
+        maxSelected = (std::max)(maxSelected, selectedCount);
+
+        // Every path from a leaf to a root must pass exactly one selected meshlet. Meshlets of a group
+        // continue to any meshlet the group produced, so the fewest and most selected meshlets on the paths
+        // are propagated from the roots down, parents always follow their children in the list.
+        std::fill(isSelected.begin(), isSelected.end(), false);
+        for (uint32_t i = 0; i < selectedCount; ++i)
+            isSelected[selected[i]] = true;
+
+        for (uint32_t i = clusterCount; i-- > 0;)
+        {
+            minCover[i] = maxCover[i] = isSelected[i] ? 1 : 0;
+            if (parentMeshlets[i] == nullptr)
+                continue;
+
+            uint32_t parentMin = UINT32_MAX, parentMax = 0;
+            for (uint32_t parent : *parentMeshlets[i])
+            {
+                parentMin = (std::min)(parentMin, minCover[parent]);
+                parentMax = (std::max)(parentMax, maxCover[parent]);
+            }
+            minCover[i] += parentMin;
+            maxCover[i] += parentMax;
+        }
+
+        for (uint32_t i = 0; i < clusterCount; ++i)
+        {
+            if (lod.Clusters[i].Level == 0)
+                leavesCoveredOnce &= minCover[i] == 1 && maxCover[i] == 1;
+        }
+
+        // The torus is closed, so is a crack-free cut without overlaps
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> edges;
+        for (uint32_t i = 0; i < selectedCount; ++i)
+        {
+            Meshlet const& meshlet = lod.Meshlets[selected[i]];
+            for (uint32_t p = 0; p < meshlet.PrimCount; ++p)
+            {
+                PackedTriangle triangle = lod.PrimitiveIndices[meshlet.PrimOffset + p];
+                uint32_t vertices[3] = { lod.UniqueVertexIndices[meshlet.VertOffset + triangle.i0],
+                    lod.UniqueVertexIndices[meshlet.VertOffset + triangle.i1], lod.UniqueVertexIndices[meshlet.VertOffset + triangle.i2] };
+
+                for (uint32_t e = 0; e < 3; ++e)
+                {
+                    uint32_t a = vertices[e], b = vertices[(e + 1) % 3];
+                    edges[std::make_pair((std::min)(a, b), (std::max)(a, b))]++;
+                }
+            }
+        }
+        for (auto const& edge : edges)
+            closed &= edge.second == 2;
+
+        // The cut is packed like the visible meshlets of a mesh, every selected meshlet gets one entry
+        MeshletPackList list = { lod.Meshlets.data(), selected.data(), selectedCount, 0, 0 };
+        MeshletPackResult result = PackMeshlets(&list, 1, clusterCount, packDesc, packTable.data());
+
+        std::vector<uint32_t> entries;
+        const MeshletPackGroup* pGroups = reinterpret_cast<const MeshletPackGroup*>(packTable.data());
+        const MeshletPackEntry* pTable = reinterpret_cast<const MeshletPackEntry*>(packTable.data());
+        for (uint32_t g = 0; g < result.GroupCount; ++g)
+        {
+            for (uint32_t e = 0; e < pGroups[g].EntryCount; ++e)
+                entries.push_back(pTable[pGroups[g].FirstEntry + e].MeshletIndex);
+        }
+        std::sort(entries.begin(), entries.end());
+        packed &= result.EntryCount == selectedCount && entries.size() == selectedCount && std::equal(entries.begin(), entries.end(), selected.begin());
+    }
+
+    std::cout << "  " << minSelected << " to " << maxSelected << " meshlets selected, " << selectionSeconds / viewCount * 1e3
+        << "ms per selection" << std::endl;
+
+    passed &= Report("parallel and serial selections match", parallelMatches);
+    passed &= Report("every leaf is covered exactly once", leavesCoveredOnce);
+    passed &= Report("cuts are closed surfaces", closed);
+    passed &= Report("cuts are packed", packed);
+
+    return passed;
+}
+
+int RunMeshletChecks()
+{
+    ThreadPool threadPool;
+
+    bool passed = CheckMeshletBuilder(threadPool);
+    passed &= CheckMeshletLod(threadPool);
+
+    std::cout << (passed ? "All meshlet checks passed" : "Some meshlet checks failed") << std::endl;
+    return passed ? 0 : 1;
+}
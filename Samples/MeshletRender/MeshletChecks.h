@@ -0,0 +1,32 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+class ThreadPool;
+
+///-------------------------------------------------------------------------------------------------
+/// Checks of the CPU meshlet tools
+///
+/// Started with "-check", the sample runs the tools on procedural meshes instead of rendering,
+/// verifies their output and prints the results and timings. No device or model file is needed.
+///-------------------------------------------------------------------------------------------------
+
+// BuildMeshlets on a sphere grid: the triangle set is preserved, meshlets are within the limits,
+// bounding spheres contain their vertices, and normal cones never cull a front-facing triangle
+bool CheckMeshletBuilder(ThreadPool& threadPool);
+
+// BuildMeshletLod on a torus: for random views, every leaf meshlet is covered exactly once by the
+// selected cut, the cut is a closed surface, and it is packed by PackMeshlets without losses
+bool CheckMeshletLod(ThreadPool& threadPool);
+
+// Runs every check, returns the exit code of the process
+int RunMeshletChecks();
@@ -0,0 +1,201 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Model.h"
+#include "MeshletCuller.h"
+
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MESHLET_CULLER_SSE2 1
+#endif
+
+namespace
+{
+    // The last group of 4 may start at any index of the range
+    const uint32_t c_padding = 3;
+
+    // Cone spreads wider than a hemisphere, triangles of the meshlet may face any direction
+    inline bool IsConeDegenerate(CullData const& data)
+    {
+        return data.NormalCone[3] == 0xff;
+    }
+
+    inline bool IsVisible(MeshletBounds const& bounds, MeshletCullView const& view, uint32_t i)
+    {
+        for (auto& plane : view.Planes)
+        {
+            if (plane[0] * bounds.CenterX[i] + plane[1] * bounds.CenterY[i] + plane[2] * bounds.CenterZ[i] + plane[3] < -bounds.Radius[i])
+                return false;
+        }
+
+        float x = view.ViewPosition[0] - bounds.ApexX[i];
+        float y = view.ViewPosition[1] - bounds.ApexY[i];
+        float z = view.ViewPosition[2] - bounds.ApexZ[i];
+
+        float facing = -(x * bounds.AxisX[i] + y * bounds.AxisY[i] + z * bounds.AxisZ[i]);
+        return facing <= bounds.ConeCutoff[i] * std::sqrt(x * x + y * y + z * z);
+    }
+}
+
+void MeshletBounds::Build(const CullData* pCullData, uint32_t count)
+{
+    Count = count;
+
+    for (auto* pArray : { &CenterX, &CenterY, &CenterZ, &Radius, &ApexX, &ApexY, &ApexZ, &AxisX, &AxisY, &AxisZ, &ConeCutoff })
+        pArray->assign(count + c_padding, 0.0f);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        CullData const& data = pCullData[i];
+
+        CenterX[i] = data.BoundingSphere.x;
+        CenterY[i] = data.BoundingSphere.y;
+        CenterZ[i] = data.BoundingSphere.z;
+        Radius[i] = data.BoundingSphere.w;
+
+        // Axis is packed to unorm8, the cutoff -cos(angle + 90 deg) to unorm8 as well
+        float axis[3];
+        for (uint32_t c = 0; c < 3; ++c)
+            axis[c] = data.NormalCone[c] / 255.0f * 2.0f - 1.0f;
+
+        float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        bool degenerate = IsConeDegenerate(data) || length == 0.0f;
+
+        float scale = degenerate ? 0.0f : 1.0f / length;
+        AxisX[i] = axis[0] * scale;
+        AxisY[i] = axis[1] * scale;
+        AxisZ[i] = axis[2] * scale;
+
+        ApexX[i] = CenterX[i] - AxisX[i] * data.ApexOffset;
+        ApexY[i] = CenterY[i] - AxisY[i] * data.ApexOffset;
+        ApexZ[i] = CenterZ[i] - AxisZ[i] * data.ApexOffset;
+
+        ConeCutoff[i] = degenerate ? (std::numeric_limits<float>::max)() : data.NormalCone[3] / 255.0f;
+    }
+}
+
+MeshletCullView MeshletCullView::Create(const float m[4][4], const float viewPosition[3])
+{
+    MeshletCullView view;
+
+    // Planes are combinations of the matrix columns, D3D clip space depth is [0; w]
+    for (uint32_t r = 0; r < 4; ++r)
+    {
+        view.Planes[0][r] = m[r][3] + m[r][0];  // Left
+        view.Planes[1][r] = m[r][3] - m[r][0];  // Right
+        view.Planes[2][r] = m[r][3] + m[r][1];  // Bottom
+        view.Planes[3][r] = m[r][3] - m[r][1];  // Top
+        view.Planes[4][r] = m[r][2];            // Near
+        view.Planes[5][r] = m[r][3] - m[r][2];  // Far
+    }
+
+    // Distances to normalized planes are compared to sphere radii
+    for (auto& plane : view.Planes)
+    {
+        float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        float scale = length > 0.0f ? 1.0f / length : 0.0f;
+
+        for (float& value : plane)
+            value *= scale;
+    }
+
+    for (uint32_t c = 0; c < 3; ++c)
+        view.ViewPosition[c] = viewPosition[c];
+
+    return view;
+}
+
+uint32_t CullMeshlets(MeshletBounds const& bounds, MeshletCullView const& view, uint32_t first, uint32_t count, uint32_t* pVisible)
+{
+    uint32_t visibleCount = 0;
+
+    if (bounds.Count == 0)
+    {
+        for (uint32_t i = first; i < first + count; ++i)
+            pVisible[visibleCount++] = i;
+
+        return visibleCount;
+    }
+
+    uint32_t i = first;
+    const uint32_t end = first + count;
+
+#if defined(MESHLET_CULLER_SSE2)
+    __m128 planes[6][4];
+    for (uint32_t p = 0; p < 6; ++p)
+    {
+        for (uint32_t c = 0; c < 4; ++c)
+            planes[p][c] = _mm_set1_ps(view.Planes[p][c]);
+    }
+
+    const __m128 viewX = _mm_set1_ps(view.ViewPosition[0]);
+    const __m128 viewY = _mm_set1_ps(view.ViewPosition[1]);
+    const __m128 viewZ = _mm_set1_ps(view.ViewPosition[2]);
+
+    for (; i < end; i += 4)
+    {
+        __m128 centerX = _mm_loadu_ps(&bounds.CenterX[i]);
+        __m128 centerY = _mm_loadu_ps(&bounds.CenterY[i]);
+        __m128 centerZ = _mm_loadu_ps(&bounds.CenterZ[i]);
+        __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&bounds.Radius[i]));
+
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for (uint32_t p = 0; p < 6; ++p)
+        {
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(planes[p][0], centerX), _mm_mul_ps(planes[p][1], centerY)),
+                _mm_add_ps(_mm_mul_ps(planes[p][2], centerZ), planes[p][3]));
+
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negRadius));
+        }
+
+        __m128 x = _mm_sub_ps(viewX, _mm_loadu_ps(&bounds.ApexX[i]));
+        __m128 y = _mm_sub_ps(viewY, _mm_loadu_ps(&bounds.ApexY[i]));
+        __m128 z = _mm_sub_ps(viewZ, _mm_loadu_ps(&bounds.ApexZ[i]));
+
+        __m128 facing = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(x, _mm_loadu_ps(&bounds.AxisX[i])),
+            _mm_mul_ps(y, _mm_loadu_ps(&bounds.AxisY[i]))),
+            _mm_mul_ps(z, _mm_loadu_ps(&bounds.AxisZ[i])));
+        facing = _mm_sub_ps(_mm_setzero_ps(), facing);
+
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        visible = _mm_and_ps(visible, _mm_cmple_ps(facing, _mm_mul_ps(_mm_loadu_ps(&bounds.ConeCutoff[i]), distance)));
+
+        // Lanes past the range belong to other subsets or padding
+        int mask = _mm_movemask_ps(visible);
+        if (end - i < 4)
+            mask &= (1 << (end - i)) - 1;
+
+        while (mask != 0)
+        {
+            uint32_t lane = 0;
+            while ((mask & (1 << lane)) == 0)
+                ++lane;
+
+            pVisible[visibleCount++] = i + lane;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i < end; ++i)
+    {
+        if (IsVisible(bounds, view, i))
+            pVisible[visibleCount++] = i;
+    }
+
+    return visibleCount;
+}
@@ -0,0 +1,54 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct CullData;
+
+///-------------------------------------------------------------------------------------------------
+/// CPU meshlet culling
+///
+/// Meshlets are tested against the view frustum by their bounding spheres and rejected as
+/// back-facing by their normal cones, 4 meshlets at a time. Bounds are kept in SoA arrays, every
+/// array is padded so that the last group of 4 may always be loaded.
+///
+/// Everything is in the model space: the frustum is extracted from the world-view-projection
+/// matrix and the view position is transformed by the inverse world matrix.
+///-------------------------------------------------------------------------------------------------
+
+struct MeshletBounds
+{
+    // Meshlets without cull data are never culled
+    void Build(const CullData* pCullData, uint32_t count);
+
+    uint32_t Count = 0;
+
+    std::vector<float> CenterX, CenterY, CenterZ, Radius;
+
+    // Meshlet is back-facing if dot(normalize(view - apex), -axis) > ConeCutoff
+    std::vector<float> ApexX, ApexY, ApexZ;
+    std::vector<float> AxisX, AxisY, AxisZ, ConeCutoff;
+};
+
+struct MeshletCullView
+{
+    // Row-vector convention of DirectXMath: clip = float4(position, 1) * worldViewProj
+    static MeshletCullView Create(const float worldViewProj[4][4], const float viewPosition[3]);
+
+    float Planes[6][4];     // Normalized, inside is dot(plane.xyz, p) + plane.w >= 0
+    float ViewPosition[3];
+};
+
+// Writes indices of visible meshlets of [first; first + count) to pVisible, returns their number
+uint32_t CullMeshlets(MeshletBounds const& bounds, MeshletCullView const& view, uint32_t first, uint32_t count, uint32_t* pVisible);
@@ -0,0 +1,796 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "MeshletLod.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <queue>
+
+namespace
+{
+    const uint32_t c_invalid = uint32_t(-1);
+
+    // Clusters selected by a single job
+    const uint32_t c_selectionBatch = 1024;
+
+    struct Float3
+    {
+        float x, y, z;
+
+        Float3 operator-(Float3 const& o) const { return { x - o.x, y - o.y, z - o.z }; }
+    };
+
+    inline float Dot(Float3 const& a, Float3 const& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    inline Float3 Cross(Float3 const& a, Float3 const& b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    inline float Length(Float3 const& a)
+    {
+        return std::sqrt(Dot(a, a));
+    }
+
+    inline Float3 LoadPosition(MeshletBuildInput const& input, uint32_t index)
+    {
+        Float3 position;
+        std::memcpy(&position, input.pPositions + size_t(index) * input.PositionStride, sizeof(position));
+        return position;
+    }
+
+    // Smallest sphere enclosing both, xyz = center, w = radius
+    void MergeSphere(float sphere[4], const float other[4])
+    {
+        Float3 delta = { other[0] - sphere[0], other[1] - sphere[1], other[2] - sphere[2] };
+        float distance = Length(delta);
+
+        if (distance + other[3] <= sphere[3])
+            return;
+
+        if (distance + sphere[3] <= other[3])
+        {
+            std::memcpy(sphere, other, 4 * sizeof(float));
+            return;
+        }
+
+        float radius = (distance + sphere[3] + other[3]) * 0.5f;
+        float t = (radius - sphere[3]) / distance;
+
+        sphere[0] += delta.x * t;
+        sphere[1] += delta.y * t;
+        sphere[2] += delta.z * t;
+        sphere[3] = radius;
+    }
+
+    inline uint32_t SpreadBits10(uint32_t value)
+    {
+        value &= 0x3ff;
+        value = (value | (value << 16)) & 0x030000ff;
+        value = (value | (value << 8)) & 0x0300f00f;
+        value = (value | (value << 4)) & 0x030c30c3;
+        value = (value | (value << 2)) & 0x09249249;
+        return value;
+    }
+
+    ///---------------------------------------------------------------------------------------------
+    /// Half-edge collapse simplifier of a single group
+    ///
+    /// Vertices only move onto their neighbours, so no vertex is ever created. The shortest edges
+    /// go first and the longest collapsed one is the error of the result. Collapses that would
+    /// make the surface non-manifold or flip a triangle are rejected.
+    ///---------------------------------------------------------------------------------------------
+
+    class GroupSimplifier
+    {
+    public:
+        GroupSimplifier(std::vector<Float3> const& positions, std::vector<uint8_t> const& locked, std::vector<uint32_t>& indices)
+            : m_Positions(positions)
+            , m_Locked(locked)
+            , m_Indices(indices)
+        {
+        }
+
+        // Removes triangles of indices until targetTriangleCount remain or nothing can be collapsed, returns the error
+        float Simplify(uint32_t targetTriangleCount)
+        {
+            const uint32_t triangleCount = static_cast<uint32_t>(m_Indices.size() / 3);
+
+            m_VertexTriangles.assign(m_Positions.size(), {});
+            m_RemovedVertices.assign(m_Positions.size(), 0);
+            m_RemovedTriangles.assign(triangleCount, 0);
+
+            for (uint32_t t = 0; t < triangleCount; ++t)
+            {
+                for (uint32_t k = 0; k < 3; ++k)
+                    m_VertexTriangles[m_Indices[t * 3 + k]].push_back(t);
+            }
+
+            for (uint32_t t = 0; t < triangleCount; ++t)
+            {
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    uint32_t a = m_Indices[t * 3 + k];
+                    uint32_t b = m_Indices[t * 3 + (k + 1) % 3];
+
+                    PushCollapse(a, b);
+                    PushCollapse(b, a);
+                }
+            }
+
+            uint32_t liveCount = triangleCount;
+            float error = 0.0f;
+
+            while (liveCount > targetTriangleCount && !m_Queue.empty())
+            {
+                Collapse collapse = m_Queue.top();
+                m_Queue.pop();
+
+                uint32_t removed = TryCollapse(collapse.From, collapse.To);
+                if (removed == 0)
+                    continue;
+
+                liveCount -= removed;
+                error = (std::max)(error, collapse.Cost);
+            }
+
+            uint32_t count = 0;
+            for (uint32_t t = 0; t < triangleCount; ++t)
+            {
+                if (m_RemovedTriangles[t] != 0)
+                    continue;
+
+                for (uint32_t k = 0; k < 3; ++k)
+                    m_Indices[count * 3 + k] = m_Indices[t * 3 + k];
+
+                ++count;
+            }
+
+            m_Indices.resize(count * 3);
+            return error;
+        }
+
+    private:
+        struct Collapse
+        {
+            float    Cost;
+            uint32_t From;
+            uint32_t To;
+
+            bool operator>(Collapse const& o) const { return Cost > o.Cost; }
+        };
+
+        void PushCollapse(uint32_t from, uint32_t to)
+        {
+            // Collapses never move positions, so costs of queued edges stay valid
+            if (m_Locked[from] == 0)
+                m_Queue.push({ Length(m_Positions[from] - m_Positions[to]), from, to });
+        }
+
+        bool HasVertex(uint32_t t, uint32_t v) const
+        {
+            return m_Indices[t * 3] == v || m_Indices[t * 3 + 1] == v || m_Indices[t * 3 + 2] == v;
+        }
+
+        void GatherNeighbours(uint32_t v, std::vector<uint32_t>& neighbours) const
+        {
+            neighbours.clear();
+            for (uint32_t t : m_VertexTriangles[v])
+            {
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    if (m_Indices[t * 3 + k] != v)
+                        neighbours.push_back(m_Indices[t * 3 + k]);
+                }
+            }
+
+            std::sort(neighbours.begin(), neighbours.end());
+            neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        }
+
+        Float3 Normal(uint32_t t, uint32_t from, uint32_t to) const
+        {
+            Float3 p[3];
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                uint32_t v = m_Indices[t * 3 + k];
+                p[k] = m_Positions[v == from ? to : v];
+            }
+
+            return Cross(p[1] - p[0], p[2] - p[0]);
+        }
+
+        // Returns the number of removed triangles, 0 if the collapse is rejected
+        uint32_t TryCollapse(uint32_t from, uint32_t to)
+        {
+            if (m_RemovedVertices[from] != 0 || m_RemovedVertices[to] != 0)
+                return 0;
+
+            // Link condition: vertices adjacent to both must be the opposite corners of the edge
+            m_Opposite.clear();
+            for (uint32_t t : m_VertexTriangles[from])
+            {
+                if (!HasVertex(t, to))
+                    continue;
+
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    uint32_t v = m_Indices[t * 3 + k];
+                    if (v != from && v != to)
+                        m_Opposite.push_back(v);
+                }
+            }
+
+            if (m_Opposite.empty())
+                return 0;
+
+            GatherNeighbours(from, m_FromNeighbours);
+            GatherNeighbours(to, m_ToNeighbours);
+
+            m_Common.clear();
+            std::set_intersection(m_FromNeighbours.begin(), m_FromNeighbours.end(), m_ToNeighbours.begin(), m_ToNeighbours.end(),
+                std::back_inserter(m_Common));
+
+            std::sort(m_Opposite.begin(), m_Opposite.end());
+            m_Opposite.erase(std::unique(m_Opposite.begin(), m_Opposite.end()), m_Opposite.end());
+
+            if (m_Common.size() != m_Opposite.size())
+                return 0;
+
+            // A new edge between locked vertices may duplicate one of a neighbouring group and pinch the surface
+            if (m_Locked[to] != 0)
+            {
+                for (uint32_t v : m_FromNeighbours)
+                {
+                    if (v != to && m_Locked[v] != 0 && !std::binary_search(m_ToNeighbours.begin(), m_ToNeighbours.end(), v))
+                        return 0;
+                }
+            }
+
+            for (uint32_t t : m_VertexTriangles[from])
+            {
+                if (!HasVertex(t, to) && Dot(Normal(t, from, to), Normal(t, c_invalid, c_invalid)) <= 0.0f)
+                    return 0;
+            }
+
+            uint32_t removed = 0;
+            for (uint32_t t : m_VertexTriangles[from])
+            {
+                if (HasVertex(t, to))
+                {
+                    m_RemovedTriangles[t] = 1;
+                    ++removed;
+
+                    for (uint32_t k = 0; k < 3; ++k)
+                    {
+                        uint32_t v = m_Indices[t * 3 + k];
+                        if (v == from)
+                            continue;
+
+                        auto& triangles = m_VertexTriangles[v];
+                        triangles.erase(std::find(triangles.begin(), triangles.end(), t));
+                    }
+                }
+                else
+                {
+                    for (uint32_t k = 0; k < 3; ++k)
+                    {
+                        if (m_Indices[t * 3 + k] == from)
+                            m_Indices[t * 3 + k] = to;
+                    }
+
+                    m_VertexTriangles[to].push_back(t);
+                }
+            }
+
+            m_VertexTriangles[from].clear();
+            m_RemovedVertices[from] = 1;
+
+            for (uint32_t v : m_FromNeighbours)
+            {
+                if (v == to)
+                    continue;
+
+                PushCollapse(v, to);
+                PushCollapse(to, v);
+            }
+
+            return removed;
+        }
+
+        std::vector<Float3> const&  m_Positions;
+        std::vector<uint8_t> const& m_Locked;
+        std::vector<uint32_t>&      m_Indices;
+
+        std::vector<std::vector<uint32_t>> m_VertexTriangles;
+        std::vector<uint8_t>               m_RemovedVertices;
+        std::vector<uint8_t>               m_RemovedTriangles;
+
+        std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> m_Queue;
+
+        std::vector<uint32_t> m_Opposite;
+        std::vector<uint32_t> m_FromNeighbours;
+        std::vector<uint32_t> m_ToNeighbours;
+        std::vector<uint32_t> m_Common;
+    };
+
+    struct GroupResult
+    {
+        bool                Simplified = false;
+        float               Error = 0.0f;
+        MeshletBuildOutput  Meshlets;       // 32-bit indices into Vertices
+        std::vector<uint32_t> Vertices;     // Group-local to source vertex indices
+    };
+
+    void GatherTriangles(MeshletLodMesh const& lod, uint32_t cluster, std::vector<uint32_t>& indices)
+    {
+        Meshlet const& meshlet = lod.Meshlets[cluster];
+
+        for (uint32_t p = 0; p < meshlet.PrimCount; ++p)
+        {
+            PackedTriangle const& triangle = lod.PrimitiveIndices[meshlet.PrimOffset + p];
+
+            indices.push_back(lod.UniqueVertexIndices[meshlet.VertOffset + triangle.i0]);
+            indices.push_back(lod.UniqueVertexIndices[meshlet.VertOffset + triangle.i1]);
+            indices.push_back(lod.UniqueVertexIndices[meshlet.VertOffset + triangle.i2]);
+        }
+    }
+
+    bool SimplifyGroup(MeshletBuildInput const& input, MeshletLodBuildDesc const& desc, MeshletLodMesh const& lod,
+        const uint32_t* pClusters, uint32_t clusterCount, std::vector<uint8_t> const& sharedVertices, GroupResult& result)
+    {
+        std::vector<uint32_t> indices;
+        for (uint32_t i = 0; i < clusterCount; ++i)
+            GatherTriangles(lod, pClusters[i], indices);
+
+        // Group-local vertices keep the working set proportional to the group
+        result.Vertices = indices;
+        std::sort(result.Vertices.begin(), result.Vertices.end());
+        result.Vertices.erase(std::unique(result.Vertices.begin(), result.Vertices.end()), result.Vertices.end());
+
+        std::vector<Float3> positions(result.Vertices.size());
+        std::vector<uint8_t> locked(result.Vertices.size());
+
+        for (size_t i = 0; i < result.Vertices.size(); ++i)
+        {
+            positions[i] = LoadPosition(input, result.Vertices[i]);
+            locked[i] = sharedVertices[result.Vertices[i]];
+        }
+
+        for (uint32_t& index : indices)
+            index = static_cast<uint32_t>(std::lower_bound(result.Vertices.begin(), result.Vertices.end(), index) - result.Vertices.begin());
+
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+        GroupSimplifier simplifier(positions, locked, indices);
+        result.Error = simplifier.Simplify(triangleCount / 2);
+
+        result.Simplified = indices.size() / 3 <= triangleCount * desc.MinReduction;
+        if (!result.Simplified)
+            return true;
+
+        MeshletBuildInput groupInput = {};
+        groupInput.pIndices = indices.data();
+        groupInput.IndexCount = static_cast<uint32_t>(indices.size());
+        groupInput.IndexSize = sizeof(uint32_t);
+        groupInput.pPositions = reinterpret_cast<const uint8_t*>(positions.data());
+        groupInput.PositionStride = sizeof(Float3);
+        groupInput.VertexCount = static_cast<uint32_t>(positions.size());
+
+        return BuildMeshlets(groupInput, desc.Meshlets, result.Meshlets);
+    }
+
+    // Appends meshlets of output to the mesh, indices of output are mapped through pVertices if it's provided
+    void AppendMeshlets(MeshletLodMesh& lod, MeshletBuildOutput const& output, uint32_t indexSize, const uint32_t* pVertices,
+        const float* pLodSphere, float error, uint32_t level)
+    {
+        const uint32_t vertexOffset = static_cast<uint32_t>(lod.UniqueVertexIndices.size());
+        const uint32_t primitiveOffset = static_cast<uint32_t>(lod.PrimitiveIndices.size());
+
+        for (size_t i = 0; i < output.UniqueVertexIndices.size(); i += indexSize)
+        {
+            uint32_t index = 0;
+            std::memcpy(&index, &output.UniqueVertexIndices[i], indexSize);
+            lod.UniqueVertexIndices.push_back(pVertices != nullptr ? pVertices[index] : index);
+        }
+
+        lod.PrimitiveIndices.insert(lod.PrimitiveIndices.end(), output.PrimitiveIndices.begin(), output.PrimitiveIndices.end());
+        lod.CullingData.insert(lod.CullingData.end(), output.CullingData.begin(), output.CullingData.end());
+
+        for (size_t i = 0; i < output.Meshlets.size(); ++i)
+        {
+            Meshlet meshlet = output.Meshlets[i];
+            meshlet.VertOffset += vertexOffset;
+            meshlet.PrimOffset += primitiveOffset;
+            lod.Meshlets.push_back(meshlet);
+
+            MeshletLodCluster cluster = {};
+
+            // Leaves are bounded by their own spheres
+            if (pLodSphere != nullptr)
+                std::memcpy(cluster.LodSphere, pLodSphere, sizeof(cluster.LodSphere));
+            else
+                std::memcpy(cluster.LodSphere, &output.CullingData[i].BoundingSphere, sizeof(cluster.LodSphere));
+
+            cluster.Error = error;
+            cluster.ParentError = FLT_MAX;
+            cluster.Level = level;
+            lod.Clusters.push_back(cluster);
+        }
+    }
+
+    // Sorts clusters along a Morton curve of their centers, consecutive clusters are then close to each other
+    void SortSpatially(MeshletLodMesh const& lod, std::vector<uint32_t>& clusters)
+    {
+        float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+        float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for (uint32_t i : clusters)
+        {
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                minimum[c] = (std::min)(minimum[c], lod.Clusters[i].LodSphere[c]);
+                maximum[c] = (std::max)(maximum[c], lod.Clusters[i].LodSphere[c]);
+            }
+        }
+
+        float extent = (std::max)((std::max)(maximum[0] - minimum[0], maximum[1] - minimum[1]), maximum[2] - minimum[2]);
+        float scale = extent > 0.0f ? 1023.0f / extent : 0.0f;
+
+        std::vector<std::pair<uint32_t, uint32_t>> keys;
+        keys.reserve(clusters.size());
+
+        for (uint32_t i : clusters)
+        {
+            uint32_t code = 0;
+            for (uint32_t c = 0; c < 3; ++c)
+                code |= SpreadBits10(static_cast<uint32_t>((lod.Clusters[i].LodSphere[c] - minimum[c]) * scale)) << c;
+
+            keys.push_back({ code, i });
+        }
+
+        std::sort(keys.begin(), keys.end());
+
+        for (size_t i = 0; i < keys.size(); ++i)
+            clusters[i] = keys[i].second;
+    }
+
+    // Reorders clusters so that groups are consecutive, a group is grown from a seed by the clusters that share
+    // the most vertices with it. Seeds follow the Morton order, so leftover clusters still end up near each other.
+    void GroupClusters(MeshletLodMesh const& lod, uint32_t clustersPerGroup, std::vector<uint32_t>& clusters, std::vector<uint32_t>& groupOffsets)
+    {
+        SortSpatially(lod, clusters);
+
+        const uint32_t count = static_cast<uint32_t>(clusters.size());
+
+        std::vector<std::pair<uint32_t, uint32_t>> vertexClusters;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Meshlet const& meshlet = lod.Meshlets[clusters[i]];
+
+            for (uint32_t v = 0; v < meshlet.VertCount; ++v)
+                vertexClusters.push_back({ lod.UniqueVertexIndices[meshlet.VertOffset + v], i });
+        }
+
+        std::sort(vertexClusters.begin(), vertexClusters.end());
+
+        std::vector<std::pair<uint32_t, uint32_t>> pairs;
+        for (size_t begin = 0, end = 0; begin < vertexClusters.size(); begin = end)
+        {
+            while (end < vertexClusters.size() && vertexClusters[end].first == vertexClusters[begin].first)
+                ++end;
+
+            for (size_t a = begin; a < end; ++a)
+            {
+                for (size_t b = begin; b < end; ++b)
+                {
+                    if (a != b)
+                        pairs.push_back({ vertexClusters[a].second, vertexClusters[b].second });
+                }
+            }
+        }
+
+        std::sort(pairs.begin(), pairs.end());
+
+        // Adjacency of every cluster, weights are numbers of shared vertices
+        std::vector<uint32_t> adjacencyBegin(count + 1, 0);
+        std::vector<uint32_t> adjacency;
+        std::vector<uint32_t> weights;
+
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            if (i > 0 && pairs[i] == pairs[i - 1])
+            {
+                ++weights.back();
+                continue;
+            }
+
+            adjacency.push_back(pairs[i].second);
+            weights.push_back(1);
+            ++adjacencyBegin[pairs[i].first + 1];
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+            adjacencyBegin[i + 1] += adjacencyBegin[i];
+
+        std::vector<uint8_t> grouped(count, 0);
+        std::vector<uint32_t> scores(count, 0);
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> ordered;
+        ordered.reserve(count);
+        groupOffsets.clear();
+
+        auto addCluster = [&](uint32_t i)
+        {
+            grouped[i] = 1;
+            ordered.push_back(clusters[i]);
+
+            for (uint32_t a = adjacencyBegin[i]; a < adjacencyBegin[i + 1]; ++a)
+            {
+                uint32_t neighbour = adjacency[a];
+                if (grouped[neighbour] != 0)
+                    continue;
+
+                if (scores[neighbour] == 0)
+                    candidates.push_back(neighbour);
+
+                scores[neighbour] += weights[a];
+            }
+        };
+
+        for (uint32_t seed = 0; seed < count; ++seed)
+        {
+            if (grouped[seed] != 0)
+                continue;
+
+            groupOffsets.push_back(static_cast<uint32_t>(ordered.size()));
+            addCluster(seed);
+
+            for (uint32_t size = 1; size < clustersPerGroup; ++size)
+            {
+                uint32_t best = c_invalid;
+                for (uint32_t candidate : candidates)
+                {
+                    if (grouped[candidate] == 0 && (best == c_invalid || scores[candidate] > scores[best]))
+                        best = candidate;
+                }
+
+                if (best == c_invalid)
+                    break;
+
+                addCluster(best);
+            }
+
+            for (uint32_t candidate : candidates)
+                scores[candidate] = 0;
+
+            candidates.clear();
+        }
+
+        groupOffsets.push_back(count);
+        clusters.swap(ordered);
+    }
+
+    inline float ProjectedError(const float sphere[4], float error, MeshletLodView const& view)
+    {
+        Float3 delta = { sphere[0] - view.ViewPosition[0], sphere[1] - view.ViewPosition[1], sphere[2] - view.ViewPosition[2] };
+        float distance = Length(delta) - sphere[3];
+
+        return error * view.ProjectionScale / (std::max)(distance, view.NearDistance);
+    }
+
+    // Both sides of a group compute the same value from the same sphere and error, so exactly one of them is drawn
+    inline bool IsSelected(MeshletLodCluster const& cluster, MeshletLodView const& view)
+    {
+        if (ProjectedError(cluster.LodSphere, cluster.Error, view) > view.ErrorThreshold)
+            return false;
+
+        return cluster.ParentError == FLT_MAX || ProjectedError(cluster.ParentSphere, cluster.ParentError, view) > view.ErrorThreshold;
+    }
+}
+
+bool BuildMeshletLod(MeshletBuildInput const& input, MeshletLodBuildDesc const& desc, MeshletLodMesh& lod, ThreadPool* pThreadPool)
+{
+    lod = {};
+
+    if (desc.MeshletsPerGroup < 2 || desc.MaxLevels == 0)
+        return false;
+
+    MeshletBuildInput wholeInput = input;
+    wholeInput.pIndexSubsets = nullptr;
+    wholeInput.IndexSubsetCount = 0;
+
+    MeshletBuildOutput leaves;
+    if (!BuildMeshlets(wholeInput, desc.Meshlets, leaves))
+        return false;
+
+    AppendMeshlets(lod, leaves, input.IndexSize, nullptr, nullptr, 0.0f, 0);
+    lod.LevelCount = 1;
+
+    std::vector<uint32_t> level(lod.Clusters.size());
+    for (uint32_t i = 0; i < level.size(); ++i)
+        level[i] = i;
+
+    // Vertices used by more than one group of the level are locked, neighbouring groups stay stitched
+    std::vector<uint32_t> vertexGroups(input.VertexCount, c_invalid);
+    std::vector<uint8_t> sharedVertices(input.VertexCount, 0);
+    std::vector<uint32_t> groupOffsets;
+
+    while (level.size() > 1 && lod.LevelCount < desc.MaxLevels)
+    {
+        GroupClusters(lod, desc.MeshletsPerGroup, level, groupOffsets);
+
+        const uint32_t groupCount = static_cast<uint32_t>(groupOffsets.size() - 1);
+
+        auto groupBegin = [&](uint32_t group) { return groupOffsets[group]; };
+        auto groupSize = [&](uint32_t group) { return groupOffsets[group + 1] - groupOffsets[group]; };
+
+        for (uint32_t group = 0; group < groupCount; ++group)
+        {
+            for (uint32_t i = 0; i < groupSize(group); ++i)
+            {
+                Meshlet const& meshlet = lod.Meshlets[level[groupBegin(group) + i]];
+
+                for (uint32_t v = meshlet.VertOffset; v < meshlet.VertOffset + meshlet.VertCount; ++v)
+                {
+                    uint32_t vertex = lod.UniqueVertexIndices[v];
+
+                    if (vertexGroups[vertex] == c_invalid)
+                        vertexGroups[vertex] = group;
+                    else if (vertexGroups[vertex] != group)
+                        sharedVertices[vertex] = 1;
+                }
+            }
+        }
+
+        std::vector<GroupResult> results(groupCount);
+        std::atomic<bool> succeeded(true);
+
+        auto simplifyGroup = [&](uint32_t group)
+        {
+            if (!SimplifyGroup(input, desc, lod, &level[groupBegin(group)], groupSize(group), sharedVertices, results[group]))
+                succeeded = false;
+        };
+
+        if (pThreadPool != nullptr)
+        {
+            pThreadPool->ParallelFor(groupCount, simplifyGroup);
+        }
+        else
+        {
+            for (uint32_t group = 0; group < groupCount; ++group)
+                simplifyGroup(group);
+        }
+
+        if (!succeeded)
+        {
+            lod = {};
+            return false;
+        }
+
+        for (uint32_t cluster : level)
+        {
+            Meshlet const& meshlet = lod.Meshlets[cluster];
+
+            for (uint32_t v = meshlet.VertOffset; v < meshlet.VertOffset + meshlet.VertCount; ++v)
+            {
+                vertexGroups[lod.UniqueVertexIndices[v]] = c_invalid;
+                sharedVertices[lod.UniqueVertexIndices[v]] = 0;
+            }
+        }
+
+        std::vector<uint32_t> nextLevel;
+        bool simplified = false;
+
+        for (uint32_t group = 0; group < groupCount; ++group)
+        {
+            GroupResult const& result = results[group];
+            const uint32_t* pChildren = &level[groupBegin(group)];
+
+            // Clusters of a group that couldn't be simplified are grouped again with the next level,
+            // they must keep taking part in vertex locking or their neighbours would detach from them
+            if (!result.Simplified)
+            {
+                nextLevel.insert(nextLevel.end(), pChildren, pChildren + groupSize(group));
+                continue;
+            }
+
+            simplified = true;
+
+            float sphere[4];
+            std::memcpy(sphere, lod.Clusters[pChildren[0]].LodSphere, sizeof(sphere));
+
+            float childError = 0.0f;
+            for (uint32_t i = 0; i < groupSize(group); ++i)
+            {
+                MergeSphere(sphere, lod.Clusters[pChildren[i]].LodSphere);
+                childError = (std::max)(childError, lod.Clusters[pChildren[i]].Error);
+            }
+
+            // Errors accumulate, so they only grow towards the roots
+            float error = childError + result.Error;
+
+            for (uint32_t i = 0; i < groupSize(group); ++i)
+            {
+                MeshletLodCluster& child = lod.Clusters[pChildren[i]];
+                std::memcpy(child.ParentSphere, sphere, sizeof(sphere));
+                child.ParentError = error;
+            }
+
+            uint32_t first = static_cast<uint32_t>(lod.Clusters.size());
+            AppendMeshlets(lod, result.Meshlets, sizeof(uint32_t), result.Vertices.data(), sphere, error, lod.LevelCount);
+
+            for (uint32_t i = first; i < lod.Clusters.size(); ++i)
+                nextLevel.push_back(i);
+        }
+
+        // Whatever is left are the roots
+        if (!simplified)
+            break;
+
+        level.swap(nextLevel);
+        ++lod.LevelCount;
+    }
+
+    return true;
+}
+
+uint32_t SelectMeshletLod(MeshletLodMesh const& lod, MeshletLodView const& view, uint32_t* pSelected, ThreadPool* pThreadPool)
+{
+    const uint32_t clusterCount = static_cast<uint32_t>(lod.Clusters.size());
+    const uint32_t batchCount = (clusterCount + c_selectionBatch - 1) / c_selectionBatch;
+
+    // Every batch writes to its own range of pSelected first, the ranges are packed afterwards
+    std::vector<uint32_t> batchCounts(batchCount);
+
+    auto selectBatch = [&](uint32_t batch)
+    {
+        uint32_t first = batch * c_selectionBatch;
+        uint32_t end = (std::min)(first + c_selectionBatch, clusterCount);
+        uint32_t count = 0;
+
+        for (uint32_t i = first; i < end; ++i)
+        {
+            if (IsSelected(lod.Clusters[i], view))
+                pSelected[first + count++] = i;
+        }
+
+        batchCounts[batch] = count;
+    };
+
+    if (pThreadPool != nullptr && batchCount > 1)
+    {
+        pThreadPool->ParallelFor(batchCount, selectBatch);
+    }
+    else
+    {
+        for (uint32_t batch = 0; batch < batchCount; ++batch)
+            selectBatch(batch);
+    }
+
+    uint32_t selectedCount = 0;
+    for (uint32_t batch = 0; batch < batchCount; ++batch)
+    {
+        std::memmove(pSelected + selectedCount, pSelected + batch * c_selectionBatch, batchCounts[batch] * sizeof(uint32_t));
+        selectedCount += batchCounts[batch];
+    }
+
+    return selectedCount;
+}
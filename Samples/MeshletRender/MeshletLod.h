@@ -0,0 +1,74 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "MeshletBuilder.h"
+
+///-------------------------------------------------------------------------------------------------
+/// Hierarchical meshlet LOD
+///
+/// Meshlets of the full mesh are the leaves of a DAG. Every level groups meshlets of the previous
+/// one by spatial proximity, simplifies each group with its border locked and splits it into new
+/// meshlets again. Simplification only collapses edges onto existing vertices, so every level
+/// indexes the source vertex buffer.
+///
+/// A meshlet is drawn if its own error is small enough on screen and its parent group's error
+/// isn't. The group's sphere and error are stored identically on both sides of the group, and
+/// they grow monotonically towards the roots, so every view selects a crack-free cut.
+///-------------------------------------------------------------------------------------------------
+
+struct MeshletLodCluster
+{
+    float    LodSphere[4];      // Sphere of the group that produced the meshlet, xyz = center, w = radius
+    float    Error;             // Object space error of the meshlet, 0 for the leaves
+    float    ParentSphere[4];
+    float    ParentError;       // FLT_MAX for the roots
+    uint32_t Level;
+};
+
+struct MeshletLodMesh
+{
+    // Layout of Mesh, all levels are in a single subset, indices are 32-bit
+    std::vector<Meshlet>            Meshlets;
+    std::vector<uint32_t>           UniqueVertexIndices;
+    std::vector<PackedTriangle>     PrimitiveIndices;
+    std::vector<CullData>           CullingData;
+
+    std::vector<MeshletLodCluster>  Clusters;
+    uint32_t                        LevelCount = 0;
+};
+
+struct MeshletLodBuildDesc
+{
+    MeshletBuildDesc Meshlets;
+
+    uint32_t MeshletsPerGroup = 4;
+    uint32_t MaxLevels = 16;
+
+    // A group that can't be simplified below this share of its triangles ends its branch of the DAG
+    float    MinReduction = 0.85f;
+};
+
+struct MeshletLodView
+{
+    float ViewPosition[3];      // In the model space
+    float ProjectionScale;      // Viewport height / (2 * tan(fovY / 2))
+    float ErrorThreshold;       // In pixels
+    float NearDistance = 0.01f;
+};
+
+// Groups are simplified by the thread pool if it's provided. Index subsets of the input are ignored.
+bool BuildMeshletLod(MeshletBuildInput const& input, MeshletLodBuildDesc const& desc, MeshletLodMesh& lod, ThreadPool* pThreadPool = nullptr);
+
+// Writes indices of selected meshlets to pSelected (room for every cluster), returns the selected count.
+// The indices are a MeshletPackList of lod.Meshlets, the cut is packed for the mesh shader by PackMeshlets.
+uint32_t SelectMeshletLod(MeshletLodMesh const& lod, MeshletLodView const& view, uint32_t* pSelected, ThreadPool* pThreadPool = nullptr);
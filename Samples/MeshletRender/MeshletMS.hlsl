@@ -17,10 +17,15 @@ struct Constants
     uint     DrawMeshlets;
 };
 
-struct MeshInfo
+// Location of a mesh in the merged buffers of the model
+struct MeshOffsets
 {
-    uint IndexBytes;
+    uint VertexOffset;
     uint MeshletOffset;
+    uint UniqueVertexIndexOffset;
+    uint PrimitiveOffset;
+    uint IndexBytes;
+    uint3 Padding;
 };
 
 struct Vertex
@@ -45,13 +50,14 @@ struct Meshlet
     uint PrimOffset;
 };
 
-ConstantBuffer<Constants> Globals             : register(b0);
-ConstantBuffer<MeshInfo>  MeshInfo            : register(b1);
+ConstantBuffer<Constants>       Globals             : register(b0);
 
-StructuredBuffer<Vertex>  Vertices            : register(t0);
-StructuredBuffer<Meshlet> Meshlets            : register(t1);
-ByteAddressBuffer         UniqueVertexIndices : register(t2);
-StructuredBuffer<uint>    PrimitiveIndices    : register(t3);
+StructuredBuffer<Vertex>        Vertices            : register(t0);
+StructuredBuffer<Meshlet>       Meshlets            : register(t1);
+ByteAddressBuffer               UniqueVertexIndices : register(t2);
+StructuredBuffer<uint>          PrimitiveIndices    : register(t3);
+StructuredBuffer<uint2>         MeshletPacks        : register(t4);
+StructuredBuffer<MeshOffsets>   Meshes              : register(t5);
 
 
 /////
@@ -63,24 +69,24 @@ uint3 UnpackPrimitive(uint primitive)
     return uint3(primitive & 0x3FF, (primitive >> 10) & 0x3FF, (primitive >> 20) & 0x3FF);
 }
 
-uint3 GetPrimitive(Meshlet m, uint index)
+uint3 GetPrimitive(MeshOffsets mesh, Meshlet m, uint index)
 {
-    return UnpackPrimitive(PrimitiveIndices[m.PrimOffset + index]);
+    return UnpackPrimitive(PrimitiveIndices[mesh.PrimitiveOffset + m.PrimOffset + index]);
 }
 
-uint GetVertexIndex(Meshlet m, uint localIndex)
+uint GetVertexIndex(MeshOffsets mesh, Meshlet m, uint localIndex)
 {
     localIndex = m.VertOffset + localIndex;
 
-    if (MeshInfo.IndexBytes == 4) // 32-bit Vertex Indices
+    if (mesh.IndexBytes == 4) // 32-bit Vertex Indices
     {
-        return UniqueVertexIndices.Load(localIndex * 4);
+        return UniqueVertexIndices.Load(mesh.UniqueVertexIndexOffset + localIndex * 4);
     }
     else // 16-bit Vertex Indices
     {
-        // Byte address must be 4-byte aligned.
+        // Byte address must be 4-byte aligned, indices of every mesh start at an aligned offset.
         uint wordOffset = (localIndex & 0x1);
-        uint byteOffset = (localIndex / 2) * 4;
+        uint byteOffset = mesh.UniqueVertexIndexOffset + (localIndex / 2) * 4;
 
         // Grab the pair of 16-bit indices, shift & mask off proper 16-bits.
         uint indexPair = UniqueVertexIndices.Load(byteOffset);
@@ -90,9 +96,9 @@ uint GetVertexIndex(Meshlet m, uint localIndex)
     }
 }
 
-VertexOut GetVertexAttributes(uint meshletIndex, uint vertexIndex)
+VertexOut GetVertexAttributes(MeshOffsets mesh, uint meshletIndex, uint vertexIndex)
 {
-    Vertex v = Vertices[vertexIndex];
+    Vertex v = Vertices[mesh.VertexOffset + vertexIndex];
 
     VertexOut vout;
     vout.PositionVS = mul(float4(v.Position, 1), Globals.WorldView).xyz;
@@ -104,6 +110,8 @@ VertexOut GetVertexAttributes(uint meshletIndex, uint vertexIndex)
 }
 
 
+// A group draws several meshlets of any meshes: the pack table starts with uint2(first entry, entry count) of every group,
+// an entry is uint2(meshlet index in the merged buffer, first output vertex | first output primitive << 8 | mesh index << 16)
 [NumThreads(128, 1, 1)]
 [OutputTopology("triangle")]
 void main(
@@ -113,18 +121,33 @@ void main(
     out vertices VertexOut verts[64]
 )
 {
-    Meshlet m = Meshlets[MeshInfo.MeshletOffset + gid];
+    uint2 group = MeshletPacks[gid];
 
-    SetMeshOutputCounts(m.VertCount, m.PrimCount);
+    // Outputs of the group end with its last meshlet
+    uint2 last = MeshletPacks[group.x + group.y - 1];
+    Meshlet lastMeshlet = Meshlets[last.x];
 
-    if (gtid < m.PrimCount)
-    {
-        tris[gtid] = GetPrimitive(m, gtid);
-    }
+    SetMeshOutputCounts((last.y & 0xff) + lastMeshlet.VertCount, ((last.y >> 8) & 0xff) + lastMeshlet.PrimCount);
 
-    if (gtid < m.VertCount)
+    for (uint i = 0; i < group.y; ++i)
     {
-        uint vertexIndex = GetVertexIndex(m, gtid);
-        verts[gtid] = GetVertexAttributes(gid, vertexIndex);
+        uint2 entry = MeshletPacks[group.x + i];
+        uint meshletIndex = entry.x;
+        uint vertexBase = entry.y & 0xff;
+        uint primitiveBase = (entry.y >> 8) & 0xff;
+
+        MeshOffsets mesh = Meshes[entry.y >> 16];
+        Meshlet m = Meshlets[meshletIndex];
+
+        if (gtid >= primitiveBase && gtid < primitiveBase + m.PrimCount)
+        {
+            tris[gtid] = GetPrimitive(mesh, m, gtid - primitiveBase) + vertexBase;
+        }
+
+        if (gtid >= vertexBase && gtid < vertexBase + m.VertCount)
+        {
+            uint vertexIndex = GetVertexIndex(mesh, m, gtid - vertexBase);
+            verts[gtid] = GetVertexAttributes(mesh, meshletIndex, vertexIndex);
+        }
     }
 }
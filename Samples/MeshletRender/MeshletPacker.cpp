@@ -0,0 +1,127 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Model.h"
+#include "MeshletPacker.h"
+
+#include <algorithm>
+
+static_assert(sizeof(MeshletPackGroup) == 2 * sizeof(uint32_t), "Pack table elements are uint2");
+static_assert(sizeof(MeshletPackEntry) == 2 * sizeof(uint32_t), "Pack table elements are uint2");
+
+namespace
+{
+    ///---------------------------------------------------------------------------------------------
+    /// Next-fit packing with a single open group. A meshlet that doesn't fit the open group
+    /// competes with it: the fuller of the two is written out and the other one stays open, so
+    /// full meshlets pass through without closing a group of small ones.
+    ///---------------------------------------------------------------------------------------------
+
+    class Packer
+    {
+    public:
+        Packer(MeshletPackDesc const& desc, uint32_t capacity, void* pTable)
+            : m_Desc(desc)
+            , m_pGroups(static_cast<MeshletPackGroup*>(pTable))
+            , m_pEntries(static_cast<MeshletPackEntry*>(pTable) + GetMeshletPackEntryOffset(capacity))
+            , m_EntryOffset(GetMeshletPackEntryOffset(capacity))
+        {
+        }
+
+        void Add(uint32_t meshletIndex, Meshlet const& meshlet, uint32_t tag)
+        {
+            if (m_OpenCount < m_Desc.MaxMeshletsPerGroup &&
+                m_OpenVertices + meshlet.VertCount <= m_Desc.MaxVertices &&
+                m_OpenPrimitives + meshlet.PrimCount <= m_Desc.MaxPrimitives)
+            {
+                Append(meshletIndex, meshlet, tag);
+                return;
+            }
+
+            if (Fill(meshlet.VertCount, meshlet.PrimCount) >= Fill(m_OpenVertices, m_OpenPrimitives))
+            {
+                // Entries of the open group move by one, written entries stay contiguous
+                MeshletPackEntry* pOpen = m_pEntries + m_Result.EntryCount;
+                std::copy_backward(pOpen, pOpen + m_OpenCount, pOpen + m_OpenCount + 1);
+
+                m_pGroups[m_Result.GroupCount++] = { m_EntryOffset + m_Result.EntryCount, 1 };
+                m_pEntries[m_Result.EntryCount++] = { meshletIndex, tag << 16 };
+                return;
+            }
+
+            Close();
+            Append(meshletIndex, meshlet, tag);
+        }
+
+        MeshletPackResult Finish()
+        {
+            Close();
+            return m_Result;
+        }
+
+    private:
+        float Fill(uint32_t vertices, uint32_t primitives) const
+        {
+            return (std::max)(float(vertices) / m_Desc.MaxVertices, float(primitives) / m_Desc.MaxPrimitives);
+        }
+
+        void Append(uint32_t meshletIndex, Meshlet const& meshlet, uint32_t tag)
+        {
+            // Entries of the open group are kept past the written ones until it's closed
+            m_pEntries[m_Result.EntryCount + m_OpenCount++] = { meshletIndex, m_OpenVertices | (m_OpenPrimitives << 8) | (tag << 16) };
+
+            m_OpenVertices += meshlet.VertCount;
+            m_OpenPrimitives += meshlet.PrimCount;
+        }
+
+        void Close()
+        {
+            if (m_OpenCount == 0)
+                return;
+
+            m_pGroups[m_Result.GroupCount++] = { m_EntryOffset + m_Result.EntryCount, m_OpenCount };
+            m_Result.EntryCount += m_OpenCount;
+
+            m_OpenCount = 0;
+            m_OpenVertices = 0;
+            m_OpenPrimitives = 0;
+        }
+
+        MeshletPackDesc const&  m_Desc;
+        MeshletPackGroup*       m_pGroups;
+        MeshletPackEntry*       m_pEntries;
+        const uint32_t          m_EntryOffset;
+
+        MeshletPackResult       m_Result = {};
+
+        uint32_t                m_OpenCount = 0;
+        uint32_t                m_OpenVertices = 0;
+        uint32_t                m_OpenPrimitives = 0;
+    };
+}
+
+MeshletPackResult PackMeshlets(const MeshletPackList* pLists, uint32_t listCount, uint32_t capacity, MeshletPackDesc const& desc, void* pTable)
+{
+    Packer packer(desc, capacity, pTable);
+
+    for (uint32_t i = 0; i < listCount; ++i)
+    {
+        MeshletPackList const& list = pLists[i];
+
+        for (uint32_t j = 0; j < list.Count; ++j)
+        {
+            uint32_t index = list.pIndices[j];
+            packer.Add(list.MeshletOffset + index, list.pMeshlets[index], list.Tag & 0xffff);
+        }
+    }
+
+    return packer.Finish();
+}
@@ -0,0 +1,74 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstdint>
+
+struct Meshlet;
+
+///-------------------------------------------------------------------------------------------------
+/// Meshlet packing
+///
+/// Small meshlets leave most threads of a mesh shader group idle. The packer merges meshlets of
+/// any number of lists (subsets, meshes, LOD cuts) into groups that fill the vertex and
+/// primitive outputs of the shader, one group per dispatched thread group.
+///
+/// The pack table is an array of uint2 uploaded as a structured buffer: MeshletPackGroup headers
+/// of the dispatched groups come first, MeshletPackEntry records start at the element
+/// GetMeshletPackEntryOffset(capacity). Headers address entries by their absolute element.
+///-------------------------------------------------------------------------------------------------
+
+struct MeshletPackDesc
+{
+    // Outputs declared by the mesh shader, at most 256 each
+    uint32_t MaxVertices = 64;
+    uint32_t MaxPrimitives = 126;
+
+    // Bounds the loop of the shader over the meshlets of a group
+    uint32_t MaxMeshletsPerGroup = 32;
+};
+
+// Meshlets of a single source to pack, e.g. the visible meshlets of a mesh
+struct MeshletPackList
+{
+    const Meshlet*  pMeshlets;      // Meshlets the indices refer to
+    const uint32_t* pIndices;
+    uint32_t        Count;
+    uint32_t        MeshletOffset;  // Added to the indices in the table, e.g. the first meshlet of a mesh in merged buffers
+    uint32_t        Tag;            // 16 bits passed to the shader with every meshlet, e.g. the index of the mesh
+};
+
+struct MeshletPackGroup
+{
+    uint32_t FirstEntry;
+    uint32_t EntryCount;
+};
+
+struct MeshletPackEntry
+{
+    uint32_t MeshletIndex;
+    uint32_t Bases;         // First output vertex in bits 0-7, first output primitive in bits 8-15, tag in bits 16-31
+};
+
+// Table elements for up to capacity meshlets, every meshlet may end up in a group of its own
+inline uint32_t GetMeshletPackEntryOffset(uint32_t capacity) { return capacity; }
+inline uint32_t GetMeshletPackTableSize(uint32_t capacity) { return capacity * 2; }
+
+struct MeshletPackResult
+{
+    uint32_t GroupCount;    // Thread groups to dispatch
+    uint32_t EntryCount;
+};
+
+// Packs the meshlets of all lists. pTable has room for GetMeshletPackTableSize(capacity) uint2 elements,
+// capacity is at least the total size of the lists.
+MeshletPackResult PackMeshlets(const MeshletPackList* pLists, uint32_t listCount, uint32_t capacity, MeshletPackDesc const& desc, void* pTable);
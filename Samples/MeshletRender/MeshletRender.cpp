@@ -18,6 +18,7 @@
 const char* c_meshShaderFilename = "MeshletMS.cso";
 const char* c_pixelShaderFilename = "MeshletPS.cso";
 const char* c_meshFilename = "Dragon_LOD0.bin";
+const char* c_compressedMeshFilename = "Dragon_LOD0.mshlz";
 
 const SG_COLOR_4F ClearColor = { 0.0f, 0.2f, 0.4f, 1.0f };
 
@@ -32,11 +33,12 @@ MeshletRender::MeshletRender(U32 width, U32 height, wchar_t const* windowName)
 
     , m_pPipelineState(SG_NULL)
 
-    , m_pDepthStencil(SG_NULL)
-    , m_pDSView(SG_NULL)
+    , m_DepthDesc{}
+
+    , m_pFrameConstants(SG_NULL)
+    , m_ModelResidency(InvalidResidencyHandle)
 
     , m_Camera(false)
-    , m_FrameIndex(0)
     , m_CurrentAngle(0.0f)
 {
     m_Camera.SetFOV(DEG2RAD(60.0f));
@@ -60,13 +62,14 @@ void MeshletRender::OnInit()
 
     SG_EXECUTION_CONTEXT_DESC execCtxDesc{};
     execCtxDesc.FrameBuffers = NumFrames;
-    execCtxDesc.QueueCount = 1;
+    execCtxDesc.QueueCount = 2;
     execCtxDesc.QueueTypes[0] = SG_QUEUE_TYPE_GRAPHICS;
+    execCtxDesc.QueueTypes[1] = SG_QUEUE_TYPE_COPY;
 
     SG_DEVICE_DESC deviceDesc{};
     deviceDesc.pExecutionContextDesc = &execCtxDesc;
 
-    if (SgCreateDevice(pAdapter, &deviceDesc, &m_pDevice) != SG_OK)
+    if (CreateDevice(pAdapter, &deviceDesc, &m_pDevice) != SG_OK)
         throw std::exception("Failed device object creation");
 
     SG_RELEASE(pAdapter);
@@ -80,7 +83,7 @@ void MeshletRender::OnInit()
     swapChainDesc.Flags = SG_SWAP_CHAIN_FLAG_ALLOW_TEARING;
     swapChainDesc.SwapEffect = SG_SWAP_EFFECT_SEQUENTIAL;
 
-    if (SgCreateSwapChain(m_pExecutionContext, 0, &swapChainDesc, &m_pSwapChain) != SG_OK)
+    if (CreateSwapChain(m_pExecutionContext, 0, &swapChainDesc, &m_pSwapChain) != SG_OK)
         throw std::exception("Failed swap chain creation");
 
     LoadPipelineState();
@@ -91,12 +94,15 @@ void MeshletRender::OnDestroy()
 {
     m_pExecutionContext->WaitForIdle();
 
+    m_Residency.Unregister(m_ModelResidency);
+    m_Residency.Destroy();
     m_Model = {};
-    for (int i = 0; i < _countof(m_pConstantBuffers); i++)
-        SG_RELEASE(m_pConstantBuffers[i]);
+    m_pFrameConstants = SG_NULL;
+    m_UploadRing.Destroy();
+    m_UploadStream.Destroy();
+    m_BufferHeap.Destroy();
 
-    SG_RELEASE(m_pDSView);
-    SG_RELEASE(m_pDepthStencil);
+    m_TransientPool.Destroy();
 
     SG_RELEASE(m_pPipelineState);
 
@@ -118,8 +124,8 @@ void MeshletRender::LoadPipelineState()
     psoDesc.PS = { psBuffer.data(), psBuffer.size() };
 
     SG_BINDING_TABLE_DESC table{};
-    table.ConstantBuffers   = { 0, 0, 2 };
-    table.SRVs              = { 0, 0, 4 };
+    table.ConstantBuffers   = { 0, 0, 1 };
+    table.SRVs              = { 0, 0, 6 };
     table.ShaderVisibility  = SG_SHADER_VISIBILITY_ALL;
 
     psoDesc.RootSignature.Type = SG_ROOT_SIGNATURE_TYPE_TABULAR;
@@ -131,43 +137,42 @@ void MeshletRender::LoadPipelineState()
 
 void MeshletRender::LoadAssets()
 {
-    // Create depth texture and its DSV.
-    {
-        SG_TEXTURE_DESC depthTextureDesc = FastTextureDesc::Tex2D(SG_TEXTURE_TYPE_DEPTH_STENCIL, m_Width, m_Height, SG_FORMAT_D16_UNORM, 1, false, false);
-        depthTextureDesc.DefaultValue.Format = SG_FORMAT_D16_UNORM;
-        depthTextureDesc.DefaultValue.Depth = 1.0f;
+    // The depth texture is requested from the transient pool by every frame, it's only used by the drawing pass
+    m_DepthDesc = FastTextureDesc::Tex2D(SG_TEXTURE_TYPE_DEPTH_STENCIL, m_Width, m_Height, SG_FORMAT_D16_UNORM, 1, false, false);
+    m_DepthDesc.DefaultValue.Format = SG_FORMAT_D16_UNORM;
+    m_DepthDesc.DefaultValue.Depth = 1.0f;
 
-        if (m_pDevice->CreateTexture(&depthTextureDesc, &m_pDepthStencil) != SG_OK)
-            throw std::exception("Failed to create depth texture");
+    m_TransientPool.Init(m_pDevice);
 
-        SG_DEPTH_STENCIL_VIEW_DESC dsvDesc = FastViewDesc::AsDepthStencil(SG_FORMAT_D16_UNORM, 0, 0);
-        if (m_pDevice->CreateDepthStencilView(m_pDepthStencil, &dsvDesc, &m_pDSView) != SG_OK)
-            throw std::exception("Failed to create DSV");
-    }
+    // Per-frame constants are allocated from the ring, it recycles them when a frame buffer retires.
+    m_UploadRing.Init(m_pDevice, NumFrames);
+
+    // Model data is streamed by the copy queue over several frames, meshes are drawn as soon as they are available
+    m_UploadStream.Init(m_pDevice, NumFrames, CopyQueue);
 
-    // Create constant buffers.
-    for (U32 i = 0; i < _countof(m_pConstantBuffers); i++)
+    // Small buffers of the model are placed in shared pages instead of a committed buffer each
+    m_BufferHeap.Init(m_pDevice, NumFrames, FastBufferDesc::Structured(0, true, false, false));
+
+    // Meshes are parsed, and their resources are created, by the thread pool.
+    // The compressed copy of the model is created on the first run, the initial file is used if it can't be written.
+    if (!m_Model.LoadFromFile(c_compressedMeshFilename, &m_ThreadPool))
     {
-        SG_BUFFER_DESC cbDesc = FastBufferDesc::Constant(sizeof(Constants));
+        CompressModelFile(c_meshFilename, c_compressedMeshFilename);
 
-        if (m_pDevice->CreateBuffer(&cbDesc, &m_pConstantBuffers[i]) != SG_OK)
-            throw std::exception("Failed to create constant buffer");
+        if (!m_Model.LoadFromFile(c_compressedMeshFilename, &m_ThreadPool) && !m_Model.LoadFromFile(c_meshFilename, &m_ThreadPool))
+            throw std::exception("Failed to load a model");
     }
 
-    if (!m_Model.LoadFromFile(c_meshFilename))
-        throw std::exception("Failed to load a model");
-
-    // Upload frame
-    {
-        m_pExecutionContext->BeginFrame();
-        ISGCommandList* pCommandList;
-        if (m_pExecutionContext->ScheduleCommandList(0, 1, &pCommandList) == SG_OK)
+    // The model can be recreated from the mapped file, so its buffers are released if they stay unused while
+    // the video memory is over the budget. Meshes are merged into shared buffers, their vertex streams have to match.
+    m_Residency.Init(m_pDevice, NumFrames);
+    m_ModelResidency = m_Residency.Register(m_Model.GetGpuResourceSize(), ResidencyPriority::Normal,
+        [this]()
         {
-            m_Model.UploadGpuResources(m_pDevice, pCommandList);
-            m_pExecutionContext->FinishCommandList(pCommandList);
-        }
-        m_pExecutionContext->EndFrame();
-    }
+            if (!m_Model.UploadGpuResources(m_pDevice, m_UploadStream, m_BufferHeap, &m_ThreadPool))
+                throw std::exception("Failed to create model resources");
+        },
+        [this]() { m_Model.ReleaseGpuResources(m_BufferHeap); });
 }
 
 void MeshletRender::OnUpdate()
@@ -185,10 +190,20 @@ void MeshletRender::OnUpdate()
 void MeshletRender::OnRender()
 {
     m_pExecutionContext->BeginFrame();
+    m_UploadRing.BeginFrame();
+    m_TransientPool.BeginFrame();
+    m_BufferHeap.BeginFrame();
+    m_Residency.BeginFrame();
+
+    // Restored buffers are drawn as soon as their uploads, which are queued by the restore, complete
+    m_Residency.MakeResident(m_ModelResidency);
+    m_UploadStream.Update(m_pExecutionContext, UploadTimeIndex);
 
     // Update buffer after frame has begun to prevent data race
     {
-        m_Camera.SetPosition({ cos(m_CurrentAngle) * 150.0f, 75, sin(m_CurrentAngle) * 150.0f });
+        XMFLOAT3 viewPosition = { cos(m_CurrentAngle) * 150.0f, 75, sin(m_CurrentAngle) * 150.0f };
+
+        m_Camera.SetPosition(viewPosition);
         m_Camera.SetTarget({ 0, 75, 0 });
         m_Camera.Update();
 
@@ -200,46 +215,133 @@ void MeshletRender::OnRender()
         cbData.WorldViewProj = XMMatrixTranspose(world * m_Camera.GetViewProjection());
         cbData.DrawMeshlets = true;
 
-        UploadBuffer(m_pConstantBuffers[m_FrameIndex], &cbData, sizeof(cbData));
+        m_pFrameConstants = m_UploadRing.AllocateConstants(&cbData, sizeof(cbData));
+
+        UpdateVisibleMeshlets(world, viewPosition);
     }
 
     ISGCommandList* pCommandList = nullptr;
-    if (m_pExecutionContext->ScheduleCommandList(0, 1, &pCommandList) == SG_OK)
+    if (m_pExecutionContext->ScheduleCommandList(GraphicsQueue, DrawTimeIndex, &pCommandList) == SG_OK)
     {
-        PopulateCommandList(pCommandList);
+        // Bindings are recorded through the filter, which drops the redundant ones
+        m_StateFilter.Begin(pCommandList);
+        PopulateCommandList(&m_StateFilter);
+        m_StateFilter.End();
+
         m_pExecutionContext->FinishCommandList(pCommandList);
     }
 
     m_pExecutionContext->EndFrame1(1, &m_pSwapChain);
-    m_FrameIndex = (m_FrameIndex + 1) % NumFrames;
+}
+
+void MeshletRender::UpdateVisibleMeshlets(XMMATRIX const& world, XMFLOAT3 const& viewPosition)
+{
+    // Culling is done in the model space of meshes
+    XMFLOAT4X4 worldViewProj;
+    XMStoreFloat4x4(&worldViewProj, world * m_Camera.GetViewProjection());
+
+    XMFLOAT3 modelViewPosition;
+    XMStoreFloat3(&modelViewPosition, XMVector3TransformCoord(XMLoadFloat3(&viewPosition), XMMatrixInverse(nullptr, world)));
+
+    MeshletCullView view = MeshletCullView::Create(worldViewProj.m, &modelViewPosition.x);
+
+    m_Visibility.resize(m_Model.GetMeshCount());
+
+    // Meshes are culled in parallel
+    m_ThreadPool.ParallelFor(m_Model.GetMeshCount(), [&](SgU32 i)
+    {
+        const Mesh& mesh = m_Model.GetMesh(i);
+        MeshVisibility& visibility = m_Visibility[i];
+
+        visibility.SubsetCounts.assign(mesh.MeshletSubsets.size(), 0);
+
+        if (!m_UploadStream.IsAvailable(mesh.UploadTicket) || mesh.Meshlets.size() == 0)
+            return;
+
+        visibility.VisibleMeshlets.resize(mesh.Meshlets.size());
+
+        for (UINT j = 0; j < mesh.MeshletSubsets.size(); j++)
+        {
+            const Subset& subset = mesh.MeshletSubsets[j];
+            visibility.SubsetCounts[j] = CullMeshlets(mesh.Bounds, view, subset.Offset, subset.Count, visibility.VisibleMeshlets.data() + subset.Offset);
+        }
+    });
+
+    // Meshlets of all meshes and subsets fill thread groups together, the mesh index is the tag of its meshlets
+    m_PackLists.clear();
+
+    for (UINT i = 0; i < m_Model.GetMeshCount(); i++)
+    {
+        const Mesh& mesh = m_Model.GetMesh(i);
+        const MeshVisibility& visibility = m_Visibility[i];
+
+        for (UINT j = 0; j < visibility.SubsetCounts.size(); j++)
+        {
+            if (visibility.SubsetCounts[j] != 0)
+            {
+                m_PackLists.push_back({ mesh.Meshlets.data(), visibility.VisibleMeshlets.data() + mesh.MeshletSubsets[j].Offset,
+                    visibility.SubsetCounts[j], mesh.Offsets.MeshletOffset, i });
+            }
+        }
+    }
+
+    const ModelBuffers& buffers = m_Model.GetBuffers();
+
+    // Pack table and dispatch arguments are written straight to upload memory of the frame
+    m_DrawPacket.PackTable = m_UploadRing.Allocate(GetMeshletPackTableSize(buffers.MeshletCount) * sizeof(MeshletPackEntry), sizeof(MeshletPackEntry));
+    m_DrawPacket.Packing = PackMeshlets(m_PackLists.data(), static_cast<uint32_t>(m_PackLists.size()), buffers.MeshletCount, MeshletPackDesc(),
+        m_DrawPacket.PackTable.pCpuAddress);
+
+    m_DrawPacket.DispatchArgs = m_UploadRing.Allocate(sizeof(SG_DISPATCH_MESH_INDIRECT_ARGS), sizeof(SgU32));
+
+    SG_DISPATCH_MESH_INDIRECT_ARGS* pArgs = static_cast<SG_DISPATCH_MESH_INDIRECT_ARGS*>(m_DrawPacket.DispatchArgs.pCpuAddress);
+    pArgs->ThreadGroupCountX = m_DrawPacket.Packing.GroupCount;
+    pArgs->ThreadGroupCountY = 1;
+    pArgs->ThreadGroupCountZ = 1;
 }
 
 void MeshletRender::PopulateCommandList(ISGCommandList* pCommandList)
 {
+    const ModelBuffers& buffers = m_Model.GetBuffers();
+
+    // The pack table is copied before the pass: group headers start it, entries follow at a fixed offset
+    if (m_DrawPacket.Packing.GroupCount != 0)
+    {
+        U32 entryOffset = GetMeshletPackEntryOffset(buffers.MeshletCount) * sizeof(MeshletPackEntry);
+
+        pCommandList->CopyBufferRegion(buffers.MeshletPackResource.Resourse.Get(), buffers.MeshletPackResource.Offset,
+            m_DrawPacket.PackTable.pBuffer, m_DrawPacket.PackTable.Offset, m_DrawPacket.Packing.GroupCount * sizeof(MeshletPackGroup));
+        pCommandList->CopyBufferRegion(buffers.MeshletPackResource.Resourse.Get(), buffers.MeshletPackResource.Offset + entryOffset,
+            m_DrawPacket.PackTable.pBuffer, m_DrawPacket.PackTable.Offset + entryOffset, m_DrawPacket.Packing.EntryCount * sizeof(MeshletPackEntry));
+    }
+
     pCommandList->SetRenderTarget(0, m_pSwapChain->GetCurrentRTV());
     pCommandList->ClearRenderTarget(m_pSwapChain->GetCurrentRTV(), &ClearColor);
 
-    pCommandList->SetDepthStencil(m_pDSView);
-    pCommandList->ClearDepthStencil(m_pDSView, SG_CLEAR_FLAG_DEPTH, 1.0f, 0);
+    // Content of a transient texture is undefined, the clear initializes it
+    ISGTexture* pDepthStencil = m_TransientPool.AcquireTexture(m_DepthDesc, DrawTimeIndex, DrawTimeIndex);
+    ISGDepthStencilView* pDSView = m_TransientPool.GetDepthStencilView(pDepthStencil, FastViewDesc::AsDepthStencil(SG_FORMAT_D16_UNORM, 0, 0));
+
+    pCommandList->SetDepthStencil(pDSView);
+    pCommandList->ClearDepthStencil(pDSView, SG_CLEAR_FLAG_DEPTH, 1.0f, 0);
 
     pCommandList->SetViewports(1, &m_Viewport);
     pCommandList->SetScissorRects(1, &m_Scissor);
 
     pCommandList->SetPipelineState(m_pPipelineState);
 
-    pCommandList->SetConstantBuffer(0, 0, m_pConstantBuffers[m_FrameIndex]);
+    pCommandList->SetConstantBuffer(0, 0, m_pFrameConstants);
 
-    for (auto& mesh : m_Model)
-    {
-        pCommandList->SetShaderResource(0, 0, mesh.VertexResources[0].View.Get());
-        pCommandList->SetShaderResource(0, 1, mesh.MeshletResource.View.Get());
-        pCommandList->SetShaderResource(0, 2, mesh.UniqueVertexIndexResource.View.Get());
-        pCommandList->SetShaderResource(0, 3, mesh.PrimitiveIndexResource.View.Get());
+    if (m_DrawPacket.Packing.GroupCount == 0)
+        return;
 
-        for (UINT i = 0; i < mesh.MeshletSubsets.size(); i++)
-        {
-            pCommandList->SetConstantBuffer(0, 1, mesh.MeshletInfoCBs[i].Get());
-            pCommandList->DispatchMesh(mesh.MeshletSubsets[i].Count, 1, 1);
-        }
-    }
+    // Every mesh is in the merged buffers, the whole model takes a single set of bindings and one dispatch
+    pCommandList->SetShaderResource(0, 0, buffers.VertexResources[0].View.Get());
+    pCommandList->SetShaderResource(0, 1, buffers.MeshletResource.View.Get());
+    pCommandList->SetShaderResource(0, 2, buffers.UniqueVertexIndexResource.View.Get());
+    pCommandList->SetShaderResource(0, 3, buffers.PrimitiveIndexResource.View.Get());
+    pCommandList->SetShaderResource(0, 4, buffers.MeshletPackResource.View.Get());
+    pCommandList->SetShaderResource(0, 5, buffers.MeshOffsetResource.View.Get());
+
+    pCommandList->DispatchMeshIndirect(1, m_DrawPacket.DispatchArgs.pBuffer, m_DrawPacket.DispatchArgs.Offset);
 }
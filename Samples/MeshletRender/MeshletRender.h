@@ -18,6 +18,10 @@
 #include "SGX/SGSample.h"
 #include <DirectXMath.h>
 #include "Model.h"
+#include "SGX/SGFrameUploadRing.h"
+#include "SGX/SGResidency.h"
+#include "SGX/SGStateFilter.h"
+#include "SGX/SGTransientPool.h"
 
 class MeshletRender : public ISGSample
 {
@@ -42,6 +46,29 @@ private:
     // Number of frame buffers
     static const uint32_t NumFrames = 3;
 
+    // Queues of the execution context
+    static const SgU8 GraphicsQueue = 0;
+    static const SgU8 CopyQueue = 1;
+
+    // Visible meshlets of a mesh for the current frame, the list of a subset starts at the subset's offset
+    struct MeshVisibility
+    {
+        std::vector<uint32_t>   VisibleMeshlets;
+        std::vector<uint32_t>   SubsetCounts;
+    };
+
+    // Visible meshlets of the whole model packed into the thread groups of a single indirect dispatch
+    struct DrawPacket
+    {
+        UploadAllocation        PackTable;
+        UploadAllocation        DispatchArgs;
+        MeshletPackResult       Packing;
+    };
+
+    // Streamed copies precede drawing of the same frame
+    static const SgU16 UploadTimeIndex = 1;
+    static const SgU16 DrawTimeIndex = 2;
+
     SG_VIEWPORT m_Viewport;
     SG_RECT m_Scissor;
 
@@ -50,19 +77,29 @@ private:
     ISGSwapChain* m_pSwapChain;
 
     ISGPipelineState* m_pPipelineState;
+    StateFilterCommandList m_StateFilter;
 
-    ISGBuffer* m_pConstantBuffers[NumFrames];
+    FrameUploadRing m_UploadRing;
+    UploadStream m_UploadStream;
+    BufferHeap m_BufferHeap;
+    ResidencyManager m_Residency;
+    ResidencyHandle m_ModelResidency;
+    ThreadPool m_ThreadPool;
+    ISGBuffer* m_pFrameConstants;
 
-    ISGTexture* m_pDepthStencil;
-    ISGDepthStencilView* m_pDSView;
+    TransientPool m_TransientPool;
+    SG_TEXTURE_DESC m_DepthDesc;
 
     TimeScaler m_TimeScaler;
     Camera m_Camera;
     Model m_Model;
-    U32 m_FrameIndex;
+    std::vector<MeshVisibility> m_Visibility;
+    std::vector<MeshletPackList> m_PackLists;
+    DrawPacket m_DrawPacket;
     float m_CurrentAngle;
 
     void LoadPipelineState();
     void LoadAssets();
+    void UpdateVisibleMeshlets(XMMATRIX const& world, XMFLOAT3 const& viewPosition);
     void PopulateCommandList(ISGCommandList* pCommandList);
 };
@@ -12,60 +12,14 @@
 #include "Span.h"
 #include "Model.h"
 
-#include <fstream>
+#include <atomic>
+#include <cstring>
 #include <unordered_set>
 
 using namespace DirectX;
 
 namespace
 {
-    const uint32_t c_prolog = 'MSHL';
-
-    enum FileVersion
-    {
-        FILE_VERSION_INITIAL = 0,
-        CURRENT_FILE_VERSION = FILE_VERSION_INITIAL
-    };
-
-    struct FileHeader
-    {
-        uint32_t Prolog;
-        uint32_t Version;
-
-        uint32_t MeshCount;
-        uint32_t AccessorCount;
-        uint32_t BufferViewCount;
-        uint32_t BufferSize;
-    };
-
-    struct MeshHeader
-    {
-        uint32_t Indices;
-        uint32_t IndexSubsets;
-        uint32_t Attributes[Attribute::Count];
-
-        uint32_t Meshlets;
-        uint32_t MeshletSubsets;
-        uint32_t UniqueVertexIndices;
-        uint32_t PrimitiveIndices;
-        uint32_t CullData;
-    };
-
-    struct BufferView
-    {
-        uint32_t Offset;
-        uint32_t Size;
-    };
-
-    struct Accessor
-    {
-        uint32_t BufferView;
-        uint32_t Offset;
-        uint32_t Size;
-        uint32_t Stride;
-        uint32_t Count;
-    };
-
     template <typename T, typename U>
     constexpr T DivRoundUp(T num, U denom)
     {
@@ -73,75 +27,174 @@ namespace
     }
 }
 
-bool Model::LoadFromFile(const char* filename)
+bool Model::LoadFromFile(const char* filename, ThreadPool* pThreadPool)
 {
-    std::ifstream stream(filename, std::ios::binary);
-    if (!stream.is_open())
+    MappedFile file;
+    if (!file.Open(filename))
     {
         return false;
     }
 
+    const uint8_t* fileData = file.GetData();
+    const uint64_t fileSize = file.GetSize();
+    uint64_t fileOffset = 0;
+
+    // Metadata is small, it's copied out of the mapping to be properly aligned
+    auto read = [&](void* dest, uint64_t size)
+    {
+        if (size > fileSize - fileOffset)
+            return false;
+
+        std::memcpy(dest, fileData + fileOffset, size);
+        fileOffset += size;
+        return true;
+    };
+
     std::vector<MeshHeader> meshes;
     std::vector<BufferView> bufferViews;
     std::vector<Accessor> accessors;
+    std::vector<StreamDesc> streams;
 
     FileHeader header;
-    stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!read(&header, sizeof(header)))
+    {
+        return false;
+    }
 
     if (header.Prolog != c_prolog)
     {
         return false; // Incorrect file format.
     }
 
-    if (header.Version != CURRENT_FILE_VERSION)
+    if (header.Version != FILE_VERSION_INITIAL && header.Version != FILE_VERSION_COMPRESSED)
     {
         return false; // Version mismatch between export and import serialization code.
     }
 
     // Read mesh metdata
     meshes.resize(header.MeshCount);
-    stream.read(reinterpret_cast<char*>(meshes.data()), meshes.size() * sizeof(meshes[0]));
-    
     accessors.resize(header.AccessorCount);
-    stream.read(reinterpret_cast<char*>(accessors.data()), accessors.size() * sizeof(accessors[0]));
-
     bufferViews.resize(header.BufferViewCount);
-    stream.read(reinterpret_cast<char*>(bufferViews.data()), bufferViews.size() * sizeof(bufferViews[0]));
+    streams.resize(header.BufferViewCount);
+
+    if (!read(meshes.data(), meshes.size() * sizeof(meshes[0])) ||
+        !read(accessors.data(), accessors.size() * sizeof(accessors[0])) ||
+        !read(bufferViews.data(), bufferViews.size() * sizeof(bufferViews[0])))
+    {
+        return false;
+    }
+
+    // Buffer views of the initial version are raw
+    if (header.Version == FILE_VERSION_COMPRESSED)
+    {
+        if (!read(streams.data(), streams.size() * sizeof(streams[0])))
+            return false;
+    }
+    else
+    {
+        for (size_t i = 0; i < streams.size(); ++i)
+            streams[i] = { STREAM_CODEC_RAW, bufferViews[i].Size };
+    }
+
+    // The rest of the file is the binary data, spans reference it in place
+    if (fileSize - fileOffset != header.BufferSize)
+    {
+        return false; // There's a problem if the file isn't completely consumed.
+    }
 
-    m_buffer.resize(header.BufferSize);
-    stream.read(reinterpret_cast<char*>(m_buffer.data()), header.BufferSize);
+    const uint8_t* buffer = fileData + fileOffset;
 
-    char eofbyte;
-    stream.read(&eofbyte, 1); // Read last byte to hit the eof bit
+    // A corrupted file must not make spans point outside of the mapping, nor decoding write outside of staging memory
+    for (uint32_t i = 0; i < header.BufferViewCount; ++i)
+    {
+        BufferView& bufferView = bufferViews[i];
+        if (bufferView.Offset > header.BufferSize || bufferView.Size > header.BufferSize - bufferView.Offset)
+            return false;
 
-    assert(stream.eof()); // There's a problem if we didn't completely consume the file contents.
+        if (!ValidateStream(streams[i], buffer + bufferView.Offset, bufferView.Size))
+            return false;
+    }
 
-    stream.close();
+    for (auto& accessor : accessors)
+    {
+        if (accessor.BufferView >= header.BufferViewCount)
+            return false;
+    }
 
-    // Populate mesh data from binary data and metadata.
+    // Populate mesh data from binary data and metadata. Meshes are independent, so they may be parsed in parallel.
     m_meshes.resize(meshes.size());
-    for (uint32_t i = 0; i < static_cast<uint32_t>(meshes.size()); ++i)
+
+    std::atomic<bool> valid(true);
+
+    auto loadMesh = [&](uint32_t i)
     {
         auto& meshView = meshes[i];
         auto& mesh = m_meshes[i];
 
-        // Index data
+        const uint32_t* accessorIndices = reinterpret_cast<const uint32_t*>(&meshView);
+        for (uint32_t j = 0; j < sizeof(MeshHeader) / sizeof(uint32_t); ++j)
         {
-            Accessor& accessor = accessors[meshView.Indices];
-            BufferView& bufferView = bufferViews[accessor.BufferView];
+            if (accessorIndices[j] != uint32_t(-1) && accessorIndices[j] >= header.AccessorCount)
+            {
+                valid = false;
+                return;
+            }
+        }
 
-            mesh.IndexSize = accessor.Size;
-            mesh.IndexCount = accessor.Count;
+        // Only the cull data and vertex attributes may be missing
+        const uint32_t requiredAccessors[] = { meshView.Indices, meshView.IndexSubsets, meshView.Meshlets,
+            meshView.MeshletSubsets, meshView.UniqueVertexIndices, meshView.PrimitiveIndices };
 
-            mesh.Indices = MakeSpan(m_buffer.data() + bufferView.Offset, bufferView.Size);
+        for (uint32_t accessorIndex : requiredAccessors)
+        {
+            if (accessorIndex == uint32_t(-1))
+            {
+                valid = false;
+                return;
+            }
         }
 
+        // Spans the CPU reads must lie within their buffer views
+        auto fitsBufferView = [&](const Accessor& accessor, size_t elementSize)
+        {
+            return static_cast<uint64_t>(accessor.Count) * elementSize <= bufferViews[accessor.BufferView].Size;
+        };
+
+        auto getStream = [&](uint32_t bufferViewIndex)
+        {
+            BufferView& bufferView = bufferViews[bufferViewIndex];
+            return EncodedStream{ MakeSpan(buffer + bufferView.Offset, bufferView.Size), streams[bufferViewIndex] };
+        };
+
+        auto isRaw = [&](uint32_t bufferViewIndex)
+        {
+            return streams[bufferViewIndex].Codec == STREAM_CODEC_RAW;
+        };
+
+        // Subsets and meshlets are used by the CPU, they are never compressed
+        if (!isRaw(accessors[meshView.IndexSubsets].BufferView) ||
+            !isRaw(accessors[meshView.Meshlets].BufferView) ||
+            !isRaw(accessors[meshView.MeshletSubsets].BufferView))
+        {
+            valid = false;
+            return;
+        }
+
+        // Index data, unique vertex indices have the size of the indices
+        mesh.IndexSize = accessors[meshView.Indices].Size;
+
         // Index Subset data
         {
             Accessor& accessor = accessors[meshView.IndexSubsets];
             BufferView& bufferView = bufferViews[accessor.BufferView];
 
-            mesh.IndexSubsets = MakeSpan(reinterpret_cast<Subset*>(m_buffer.data() + bufferView.Offset), accessor.Count);
+            if (!fitsBufferView(accessor, sizeof(Subset)))
+            {
+                valid = false;
+                return;
+            }
+
+            mesh.IndexSubsets = MakeSpan(reinterpret_cast<const Subset*>(buffer + bufferView.Offset), accessor.Count);
         }
 
         // Vertex data & layout metadata
@@ -155,7 +208,12 @@ bool Model::LoadFromFile(const char* filename)
                 continue;
 
             Accessor& accessor = accessors[meshView.Attributes[j]];
-            
+            if (accessor.Stride == 0)
+            {
+                valid = false;
+                return;
+            }
+
             auto it = std::find(vbMap.begin(), vbMap.end(), accessor.BufferView);
             if (it != vbMap.end())
             {
@@ -164,13 +222,19 @@ bool Model::LoadFromFile(const char* filename)
 
             // New buffer view encountered; add to list and copy vertex data
             vbMap.push_back(accessor.BufferView);
-            BufferView& bufferView = bufferViews[accessor.BufferView];
-
-            Span<uint8_t> verts = MakeSpan(m_buffer.data() + bufferView.Offset, bufferView.Size);
+            EncodedStream verts = getStream(accessor.BufferView);
 
             mesh.VertexStrides.push_back(accessor.Stride);
-            mesh.Vertices.push_back(verts);
-            mesh.VertexCount = static_cast<uint32_t>(verts.size()) / accessor.Stride;
+            mesh.VertexStreams.push_back(verts);
+            mesh.Vertices.push_back(isRaw(accessor.BufferView) ? verts.Data : Span<const uint8_t>());
+            mesh.VertexCount = verts.Desc.DecodedSize / accessor.Stride;
+        }
+
+        // Vertex offsets of the merged buffers are counted in vertices of the first stream
+        if (mesh.VertexStreams.empty())
+        {
+            valid = false;
+            return;
         }
 
         // Meshlet data
@@ -178,7 +242,13 @@ bool Model::LoadFromFile(const char* filename)
             Accessor& accessor = accessors[meshView.Meshlets];
             BufferView& bufferView = bufferViews[accessor.BufferView];
 
-            mesh.Meshlets = MakeSpan(reinterpret_cast<Meshlet*>(m_buffer.data() + bufferView.Offset), accessor.Count);
+            if (!fitsBufferView(accessor, sizeof(Meshlet)))
+            {
+                valid = false;
+                return;
+            }
+
+            mesh.Meshlets = MakeSpan(reinterpret_cast<const Meshlet*>(buffer + bufferView.Offset), accessor.Count);
         }
 
         // Meshlet Subset data
@@ -186,15 +256,32 @@ bool Model::LoadFromFile(const char* filename)
             Accessor& accessor = accessors[meshView.MeshletSubsets];
             BufferView& bufferView = bufferViews[accessor.BufferView];
 
-            mesh.MeshletSubsets = MakeSpan(reinterpret_cast<Subset*>(m_buffer.data() + bufferView.Offset), accessor.Count);
+            if (!fitsBufferView(accessor, sizeof(Subset)))
+            {
+                valid = false;
+                return;
+            }
+
+            mesh.MeshletSubsets = MakeSpan(reinterpret_cast<const Subset*>(buffer + bufferView.Offset), accessor.Count);
+
+            // Culling writes the visibility of a subset's meshlets by its range
+            for (auto& subset : mesh.MeshletSubsets)
+            {
+                if (static_cast<uint64_t>(subset.Offset) + subset.Count > mesh.Meshlets.size())
+                {
+                    valid = false;
+                    return;
+                }
+            }
         }
 
         // Unique Vertex Index data
         {
             Accessor& accessor = accessors[meshView.UniqueVertexIndices];
-            BufferView& bufferView = bufferViews[accessor.BufferView];
 
-            mesh.UniqueVertexIndices = MakeSpan(m_buffer.data() + bufferView.Offset, bufferView.Size);
+            mesh.UniqueVertexIndexStream = getStream(accessor.BufferView);
+            if (isRaw(accessor.BufferView))
+                mesh.UniqueVertexIndices = mesh.UniqueVertexIndexStream.Data;
         }
 
         // Primitive Index data
@@ -202,81 +289,197 @@ bool Model::LoadFromFile(const char* filename)
             Accessor& accessor = accessors[meshView.PrimitiveIndices];
             BufferView& bufferView = bufferViews[accessor.BufferView];
 
-            mesh.PrimitiveIndices = MakeSpan(reinterpret_cast<PackedTriangle*>(m_buffer.data() + bufferView.Offset), accessor.Count);
+            mesh.PrimitiveIndexStream = getStream(accessor.BufferView);
+            if (isRaw(accessor.BufferView))
+            {
+                if (!fitsBufferView(accessor, sizeof(PackedTriangle)))
+                {
+                    valid = false;
+                    return;
+                }
+
+                mesh.PrimitiveIndices = MakeSpan(reinterpret_cast<const PackedTriangle*>(buffer + bufferView.Offset), accessor.Count);
+            }
         }
-     }
 
-     return true;
+        // Cull data, it's optional and has to match the meshlets
+        if (meshView.CullData != uint32_t(-1))
+        {
+            Accessor& accessor = accessors[meshView.CullData];
+            BufferView& bufferView = bufferViews[accessor.BufferView];
+
+            if (isRaw(accessor.BufferView) && accessor.Count == mesh.Meshlets.size() && fitsBufferView(accessor, sizeof(CullData)))
+            {
+                mesh.CullingData = MakeSpan(reinterpret_cast<const CullData*>(buffer + bufferView.Offset), accessor.Count);
+            }
+        }
+
+        mesh.Bounds.Build(mesh.CullingData.data(), static_cast<uint32_t>(mesh.CullingData.size()));
+    };
+
+    if (pThreadPool != nullptr)
+    {
+        pThreadPool->ParallelFor(static_cast<uint32_t>(meshes.size()), loadMesh);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < static_cast<uint32_t>(meshes.size()); ++i)
+            loadMesh(i);
+    }
+
+    if (!valid)
+    {
+        m_meshes.clear();
+        return false;
+    }
+
+    m_file = std::move(file);
+
+    return true;
 }
 
-bool Model::UploadGpuResources(ISGDevice* pDevice, ISGCommandList* pCmdList)
+bool Model::UploadGpuResources(ISGDevice* pDevice, UploadStream& uploadStream, BufferHeap& bufferHeap, ThreadPool* pThreadPool)
 {
-    for (uint32_t i = 0; i < m_meshes.size(); ++i)
-    {
-        auto& m = m_meshes[i];
+    if (m_meshes.empty())
+        return false;
 
-        // Create committed D3D resources of proper sizes
-        m.IndexResource.Init(pDevice, m.Indices.size(), m.IndexSize);
-        m.MeshletResource.Init(pDevice, m.Meshlets.size() * sizeof(m.Meshlets[0]), sizeof(m.Meshlets[0]));
-        m.UniqueVertexIndexResource.Init(pDevice, DivRoundUp(m.UniqueVertexIndices.size(), 4) * 4, 4);
-        m.PrimitiveIndexResource.Init(pDevice, m.PrimitiveIndices.size() * sizeof(m.PrimitiveIndices[0]), sizeof(m.PrimitiveIndices[0]));
-        m.MeshInfoResource.Init(pDevice, sizeof(MeshInfo), sizeof(MeshInfo));
+    // Raw streams are copied from the mapping, compressed ones are decoded into staging memory when they are staged
+    auto queueStream = [&](ISGBuffer* pBuffer, U64 offset, EncodedStream const& stream)
+    {
+        if (stream.Desc.Codec == STREAM_CODEC_RAW)
+            return uploadStream.QueueBufferUpload(pBuffer, offset, stream.Data.data(), stream.Data.size());
 
-        m_meshes[i].MeshletInfoCBs.resize(m_meshes[i].MeshletSubsets.size());
-        for (UINT j = 0; j < m_meshes[i].MeshletInfoCBs.size(); j++)
+        return uploadStream.QueueBufferUpload(pBuffer, offset, stream.Desc.DecodedSize, [stream, pThreadPool](void* pDest)
         {
-            struct ShaderMeshInfo
-            {
-                UINT IndexBytes;
-                UINT MeshletOffset;
-            } meshInfo;
+            // LoadFromFile validates stream headers only, corrupt payloads are found while decoding and fail the upload
+            if (!DecodeStream(stream.Desc, stream.Data.data(), stream.Data.size(), static_cast<uint8_t*>(pDest), pThreadPool))
+                throw std::exception("Failed to decode model stream");
+        });
+    };
 
-            meshInfo.IndexBytes = m_meshes[i].IndexSize;
-            meshInfo.MeshletOffset = m_meshes[i].MeshletSubsets[j].Offset;
+    // Meshes follow each other in the merged buffers, vertex streams of every mesh must match
+    const std::vector<uint32_t>& strides = m_meshes[0].VertexStrides;
 
-            ComPtr<ISGBuffer>& buffer = m_meshes[i].MeshletInfoCBs[j];
+    // Totals are summed wide, offsets and buffer sizes are 32-bit and have to be range checked
+    uint64_t vertexCount = 0;
+    uint64_t meshletCount = 0;
+    uint64_t uniqueVertexIndexBytes = 0;
+    uint64_t primitiveCount = 0;
 
-            SG_BUFFER_DESC cbDesc = FastBufferDesc::Constant(sizeof(ShaderMeshInfo));
-            pDevice->CreateBuffer(&cbDesc, &buffer);
+    for (auto& m : m_meshes)
+    {
+        if (m.VertexStrides != strides)
+            return false;
+
+        m.Offsets = {};
+        m.Offsets.VertexOffset = static_cast<uint32_t>(vertexCount);
+        m.Offsets.MeshletOffset = static_cast<uint32_t>(meshletCount);
+        m.Offsets.UniqueVertexIndexOffset = static_cast<uint32_t>(uniqueVertexIndexBytes);
+        m.Offsets.PrimitiveOffset = static_cast<uint32_t>(primitiveCount);
+        m.Offsets.IndexBytes = m.IndexSize;
+
+        vertexCount += m.VertexStreams[0].Desc.DecodedSize / strides[0];
+        meshletCount += m.Meshlets.size();
+        uniqueVertexIndexBytes += DivRoundUp(uint64_t(m.UniqueVertexIndexStream.Desc.DecodedSize), 4) * 4;
+        primitiveCount += m.PrimitiveIndexStream.Desc.DecodedSize / sizeof(PackedTriangle);
+    }
 
-            uint8_t* memory = nullptr;
-            buffer->Map(reinterpret_cast<void**>(&memory));
-            std::memcpy(memory, &meshInfo, sizeof(meshInfo));
-            buffer->Unmap();
-        }
+    uint64_t maxVertexBytes = 0;
+    for (uint32_t stride : strides)
+        maxVertexBytes = (std::max)(maxVertexBytes, vertexCount * stride);
 
-        m.VertexResources.resize(m.Vertices.size());
+    const uint64_t bufferBytes[] = { maxVertexBytes, meshletCount * sizeof(Meshlet), uniqueVertexIndexBytes,
+        primitiveCount * sizeof(PackedTriangle) };
 
-        for (uint32_t j = 0; j < m.Vertices.size(); ++j)
-        {
-            SG_BUFFER_DESC vertexDesc = FastBufferDesc::Vertex(m.Vertices[j].size(), true, false, false);
-            pDevice->CreateBuffer(&vertexDesc, &m.VertexResources[j].Resourse);
+    for (uint64_t bytes : bufferBytes)
+    {
+        if (bytes > UINT32_MAX)
+            return false;
+    }
 
-            SG_SHADER_RESOURCE_VIEW_DESC viewDesc = FastViewDesc::AsStructuredBuffer(0, m.Vertices[j].size() / m.VertexStrides[j], m.VertexStrides[j]);
-            pDevice->CreateShaderResourceView(m.VertexResources[j].Resourse.Get(), &viewDesc, &m.VertexResources[j].View);
-        }
+    // The meshlet buffer fits, so its count does too
+    const uint64_t packTableBytes = uint64_t(GetMeshletPackTableSize(static_cast<uint32_t>(meshletCount))) * sizeof(MeshletPackEntry);
+    if (packTableBytes > UINT32_MAX)
+        return false;
+
+    const uint32_t meshCount = GetMeshCount();
+
+    // Create committed D3D resources of proper sizes
+    m_buffers.VertexResources.resize(strides.size());
+
+    for (uint32_t j = 0; j < strides.size(); ++j)
+    {
+        const uint32_t vertexBytes = static_cast<uint32_t>(vertexCount * strides[j]);
+
+        SG_BUFFER_DESC vertexDesc = FastBufferDesc::Vertex(vertexBytes, true, false, false);
+        pDevice->CreateBuffer(&vertexDesc, &m_buffers.VertexResources[j].Resourse);
+
+        SG_SHADER_RESOURCE_VIEW_DESC viewDesc = FastViewDesc::AsStructuredBuffer(0, static_cast<uint32_t>(vertexCount), strides[j]);
+        pDevice->CreateShaderResourceView(m_buffers.VertexResources[j].Resourse.Get(), &viewDesc, &m_buffers.VertexResources[j].View);
+    }
+
+    m_buffers.MeshletCount = static_cast<uint32_t>(meshletCount);
+    m_buffers.MeshletResource.Init(pDevice, static_cast<uint32_t>(meshletCount * sizeof(Meshlet)), sizeof(Meshlet));
+    m_buffers.UniqueVertexIndexResource.Init(pDevice, static_cast<uint32_t>(uniqueVertexIndexBytes), 4);
+    m_buffers.PrimitiveIndexResource.Init(pDevice, static_cast<uint32_t>(primitiveCount * sizeof(PackedTriangle)), sizeof(PackedTriangle));
+    m_buffers.MeshOffsetResource.Init(pDevice, bufferHeap, meshCount * sizeof(MeshOffsets), sizeof(MeshOffsets));
+    m_buffers.MeshletPackResource.Init(pDevice, bufferHeap, static_cast<uint32_t>(packTableBytes), sizeof(MeshletPackEntry));
+
+    // Upload requests of different meshes don't depend on each other
+    auto uploadMesh = [&](uint32_t i)
+    {
+        auto& m = m_meshes[i];
 
-        // Map & copy memory to upload heap
-        for (uint32_t j = 0; j < m.Vertices.size(); ++j)
+        // Requests reference the model's memory, it's staged later within the stream's budget
+        for (uint32_t j = 0; j < m.VertexStreams.size(); ++j)
         {
-            UploadCommonBuffer(pDevice, pCmdList, m.VertexResources[j].Resourse.Get(), m.Vertices[j].data(), m.Vertices[j].size());
+            queueStream(m_buffers.VertexResources[j].Resourse.Get(), U64(m.Offsets.VertexOffset) * strides[j], m.VertexStreams[j]);
         }
 
-        UploadCommonBuffer(pDevice, pCmdList, m.IndexResource.Resourse.Get(), m.Indices.data(), m.Indices.size());
-        UploadCommonBuffer(pDevice, pCmdList, m.MeshletResource.Resourse.Get(), m.Meshlets.data(), m.Meshlets.size() * sizeof(m.Meshlets[0]));
-        UploadCommonBuffer(pDevice, pCmdList, m.UniqueVertexIndexResource.Resourse.Get(), m.UniqueVertexIndices.data(), m.UniqueVertexIndices.size());
-        UploadCommonBuffer(pDevice, pCmdList, m.PrimitiveIndexResource.Resourse.Get(), m.PrimitiveIndices.data(), m.PrimitiveIndices.size() * sizeof(m.PrimitiveIndices[0]));
+        uploadStream.QueueBufferUpload(m_buffers.MeshletResource.Resourse.Get(), U64(m.Offsets.MeshletOffset) * sizeof(Meshlet),
+            m.Meshlets.data(), m.Meshlets.size() * sizeof(Meshlet));
+        queueStream(m_buffers.UniqueVertexIndexResource.Resourse.Get(), m.Offsets.UniqueVertexIndexOffset, m.UniqueVertexIndexStream);
+        queueStream(m_buffers.PrimitiveIndexResource.Resourse.Get(), U64(m.Offsets.PrimitiveOffset) * sizeof(PackedTriangle), m.PrimitiveIndexStream);
 
-        {
-            MeshInfo info = {};
-            info.IndexSize            = m.IndexSize;
-            info.MeshletCount         = static_cast<uint32_t>(m.Meshlets.size());
-            info.LastMeshletVertCount = m.Meshlets.back().VertCount;
-            info.LastMeshletPrimCount = m.Meshlets.back().PrimCount;
+        // Requests are processed in order, the offsets of the mesh complete it
+        m.UploadTicket = uploadStream.QueueBufferUpload(m_buffers.MeshOffsetResource.Resourse.Get(),
+            m_buffers.MeshOffsetResource.Offset + U64(i) * sizeof(MeshOffsets), &m.Offsets, sizeof(MeshOffsets));
+    };
 
-            UploadCommonBuffer(pDevice, pCmdList, m.MeshInfoResource.Resourse.Get(), &info, sizeof(MeshInfo));
-        }
+    if (pThreadPool != nullptr)
+    {
+        pThreadPool->ParallelFor(meshCount, uploadMesh);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < meshCount; ++i)
+            uploadMesh(i);
     }
 
     return true;
 }
+
+void Model::ReleaseGpuResources(BufferHeap& bufferHeap)
+{
+    m_buffers.MeshOffsetResource.Free(bufferHeap);
+    m_buffers.MeshletPackResource.Free(bufferHeap);
+    m_buffers = {};
+}
+
+uint64_t Model::GetGpuResourceSize() const
+{
+    uint64_t size = 0;
+    uint32_t meshletCount = 0;
+
+    for (auto& m : m_meshes)
+    {
+        for (auto& stream : m.VertexStreams)
+            size += stream.Desc.DecodedSize;
+
+        size += m.Meshlets.size() * sizeof(Meshlet) + DivRoundUp(m.UniqueVertexIndexStream.Desc.DecodedSize, 4) * 4 +
+            m.PrimitiveIndexStream.Desc.DecodedSize + sizeof(MeshOffsets);
+        meshletCount += static_cast<uint32_t>(m.Meshlets.size());
+    }
+
+    return size + GetMeshletPackTableSize(meshletCount) * sizeof(MeshletPackEntry);
+}
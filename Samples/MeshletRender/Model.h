@@ -15,7 +15,14 @@
 #include <windows.h>
 #include <vector>
 #include <DirectXCollision.h>
+#include "ModelCodec.h"
+#include "MeshletCuller.h"
+#include "MeshletPacker.h"
 #include "SGX/SGHelpers.h"
+#include "SGX/SGBufferHeap.h"
+#include "SGX/SGUploadStream.h"
+#include "SGX/SGMappedFile.h"
+#include "SGX/SGThreadPool.h"
 
 #include <wrl.h>
 using Microsoft::WRL::ComPtr;
@@ -42,13 +49,15 @@ struct Subset
     uint32_t Count;
 };
 
-struct MeshInfo
+// Location of a mesh in the merged buffers of its model, the mesh shader reads it by the mesh index
+struct MeshOffsets
 {
-    uint32_t IndexSize;
-    uint32_t MeshletCount;
-
-    uint32_t LastMeshletVertCount;
-    uint32_t LastMeshletPrimCount;
+    uint32_t VertexOffset;              // In vertices
+    uint32_t MeshletOffset;             // In meshlets
+    uint32_t UniqueVertexIndexOffset;   // In bytes, 4-byte aligned
+    uint32_t PrimitiveOffset;           // In triangles
+    uint32_t IndexBytes;
+    uint32_t Padding[3];
 };
 
 struct Meshlet
@@ -59,6 +68,13 @@ struct Meshlet
     uint32_t PrimOffset;
 };
 
+struct CullData
+{
+    DirectX::XMFLOAT4 BoundingSphere;   // xyz = center, w = radius
+    uint8_t           NormalCone[4];    // xyz = axis, w = -cos(a + 90)
+    float             ApexOffset;       // apex = center - axis * offset
+};
+
 struct PackedTriangle
 {
     uint32_t i0 : 10;
@@ -77,46 +93,67 @@ struct StructuredBuffer
         pDevice->CreateShaderResourceView(Resourse.Get(), &viewDesc, &View);
     }
 
+    // Places the buffer as a range of a heap page, the view starts at the range.
+    // The range stays allocated until Free is called or the heap is destroyed.
+    void Init(ISGDevice* pDevice, BufferHeap& heap, U32 sizeBytes, U32 stride)
+    {
+        Allocation = heap.Allocate(sizeBytes, stride);
+        Resourse = Allocation.pBuffer;
+        Offset = Allocation.Offset;
+
+        SG_SHADER_RESOURCE_VIEW_DESC viewDesc = FastViewDesc::AsStructuredBuffer(Offset / stride, sizeBytes / stride, stride);
+        pDevice->CreateShaderResourceView(Resourse.Get(), &viewDesc, &View);
+    }
+
+    // Returns the range of a placed buffer to its heap, frames in flight must not use it anymore
+    void Free(BufferHeap& heap)
+    {
+        heap.Free(Allocation);
+        *this = {};
+    }
+
     ComPtr<ISGBuffer> Resourse;
     ComPtr<ISGShaderResourceView> View;
+    U32 Offset = 0;                     // Of the range, copies to the buffer must add it
+    BufferAllocation Allocation = {};   // Empty if the buffer isn't placed
+};
+
+// A buffer view as it's stored in the file, decoded when it's uploaded
+struct EncodedStream
+{
+    Span<const uint8_t> Data;
+    StreamDesc          Desc;
 };
 
 struct Mesh
 {
-    std::vector<Span<uint8_t>> Vertices;
+    // Spans reference the read-only mapping of the model file.
+    // Vertex, unique vertex index and primitive spans of compressed streams are empty, only their encoded streams are set.
+    std::vector<Span<const uint8_t>> Vertices;
+    std::vector<EncodedStream> VertexStreams;
     std::vector<uint32_t>      VertexStrides;
     uint32_t                   VertexCount;
 
-    Span<Subset>               IndexSubsets;
-    Span<uint8_t>              Indices;
+    // Meshlets are drawn instead of the index buffer, only its subsets and index size are used
+    Span<const Subset>         IndexSubsets;
     uint32_t                   IndexSize;
-    uint32_t                   IndexCount;
 
-    Span<Subset>                    MeshletSubsets;
-    std::vector<ComPtr<ISGBuffer>>  MeshletInfoCBs;
-    Span<Meshlet>                   Meshlets;
-    Span<uint8_t>                   UniqueVertexIndices;
-    Span<PackedTriangle>            PrimitiveIndices;
+    Span<const Subset>              MeshletSubsets;
+    Span<const Meshlet>             Meshlets;
+    Span<const uint8_t>             UniqueVertexIndices;
+    Span<const PackedTriangle>      PrimitiveIndices;
+    EncodedStream                   UniqueVertexIndexStream;
+    EncodedStream                   PrimitiveIndexStream;
 
-    // D3D resource references
-    std::vector<StructuredBuffer> VertexResources;
-    StructuredBuffer    IndexResource;
-    StructuredBuffer    MeshletResource;
-    StructuredBuffer    UniqueVertexIndexResource;
-    StructuredBuffer    PrimitiveIndexResource;
-    StructuredBuffer    MeshInfoResource;
+    // Empty if the file has no cull data
+    Span<const CullData>            CullingData;
+    MeshletBounds                   Bounds;
 
-    // Calculates the number of instances of the last meshlet which can be packed into a single threadgroup.
-    uint32_t GetLastMeshletPackCount(uint32_t subsetIndex, uint32_t maxGroupVerts, uint32_t maxGroupPrims) 
-    { 
-        if (Meshlets.size() == 0)
-            return 0;
+    // Location of the mesh in the merged buffers of the model
+    MeshOffsets         Offsets;
 
-        auto& subset = MeshletSubsets[subsetIndex];
-        auto& meshlet = Meshlets[subset.Offset + subset.Count - 1];
-
-        return min(maxGroupVerts / meshlet.VertCount, maxGroupPrims / meshlet.PrimCount);
-    }
+    // Resources may be used once the ticket is available
+    StreamTicket        UploadTicket;
 
     void GetPrimitive(uint32_t index, uint32_t& i0, uint32_t& i1, uint32_t& i2) const
     {
@@ -140,14 +177,37 @@ struct Mesh
     }
 };
 
+// Streams of all meshes merged into shared buffers, so the whole model is drawn by a single dispatch.
+// Vertex streams are merged stream by stream, every mesh has the same streams.
+struct ModelBuffers
+{
+    std::vector<StructuredBuffer> VertexResources;
+    StructuredBuffer    MeshletResource;
+    StructuredBuffer    UniqueVertexIndexResource;
+    StructuredBuffer    PrimitiveIndexResource;
+    StructuredBuffer    MeshOffsetResource;
+
+    // Pack table of the meshlets drawn by the frame, see MeshletPacker.h
+    StructuredBuffer    MeshletPackResource;
+    uint32_t            MeshletCount = 0;
+};
+
 class Model
 {
 public:
-    bool LoadFromFile(const char* filename);
-    bool UploadGpuResources(ISGDevice* pDevice, ISGCommandList* pCmdList);
+    // Meshes are processed by the thread pool if it's provided. Both initial and compressed files are supported,
+    // compressed streams are decoded straight into staging memory when the upload stream stages them.
+    bool LoadFromFile(const char* filename, ThreadPool* pThreadPool = nullptr);
+    // Small buffers (mesh offsets, pack table) are placed in the heap, it must be created with structured buffer bind flags
+    bool UploadGpuResources(ISGDevice* pDevice, UploadStream& uploadStream, BufferHeap& bufferHeap, ThreadPool* pThreadPool = nullptr);
+    // Releases the buffers and returns the placed ones to the heap, frames in flight must not use them
+    void ReleaseGpuResources(BufferHeap& bufferHeap);
+    // Bytes of the buffers created by UploadGpuResources
+    uint64_t GetGpuResourceSize() const;
 
     uint32_t GetMeshCount() const { return static_cast<uint32_t>(m_meshes.size()); }
     const Mesh& GetMesh(uint32_t i) const { return m_meshes[i]; }
+    const ModelBuffers& GetBuffers() const { return m_buffers; }
 
     // Iterator interface
     auto begin() { return m_meshes.begin(); }
@@ -155,5 +215,6 @@ public:
 
 private:
     std::vector<Mesh>                      m_meshes;
-    std::vector<uint8_t>                   m_buffer;
+    ModelBuffers                           m_buffers;
+    MappedFile                             m_file;
 };
@@ -0,0 +1,950 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "Model.h"
+#include "ModelCodec.h"
+#include "SGX/SGMappedFile.h"
+#include "SGX/SGThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MODEL_CODEC_SSE2 1
+#endif
+
+static_assert(sizeof(MeshHeader::Attributes) / sizeof(uint32_t) == Attribute::Count, "MeshHeader must list every attribute");
+
+namespace
+{
+    ///---------------------------------------------------------------------------------------------
+    /// Encoded stream layouts, every block starts at a 4-byte aligned offset of the stream
+    ///---------------------------------------------------------------------------------------------
+
+    enum AttributeCodec : uint32_t
+    {
+        ATTRIBUTE_CODEC_RAW = 0,            // Size bytes per vertex
+        ATTRIBUTE_CODEC_POSITION_Q16 = 1,   // float3 as 3 x uint16 within [Min; Min + Scale * 65535]
+        ATTRIBUTE_CODEC_NORMAL_OCT16 = 2,   // float3 unit vector as 2 x int16 octahedral coordinates
+    };
+
+    // Followed by VertexAttribute[AttributeCount] and data blocks of every attribute
+    struct VertexStreamHeader
+    {
+        uint32_t VertexCount;
+        uint32_t Stride;
+        uint32_t AttributeCount;
+    };
+
+    struct VertexAttribute
+    {
+        uint32_t Codec;
+        uint32_t Offset;        // Within a decoded vertex
+        uint32_t Size;          // Decoded size
+        uint32_t DataOffset;    // Within the stream
+        float    Min[3];
+        float    Scale[3];
+    };
+
+    // Followed by IndexChunk[ChunkCount] and varint data of every chunk
+    struct IndexStreamHeader
+    {
+        uint32_t IndexCount;
+        uint32_t IndexSize;
+        uint32_t ChunkCount;
+    };
+
+    struct IndexChunk
+    {
+        uint32_t FirstIndex;    // The chunk lasts till the next one
+        uint32_t DataOffset;    // Within the stream
+    };
+
+    // Followed by 3 bytes per triangle
+    struct TriangleStreamHeader
+    {
+        uint32_t TriangleCount;
+    };
+
+    const uint32_t c_maxAttributes = 16;
+    const uint32_t c_maxStride = 256;
+
+    const uint32_t c_indicesPerChunk = 4096;
+    const uint32_t c_meshletsPerChunk = 32;
+
+    // Decoding jobs are large enough to amortize scheduling, blocks are small enough to stay in L1
+    const uint32_t c_verticesPerJob = 8192;
+    const uint32_t c_verticesPerBlock = 64;
+    const uint32_t c_trianglesPerJob = 16384;
+
+    inline uint32_t Align4(uint32_t value)
+    {
+        return (value + 3) & ~3u;
+    }
+
+    template <typename T>
+    bool ReadStruct(const uint8_t* pSrc, size_t srcSize, size_t offset, T* pDest)
+    {
+        if (offset > srcSize || sizeof(T) > srcSize - offset)
+            return false;
+
+        std::memcpy(pDest, pSrc + offset, sizeof(T));
+        return true;
+    }
+
+    template <typename T>
+    void WriteStruct(std::vector<uint8_t>& dest, size_t offset, T const& value)
+    {
+        std::memcpy(dest.data() + offset, &value, sizeof(T));
+    }
+
+    void ParallelRun(ThreadPool* pThreadPool, uint32_t count, ThreadPool::IndexedJob const& job)
+    {
+        if (pThreadPool != nullptr && count > 1)
+        {
+            pThreadPool->ParallelFor(count, job);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                job(i);
+        }
+    }
+
+    ///---------------------------------------------------------------------------------------------
+    /// Octahedral normals
+    ///---------------------------------------------------------------------------------------------
+
+    inline float SignNotZero(float value)
+    {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    inline int16_t ToSnorm16(float value)
+    {
+        value = (std::max)(-1.0f, (std::min)(1.0f, value));
+        return static_cast<int16_t>(std::lround(value * 32767.0f));
+    }
+
+    void EncodeOctahedral(const float n[3], int16_t out[2])
+    {
+        float length = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+        if (length == 0.0f)
+        {
+            out[0] = out[1] = 0;
+            return;
+        }
+
+        float x = n[0] / length;
+        float y = n[1] / length;
+
+        if (n[2] < 0.0f)
+        {
+            float folded = (1.0f - std::fabs(y)) * SignNotZero(x);
+            y = (1.0f - std::fabs(x)) * SignNotZero(y);
+            x = folded;
+        }
+
+        out[0] = ToSnorm16(x);
+        out[1] = ToSnorm16(y);
+    }
+
+    inline void DecodeOctahedral(const int16_t in[2], float* pOut)
+    {
+        float x = (std::max)(in[0] / 32767.0f, -1.0f);
+        float y = (std::max)(in[1] / 32767.0f, -1.0f);
+        float z = 1.0f - std::fabs(x) - std::fabs(y);
+
+        if (z < 0.0f)
+        {
+            float folded = (1.0f - std::fabs(y)) * SignNotZero(x);
+            y = (1.0f - std::fabs(x)) * SignNotZero(y);
+            x = folded;
+        }
+
+        float invLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+        pOut[0] = x * invLength;
+        pOut[1] = y * invLength;
+        pOut[2] = z * invLength;
+    }
+
+    ///---------------------------------------------------------------------------------------------
+    /// Vertex stream
+    ///---------------------------------------------------------------------------------------------
+
+    uint32_t GetAttributeDataSize(VertexAttribute const& attribute, uint32_t vertexCount)
+    {
+        switch (attribute.Codec)
+        {
+        case ATTRIBUTE_CODEC_POSITION_Q16:  return vertexCount * 6;
+        case ATTRIBUTE_CODEC_NORMAL_OCT16:  return vertexCount * 4;
+        default:                            return vertexCount * attribute.Size;
+        }
+    }
+
+    bool ReadVertexStream(const uint8_t* pSrc, size_t srcSize, uint32_t decodedSize,
+        VertexStreamHeader* pHeader, VertexAttribute* pAttributes)
+    {
+        if (!ReadStruct(pSrc, srcSize, 0, pHeader))
+            return false;
+
+        if (pHeader->Stride == 0 || pHeader->Stride > c_maxStride || pHeader->AttributeCount > c_maxAttributes)
+            return false;
+
+        if (static_cast<uint64_t>(pHeader->VertexCount) * pHeader->Stride != decodedSize)
+            return false;
+
+        for (uint32_t i = 0; i < pHeader->AttributeCount; ++i)
+        {
+            VertexAttribute& attribute = pAttributes[i];
+            if (!ReadStruct(pSrc, srcSize, sizeof(VertexStreamHeader) + i * sizeof(VertexAttribute), &attribute))
+                return false;
+
+            if (attribute.Codec > ATTRIBUTE_CODEC_NORMAL_OCT16 || attribute.Offset > pHeader->Stride || attribute.Size > pHeader->Stride - attribute.Offset)
+                return false;
+
+            if (attribute.Codec != ATTRIBUTE_CODEC_RAW && attribute.Size != 3 * sizeof(float))
+                return false;
+
+            // Doesn't overflow, the decoded size fits 32 bits
+            uint32_t dataSize = GetAttributeDataSize(attribute, pHeader->VertexCount);
+            if (attribute.DataOffset > srcSize || dataSize > srcSize - attribute.DataOffset)
+                return false;
+        }
+
+        return true;
+    }
+
+    void DequantizePositions(VertexAttribute const& attribute, const uint8_t* pSrc, uint32_t count, uint8_t* pDest, uint32_t stride)
+    {
+        uint32_t i = 0;
+
+#if defined(MODEL_CODEC_SSE2)
+        const __m128 scale = _mm_setr_ps(attribute.Scale[0], attribute.Scale[1], attribute.Scale[2], 0.0f);
+        const __m128 bias = _mm_setr_ps(attribute.Min[0], attribute.Min[1], attribute.Min[2], 0.0f);
+        const __m128i zero = _mm_setzero_si128();
+
+        // 8-byte loads read 2 bytes of the next vertex, the last one is left for the scalar path
+        for (; i + 1 < count; ++i)
+        {
+            __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSrc + i * 6));
+            __m128 position = _mm_cvtepi32_ps(_mm_unpacklo_epi16(packed, zero));
+            position = _mm_add_ps(_mm_mul_ps(position, scale), bias);
+
+            float* pOut = reinterpret_cast<float*>(pDest + i * stride);
+            _mm_storel_pi(reinterpret_cast<__m64*>(pOut), position);
+            _mm_store_ss(pOut + 2, _mm_movehl_ps(position, position));
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            uint16_t packed[3];
+            std::memcpy(packed, pSrc + i * 6, sizeof(packed));
+
+            float position[3];
+            for (uint32_t c = 0; c < 3; ++c)
+                position[c] = packed[c] * attribute.Scale[c] + attribute.Min[c];
+
+            std::memcpy(pDest + i * stride, position, sizeof(position));
+        }
+    }
+
+    void DecodeNormals(const uint8_t* pSrc, uint32_t count, uint8_t* pDest, uint32_t stride)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            int16_t packed[2];
+            std::memcpy(packed, pSrc + i * 4, sizeof(packed));
+
+            float normal[3];
+            DecodeOctahedral(packed, normal);
+            std::memcpy(pDest + i * stride, normal, sizeof(normal));
+        }
+    }
+
+    bool DecodeVertexStream(const uint8_t* pSrc, size_t srcSize, uint32_t decodedSize, uint8_t* pDest, ThreadPool* pThreadPool)
+    {
+        VertexStreamHeader header;
+        VertexAttribute attributes[c_maxAttributes];
+        if (!ReadVertexStream(pSrc, srcSize, decodedSize, &header, attributes))
+            return false;
+
+        const uint32_t jobCount = (header.VertexCount + c_verticesPerJob - 1) / c_verticesPerJob;
+
+        ParallelRun(pThreadPool, jobCount, [&](SgU32 job)
+        {
+            // Vertices are assembled in a cached block and written out sequentially,
+            // upload memory is usually write-combined and shouldn't be written with a stride
+            std::vector<uint8_t> block(c_verticesPerBlock * header.Stride);
+
+            uint32_t jobEnd = (std::min)((job + 1) * c_verticesPerJob, header.VertexCount);
+
+            for (uint32_t first = job * c_verticesPerJob; first < jobEnd; first += c_verticesPerBlock)
+            {
+                uint32_t count = (std::min)(c_verticesPerBlock, jobEnd - first);
+
+                // Bytes not covered by attributes are padding
+                std::memset(block.data(), 0, block.size());
+
+                for (uint32_t a = 0; a < header.AttributeCount; ++a)
+                {
+                    VertexAttribute const& attribute = attributes[a];
+                    uint8_t* pBlockDest = block.data() + attribute.Offset;
+
+                    switch (attribute.Codec)
+                    {
+                    case ATTRIBUTE_CODEC_POSITION_Q16:
+                        DequantizePositions(attribute, pSrc + attribute.DataOffset + first * 6, count, pBlockDest, header.Stride);
+                        break;
+
+                    case ATTRIBUTE_CODEC_NORMAL_OCT16:
+                        DecodeNormals(pSrc + attribute.DataOffset + first * 4, count, pBlockDest, header.Stride);
+                        break;
+
+                    default:
+                        for (uint32_t i = 0; i < count; ++i)
+                            std::memcpy(pBlockDest + i * header.Stride, pSrc + attribute.DataOffset + (first + i) * attribute.Size, attribute.Size);
+                        break;
+                    }
+                }
+
+                std::memcpy(pDest + static_cast<size_t>(first) * header.Stride, block.data(), count * header.Stride);
+            }
+        });
+
+        return true;
+    }
+
+    ///---------------------------------------------------------------------------------------------
+    /// Index stream
+    ///---------------------------------------------------------------------------------------------
+
+    inline uint32_t ZigZagEncode(int32_t value)
+    {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    inline int32_t ZigZagDecode(uint32_t value)
+    {
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+    }
+
+    inline void WriteVarint(std::vector<uint8_t>& dest, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            dest.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+
+        dest.push_back(static_cast<uint8_t>(value));
+    }
+
+    inline bool ReadVarint(const uint8_t*& pSrc, const uint8_t* pEnd, uint32_t* pValue)
+    {
+        uint32_t value = 0;
+
+        for (uint32_t shift = 0; shift < 35; shift += 7)
+        {
+            if (pSrc == pEnd)
+                return false;
+
+            uint8_t byte = *pSrc++;
+            value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0)
+            {
+                *pValue = value;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool ReadIndexStream(const uint8_t* pSrc, size_t srcSize, uint32_t decodedSize, IndexStreamHeader* pHeader, std::vector<IndexChunk>& chunks)
+    {
+        if (!ReadStruct(pSrc, srcSize, 0, pHeader))
+            return false;
+
+        if ((pHeader->IndexSize != 2 && pHeader->IndexSize != 4) || static_cast<uint64_t>(pHeader->IndexCount) * pHeader->IndexSize > decodedSize)
+            return false;
+
+        const size_t chunkTableEnd = sizeof(IndexStreamHeader) + static_cast<size_t>(pHeader->ChunkCount) * sizeof(IndexChunk);
+        if (pHeader->ChunkCount > pHeader->IndexCount || chunkTableEnd > srcSize)
+            return false;
+
+        chunks.resize(pHeader->ChunkCount);
+        if (!chunks.empty())
+            std::memcpy(chunks.data(), pSrc + sizeof(IndexStreamHeader), chunks.size() * sizeof(IndexChunk));
+
+        for (uint32_t i = 0; i < pHeader->ChunkCount; ++i)
+        {
+            IndexChunk const& chunk = chunks[i];
+
+            bool ordered = i == 0
+                ? chunk.FirstIndex == 0 && chunk.DataOffset >= chunkTableEnd
+                : chunk.FirstIndex > chunks[i - 1].FirstIndex && chunk.DataOffset >= chunks[i - 1].DataOffset;
+
+            if (!ordered || chunk.FirstIndex >= pHeader->IndexCount || chunk.DataOffset > srcSize)
+                return false;
+        }
+
+        return pHeader->IndexCount == 0 || pHeader->ChunkCount > 0;
+    }
+
+    bool DecodeIndexStream(const uint8_t* pSrc, size_t srcSize, uint32_t decodedSize, uint8_t* pDest, ThreadPool* pThreadPool)
+    {
+        IndexStreamHeader header;
+        std::vector<IndexChunk> chunks;
+        if (!ReadIndexStream(pSrc, srcSize, decodedSize, &header, chunks))
+            return false;
+
+        std::atomic<bool> valid(true);
+
+        ParallelRun(pThreadPool, header.ChunkCount, [&](SgU32 c)
+        {
+            const bool last = c + 1 == header.ChunkCount;
+            const uint32_t first = chunks[c].FirstIndex;
+            const uint32_t end = last ? header.IndexCount : chunks[c + 1].FirstIndex;
+
+            const uint8_t* pData = pSrc + chunks[c].DataOffset;
+            const uint8_t* pDataEnd = last ? pSrc + srcSize : pSrc + chunks[c + 1].DataOffset;
+
+            // Each chunk restarts the prediction, so chunks don't depend on each other
+            uint32_t previous = 0;
+            uint32_t delta;
+
+            if (header.IndexSize == 4)
+            {
+                uint32_t* pOut = reinterpret_cast<uint32_t*>(pDest) + first;
+                for (uint32_t i = first; i < end; ++i)
+                {
+                    if (!ReadVarint(pData, pDataEnd, &delta))
+                    {
+                        valid = false;
+                        return;
+                    }
+
+                    previous += static_cast<uint32_t>(ZigZagDecode(delta));
+                    *pOut++ = previous;
+                }
+            }
+            else
+            {
+                uint16_t* pOut = reinterpret_cast<uint16_t*>(pDest) + first;
+                for (uint32_t i = first; i < end; ++i)
+                {
+                    if (!ReadVarint(pData, pDataEnd, &delta))
+                    {
+                        valid = false;
+                        return;
+                    }
+
+                    previous += static_cast<uint32_t>(ZigZagDecode(delta));
+                    *pOut++ = static_cast<uint16_t>(previous);
+                }
+            }
+        });
+
+        // Views may be padded after the last index
+        const uint32_t indexBytes = header.IndexCount * header.IndexSize;
+        std::memset(pDest + indexBytes, 0, decodedSize - indexBytes);
+
+        return valid;
+    }
+
+    ///---------------------------------------------------------------------------------------------
+    /// Triangle stream
+    ///---------------------------------------------------------------------------------------------
+
+    bool ReadTriangleStream(const uint8_t* pSrc, size_t srcSize, uint32_t decodedSize, TriangleStreamHeader* pHeader)
+    {
+        if (!ReadStruct(pSrc, srcSize, 0, pHeader))
+            return false;
+
+        return static_cast<uint64_t>(pHeader->TriangleCount) * 4 <= decodedSize &&
+            static_cast<uint64_t>(pHeader->TriangleCount) * 3 <= srcSize - sizeof(TriangleStreamHeader);
+    }
+
+    bool DecodeTriangleStream(const uint8_t* pSrc, size_t srcSize, uint32_t decodedSize, uint8_t* pDest, ThreadPool* pThreadPool)
+    {
+        TriangleStreamHeader header;
+        if (!ReadTriangleStream(pSrc, srcSize, decodedSize, &header))
+            return false;
+
+        const uint8_t* pData = pSrc + sizeof(TriangleStreamHeader);
+        const uint32_t jobCount = (header.TriangleCount + c_trianglesPerJob - 1) / c_trianglesPerJob;
+
+        ParallelRun(pThreadPool, jobCount, [&](SgU32 job)
+        {
+            uint32_t end = (std::min)((job + 1) * c_trianglesPerJob, header.TriangleCount);
+            uint32_t* pOut = reinterpret_cast<uint32_t*>(pDest);
+
+            for (uint32_t i = job * c_trianglesPerJob; i < end; ++i)
+            {
+                const uint8_t* pTriangle = pData + i * 3;
+                pOut[i] = pTriangle[0] | (pTriangle[1] << 10) | (pTriangle[2] << 20);
+            }
+        });
+
+        const uint32_t triangleBytes = header.TriangleCount * 4;
+        std::memset(pDest + triangleBytes, 0, decodedSize - triangleBytes);
+
+        return true;
+    }
+
+    ///---------------------------------------------------------------------------------------------
+    /// Encoders
+    ///---------------------------------------------------------------------------------------------
+
+    struct AttributeSource
+    {
+        uint32_t Type;
+        uint32_t Offset;
+        uint32_t Size;
+    };
+
+    bool EncodeVertexStream(const uint8_t* pSrc, uint32_t size, uint32_t stride, std::vector<AttributeSource> const& sources, std::vector<uint8_t>& dest)
+    {
+        if (stride == 0 || stride > c_maxStride || size % stride != 0 || sources.empty() || sources.size() > c_maxAttributes)
+            return false;
+
+        VertexStreamHeader header;
+        header.VertexCount = size / stride;
+        header.Stride = stride;
+        header.AttributeCount = static_cast<uint32_t>(sources.size());
+
+        std::vector<VertexAttribute> attributes(sources.size());
+        uint32_t dataOffset = sizeof(VertexStreamHeader) + header.AttributeCount * sizeof(VertexAttribute);
+
+        auto readFloat3 = [&](uint32_t vertex, uint32_t offset, float* pOut)
+        {
+            std::memcpy(pOut, pSrc + vertex * stride + offset, 3 * sizeof(float));
+        };
+
+        for (size_t a = 0; a < sources.size(); ++a)
+        {
+            AttributeSource const& source = sources[a];
+            VertexAttribute& attribute = attributes[a];
+
+            attribute = {};
+            attribute.Offset = source.Offset;
+            attribute.Size = source.Size;
+
+            if (source.Offset > stride || source.Size > stride - source.Offset)
+                return false;
+
+            // Attributes of other formats are stored as they are
+            if (source.Size == 3 * sizeof(float) && (source.Type == Attribute::Position || source.Type == Attribute::Normal))
+            {
+                bool finite = true;
+                float minValue[3] = { INFINITY, INFINITY, INFINITY };
+                float maxValue[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+                for (uint32_t v = 0; v < header.VertexCount; ++v)
+                {
+                    float value[3];
+                    readFloat3(v, source.Offset, value);
+
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        finite &= std::isfinite(value[c]);
+                        minValue[c] = (std::min)(minValue[c], value[c]);
+                        maxValue[c] = (std::max)(maxValue[c], value[c]);
+                    }
+                }
+
+                if (finite && header.VertexCount > 0)
+                {
+                    attribute.Codec = source.Type == Attribute::Position ? ATTRIBUTE_CODEC_POSITION_Q16 : ATTRIBUTE_CODEC_NORMAL_OCT16;
+
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        attribute.Min[c] = minValue[c];
+                        attribute.Scale[c] = (maxValue[c] - minValue[c]) / 65535.0f;
+                    }
+                }
+            }
+
+            attribute.DataOffset = dataOffset;
+            dataOffset = Align4(dataOffset + GetAttributeDataSize(attribute, header.VertexCount));
+        }
+
+        dest.assign(dataOffset, 0);
+        WriteStruct(dest, 0, header);
+
+        for (size_t a = 0; a < attributes.size(); ++a)
+        {
+            VertexAttribute const& attribute = attributes[a];
+            WriteStruct(dest, sizeof(VertexStreamHeader) + a * sizeof(VertexAttribute), attribute);
+
+            uint8_t* pOut = dest.data() + attribute.DataOffset;
+
+            for (uint32_t v = 0; v < header.VertexCount; ++v)
+            {
+                if (attribute.Codec == ATTRIBUTE_CODEC_POSITION_Q16)
+                {
+                    float value[3];
+                    readFloat3(v, attribute.Offset, value);
+
+                    uint16_t packed[3];
+                    for (uint32_t c = 0; c < 3; ++c)
+                    {
+                        float q = attribute.Scale[c] > 0.0f ? (value[c] - attribute.Min[c]) / attribute.Scale[c] : 0.0f;
+                        packed[c] = static_cast<uint16_t>((std::min)(65535.0f, (std::max)(0.0f, std::round(q))));
+                    }
+
+                    std::memcpy(pOut + v * 6, packed, sizeof(packed));
+                }
+                else if (attribute.Codec == ATTRIBUTE_CODEC_NORMAL_OCT16)
+                {
+                    float value[3];
+                    readFloat3(v, attribute.Offset, value);
+
+                    int16_t packed[2];
+                    EncodeOctahedral(value, packed);
+                    std::memcpy(pOut + v * 4, packed, sizeof(packed));
+                }
+                else
+                {
+                    std::memcpy(pOut + v * attribute.Size, pSrc + v * stride + attribute.Offset, attribute.Size);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // chunkStarts lists the first index of every chunk, starting from 0
+    bool EncodeIndexStream(const uint8_t* pSrc, uint32_t size, uint32_t indexSize, std::vector<uint32_t> const& chunkStarts, std::vector<uint8_t>& dest)
+    {
+        if ((indexSize != 2 && indexSize != 4) || chunkStarts.empty() || chunkStarts.back() >= size / indexSize)
+            return false;
+
+        IndexStreamHeader header;
+        header.IndexCount = size / indexSize;
+        header.IndexSize = indexSize;
+        header.ChunkCount = static_cast<uint32_t>(chunkStarts.size());
+
+        std::vector<IndexChunk> chunks(header.ChunkCount);
+
+        dest.assign(sizeof(IndexStreamHeader) + chunks.size() * sizeof(IndexChunk), 0);
+
+        for (uint32_t c = 0; c < header.ChunkCount; ++c)
+        {
+            chunks[c].FirstIndex = chunkStarts[c];
+            chunks[c].DataOffset = static_cast<uint32_t>(dest.size());
+
+            uint32_t end = c + 1 < header.ChunkCount ? chunkStarts[c + 1] : header.IndexCount;
+            uint32_t previous = 0;
+
+            for (uint32_t i = chunkStarts[c]; i < end; ++i)
+            {
+                uint32_t index = 0;
+                std::memcpy(&index, pSrc + i * indexSize, indexSize);
+
+                WriteVarint(dest, ZigZagEncode(static_cast<int32_t>(index - previous)));
+                previous = index;
+            }
+        }
+
+        WriteStruct(dest, 0, header);
+        std::memcpy(dest.data() + sizeof(IndexStreamHeader), chunks.data(), chunks.size() * sizeof(IndexChunk));
+
+        return true;
+    }
+
+    bool EncodeTriangleStream(const uint8_t* pSrc, uint32_t size, std::vector<uint8_t>& dest)
+    {
+        TriangleStreamHeader header;
+        header.TriangleCount = size / 4;
+
+        dest.assign(sizeof(TriangleStreamHeader) + header.TriangleCount * 3, 0);
+        WriteStruct(dest, 0, header);
+
+        uint8_t* pOut = dest.data() + sizeof(TriangleStreamHeader);
+
+        for (uint32_t i = 0; i < header.TriangleCount; ++i)
+        {
+            uint32_t packed;
+            std::memcpy(&packed, pSrc + i * 4, sizeof(packed));
+
+            uint32_t i0 = packed & 0x3ff;
+            uint32_t i1 = (packed >> 10) & 0x3ff;
+            uint32_t i2 = (packed >> 20) & 0x3ff;
+
+            // Byte indices only fit meshlets of up to 256 vertices
+            if (i0 > 0xff || i1 > 0xff || i2 > 0xff)
+                return false;
+
+            pOut[i * 3 + 0] = static_cast<uint8_t>(i0);
+            pOut[i * 3 + 1] = static_cast<uint8_t>(i1);
+            pOut[i * 3 + 2] = static_cast<uint8_t>(i2);
+        }
+
+        return true;
+    }
+}
+
+bool ValidateStream(StreamDesc const& desc, const uint8_t* pSrc, size_t srcSize)
+{
+    switch (desc.Codec)
+    {
+    case STREAM_CODEC_RAW:
+        return srcSize == desc.DecodedSize;
+
+    case STREAM_CODEC_VERTEX:
+    {
+        VertexStreamHeader header;
+        VertexAttribute attributes[c_maxAttributes];
+        return ReadVertexStream(pSrc, srcSize, desc.DecodedSize, &header, attributes);
+    }
+
+    case STREAM_CODEC_INDEX:
+    {
+        IndexStreamHeader header;
+        std::vector<IndexChunk> chunks;
+        return ReadIndexStream(pSrc, srcSize, desc.DecodedSize, &header, chunks);
+    }
+
+    case STREAM_CODEC_TRIANGLE:
+    {
+        TriangleStreamHeader header;
+        return ReadTriangleStream(pSrc, srcSize, desc.DecodedSize, &header);
+    }
+
+    default:
+        return false;
+    }
+}
+
+bool DecodeStream(StreamDesc const& desc, const uint8_t* pSrc, size_t srcSize, uint8_t* pDest, ThreadPool* pThreadPool)
+{
+    bool decoded = false;
+
+    switch (desc.Codec)
+    {
+    case STREAM_CODEC_RAW:
+        decoded = srcSize == desc.DecodedSize;
+        if (decoded)
+            std::memcpy(pDest, pSrc, srcSize);
+        break;
+
+    case STREAM_CODEC_VERTEX:
+        decoded = DecodeVertexStream(pSrc, srcSize, desc.DecodedSize, pDest, pThreadPool);
+        break;
+
+    case STREAM_CODEC_INDEX:
+        decoded = DecodeIndexStream(pSrc, srcSize, desc.DecodedSize, pDest, pThreadPool);
+        break;
+
+    case STREAM_CODEC_TRIANGLE:
+        decoded = DecodeTriangleStream(pSrc, srcSize, desc.DecodedSize, pDest, pThreadPool);
+        break;
+    }
+
+    if (!decoded)
+        std::memset(pDest, 0, desc.DecodedSize);
+
+    return decoded;
+}
+
+bool CompressModelFile(const char* srcFilename, const char* dstFilename)
+{
+    MappedFile file;
+    if (!file.Open(srcFilename))
+        return false;
+
+    const uint8_t* fileData = file.GetData();
+    const uint64_t fileSize = file.GetSize();
+    uint64_t fileOffset = 0;
+
+    auto read = [&](void* dest, uint64_t size)
+    {
+        if (size > fileSize - fileOffset)
+            return false;
+
+        std::memcpy(dest, fileData + fileOffset, size);
+        fileOffset += size;
+        return true;
+    };
+
+    FileHeader header;
+    if (!read(&header, sizeof(header)) || header.Prolog != c_prolog || header.Version != FILE_VERSION_INITIAL)
+        return false;
+
+    std::vector<MeshHeader> meshes(header.MeshCount);
+    std::vector<Accessor> accessors(header.AccessorCount);
+    std::vector<BufferView> bufferViews(header.BufferViewCount);
+
+    if (!read(meshes.data(), meshes.size() * sizeof(meshes[0])) ||
+        !read(accessors.data(), accessors.size() * sizeof(accessors[0])) ||
+        !read(bufferViews.data(), bufferViews.size() * sizeof(bufferViews[0])) ||
+        fileSize - fileOffset != header.BufferSize)
+    {
+        return false;
+    }
+
+    const uint8_t* buffer = fileData + fileOffset;
+
+    for (auto& bufferView : bufferViews)
+    {
+        if (bufferView.Offset > header.BufferSize || bufferView.Size > header.BufferSize - bufferView.Offset)
+            return false;
+    }
+
+    auto getAccessor = [&](uint32_t index) -> const Accessor*
+    {
+        if (index >= header.AccessorCount || accessors[index].BufferView >= header.BufferViewCount)
+            return nullptr;
+
+        return &accessors[index];
+    };
+
+    // Find out what every buffer view holds, views used in several ways stay raw
+    struct ViewUsage
+    {
+        uint32_t                     Codec;
+        bool                         Conflict;
+        uint32_t                     ElementSize;
+        uint32_t                     Stride;
+        std::vector<AttributeSource> Attributes;
+        std::vector<uint32_t>        ChunkStarts;
+    };
+
+    std::vector<ViewUsage> usages(header.BufferViewCount);
+
+    auto use = [&](const Accessor* pAccessor, uint32_t codec)
+    {
+        ViewUsage& usage = usages[pAccessor->BufferView];
+
+        if (usage.Codec != STREAM_CODEC_RAW && (usage.Codec != codec || codec != STREAM_CODEC_VERTEX))
+            usage.Conflict = true;
+
+        usage.Codec = codec;
+        return &usage;
+    };
+
+    for (MeshHeader const& mesh : meshes)
+    {
+        if (const Accessor* pAccessor = getAccessor(mesh.Indices))
+        {
+            ViewUsage* pUsage = use(pAccessor, STREAM_CODEC_INDEX);
+            pUsage->ElementSize = pAccessor->Size;
+
+            for (uint32_t first = 0; first < pAccessor->Count; first += c_indicesPerChunk)
+                pUsage->ChunkStarts.push_back(first);
+        }
+
+        // Chunks of unique vertex indices follow groups of meshlets, which are encoded and decoded independently
+        const Accessor* pMeshlets = getAccessor(mesh.Meshlets);
+        if (const Accessor* pAccessor = getAccessor(mesh.UniqueVertexIndices))
+        {
+            ViewUsage* pUsage = use(pAccessor, STREAM_CODEC_INDEX);
+            pUsage->ElementSize = pAccessor->Size;
+
+            BufferView meshletView = pMeshlets != nullptr ? bufferViews[pMeshlets->BufferView] : BufferView{};
+            uint32_t meshletCount = (std::min)(pMeshlets != nullptr ? pMeshlets->Count : 0, meshletView.Size / static_cast<uint32_t>(sizeof(Meshlet)));
+
+            uint32_t previousStart = 0;
+            pUsage->ChunkStarts.push_back(0);
+
+            for (uint32_t m = c_meshletsPerChunk; m < meshletCount; m += c_meshletsPerChunk)
+            {
+                Meshlet meshlet;
+                std::memcpy(&meshlet, buffer + meshletView.Offset + m * sizeof(Meshlet), sizeof(meshlet));
+
+                if (meshlet.VertOffset > previousStart && meshlet.VertOffset < pAccessor->Count)
+                {
+                    pUsage->ChunkStarts.push_back(meshlet.VertOffset);
+                    previousStart = meshlet.VertOffset;
+                }
+            }
+        }
+
+        if (const Accessor* pAccessor = getAccessor(mesh.PrimitiveIndices))
+            use(pAccessor, STREAM_CODEC_TRIANGLE);
+
+        for (uint32_t j = 0; j < sizeof(mesh.Attributes) / sizeof(mesh.Attributes[0]); ++j)
+        {
+            if (const Accessor* pAccessor = getAccessor(mesh.Attributes[j]))
+            {
+                ViewUsage* pUsage = use(pAccessor, STREAM_CODEC_VERTEX);
+
+                if (!pUsage->Attributes.empty() && pUsage->Stride != pAccessor->Stride)
+                    pUsage->Conflict = true;
+
+                pUsage->Stride = pAccessor->Stride;
+                pUsage->Attributes.push_back({ j, pAccessor->Offset, pAccessor->Size });
+            }
+        }
+    }
+
+    // Encode the views, each one falls back to raw if it can't be encoded or doesn't get smaller
+    std::vector<BufferView> encodedViews(header.BufferViewCount);
+    std::vector<StreamDesc> streams(header.BufferViewCount);
+    std::vector<uint8_t> encodedBuffer;
+    std::vector<uint8_t> encoded;
+
+    for (uint32_t i = 0; i < header.BufferViewCount; ++i)
+    {
+        const uint8_t* pSrc = buffer + bufferViews[i].Offset;
+        const uint32_t size = bufferViews[i].Size;
+        ViewUsage const& usage = usages[i];
+
+        bool compressed = false;
+        if (!usage.Conflict)
+        {
+            switch (usage.Codec)
+            {
+            case STREAM_CODEC_VERTEX:   compressed = EncodeVertexStream(pSrc, size, usage.Stride, usage.Attributes, encoded); break;
+            case STREAM_CODEC_INDEX:    compressed = EncodeIndexStream(pSrc, size, usage.ElementSize, usage.ChunkStarts, encoded); break;
+            case STREAM_CODEC_TRIANGLE: compressed = EncodeTriangleStream(pSrc, size, encoded); break;
+            }
+        }
+
+        streams[i].DecodedSize = size;
+        streams[i].Codec = compressed && encoded.size() < size ? usage.Codec : STREAM_CODEC_RAW;
+
+        if (streams[i].Codec == STREAM_CODEC_RAW)
+            encoded.assign(pSrc, pSrc + size);
+
+        encodedBuffer.resize(Align4(static_cast<uint32_t>(encodedBuffer.size())), 0);
+
+        encodedViews[i].Offset = static_cast<uint32_t>(encodedBuffer.size());
+        encodedViews[i].Size = static_cast<uint32_t>(encoded.size());
+        encodedBuffer.insert(encodedBuffer.end(), encoded.begin(), encoded.end());
+    }
+
+    FileHeader encodedHeader = header;
+    encodedHeader.Version = FILE_VERSION_COMPRESSED;
+    encodedHeader.BufferSize = static_cast<uint32_t>(encodedBuffer.size());
+
+    std::ofstream stream(dstFilename, std::ios::binary);
+    if (!stream.is_open())
+        return false;
+
+    stream.write(reinterpret_cast<const char*>(&encodedHeader), sizeof(encodedHeader));
+    stream.write(reinterpret_cast<const char*>(meshes.data()), meshes.size() * sizeof(meshes[0]));
+    stream.write(reinterpret_cast<const char*>(accessors.data()), accessors.size() * sizeof(accessors[0]));
+    stream.write(reinterpret_cast<const char*>(encodedViews.data()), encodedViews.size() * sizeof(encodedViews[0]));
+    stream.write(reinterpret_cast<const char*>(streams.data()), streams.size() * sizeof(streams[0]));
+    stream.write(reinterpret_cast<const char*>(encodedBuffer.data()), encodedBuffer.size());
+
+    return stream.good();
+}
@@ -0,0 +1,112 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+///-------------------------------------------------------------------------------------------------
+/// MSHL file layout
+///
+/// FileHeader, MeshHeader[MeshCount], Accessor[AccessorCount], BufferView[BufferViewCount],
+/// StreamDesc[BufferViewCount] (compressed version only), binary data of BufferSize bytes.
+///
+/// In a compressed file every buffer view is an encoded stream, StreamDesc tells how to decode it.
+/// Accessors describe the decoded data, so the rest of the metadata has the same meaning as in
+/// the initial version.
+///-------------------------------------------------------------------------------------------------
+
+const uint32_t c_prolog = 'MSHL';
+
+enum FileVersion
+{
+    FILE_VERSION_INITIAL = 0,
+    FILE_VERSION_COMPRESSED = 1,
+    CURRENT_FILE_VERSION = FILE_VERSION_COMPRESSED
+};
+
+struct FileHeader
+{
+    uint32_t Prolog;
+    uint32_t Version;
+
+    uint32_t MeshCount;
+    uint32_t AccessorCount;
+    uint32_t BufferViewCount;
+    uint32_t BufferSize;
+};
+
+struct MeshHeader
+{
+    uint32_t Indices;
+    uint32_t IndexSubsets;
+    uint32_t Attributes[5]; // Attribute::Count
+
+    uint32_t Meshlets;
+    uint32_t MeshletSubsets;
+    uint32_t UniqueVertexIndices;
+    uint32_t PrimitiveIndices;
+    uint32_t CullData;
+};
+
+struct BufferView
+{
+    uint32_t Offset;
+    uint32_t Size;
+};
+
+struct Accessor
+{
+    uint32_t BufferView;
+    uint32_t Offset;
+    uint32_t Size;
+    uint32_t Stride;
+    uint32_t Count;
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Stream codecs
+///
+/// STREAM_CODEC_VERTEX     - interleaved vertices stored attribute by attribute: positions are
+///                           quantized to 16 bits per component within the bounding box, normals
+///                           are octahedral 2x16 bits, other attributes are raw;
+/// STREAM_CODEC_INDEX      - 16/32-bit indices as zigzag deltas in LEB128 varints, split into
+///                           independently decodable chunks (by groups of meshlets for unique
+///                           vertex indices);
+/// STREAM_CODEC_TRIANGLE   - 10-bit packed triangles as 3 bytes when meshlets have at most 256 vertices.
+///-------------------------------------------------------------------------------------------------
+
+enum StreamCodec : uint32_t
+{
+    STREAM_CODEC_RAW = 0,
+    STREAM_CODEC_VERTEX = 1,
+    STREAM_CODEC_INDEX = 2,
+    STREAM_CODEC_TRIANGLE = 3,
+};
+
+struct StreamDesc
+{
+    uint32_t Codec;
+    uint32_t DecodedSize;
+};
+
+// Checks headers of an encoded stream, decoding of a stream that passed it never writes out of pDest
+bool ValidateStream(StreamDesc const& desc, const uint8_t* pSrc, size_t srcSize);
+
+// Decodes a stream straight into destination memory (e.g. staging memory of an upload), chunks are
+// decoded by the thread pool if it's provided. Returns false on corrupted data, pDest is zeroed then.
+bool DecodeStream(StreamDesc const& desc, const uint8_t* pSrc, size_t srcSize, uint8_t* pDest, ThreadPool* pThreadPool = nullptr);
+
+// Converts a file of the initial version to the compressed one
+bool CompressModelFile(const char* srcFilename, const char* dstFilename);
@@ -0,0 +1,83 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <Include/SGLib.h>
+
+///-------------------------------------------------------------------------------------------------
+/// Bindless table
+///
+/// Emulates bindless access on top of a tabular root signature: a binding table parameter declares
+/// one large range of views (SRVs, UAVs or samplers), and every view registered in the table gets a
+/// persistent index in it. Shaders declare an unbounded array over the range and receive indices
+/// through constants, so draws change constants instead of views:
+///
+///     tables[1].SRVs = { 1, 0, capacity };                    // Root signature, space #1
+///     Texture2D Textures[] : register(t0, space1);            // Shader
+///     Textures[NonUniformResourceIndex(material.TextureIndex)]
+///
+/// Bind writes the used part of the table with a single ranged call, once per command list.
+/// Free indices are filled with the fallback view, so the whole bound range is always valid.
+///
+/// The call isn't free: every Bind copies GetCount() descriptors, whether they changed or not.
+/// The saving is in the draws, which no longer set views, so bind the table once per list and
+/// keep it compact rather than binding it per draw or registering views that are never drawn.
+///-------------------------------------------------------------------------------------------------
+
+static const SgU32 InvalidBindlessIndex = ~0u;
+
+template <typename TView>
+class BindlessTable
+{
+public:
+    BindlessTable();
+    ~BindlessTable();
+
+    BindlessTable(BindlessTable const&) = delete;
+    BindlessTable& operator=(BindlessTable const&) = delete;
+
+    // capacity must not exceed the number of registers of the range, the fallback view is referenced by the table
+    void    Init(SgU32 capacity, TView* pFallback);
+    void    Destroy();
+
+    // Returns the index of the view, a view registered twice keeps its index.
+    // Returns InvalidBindlessIndex if the table is full. Thread-safe.
+    SgU32   Register(TView* pView);
+
+    // Frees the index of the view, it may be given to another view by the next Register.
+    // Command lists recorded before keep their copy of the table. Thread-safe.
+    void    Unregister(TView* pView);
+
+    // Returns InvalidBindlessIndex for views which aren't registered. Thread-safe.
+    SgU32   GetBindlessIndex(TView* pView) const;
+
+    // Writes indices [0; GetCount()) to the binding table parameter, copies GetCount() descriptors every call
+    void    Bind(ISGCommandList* pCommandList, SgU32 paramIdx) const;
+
+    // Number of indices in use, including the free ones below the highest registered index
+    SgU32   GetCount() const;
+
+private:
+    mutable std::mutex                  m_Mutex;
+    std::vector<TView*>                 m_Views;
+    std::vector<SgU32>                  m_FreeIndices;
+    std::unordered_map<TView*, SgU32>   m_Indices;
+    TView*                              m_pFallback;
+    SgU32                               m_Capacity;
+};
+
+typedef BindlessTable<ISGShaderResourceView>    BindlessSRVTable;
+typedef BindlessTable<ISGUnorderedAccessView>   BindlessUAVTable;
+typedef BindlessTable<ISGSampler>               BindlessSamplerTable;
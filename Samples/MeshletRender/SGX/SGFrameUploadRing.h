@@ -0,0 +1,104 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <mutex>
+#include "SGHelpers.h"
+
+///-------------------------------------------------------------------------------------------------
+/// Per-frame upload ring
+///
+/// Keeps a set of persistently mapped upload buffers for every frame buffer of the execution context.
+/// Everything allocated during a frame is recycled when the same frame buffer is begun again, that is
+/// when ISGExecutionContext::BeginFrame has waited for its previous execution.
+///
+/// Allocate returns a linear suballocation (CPU pointer, buffer, offset) aligned to
+/// SG_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT by default: suitable for vertex/index data and copy sources.
+/// ISGCommandList::SetConstantBuffer binds a whole buffer, so AllocateConstants returns a pooled
+/// constant buffer of the frame instead of an offset.
+///-------------------------------------------------------------------------------------------------
+
+struct UploadAllocation
+{
+    void*       pCpuAddress;
+    ISGBuffer*  pBuffer;
+    U32         Offset;
+    U32         Size;
+};
+
+struct FrameUploadRingStats
+{
+    U64 AllocatedBytes;         // Within the current frame
+    U32 ConstantBuffers;        // Within the current frame
+    U32 Pages;                  // Over all frame buffers
+    U32 PooledConstantBuffers;  // Over all frame buffers
+};
+
+class FrameUploadRing
+{
+public:
+    static const U32 DefaultPageSize = 4 << 20;
+
+    FrameUploadRing();
+    ~FrameUploadRing();
+
+    FrameUploadRing(FrameUploadRing const&) = delete;
+    FrameUploadRing& operator=(FrameUploadRing const&) = delete;
+
+    // frameBuffers must match SG_EXECUTION_CONTEXT_DESC::FrameBuffers
+    void                Init(ISGDevice* pDevice, U32 frameBuffers, U32 pageSize = DefaultPageSize);
+    void                Destroy();
+
+    // Call right after ISGExecutionContext::BeginFrame
+    void                BeginFrame();
+
+    // Returned memory is write-only for the CPU and valid until the frame buffer is reused. Thread-safe.
+    UploadAllocation    Allocate(U32 sizeBytes, U32 alignment = SG_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+    // Returns a constant buffer filled with pData, the buffer is owned by the ring. Thread-safe.
+    ISGBuffer*          AllocateConstants(void const* pData, U32 sizeBytes);
+
+    // Returns a constant buffer of at least sizeBytes to be filled through *ppCpuAddress until the frame is submitted. Thread-safe.
+    ISGBuffer*          AllocateConstants(U32 sizeBytes, void** ppCpuAddress);
+
+    FrameUploadRingStats GetStats() const;
+
+private:
+    // Constant buffers are pooled by power of two sizes from 256 bytes to 64 KB
+    static const U32 NumSizeClasses = 9;
+
+    struct MappedBuffer
+    {
+        ISGBuffer*  pBuffer;
+        U8*         pData;
+        U32         Size;
+    };
+
+    struct FrameBuffer
+    {
+        std::vector<MappedBuffer>   Pages;
+        U32                         CurrentPage;
+        U32                         CurrentOffset;
+        U64                         AllocatedBytes;
+
+        std::vector<MappedBuffer>   ConstantBuffers[NumSizeClasses];
+        U32                         UsedConstantBuffers[NumSizeClasses];
+    };
+
+    MappedBuffer        CreateMappedBuffer(SG_BUFFER_DESC const& desc);
+
+    ISGDevice*                  m_pDevice;
+    std::vector<FrameBuffer>    m_FrameBuffers;
+    U32                         m_FrameBufferIndex;
+    U32                         m_PageSize;
+    mutable std::mutex          m_Mutex;
+};
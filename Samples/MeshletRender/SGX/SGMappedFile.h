@@ -0,0 +1,48 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "SGHelpers.h"
+
+///-------------------------------------------------------------------------------------------------
+/// Read-only memory mapped file
+///
+/// Maps the whole file into the address space, pages are loaded by the OS on first access.
+/// Unlike LoadBinaryFile nothing is copied, so data may be passed straight to staging memory.
+/// The mapping is read-only: writing through the returned pointer is an access violation.
+///-------------------------------------------------------------------------------------------------
+
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    // Returns false if the file is missing or empty
+    bool        Open(char const* pFileName);
+    void        Close();
+
+    bool        IsOpen() const { return m_pData != nullptr; }
+    U8 const*   GetData() const { return m_pData; }
+    U64         GetSize() const { return m_Size; }
+
+private:
+    void*       m_hMapping;     // Used on Windows only
+    U8 const*   m_pData;
+    U64         m_Size;
+};
@@ -0,0 +1,42 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include "SGThreadPool.h"
+
+///-------------------------------------------------------------------------------------------------
+/// Parallel command list recording
+///
+/// A command list group is a single logical slot (queue, time index) split into N sub-command-lists.
+/// Sub-lists occupy consecutive time indices [timeIndex; timeIndex + N), so the scheduler executes
+/// them one after another in the group order while they are recorded concurrently.
+/// Every sub-list starts with an empty state: render targets, viewports and pipeline state must be
+/// set in each of them (use the prologue callback of RecordCommandListGroup).
+///-------------------------------------------------------------------------------------------------
+
+// Schedules numLists command lists on queueIndex at time indices [timeIndex; timeIndex + numLists).
+// On failure no list stays scheduled.
+SG_RESULT ScheduleCommandListGroup(ISGExecutionContext* pExecCtx, SgU8 queueIndex, SgU16 timeIndex, SgU16 numLists, ISGCommandList** ppOutCommandLists);
+
+// Finishes every command list of the group, returns the first error
+SG_RESULT FinishCommandListGroup(ISGExecutionContext* pExecCtx, SgU16 numLists, ISGCommandList** ppCommandLists);
+
+typedef std::function<void(ISGCommandList* pCommandList, SgU32 listIndex)> CommandListRecordFunc;
+
+// Schedules the group, records every sub-list on the thread pool and finishes the group.
+// Scheduling and finishing happen on the calling thread, prologue (optional) and record are invoked on workers.
+// Returns the next free time index on success, 0 otherwise.
+SgU16 RecordCommandListGroup(ISGExecutionContext* pExecCtx, ThreadPool& threadPool, SgU8 queueIndex, SgU16 timeIndex, SgU16 numLists,
+    CommandListRecordFunc const& prologue, CommandListRecordFunc const& record);
+
+// Splits [0; itemCount) into numLists contiguous ranges, returns the range of listIndex
+void GetCommandListGroupRange(SgU32 itemCount, SgU32 numLists, SgU32 listIndex, SgU32* pOutFirst, SgU32* pOutCount);
@@ -0,0 +1,59 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Include/SGLib.h>
+
+///-------------------------------------------------------------------------------------------------
+/// Simple FIFO worker pool
+///-------------------------------------------------------------------------------------------------
+class ThreadPool
+{
+public:
+    typedef std::function<void()> Job;
+    typedef std::function<void(SgU32 index)> IndexedJob;
+
+    // numThreads = 0 uses hardware concurrency minus the calling thread
+    explicit ThreadPool(SgU32 numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    void    Submit(Job job);
+
+    // Runs job(0) ... job(count - 1) on the workers and the calling thread, returns when every index is done.
+    // Safe to call from a worker: the caller executes the remaining indices itself.
+    void    ParallelFor(SgU32 count, IndexedJob const& job);
+
+    // Waits for every submitted job
+    void    WaitIdle();
+
+    SgU32   GetThreadCount() const { return static_cast<SgU32>(m_Threads.size()); }
+
+private:
+    void    WorkerLoop();
+
+    std::vector<std::thread>    m_Threads;
+    std::deque<Job>             m_Jobs;
+    std::mutex                  m_Mutex;
+    std::condition_variable     m_JobAvailable;
+    std::condition_variable     m_Idle;
+    SgU32                       m_ActiveJobs;
+    bool                        m_Stop;
+};
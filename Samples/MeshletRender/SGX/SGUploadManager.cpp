@@ -0,0 +1,375 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGUploadManager.h"
+#include <cassert>
+#include <cstring>
+
+namespace
+{
+    // Staging offsets are aligned to keep copies friendly to any copy engine
+    const U32 StagingAlignment = 16;
+
+    bool IsSameStagingDesc(SG_TEXTURE_DESC const& a, SG_TEXTURE_DESC const& b)
+    {
+        return a.Dimension == b.Dimension && a.Format == b.Format && a.Width == b.Width && a.Height == b.Height &&
+            a.DepthOrArraySize == b.DepthOrArraySize && a.MipLevels == b.MipLevels;
+    }
+}
+
+UploadManager::UploadManager()
+    : m_pDevice(SG_NULL)
+    , m_FrameBuffers(1)
+    , m_PageSize(DefaultPageSize)
+    , m_FrameNumber(0)
+    , m_CurrentOffset(0)
+    , m_PendingBytes(0)
+    , m_LastSubmitted(0)
+    , m_LastCompleted(0)
+{
+}
+
+UploadManager::~UploadManager()
+{
+    Destroy();
+}
+
+void UploadManager::Init(ISGDevice* pDevice, U32 frameBuffers, U32 pageSize)
+{
+    Destroy();
+
+    m_pDevice = pDevice;
+    m_pDevice->AddRef();
+
+    m_FrameBuffers = frameBuffers > 0 ? frameBuffers : 1;
+    m_PageSize = AlignValue(pageSize, StagingAlignment);
+    m_FrameNumber = 0;
+}
+
+void UploadManager::Destroy()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    ReleaseCopies();
+
+    auto releasePages = [](std::vector<Page>& pages)
+    {
+        for (Page& page : pages)
+        {
+            page.pBuffer->Unmap();
+            page.pBuffer->Release();
+        }
+
+        pages.clear();
+    };
+
+    auto releaseTextures = [](std::vector<StagingTexture>& textures)
+    {
+        for (StagingTexture& texture : textures)
+            texture.pTexture->Release();
+
+        textures.clear();
+    };
+
+    releasePages(m_Pages);
+    releaseTextures(m_StagingTextures);
+
+    for (Batch& batch : m_InFlight)
+    {
+        releasePages(batch.Pages);
+        releaseTextures(batch.StagingTextures);
+    }
+
+    m_InFlight.clear();
+    m_LastCompleted = m_LastSubmitted;
+
+    releasePages(m_FreePages);
+    releaseTextures(m_FreeStagingTextures);
+
+    m_CurrentOffset = 0;
+    m_PendingBytes = 0;
+
+    SG_RELEASE(m_pDevice);
+}
+
+void UploadManager::BeginFrame()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_FrameNumber++;
+
+    // The frame buffer of a batch has been waited by ISGExecutionContext::BeginFrame
+    while (!m_InFlight.empty() && m_InFlight.front().FrameNumber + m_FrameBuffers <= m_FrameNumber)
+    {
+        Retire(m_InFlight.front());
+        m_InFlight.pop_front();
+    }
+}
+
+void UploadManager::OnIdle()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (Batch& batch : m_InFlight)
+        Retire(batch);
+
+    m_InFlight.clear();
+}
+
+void UploadManager::Retire(Batch& batch)
+{
+    for (Page& page : batch.Pages)
+    {
+        // Dedicated pages of oversized uploads aren't pooled
+        if (page.Size == m_PageSize)
+        {
+            m_FreePages.push_back(page);
+        }
+        else
+        {
+            page.pBuffer->Unmap();
+            page.pBuffer->Release();
+        }
+    }
+
+    m_FreeStagingTextures.insert(m_FreeStagingTextures.end(), batch.StagingTextures.begin(), batch.StagingTextures.end());
+    m_LastCompleted = batch.Id;
+}
+
+void UploadManager::ReleaseCopies()
+{
+    for (BufferCopy& copy : m_BufferCopies)
+        copy.pDestBuffer->Release();
+
+    for (TextureCopy& copy : m_TextureCopies)
+        copy.pDestTexture->Release();
+
+    m_BufferCopies.clear();
+    m_TextureCopies.clear();
+}
+
+U8* UploadManager::AllocateStaging(U32 sizeBytes, ISGBuffer** ppBuffer, U32* pOffset)
+{
+    U32 offset = AlignValue(m_CurrentOffset, StagingAlignment);
+
+    if (m_Pages.empty() || offset + sizeBytes > m_Pages.back().Size)
+    {
+        Page page{};
+
+        if (sizeBytes <= m_PageSize && !m_FreePages.empty())
+        {
+            page = m_FreePages.back();
+            m_FreePages.pop_back();
+        }
+        else
+        {
+            page.Size = sizeBytes > m_PageSize ? AlignValue(sizeBytes, StagingAlignment) : m_PageSize;
+
+            SG_BUFFER_DESC desc = FastBufferDesc::Upload(page.Size);
+            if (m_pDevice->CreateBuffer(&desc, &page.pBuffer) != SG_OK)
+                throw std::exception("Failed to create staging page");
+
+            // Staging pages stay mapped for their whole life
+            if (page.pBuffer->Map(reinterpret_cast<void**>(&page.pData)) != SG_OK)
+                throw std::exception("Failed to map staging page");
+        }
+
+        m_Pages.push_back(page);
+        offset = 0;
+    }
+
+    m_CurrentOffset = offset + sizeBytes;
+
+    *ppBuffer = m_Pages.back().pBuffer;
+    *pOffset = offset;
+    return m_Pages.back().pData + offset;
+}
+
+UploadManager::StagingTexture UploadManager::AcquireStagingTexture(SG_TEXTURE_DESC const& destDesc)
+{
+    for (size_t i = 0; i < m_FreeStagingTextures.size(); i++)
+    {
+        if (IsSameStagingDesc(m_FreeStagingTextures[i].Desc, destDesc))
+        {
+            StagingTexture texture = m_FreeStagingTextures[i];
+            m_FreeStagingTextures[i] = m_FreeStagingTextures.back();
+            m_FreeStagingTextures.pop_back();
+            return texture;
+        }
+    }
+
+    StagingTexture texture{};
+    texture.Desc = destDesc;
+    texture.Desc.Type = SG_TEXTURE_TYPE_UPLOAD;
+    texture.Desc.BindFlags = SG_TEXTURE_BIND_FLAG_NONE;
+
+    if (m_pDevice->CreateTexture(&texture.Desc, &texture.pTexture) != SG_OK)
+        throw std::exception("Failed to create staging texture");
+
+    return texture;
+}
+
+void* UploadManager::AllocateBufferUpload(ISGBuffer* pDestBuffer, U64 destOffset, U32 dataSize)
+{
+    assert(pDestBuffer != nullptr);
+    assert(dataSize > 0);
+
+    BufferCopy copy{};
+    copy.pDestBuffer = pDestBuffer;
+    copy.DestOffset = destOffset;
+    copy.Size = dataSize;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    U8* pDest = AllocateStaging(dataSize, &copy.pSrcBuffer, &copy.SrcOffset);
+
+    pDestBuffer->AddRef();
+    m_BufferCopies.push_back(copy);
+    m_PendingBytes += dataSize;
+
+    return pDest;
+}
+
+void UploadManager::QueueBufferUpload(ISGBuffer* pDestBuffer, U64 destOffset, void const* pSrcData, U32 dataSize)
+{
+    if (dataSize == 0)
+        return;
+
+    // The range is owned by this call, so several threads may fill their staging memory at once
+    memcpy(AllocateBufferUpload(pDestBuffer, destOffset, dataSize), pSrcData, dataSize);
+}
+
+void UploadManager::QueueTextureUpload(ISGTexture* pDestTexture, ImageDesc const& sourceImage, ByteBuffer const& bitmap)
+{
+    assert(pDestTexture != nullptr);
+
+    SG_TEXTURE_DESC destDesc{};
+    pDestTexture->GetDesc(&destDesc);
+
+    // Destination texture should be common
+    assert(destDesc.Type == SG_TEXTURE_TYPE_COMMON);
+
+    StagingTexture staging;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        staging = AcquireStagingTexture(destDesc);
+    }
+
+    U64 sourceRowSize = SgGetFormatSize(destDesc.Format) * static_cast<U64>(sourceImage.Width);
+    assert(bitmap.size() >= sourceRowSize * sourceImage.Height);
+
+    ISGSubresource* pSubresource = nullptr;
+    staging.pTexture->GetSubresource(0, 0, 0, &pSubresource);
+
+    SG_MAPPED_SUBRESOURCE mappedSubresource;
+    if (pSubresource->Map(&mappedSubresource) == SG_OK)
+    {
+        U8* pDest = static_cast<U8*>(mappedSubresource.pData);
+        U8 const* pSource = bitmap.data();
+
+        for (U32 row = 0; row < sourceImage.Height; row++)
+        {
+            memcpy(pDest, pSource, sourceRowSize);
+
+            pDest += mappedSubresource.RowPitch;
+            pSource += sourceRowSize;
+        }
+
+        pSubresource->Unmap();
+    }
+    pSubresource->Release();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    pDestTexture->AddRef();
+    m_TextureCopies.push_back({ pDestTexture, staging.pTexture });
+    m_StagingTextures.push_back(staging);
+    m_PendingBytes += sourceRowSize * sourceImage.Height;
+}
+
+UploadBatchId UploadManager::Submit(ISGCommandList* pCommandList)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (m_BufferCopies.empty() && m_TextureCopies.empty())
+        return m_LastSubmitted;
+
+    for (BufferCopy const& copy : m_BufferCopies)
+        pCommandList->CopyBufferRegion(copy.pDestBuffer, copy.DestOffset, copy.pSrcBuffer, copy.SrcOffset, copy.Size);
+
+    for (TextureCopy const& copy : m_TextureCopies)
+        pCommandList->CopyResource(copy.pDestTexture, copy.pSrcTexture);
+
+    ReleaseCopies();
+
+    Batch batch;
+    batch.Id = ++m_LastSubmitted;
+    batch.FrameNumber = m_FrameNumber;
+    batch.Bytes = m_PendingBytes;
+    batch.Pages.swap(m_Pages);
+    batch.StagingTextures.swap(m_StagingTextures);
+    m_InFlight.push_back(std::move(batch));
+
+    m_CurrentOffset = 0;
+    m_PendingBytes = 0;
+
+    return m_LastSubmitted;
+}
+
+UploadBatchId UploadManager::Submit(ISGExecutionContext* pExecutionContext, SgU8 queueIndex, SgU16 timeIndex)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_BufferCopies.empty() && m_TextureCopies.empty())
+            return m_LastSubmitted;
+    }
+
+    ISGCommandList* pCommandList = nullptr;
+    if (pExecutionContext->ScheduleCommandList(queueIndex, timeIndex, &pCommandList) != SG_OK)
+        return 0;
+
+    UploadBatchId batchId = Submit(pCommandList);
+    pExecutionContext->FinishCommandList(pCommandList);
+
+    return batchId;
+}
+
+bool UploadManager::IsComplete(UploadBatchId batchId) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return batchId <= m_LastCompleted;
+}
+
+UploadBatchId UploadManager::GetLastCompletedBatch() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_LastCompleted;
+}
+
+UploadManagerStats UploadManager::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    UploadManagerStats stats{};
+    stats.PendingBytes = m_PendingBytes;
+    stats.Pages = static_cast<U32>(m_Pages.size() + m_FreePages.size());
+    stats.StagingTextures = static_cast<U32>(m_StagingTextures.size() + m_FreeStagingTextures.size());
+    stats.SubmittedBatches = static_cast<U32>(m_LastSubmitted);
+
+    for (Batch const& batch : m_InFlight)
+    {
+        stats.InFlightBytes += batch.Bytes;
+        stats.Pages += static_cast<U32>(batch.Pages.size());
+        stats.StagingTextures += static_cast<U32>(batch.StagingTextures.size());
+    }
+
+    return stats;
+}
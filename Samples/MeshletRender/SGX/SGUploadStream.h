@@ -0,0 +1,117 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include "SGUploadManager.h"
+
+///-------------------------------------------------------------------------------------------------
+/// Upload stream
+///
+/// Spreads uploads over several frames on a dedicated queue (usually SG_QUEUE_TYPE_COPY), so loading
+/// of large assets overlaps rendering. Every frame Update stages queued requests up to the byte
+/// budget and submits them as one command list at the given time index. Buffers are split into
+/// chunks to respect the budget, textures are staged whole.
+///
+/// Requests are processed in order, a ticket identifies the request:
+/// - IsAvailable: every copy of the request has been scheduled, command lists at later time indices
+///   of the current frame and any list of later frames may consume the data;
+/// - IsComplete: the copies have been executed by the GPU.
+///-------------------------------------------------------------------------------------------------
+
+// 0 is never returned for a request and is always available and complete
+typedef U64 StreamTicket;
+
+struct UploadStreamStats
+{
+    U64 QueuedBytes;        // Waiting for the budget
+    U64 LastFrameBytes;     // Staged by the last Update
+    U32 QueuedRequests;
+};
+
+class UploadStream
+{
+public:
+    static const U32 DefaultBytesPerFrame = 8 << 20;
+
+    // Writes dataSize bytes of a request to the staging memory
+    typedef std::function<void(void* pDest)> FillFunction;
+
+    UploadStream();
+    ~UploadStream();
+
+    UploadStream(UploadStream const&) = delete;
+    UploadStream& operator=(UploadStream const&) = delete;
+
+    // frameBuffers must match SG_EXECUTION_CONTEXT_DESC::FrameBuffers, queueIndex is the queue the copies are scheduled on
+    void            Init(ISGDevice* pDevice, U32 frameBuffers, SgU8 queueIndex, U32 bytesPerFrame = DefaultBytesPerFrame);
+
+    // Execution context must be idle
+    void            Destroy();
+
+    // Source data isn't copied and must stay valid until the request is available. Thread-safe.
+    StreamTicket    QueueBufferUpload(ISGBuffer* pDestBuffer, U64 destOffset, void const* pSrcData, U64 dataSize);
+    StreamTicket    QueueTextureUpload(ISGTexture* pDestTexture, ImageDesc const& sourceImage, ByteBuffer const& bitmap);
+
+    // Data is produced by fill when the request is staged (e.g. decoded from a compressed file), such requests
+    // aren't split between frames. fill is called by Update. Thread-safe.
+    StreamTicket    QueueBufferUpload(ISGBuffer* pDestBuffer, U64 destOffset, U64 dataSize, FillFunction fill);
+
+    // Call once per frame right after ISGExecutionContext::BeginFrame
+    void            Update(ISGExecutionContext* pExecutionContext, SgU16 timeIndex);
+
+    // Call after ISGExecutionContext::WaitForIdle
+    void            OnIdle();
+
+    bool            IsAvailable(StreamTicket ticket) const;
+    bool            IsComplete(StreamTicket ticket) const;
+
+    UploadStreamStats GetStats() const;
+
+private:
+    struct Request
+    {
+        StreamTicket        Ticket;
+        ISGBuffer*          pDestBuffer;
+        ISGTexture*         pDestTexture;
+        U64                 DestOffset;
+        U8 const*           pSrcData;
+        U64                 Size;
+        U64                 StagedBytes;
+        ImageDesc           SourceImage;
+        ByteBuffer const*   pBitmap;
+        FillFunction        Fill;
+    };
+
+    struct SubmittedBatch
+    {
+        StreamTicket    LastTicket;     // Last request fully staged into the batch
+        UploadBatchId   BatchId;
+    };
+
+    void            RetireBatches();
+
+    UploadManager               m_UploadManager;
+    SgU8                        m_QueueIndex;
+    U32                         m_BytesPerFrame;
+
+    std::deque<Request>         m_Requests;
+    std::deque<SubmittedBatch>  m_SubmittedBatches;
+    StreamTicket                m_LastQueued;
+    StreamTicket                m_LastAvailable;
+    StreamTicket                m_LastComplete;
+    U64                         m_QueuedBytes;
+    U64                         m_LastFrameBytes;
+    mutable std::mutex          m_Mutex;
+};
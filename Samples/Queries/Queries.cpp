@@ -41,12 +41,10 @@ QueriesSample::QueriesSample(U32 width, U32 height, wchar_t const* windowName)
     , m_pDepthStencil(SG_NULL)
     , m_pDSView(SG_NULL)
 
-    , m_pCbFarQuad{}
-    , m_pCbNearQuad{}
+    , m_FarQuadDraw{}
+    , m_NearQuadDraw{}
 
     , m_pPredicate(SG_NULL)
-
-    , m_FrameIndex(0)
 {
 }
 
@@ -81,6 +79,8 @@ void QueriesSample::OnInit()
     if (SgCreateSwapChain(m_pExecutionContext, 0, &swapChainDesc, &m_pSwapChain) != SG_OK)
         throw std::exception("Failed swap chain creation");
 
+    m_UploadRing.Init(m_pDevice, NumFrames);
+
     LoadPipelineState();
     LoadAssets();
 }
@@ -91,11 +91,8 @@ void QueriesSample::OnDestroy()
 
     SG_RELEASE(m_pPredicate);
 
-    for (int i = 0; i < NumFrames; i++)
-    {
-        SG_RELEASE(m_pCbFarQuad[i]);
-        SG_RELEASE(m_pCbNearQuad[i]);
-    }
+    m_DrawConstants.Destroy();
+    m_UploadRing.Destroy();
 
     SG_RELEASE(m_pDSView);
     SG_RELEASE(m_pDepthStencil);
@@ -120,6 +117,7 @@ void QueriesSample::LoadPipelineState()
     {
         { "POSITION", 0, SG_FORMAT_R32G32B32_FLOAT, 0, 0, SG_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
         { "COLOR", 0, SG_FORMAT_R32G32B32A32_FLOAT, 0, 12, SG_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        DrawConstants::GetInputElement(1),
     };
 
     ISGInputLayout* pInputLayout = nullptr;
@@ -206,30 +204,6 @@ void QueriesSample::LoadAssets()
             throw std::exception("Failed to create depth stencil view");
     }
 
-    for (uint32_t i = 0; i < NumFrames; i++)
-    {
-        SG_BUFFER_DESC cbDesc = FastBufferDesc::Constant(sizeof(SceneConstantBuffer));
-        if (m_pDevice->CreateBuffer(&cbDesc, &m_pCbFarQuad[i]) != SG_OK)
-            throw std::exception("Failed to create constant buffer");
-
-        if (m_pDevice->CreateBuffer(&cbDesc, &m_pCbNearQuad[i]) != SG_OK)
-            throw std::exception("Failed to create constant buffer");
-
-        void* pData = nullptr;
-
-        if (m_pCbFarQuad[i]->Map(&pData) != SG_OK)
-            throw std::exception("Failed to map constant buffer");
-
-        memset(pData, 0, sizeof(SceneConstantBuffer));
-        m_pCbFarQuad[i]->Unmap();
-
-        if (m_pCbNearQuad[i]->Map(&pData) != SG_OK)
-            throw std::exception("Failed to map constant buffer");
-
-        memset(pData, 0, sizeof(SceneConstantBuffer));
-        m_pCbNearQuad[i]->Unmap();
-    }
-
     // Upload frame
     m_pExecutionContext->BeginFrame();
     ISGCommandList* pCommandList;
@@ -264,6 +238,8 @@ void QueriesSample::LoadAssets()
         m_pDevice->CreateBuffer(&vbDesc, &m_pVertexBuffer);
         UploadCommonBuffer(m_pDevice, pCommandList, m_pVertexBuffer, quadVertices, sizeof(quadVertices));
 
+        m_DrawConstants.Init(m_pDevice, pCommandList);
+
         m_pExecutionContext->FinishCommandList(pCommandList);
     }
     m_pExecutionContext->EndFrame();
@@ -277,9 +253,11 @@ void QueriesSample::OnUpdate()
 void QueriesSample::OnRender()
 {
     m_pExecutionContext->BeginFrame();
+    m_UploadRing.BeginFrame();
 
-    // Update constant buffer after frame has begun to prevent data race
+    // Update constants after frame has begun to prevent data race
     {
+        static const SceneConstantBuffer farCBData = {};
         static SceneConstantBuffer nearCBData = {};
 
         static TimeScaler timeScaler;
@@ -298,7 +276,9 @@ void QueriesSample::OnRender()
             nearCBData.offset.x = -offsetBounds;
         }
 
-        UploadBuffer(m_pCbNearQuad[m_FrameIndex], &nearCBData, sizeof(nearCBData));
+        m_DrawConstants.BeginBatch(m_UploadRing, sizeof(SceneConstantBuffer), 2);
+        m_FarQuadDraw = m_DrawConstants.Push(&farCBData);
+        m_NearQuadDraw = m_DrawConstants.Push(&nearCBData);
     }
 
     ISGCommandList* pCommandList = nullptr;
@@ -309,8 +289,6 @@ void QueriesSample::OnRender()
     }
 
     m_pExecutionContext->EndFrame1(1, &m_pSwapChain);
-
-    m_FrameIndex = (m_FrameIndex + 1) % NumFrames;
 }
 
 void QueriesSample::PrepareCommandList(ISGCommandList* pCommandList)
@@ -335,24 +313,29 @@ void QueriesSample::PrepareCommandList(ISGCommandList* pCommandList)
     pCommandList->SetScissorRects(1, &m_Scissor);
 
     pCommandList->SetVertexBuffer(0, m_pVertexBuffer, 0, sizeof(Vertex));
+    m_DrawConstants.SetDrawIndexBuffer(pCommandList, 1);
     pCommandList->SetPrimitiveTopology(SG_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP);
 
     pCommandList->SetPipelineState(m_pPipelineState);
     pCommandList->SetBlendState(m_pBlendStateRTOverride, ~0);
 
-    pCommandList->SetConstantBuffer(0, 0, m_pCbFarQuad[m_FrameIndex]);
+    // The start instance selects the record of a draw. Both records are usually in the same constant buffer,
+    // but a batch continues in a new buffer when the current one is full, so every draw binds the buffer of its record.
+    pCommandList->SetConstantBuffer(0, 0, m_FarQuadDraw.pBuffer);
+
     pCommandList->SetPredication(m_pPredicate, SG_PREDICATION_OP_EQUAL_ZERO);
-    pCommandList->DrawInstanced(4, 1, 0, 0);
+    pCommandList->DrawInstanced(4, 1, 0, m_FarQuadDraw.DrawIndex);
+
+    pCommandList->SetConstantBuffer(0, 0, m_NearQuadDraw.pBuffer);
 
-    pCommandList->SetConstantBuffer(0, 0, m_pCbNearQuad[m_FrameIndex]);
     pCommandList->SetPredication(nullptr, SG_PREDICATION_OP_EQUAL_ZERO);
-    pCommandList->DrawInstanced(4, 1, 4, 0);
+    pCommandList->DrawInstanced(4, 1, 4, m_NearQuadDraw.DrawIndex);
 
     pCommandList->SetBlendState(m_pBlendStateNoBlendState, ~0);
     pCommandList->SetDepthStencilState(m_pDepthOnlyRead);
+    pCommandList->SetConstantBuffer(0, 0, m_FarQuadDraw.pBuffer);
 
     pCommandList->BeginQuery(m_pPredicate);
-    pCommandList->SetConstantBuffer(0, 0, m_pCbFarQuad[m_FrameIndex]);
-    pCommandList->DrawInstanced(4, 1, 8, 0);
+    pCommandList->DrawInstanced(4, 1, 8, m_FarQuadDraw.DrawIndex);
     pCommandList->EndQuery(m_pPredicate);
 }
@@ -15,6 +15,8 @@
 
 #include "SGX/SGSample.h"
 #include <DirectXMath.h>
+#include "SGX/SGFrameUploadRing.h"
+#include "SGX/SGDrawConstants.h"
 
 class QueriesSample : public ISGSample
 {
@@ -54,14 +56,13 @@ private:
     ISGTexture* m_pDepthStencil;
     ISGDepthStencilView* m_pDSView;
 
-    ISGBuffer* m_pCbFarQuad[NumFrames];
-    ISGBuffer* m_pCbNearQuad[NumFrames];
+    // Offsets of both quads are records of one constant buffer of the frame, draws select them by the draw index
+    FrameUploadRing m_UploadRing;
+    DrawConstants m_DrawConstants;
+    DrawConstantsAllocation m_FarQuadDraw;
+    DrawConstantsAllocation m_NearQuadDraw;
 
     ISGPredicate* m_pPredicate;
-    U32 m_FrameIndex;
-
-    static_assert(_countof(m_pCbFarQuad) == NumFrames, "Number of constant buffers must be equal NumFrames");
-    static_assert(_countof(m_pCbNearQuad) == NumFrames, "Number of constant buffers must be equal NumFrames");
 
     void LoadPipelineState();
     void LoadAssets();
@@ -0,0 +1,116 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGDrawConstants.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+DrawConstants::DrawConstants()
+    : m_pDrawIndexBuffer(SG_NULL)
+    , m_MaxDraws(0)
+    , m_pUploadRing(nullptr)
+    , m_pBuffer(SG_NULL)
+    , m_pRecords(nullptr)
+    , m_RecordSize(0)
+    , m_RecordStride(0)
+    , m_ExpectedCount(0)
+    , m_BufferCapacity(0)
+    , m_BufferCount(0)
+{
+}
+
+DrawConstants::~DrawConstants()
+{
+    Destroy();
+}
+
+void DrawConstants::Init(ISGDevice* pDevice, ISGCommandList* pCommandList, U32 maxDraws)
+{
+    Destroy();
+
+    std::vector<U32> indices(maxDraws);
+    for (U32 i = 0; i < maxDraws; i++)
+        indices[i] = i;
+
+    U32 const sizeBytes = maxDraws * sizeof(U32);
+
+    SG_BUFFER_DESC desc = FastBufferDesc::Vertex(sizeBytes, false, false, false);
+    if (pDevice->CreateBuffer(&desc, &m_pDrawIndexBuffer) != SG_OK)
+        throw std::exception("Failed to create draw index buffer");
+
+    UploadCommonBuffer(pDevice, pCommandList, m_pDrawIndexBuffer, indices.data(), sizeBytes);
+
+    m_MaxDraws = maxDraws;
+}
+
+void DrawConstants::Destroy()
+{
+    SG_RELEASE(m_pDrawIndexBuffer);
+
+    m_MaxDraws = 0;
+    m_pUploadRing = nullptr;
+    m_pBuffer = SG_NULL;
+    m_pRecords = nullptr;
+    m_BufferCapacity = 0;
+    m_BufferCount = 0;
+}
+
+SG_INPUT_ELEMENT_DESC DrawConstants::GetInputElement(U32 inputSlot)
+{
+    return { "DRAWINDEX", 0, SG_FORMAT_R32_UINT, inputSlot, 0, SG_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 };
+}
+
+void DrawConstants::SetDrawIndexBuffer(ISGCommandList* pCommandList, U32 inputSlot) const
+{
+    pCommandList->SetVertexBuffer(inputSlot, m_pDrawIndexBuffer, 0, sizeof(U32));
+}
+
+void DrawConstants::BeginBatch(FrameUploadRing& uploadRing, U32 recordSize, U32 expectedCount)
+{
+    if (AlignValue(recordSize, 16) > MaxBufferSize)
+        throw std::exception("Draw constants record exceeds 64 KB");
+
+    m_pUploadRing = &uploadRing;
+    m_RecordSize = recordSize;
+    m_RecordStride = AlignValue(recordSize, 16);
+    m_ExpectedCount = expectedCount > 0 ? expectedCount : 1;
+
+    // Buffers are taken by the first Push
+    m_pBuffer = SG_NULL;
+    m_pRecords = nullptr;
+    m_BufferCapacity = 0;
+    m_BufferCount = 0;
+}
+
+DrawConstantsAllocation DrawConstants::Push(void const* pData)
+{
+    if (m_pUploadRing == nullptr)
+        throw std::exception("Draw constants batch isn't started");
+
+    if (m_pDrawIndexBuffer == SG_NULL)
+        throw std::exception("Draw constants aren't initialized");
+
+    if (m_BufferCount == m_BufferCapacity)
+    {
+        U32 const maxRecords = (std::min)(MaxBufferSize / m_RecordStride, m_MaxDraws);
+        U32 const records = m_pBuffer == SG_NULL ? (std::min)(m_ExpectedCount, maxRecords) : maxRecords;
+
+        void* pCpuAddress = nullptr;
+        m_pBuffer = m_pUploadRing->AllocateConstants(records * m_RecordStride, &pCpuAddress);
+        m_pRecords = static_cast<U8*>(pCpuAddress);
+        m_BufferCapacity = records;
+        m_BufferCount = 0;
+    }
+
+    memcpy(m_pRecords + m_BufferCount * m_RecordStride, pData, m_RecordSize);
+    return DrawConstantsAllocation{ m_pBuffer, m_BufferCount++ };
+}
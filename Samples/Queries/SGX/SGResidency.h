@@ -0,0 +1,136 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "SGHelpers.h"
+
+///-------------------------------------------------------------------------------------------------
+/// Residency manager
+///
+/// Keeps video memory usage reported by ISGDevice::GetMemoryUsage within the budget. Resources
+/// which can be recreated from data the application keeps (streamed meshes and textures, baked
+/// lookup tables) are registered with a pair of functions: restore creates the resource and
+/// queues its upload, evict releases it together with its views.
+///
+///     handle = residency.Register(sizeBytes, ResidencyPriority::Normal,
+///         [&]() { CreateAndUpload(mesh); },                      // Also called by Register
+///         [&]() { mesh.Release(); });
+///
+/// Every use by a command list is announced by MakeResident, which restores an evicted resource.
+/// Once the usage exceeds budget * targetUsage, BeginFrame evicts the least recently used
+/// resources, lower priorities first, down to budget * (targetUsage - evictionMargin), so the
+/// restores of the next frames don't start another eviction at once. Only resources idle for
+/// minIdleFrames are evicted, and never those used by frames still in flight. The functions
+/// are called under the manager's lock and must not call it back.
+///
+/// SGLib has no way to page memory out and keep the object, so eviction destroys the resource and
+/// residency has to be restored by recreating it. SG_MEMORY_DEBUG_CONFIG::LocalBudgetLimit
+/// simulates a small budget.
+///-------------------------------------------------------------------------------------------------
+
+typedef U32 ResidencyHandle;
+
+static const ResidencyHandle InvalidResidencyHandle = ~0u;
+
+enum class ResidencyPriority : U32
+{
+    Low,
+    Normal,
+    High,
+};
+
+struct ResidencyStats
+{
+    // Local memory segment at the last BeginFrame
+    U64     Budget;
+    U64     UsedMemory;
+
+    U32     Resources;
+    U32     ResidentResources;
+    U64     ResidentBytes;
+
+    // Accumulated until reset
+    U32     Evictions;
+    U64     EvictedBytes;
+    U32     Restores;
+    U64     RestoredBytes;
+
+    // Times BeginFrame couldn't get below the target because all candidates were in flight or used too recently
+    U32     OverBudgetFrames;
+};
+
+class ResidencyManager
+{
+public:
+    typedef std::function<void()> ResidencyFunction;
+
+    ResidencyManager();
+    ~ResidencyManager();
+
+    ResidencyManager(ResidencyManager const&) = delete;
+    ResidencyManager& operator=(ResidencyManager const&) = delete;
+
+    // Evicts once the usage exceeds budget * targetUsage, down to budget * (targetUsage - evictionMargin).
+    // frameBuffers must match the execution context, minIdleFrames below it are raised to it.
+    void            Init(ISGDevice* pDevice, U32 frameBuffers, float targetUsage = 0.9f, float evictionMargin = 0.05f,
+                        U32 minIdleFrames = 0);
+
+    // Forgets the resources without calling their functions
+    void            Destroy();
+
+    // Calls restore, the resource is resident and used by the current frame. Thread-safe.
+    ResidencyHandle Register(U64 sizeBytes, ResidencyPriority priority, ResidencyFunction restore, ResidencyFunction evict);
+
+    // Calls evict if the resource is resident. The resource must not be used by frames in flight. Thread-safe.
+    void            Unregister(ResidencyHandle handle);
+
+    // Marks the resource used by the current frame. Returns false if it was evicted and has been
+    // restored now, its data is available once the upload queued by restore is. Throws if the
+    // handle isn't registered. Thread-safe.
+    bool            MakeResident(ResidencyHandle handle);
+
+    // Returns false for handles which aren't registered. Thread-safe.
+    bool            IsResident(ResidencyHandle handle) const;
+
+    // Starts a new frame and evicts the resources over the budget, must follow ISGExecutionContext::BeginFrame
+    void            BeginFrame();
+
+    ResidencyStats  GetStats() const;
+    void            ResetStats();
+
+private:
+    struct Resource
+    {
+        U64                 SizeBytes;
+        ResidencyPriority   Priority;
+        ResidencyFunction   Restore;
+        ResidencyFunction   Evict;
+        U64                 LastUsedFrame;
+        bool                Registered;
+        bool                Resident;
+    };
+
+    mutable std::mutex      m_Mutex;
+    ISGDevice*              m_pDevice;
+    U32                     m_FrameBuffers;
+    float                   m_TargetUsage;
+    float                   m_EvictionMargin;
+    U32                     m_MinIdleFrames;
+    U64                     m_FrameNumber;
+
+    std::vector<Resource>   m_Resources;
+    std::vector<U32>        m_FreeHandles;
+    ResidencyStats          m_Stats;
+};
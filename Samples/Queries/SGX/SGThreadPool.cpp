@@ -0,0 +1,127 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(SgU32 numThreads)
+    : m_ActiveJobs(0)
+    , m_Stop(false)
+{
+    if (numThreads == 0)
+        numThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+    m_Threads.reserve(numThreads);
+    for (SgU32 i = 0; i < numThreads; i++)
+        m_Threads.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+
+    m_JobAvailable.notify_all();
+
+    for (std::thread& thread : m_Threads)
+        thread.join();
+}
+
+void ThreadPool::Submit(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Jobs.push_back(std::move(job));
+    }
+
+    m_JobAvailable.notify_one();
+}
+
+void ThreadPool::ParallelFor(SgU32 count, IndexedJob const& job)
+{
+    if (count == 0)
+        return;
+
+    struct SharedState
+    {
+        std::atomic<SgU32>      NextIndex{ 0 };
+        std::atomic<SgU32>      DoneCount{ 0 };
+        std::mutex              Mutex;
+        std::condition_variable Done;
+    };
+
+    // Helpers may start after ParallelFor returned, so the state is shared and the job is copied
+    std::shared_ptr<SharedState> pState = std::make_shared<SharedState>();
+    std::shared_ptr<IndexedJob> pJob = std::make_shared<IndexedJob>(job);
+
+    auto process = [pState, pJob, count]()
+    {
+        for (SgU32 index = pState->NextIndex++; index < count; index = pState->NextIndex++)
+        {
+            (*pJob)(index);
+
+            if (++pState->DoneCount == count)
+            {
+                std::lock_guard<std::mutex> lock(pState->Mutex);
+                pState->Done.notify_all();
+            }
+        }
+    };
+
+    SgU32 const numHelpers = std::min(count - 1, GetThreadCount());
+    for (SgU32 i = 0; i < numHelpers; i++)
+        Submit(process);
+
+    process();
+
+    std::unique_lock<std::mutex> lock(pState->Mutex);
+    pState->Done.wait(lock, [&pState, count]() { return pState->DoneCount == count; });
+}
+
+void ThreadPool::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Idle.wait(lock, [this]() { return m_Jobs.empty() && m_ActiveJobs == 0; });
+}
+
+void ThreadPool::WorkerLoop()
+{
+    for (;;)
+    {
+        Job job;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_JobAvailable.wait(lock, [this]() { return m_Stop || !m_Jobs.empty(); });
+
+            if (m_Stop && m_Jobs.empty())
+                return;
+
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+            m_ActiveJobs++;
+        }
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_ActiveJobs--;
+
+            if (m_Jobs.empty() && m_ActiveJobs == 0)
+                m_Idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,239 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGUploadStream.h"
+#include <algorithm>
+#include <cassert>
+
+UploadStream::UploadStream()
+    : m_QueueIndex(0)
+    , m_BytesPerFrame(DefaultBytesPerFrame)
+    , m_LastQueued(0)
+    , m_LastAvailable(0)
+    , m_LastComplete(0)
+    , m_QueuedBytes(0)
+    , m_LastFrameBytes(0)
+{
+}
+
+UploadStream::~UploadStream()
+{
+    Destroy();
+}
+
+void UploadStream::Init(ISGDevice* pDevice, U32 frameBuffers, SgU8 queueIndex, U32 bytesPerFrame)
+{
+    Destroy();
+
+    m_QueueIndex = queueIndex;
+    m_BytesPerFrame = bytesPerFrame > 0 ? bytesPerFrame : DefaultBytesPerFrame;
+
+    // A single batch never exceeds the budget, so pages of the budget size are reused every frame
+    m_UploadManager.Init(pDevice, frameBuffers, m_BytesPerFrame);
+}
+
+void UploadStream::Destroy()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (Request& request : m_Requests)
+    {
+        SG_RELEASE(request.pDestBuffer);
+        SG_RELEASE(request.pDestTexture);
+    }
+
+    m_Requests.clear();
+    m_SubmittedBatches.clear();
+    m_UploadManager.Destroy();
+
+    m_LastAvailable = m_LastQueued;
+    m_LastComplete = m_LastQueued;
+    m_QueuedBytes = 0;
+    m_LastFrameBytes = 0;
+}
+
+StreamTicket UploadStream::QueueBufferUpload(ISGBuffer* pDestBuffer, U64 destOffset, void const* pSrcData, U64 dataSize)
+{
+    assert(pDestBuffer != nullptr);
+
+    Request request{};
+    request.pDestBuffer = pDestBuffer;
+    request.DestOffset = destOffset;
+    request.pSrcData = static_cast<U8 const*>(pSrcData);
+    request.Size = dataSize;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    request.Ticket = ++m_LastQueued;
+    pDestBuffer->AddRef();
+
+    m_Requests.push_back(request);
+    m_QueuedBytes += dataSize;
+
+    return request.Ticket;
+}
+
+StreamTicket UploadStream::QueueBufferUpload(ISGBuffer* pDestBuffer, U64 destOffset, U64 dataSize, FillFunction fill)
+{
+    assert(pDestBuffer != nullptr);
+    assert(dataSize <= UINT32_MAX);
+
+    Request request{};
+    request.pDestBuffer = pDestBuffer;
+    request.DestOffset = destOffset;
+    request.Size = dataSize;
+    request.Fill = std::move(fill);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    request.Ticket = ++m_LastQueued;
+    pDestBuffer->AddRef();
+
+    m_Requests.push_back(std::move(request));
+    m_QueuedBytes += dataSize;
+
+    return m_LastQueued;
+}
+
+StreamTicket UploadStream::QueueTextureUpload(ISGTexture* pDestTexture, ImageDesc const& sourceImage, ByteBuffer const& bitmap)
+{
+    assert(pDestTexture != nullptr);
+
+    Request request{};
+    request.pDestTexture = pDestTexture;
+    request.Size = SgGetFormatSize(sourceImage.Format) * static_cast<U64>(sourceImage.Width) * sourceImage.Height;
+    request.SourceImage = sourceImage;
+    request.pBitmap = &bitmap;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    request.Ticket = ++m_LastQueued;
+    pDestTexture->AddRef();
+
+    m_Requests.push_back(request);
+    m_QueuedBytes += request.Size;
+
+    return request.Ticket;
+}
+
+void UploadStream::Update(ISGExecutionContext* pExecutionContext, SgU16 timeIndex)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_UploadManager.BeginFrame();
+    RetireBatches();
+
+    U64 stagedBytes = 0;
+    StreamTicket lastStagedTicket = m_LastAvailable;
+
+    while (!m_Requests.empty() && stagedBytes < m_BytesPerFrame)
+    {
+        Request& request = m_Requests.front();
+
+        if (request.pDestTexture != nullptr || request.Fill)
+        {
+            // Textures and filled buffers can't be split, the first request of a frame is staged even if it exceeds the budget
+            if (stagedBytes > 0 && stagedBytes + request.Size > m_BytesPerFrame)
+                break;
+
+            if (request.pDestTexture != nullptr)
+                m_UploadManager.QueueTextureUpload(request.pDestTexture, request.SourceImage, *request.pBitmap);
+            else if (request.Size > 0)
+                request.Fill(m_UploadManager.AllocateBufferUpload(request.pDestBuffer, request.DestOffset, static_cast<U32>(request.Size)));
+
+            request.StagedBytes = request.Size;
+            stagedBytes += request.Size;
+        }
+        else
+        {
+            U64 chunkSize = (std::min)(request.Size - request.StagedBytes, m_BytesPerFrame - stagedBytes);
+
+            m_UploadManager.QueueBufferUpload(request.pDestBuffer, request.DestOffset + request.StagedBytes,
+                request.pSrcData + request.StagedBytes, static_cast<U32>(chunkSize));
+
+            request.StagedBytes += chunkSize;
+            stagedBytes += chunkSize;
+
+            if (request.StagedBytes < request.Size)
+                break;
+        }
+
+        lastStagedTicket = request.Ticket;
+
+        SG_RELEASE(request.pDestBuffer);
+        SG_RELEASE(request.pDestTexture);
+        m_Requests.pop_front();
+    }
+
+    m_QueuedBytes -= (std::min)(m_QueuedBytes, stagedBytes);
+    m_LastFrameBytes = stagedBytes;
+
+    // Nothing to copy, but empty requests may have been retired
+    if (stagedBytes == 0)
+    {
+        m_LastAvailable = lastStagedTicket;
+
+        if (m_SubmittedBatches.empty())
+            m_LastComplete = lastStagedTicket;
+        else
+            m_SubmittedBatches.back().LastTicket = lastStagedTicket;
+
+        return;
+    }
+
+    UploadBatchId batchId = m_UploadManager.Submit(pExecutionContext, m_QueueIndex, timeIndex);
+    if (batchId == 0)
+        throw std::exception("Failed to schedule upload stream command list");
+
+    m_LastAvailable = lastStagedTicket;
+    m_SubmittedBatches.push_back({ lastStagedTicket, batchId });
+}
+
+void UploadStream::OnIdle()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_UploadManager.OnIdle();
+    RetireBatches();
+}
+
+void UploadStream::RetireBatches()
+{
+    while (!m_SubmittedBatches.empty() && m_UploadManager.IsComplete(m_SubmittedBatches.front().BatchId))
+    {
+        m_LastComplete = m_SubmittedBatches.front().LastTicket;
+        m_SubmittedBatches.pop_front();
+    }
+}
+
+bool UploadStream::IsAvailable(StreamTicket ticket) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return ticket <= m_LastAvailable;
+}
+
+bool UploadStream::IsComplete(StreamTicket ticket) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return ticket <= m_LastComplete;
+}
+
+UploadStreamStats UploadStream::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    UploadStreamStats stats{};
+    stats.QueuedBytes = m_QueuedBytes;
+    stats.LastFrameBytes = m_LastFrameBytes;
+    stats.QueuedRequests = static_cast<U32>(m_Requests.size());
+
+    return stats;
+}
@@ -12,16 +12,17 @@
 
 #include "Shaders.hlsli"
 
+// Offsets of all quads of the frame, a draw selects its one by the draw index (see SGX/SGDrawConstants.h)
 cbuffer SceneConstantBuffer : register(b0)
 {
-    float4 offset;
+    float4 offsets[2];
 };
 
-PSInput VSMain(float4 position : POSITION, float4 color : COLOR)
+PSInput VSMain(float4 position : POSITION, float4 color : COLOR, uint drawIndex : DRAWINDEX)
 {
     PSInput result;
 
-    result.position = position + offset;
+    result.position = position + offsets[drawIndex];
     result.color = color;
 
     return result;
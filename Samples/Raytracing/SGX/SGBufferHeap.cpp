@@ -0,0 +1,467 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGBufferHeap.h"
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+    // Placement alignment of committed buffers
+    const U64 c_CommittedAlignment = 64 << 10;
+}
+
+BufferHeap::BufferHeap()
+    : m_pDevice(nullptr)
+    , m_Desc{}
+    , m_FrameBuffers(1)
+    , m_PageSize(0)
+    , m_DedicatedThreshold(0)
+    , m_FrameNumber(0)
+    , m_DefragmentPage(DedicatedPage)
+    , m_AllocationCount(0)
+    , m_AllocatedBytes(0)
+    , m_PaddingBytes(0)
+    , m_DedicatedBytes(0)
+    , m_MovedAllocations(0)
+    , m_MovedBytes(0)
+    , m_ReclaimedBytes(0)
+{
+}
+
+BufferHeap::~BufferHeap()
+{
+    Destroy();
+}
+
+void BufferHeap::Init(ISGDevice* pDevice, U32 frameBuffers, SG_BUFFER_DESC const& desc, U32 pageSize, U32 dedicatedThreshold)
+{
+    Destroy();
+
+    m_pDevice = pDevice;
+    m_FrameBuffers = (std::max)(frameBuffers, 1u);
+    m_Desc = desc;
+    m_PageSize = pageSize;
+    m_DedicatedThreshold = dedicatedThreshold > 0 ? (std::min)(dedicatedThreshold, pageSize) : pageSize / 4;
+}
+
+void BufferHeap::Destroy()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (Page& page : m_Pages)
+        ReleasePage(page);
+
+    for (ISGBuffer* pBuffer : m_Dedicated)
+        pBuffer->Release();
+
+    m_Pages.clear();
+    m_Dedicated.clear();
+    m_PendingBlocks.clear();
+    m_RetiringPages.clear();
+    m_pDevice = nullptr;
+    m_FrameNumber = 0;
+    m_DefragmentPage = DedicatedPage;
+    m_AllocationCount = 0;
+    m_AllocatedBytes = 0;
+    m_PaddingBytes = 0;
+    m_DedicatedBytes = 0;
+    m_MovedAllocations = 0;
+    m_MovedBytes = 0;
+    m_ReclaimedBytes = 0;
+}
+
+ISGBuffer* BufferHeap::CreateBuffer(U32 sizeBytes)
+{
+    SG_BUFFER_DESC desc = m_Desc;
+    desc.Size = sizeBytes;
+
+    ISGBuffer* pBuffer = SG_NULL;
+    if (m_pDevice->CreateBuffer(&desc, &pBuffer) != SG_OK)
+        throw std::exception("Failed to create buffer heap page");
+
+    return pBuffer;
+}
+
+bool BufferHeap::AllocateInPage(U32 pageIndex, U32 sizeBytes, U32 alignment, BufferAllocation* pAllocation)
+{
+    Page& page = m_Pages[pageIndex];
+
+    for (auto it = page.FreeRanges.begin(); it != page.FreeRanges.end(); ++it)
+    {
+        U32 const rangeOffset = it->first;
+        U32 const rangeSize = it->second;
+        U32 const offset = AlignValue(rangeOffset, alignment);
+
+        if (offset + sizeBytes > rangeOffset + rangeSize)
+            continue;
+
+        // Padding stays with the block, the tail of the range remains free
+        U32 const blockSize = offset - rangeOffset + sizeBytes;
+
+        page.FreeRanges.erase(it);
+        if (blockSize < rangeSize)
+            page.FreeRanges.emplace(rangeOffset + blockSize, rangeSize - blockSize);
+
+        page.AllocationCount++;
+        m_PaddingBytes += offset - rangeOffset;
+
+        *pAllocation = { page.pBuffer, offset, sizeBytes, pageIndex, rangeOffset, blockSize };
+        return true;
+    }
+
+    return false;
+}
+
+BufferAllocation BufferHeap::AllocatePlaced(U32 sizeBytes, U32 alignment, U32 sourcePage)
+{
+    BufferAllocation allocation = {};
+    U32 freeSlot = static_cast<U32>(m_Pages.size());
+
+    bool const compacting = sourcePage != DedicatedPage;
+
+    for (U32 i = 0; i < m_Pages.size(); i++)
+    {
+        Page const& page = m_Pages[i];
+
+        // Moves don't go to the pages being emptied or waiting to be released
+        bool const emptied = compacting && (i == sourcePage || page.Retiring || (page.PendingCount > 0 && page.AllocationCount == page.PendingCount));
+
+        if (page.pBuffer == SG_NULL)
+            freeSlot = (std::min)(freeSlot, i);
+        else if (!emptied && AllocateInPage(i, sizeBytes, alignment, &allocation))
+            return allocation;
+    }
+
+    if (compacting)
+        return allocation;
+
+    if (freeSlot == m_Pages.size())
+        m_Pages.emplace_back();
+
+    Page& page = m_Pages[freeSlot];
+    page.pBuffer = CreateBuffer(m_PageSize);
+    page.FreeRanges.emplace(0, m_PageSize);
+    page.AllocationCount = 0;
+    page.PendingCount = 0;
+    page.Retiring = false;
+    page.Reclaimed = false;
+    page.EmptyFrame = 0;
+
+    // Offset 0 is aligned to anything and the request fits the page
+    AllocateInPage(freeSlot, sizeBytes, alignment, &allocation);
+    return allocation;
+}
+
+void BufferHeap::ReleasePage(Page& page)
+{
+    SG_RELEASE(page.pBuffer);
+    page.FreeRanges.clear();
+    page.Movables.clear();
+    page.AllocationCount = 0;
+    page.PendingCount = 0;
+    page.Retiring = false;
+}
+
+BufferAllocation BufferHeap::Allocate(U32 sizeBytes, U32 alignment, bool dedicated)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (m_pDevice == nullptr)
+        throw std::exception("Buffer heap isn't initialized");
+
+    alignment = (std::max)(alignment, 1u);
+
+    BufferAllocation allocation = {};
+
+    if (dedicated || sizeBytes > m_DedicatedThreshold)
+    {
+        ISGBuffer* pBuffer = CreateBuffer(sizeBytes);
+        m_Dedicated.push_back(pBuffer);
+
+        U64 const reservedBytes = (sizeBytes + c_CommittedAlignment - 1) / c_CommittedAlignment * c_CommittedAlignment;
+        m_DedicatedBytes += reservedBytes;
+        m_PaddingBytes += reservedBytes - sizeBytes;
+
+        allocation = { pBuffer, 0, sizeBytes, DedicatedPage, 0, sizeBytes };
+    }
+    else
+    {
+        allocation = AllocatePlaced(sizeBytes, alignment, DedicatedPage);
+    }
+
+    m_AllocationCount++;
+    m_AllocatedBytes += sizeBytes;
+    return allocation;
+}
+
+BufferAllocation BufferHeap::AllocateMovable(U32 sizeBytes, U32 alignment, MoveFunction onMove)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (m_pDevice == nullptr)
+        throw std::exception("Buffer heap isn't initialized");
+
+    alignment = (std::max)(alignment, 1u);
+
+    if (sizeBytes > m_PageSize)
+        throw std::exception("Movable allocation doesn't fit a buffer heap page");
+
+    BufferAllocation const allocation = AllocatePlaced(sizeBytes, alignment, DedicatedPage);
+    m_Pages[allocation.Page].Movables.emplace(allocation.BlockOffset, Movable{ allocation, alignment, std::move(onMove) });
+
+    m_AllocationCount++;
+    m_AllocatedBytes += sizeBytes;
+    return allocation;
+}
+
+void BufferHeap::Free(BufferAllocation const& allocation)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (allocation.pBuffer == SG_NULL)
+        return;
+
+    m_AllocationCount--;
+    m_AllocatedBytes -= allocation.Size;
+
+    if (allocation.Page == DedicatedPage)
+    {
+        auto it = std::find(m_Dedicated.begin(), m_Dedicated.end(), allocation.pBuffer);
+        if (it != m_Dedicated.end())
+        {
+            U64 const reservedBytes = (allocation.Size + c_CommittedAlignment - 1) / c_CommittedAlignment * c_CommittedAlignment;
+            m_DedicatedBytes -= reservedBytes;
+            m_PaddingBytes -= reservedBytes - allocation.Size;
+
+            (*it)->Release();
+            m_Dedicated.erase(it);
+        }
+        return;
+    }
+
+    m_Pages[allocation.Page].Movables.erase(allocation.BlockOffset);
+    FreeBlock(allocation, false);
+}
+
+void BufferHeap::FreeBlock(BufferAllocation const& allocation, bool pending)
+{
+    Page& page = m_Pages[allocation.Page];
+    m_PaddingBytes -= allocation.Offset - allocation.BlockOffset;
+
+    if (pending)
+        page.PendingCount--;
+
+    // Frames in flight may still read the page, it's released by BeginFrame once they retire
+    if (--page.AllocationCount == 0)
+    {
+        if (!page.Retiring)
+            m_RetiringPages.push_back(allocation.Page);
+
+        page.Retiring = true;
+        page.Reclaimed = pending;
+        page.EmptyFrame = m_FrameNumber;
+
+        if (m_DefragmentPage == allocation.Page)
+            m_DefragmentPage = DedicatedPage;
+    }
+
+    // Merges the block with the free neighbours
+    U32 offset = allocation.BlockOffset;
+    U32 size = allocation.BlockSize;
+
+    auto next = page.FreeRanges.lower_bound(offset);
+    if (next != page.FreeRanges.end() && next->first == offset + size)
+    {
+        size += next->second;
+        next = page.FreeRanges.erase(next);
+    }
+
+    if (next != page.FreeRanges.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size += prev->second;
+            page.FreeRanges.erase(prev);
+        }
+    }
+
+    page.FreeRanges.emplace(offset, size);
+}
+
+void BufferHeap::BeginFrame()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_FrameNumber++;
+
+    // The frame buffer of the moves has been waited by ISGExecutionContext::BeginFrame
+    auto it = m_PendingBlocks.begin();
+    for (; it != m_PendingBlocks.end() && m_FrameNumber - it->FrameNumber >= m_FrameBuffers; ++it)
+        FreeBlock(it->Allocation, true);
+
+    m_PendingBlocks.erase(m_PendingBlocks.begin(), it);
+
+    U32 livePages = 0;
+    for (Page const& page : m_Pages)
+        livePages += page.pBuffer != SG_NULL ? 1 : 0;
+
+    auto retired = std::remove_if(m_RetiringPages.begin(), m_RetiringPages.end(), [&](U32 pageIndex)
+    {
+        Page& page = m_Pages[pageIndex];
+
+        // Allocated from again, or the last page, which is kept
+        if (page.AllocationCount > 0 || livePages == 1)
+        {
+            page.Retiring = false;
+            return true;
+        }
+
+        if (m_FrameNumber - page.EmptyFrame < m_FrameBuffers)
+            return false;
+
+        if (page.Reclaimed)
+            m_ReclaimedBytes += m_PageSize;
+
+        ReleasePage(page);
+        livePages--;
+        return true;
+    });
+
+    m_RetiringPages.erase(retired, m_RetiringPages.end());
+}
+
+U64 BufferHeap::Defragment(ISGCommandList* pCommandList, U64 maxBytes)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto isMovable = [](Page const& page)
+    {
+        return page.pBuffer != SG_NULL && !page.Movables.empty() && page.AllocationCount == page.PendingCount + page.Movables.size();
+    };
+
+    if (m_DefragmentPage == DedicatedPage || !isMovable(m_Pages[m_DefragmentPage]))
+    {
+        m_DefragmentPage = DedicatedPage;
+
+        // The least occupied page with movable allocations only, whose allocations fit the free memory of the others.
+        // Pages waiting to be released don't take moves.
+        U64 totalFree = 0;
+        for (Page const& page : m_Pages)
+        {
+            if (page.Retiring)
+                continue;
+
+            for (auto const& range : page.FreeRanges)
+                totalFree += range.second;
+        }
+
+        U64 minBytes = ~0ull;
+        for (U32 i = 0; i < m_Pages.size(); i++)
+        {
+            Page const& page = m_Pages[i];
+
+            if (!isMovable(page))
+                continue;
+
+            U64 movableBytes = 0;
+            for (auto const& movable : page.Movables)
+                movableBytes += movable.second.Allocation.BlockSize;
+
+            U64 pageFree = 0;
+            for (auto const& range : page.FreeRanges)
+                pageFree += range.second;
+
+            if (movableBytes < minBytes && movableBytes <= totalFree - pageFree)
+            {
+                minBytes = movableBytes;
+                m_DefragmentPage = i;
+            }
+        }
+
+        if (m_DefragmentPage == DedicatedPage)
+            return 0;
+    }
+
+    U32 const sourceIndex = m_DefragmentPage;
+    Page& source = m_Pages[sourceIndex];
+    U64 movedBytes = 0;
+
+    while (!source.Movables.empty())
+    {
+        auto it = source.Movables.begin();
+        BufferAllocation const oldAllocation = it->second.Allocation;
+
+        if (movedBytes > 0 && movedBytes + oldAllocation.Size > maxBytes)
+            break;
+
+        // Pages aren't created, so the page vector and the source stay in place
+        BufferAllocation const newAllocation = AllocatePlaced(oldAllocation.Size, it->second.Alignment, sourceIndex);
+        if (newAllocation.pBuffer == SG_NULL)
+        {
+            m_DefragmentPage = DedicatedPage;
+            break;
+        }
+
+        pCommandList->CopyBufferRegion(newAllocation.pBuffer, newAllocation.Offset, oldAllocation.pBuffer, oldAllocation.Offset, oldAllocation.Size);
+
+        Movable& movable = m_Pages[newAllocation.Page].Movables.emplace(newAllocation.BlockOffset, std::move(it->second)).first->second;
+        movable.Allocation = newAllocation;
+        source.Movables.erase(it);
+
+        // The old block is read by the copy and by frames in flight
+        source.PendingCount++;
+        m_PendingBlocks.push_back({ oldAllocation, m_FrameNumber });
+
+        movedBytes += oldAllocation.Size;
+        m_MovedAllocations++;
+        m_MovedBytes += oldAllocation.Size;
+
+        movable.OnMove(newAllocation);
+    }
+
+    return movedBytes;
+}
+
+BufferHeapStats BufferHeap::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    BufferHeapStats stats = {};
+    stats.DedicatedCount = static_cast<U32>(m_Dedicated.size());
+    stats.AllocationCount = m_AllocationCount;
+    stats.AllocatedBytes = m_AllocatedBytes;
+    stats.WastedBytes = m_PaddingBytes;
+    stats.ReservedBytes = m_DedicatedBytes;
+
+    for (Page const& page : m_Pages)
+    {
+        if (page.pBuffer == SG_NULL)
+            continue;
+
+        stats.PageCount++;
+        stats.ReservedBytes += m_PageSize;
+
+        for (auto const& range : page.FreeRanges)
+        {
+            stats.FreeBytes += range.second;
+            stats.LargestFreeRange = (std::max)(stats.LargestFreeRange, U64(range.second));
+        }
+    }
+
+    stats.Fragmentation = stats.FreeBytes > 0 ? 1.0f - float(stats.LargestFreeRange) / float(stats.FreeBytes) : 0.0f;
+    stats.MovedAllocations = m_MovedAllocations;
+    stats.MovedBytes = m_MovedBytes;
+    stats.ReclaimedBytes = m_ReclaimedBytes;
+    return stats;
+}
@@ -0,0 +1,201 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "SGHelpers.h"
+
+///-------------------------------------------------------------------------------------------------
+/// Buffer heap
+///
+/// Every ISGDevice::CreateBuffer call makes a committed allocation, which is rounded up to 64 KB
+/// and costs a driver call. BufferHeap places small and medium buffers as ranges of large page
+/// buffers of the same type and bind flags. Views address a range by their first element, vertex
+/// and index buffers and copies by the offset:
+///
+///     BufferAllocation allocation = heap.Allocate(indexBytes, sizeof(U32));
+///     FastViewDesc::AsStructuredBuffer(allocation.Offset / sizeof(U32), indexCount, sizeof(U32));
+///     pCommandList->SetIndexBuffer(allocation.pBuffer, allocation.Offset, SG_FORMAT_R32_UINT);
+///
+/// Free ranges of a page are kept sorted by offset and merged with their neighbours when freed,
+/// allocations take the first range that fits. Requests larger than the dedicated threshold,
+/// or asked to be dedicated, get their own buffer.
+///
+/// A freed range may be given out again at once, it must not be used by frames in flight. A page
+/// left empty is released by BeginFrame once the frames in flight, which may still read it, retire.
+///
+/// Allocations made with a move function may be relocated by Defragment, which empties the least
+/// occupied page into the free ranges of the others so it can be released. SGLib views can't be
+/// pointed at another range, the move function gets the new allocation and recreates them:
+///
+///     allocation = heap.AllocateMovable(size, stride, [&](BufferAllocation const& moved)
+///     {
+///         mesh.Allocation = moved;
+///         mesh.RecreateViews();
+///     });
+///
+///     heap.BeginFrame();
+///     heap.Defragment(pCommandList, 4 << 20);        // Copies up to 4 MB per frame
+///
+/// The copies are recorded into the list, which must run before the lists using the moved data.
+/// Old ranges stay allocated until the frames in flight, which may still read them, retire.
+///-------------------------------------------------------------------------------------------------
+
+struct BufferAllocation
+{
+    ISGBuffer*  pBuffer;        // Page or dedicated buffer, owned by the heap
+    U32         Offset;         // Aligned offset of the range in the buffer
+    U32         Size;
+
+    // Placement of the range, used by Free
+    U32         Page;
+    U32         BlockOffset;
+    U32         BlockSize;
+};
+
+struct BufferHeapStats
+{
+    U32         PageCount;
+    U32         DedicatedCount;
+    U32         AllocationCount;
+
+    // Bytes of pages and dedicated buffers, the dedicated ones are counted rounded up to 64 KB
+    U64         ReservedBytes;
+
+    // Requested bytes of live allocations
+    U64         AllocatedBytes;
+
+    // Alignment padding of placed allocations and 64 KB rounding of dedicated ones
+    U64         WastedBytes;
+
+    // Free bytes of pages and the largest free range
+    U64         FreeBytes;
+    U64         LargestFreeRange;
+
+    // 1 - LargestFreeRange / FreeBytes, 0 means all of the free memory is contiguous
+    float       Fragmentation;
+
+    // Accumulated by Defragment: moved allocations and bytes of the pages released thanks to them
+    U32         MovedAllocations;
+    U64         MovedBytes;
+    U64         ReclaimedBytes;
+};
+
+class BufferHeap
+{
+public:
+    static const U32 DefaultPageSize = 16 << 20;
+    static const U32 DedicatedPage = ~0u;
+
+    // Gets the new placement of a movable allocation
+    typedef std::function<void(BufferAllocation const& allocation)> MoveFunction;
+
+    BufferHeap();
+    ~BufferHeap();
+
+    BufferHeap(BufferHeap const&) = delete;
+    BufferHeap& operator=(BufferHeap const&) = delete;
+
+    // Pages are created with the type and bind flags of the desc, its size is ignored.
+    // Requests above dedicatedThreshold bytes (a quarter of the page by default) are dedicated.
+    // frameBuffers must match the execution context.
+    void        Init(ISGDevice* pDevice, U32 frameBuffers, SG_BUFFER_DESC const& desc, U32 pageSize = DefaultPageSize, U32 dedicatedThreshold = 0);
+
+    // Releases all pages and dedicated buffers, views and references taken by the application keep them alive
+    void        Destroy();
+
+    // The offset is a multiple of alignment, which doesn't have to be a power of two (structure strides).
+    // Throws if a buffer can't be created. Thread-safe.
+    BufferAllocation Allocate(U32 sizeBytes, U32 alignment, bool dedicated = false);
+
+    // Placed in a page even above the dedicated threshold, Defragment may move it. Thread-safe.
+    BufferAllocation AllocateMovable(U32 sizeBytes, U32 alignment, MoveFunction onMove);
+
+    // Returns the range to its page. A page left empty is released by BeginFrame after the frames in flight,
+    // unless it's the only one or it's allocated from again meanwhile. The allocation given by the last move
+    // must be passed for a moved one. Thread-safe.
+    void        Free(BufferAllocation const& allocation);
+
+    // Call after ISGExecutionContext::BeginFrame, frees the ranges left by moves and releases the pages
+    // left empty by retired frames
+    void        BeginFrame();
+
+    // Moves allocations of the least occupied page to other pages, up to maxBytes (at least one
+    // allocation), and records the copies. Move functions are called under the heap's lock and
+    // must not call it back. Returns the moved bytes.
+    U64         Defragment(ISGCommandList* pCommandList, U64 maxBytes);
+
+    BufferHeapStats GetStats() const;
+
+private:
+    struct Movable
+    {
+        BufferAllocation    Allocation;
+        U32                 Alignment;
+        MoveFunction        OnMove;
+    };
+
+    struct Page
+    {
+        ISGBuffer*              pBuffer;
+        std::map<U32, U32>      FreeRanges;     // Offset to size
+        std::map<U32, Movable>  Movables;       // By block offset
+        U32                     AllocationCount;
+        U32                     PendingCount;   // Blocks left by moves
+        bool                    Retiring;       // Empty, released once the frame it was emptied by retires
+        bool                    Reclaimed;      // Emptied by moves
+        U64                     EmptyFrame;
+    };
+
+    struct PendingBlock
+    {
+        BufferAllocation    Allocation;
+        U64                 FrameNumber;
+    };
+
+    ISGBuffer*  CreateBuffer(U32 sizeBytes);
+    bool        AllocateInPage(U32 pageIndex, U32 sizeBytes, U32 alignment, BufferAllocation* pAllocation);
+    // Creates a page if nothing fits, unless it moves an allocation out of sourcePage
+    BufferAllocation AllocatePlaced(U32 sizeBytes, U32 alignment, U32 sourcePage);
+    void        FreeBlock(BufferAllocation const& allocation, bool pending);
+    void        ReleasePage(Page& page);
+
+    mutable std::mutex      m_Mutex;
+    ISGDevice*              m_pDevice;
+    SG_BUFFER_DESC          m_Desc;
+    U32                     m_FrameBuffers;
+    U32                     m_PageSize;
+    U32                     m_DedicatedThreshold;
+    U64                     m_FrameNumber;
+
+    // Released pages leave empty slots, so page indices of live allocations stay valid
+    std::vector<Page>       m_Pages;
+    std::vector<ISGBuffer*> m_Dedicated;
+
+    // Page being emptied by Defragment and the blocks it left
+    U32                         m_DefragmentPage;
+    std::vector<PendingBlock>   m_PendingBlocks;
+
+    // Empty pages waiting for the frames in flight
+    std::vector<U32>            m_RetiringPages;
+
+    U32                     m_AllocationCount;
+    U64                     m_AllocatedBytes;
+    U64                     m_PaddingBytes;
+    U64                     m_DedicatedBytes;
+    U32                     m_MovedAllocations;
+    U64                     m_MovedBytes;
+    U64                     m_ReclaimedBytes;
+};
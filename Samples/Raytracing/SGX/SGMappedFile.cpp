@@ -0,0 +1,153 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGMappedFile.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : m_hMapping(nullptr)
+    , m_pData(nullptr)
+    , m_Size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+    : m_hMapping(other.m_hMapping)
+    , m_pData(other.m_pData)
+    , m_Size(other.m_Size)
+{
+    other.m_hMapping = nullptr;
+    other.m_pData = nullptr;
+    other.m_Size = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+    if (this != &other)
+    {
+        Close();
+
+        m_hMapping = other.m_hMapping;
+        m_pData = other.m_pData;
+        m_Size = other.m_Size;
+
+        other.m_hMapping = nullptr;
+        other.m_pData = nullptr;
+        other.m_Size = 0;
+    }
+
+    return *this;
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(char const* pFileName)
+{
+    Close();
+
+    HANDLE hFile = CreateFileA(pFileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    // The mapping keeps the file open, its handle isn't needed anymore
+    HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(hFile);
+
+    if (hMapping == nullptr)
+        return false;
+
+    void* pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (pView == nullptr)
+    {
+        CloseHandle(hMapping);
+        return false;
+    }
+
+    m_hMapping = hMapping;
+    m_pData = static_cast<U8 const*>(pView);
+    m_Size = static_cast<U64>(fileSize.QuadPart);
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_pData != nullptr)
+        UnmapViewOfFile(m_pData);
+
+    if (m_hMapping != nullptr)
+        CloseHandle(m_hMapping);
+
+    m_hMapping = nullptr;
+    m_pData = nullptr;
+    m_Size = 0;
+}
+
+#else
+
+bool MappedFile::Open(char const* pFileName)
+{
+    Close();
+
+    int fd = open(pFileName, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // The mapping keeps the file open, its descriptor isn't needed anymore
+    void* pView = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (pView == MAP_FAILED)
+        return false;
+
+    m_pData = static_cast<U8 const*>(pView);
+    m_Size = static_cast<U64>(fileStat.st_size);
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_pData != nullptr)
+        munmap(const_cast<U8*>(m_pData), static_cast<size_t>(m_Size));
+
+    m_pData = nullptr;
+    m_Size = 0;
+}
+
+#endif
@@ -0,0 +1,385 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGMipStreamer.h"
+#include <algorithm>
+
+MipStreamer::MipStreamer()
+    : m_pDevice(nullptr)
+    , m_FrameBuffers(1)
+    , m_UploadBudget(0)
+    , m_TailSize(DefaultTailSize)
+    , m_DropFrames(DefaultDropFrames)
+    , m_FrameNumber(0)
+    , m_Stats{}
+{
+}
+
+MipStreamer::~MipStreamer()
+{
+    Destroy();
+}
+
+void MipStreamer::Init(ISGDevice* pDevice, U32 frameBuffers, U64 uploadBudget, U32 tailSize, U32 dropFrames)
+{
+    Destroy();
+
+    m_pDevice = pDevice;
+    m_FrameBuffers = (std::max)(frameBuffers, 1u);
+    m_UploadBudget = uploadBudget;
+    m_TailSize = (std::max)(tailSize, 1u);
+    m_DropFrames = dropFrames;
+}
+
+void MipStreamer::Destroy()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (Texture& texture : m_Textures)
+    {
+        SG_RELEASE(texture.pView);
+        SG_RELEASE(texture.pTexture);
+    }
+
+    for (Retired& retired : m_Retired)
+        retired.pObject->Release();
+
+    m_Textures.clear();
+    m_FreeHandles.clear();
+    m_Retired.clear();
+    m_pDevice = nullptr;
+    m_FrameNumber = 0;
+    m_Stats = {};
+}
+
+StreamedTextureHandle MipStreamer::Register(SG_TEXTURE_DESC const& desc, MipLoader loader)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (m_pDevice == nullptr)
+        throw std::exception("Mip streamer isn't initialized");
+
+    if (desc.Dimension != SG_TEXTURE_DIMENSION_2D || desc.DepthOrArraySize > 1 || desc.MipLevels == 0)
+        throw std::exception("Streamed texture must be a 2D texture with an explicit mip chain");
+
+    StreamedTextureHandle handle;
+    if (!m_FreeHandles.empty())
+    {
+        handle = m_FreeHandles.back();
+        m_FreeHandles.pop_back();
+    }
+    else
+    {
+        handle = static_cast<StreamedTextureHandle>(m_Textures.size());
+        m_Textures.emplace_back();
+    }
+
+    U32 tailMip = 0;
+    while (tailMip + 1 < desc.MipLevels && (std::max)(desc.Width >> tailMip, desc.Height >> tailMip) > m_TailSize)
+        tailMip++;
+
+    Texture& texture = m_Textures[handle];
+    texture = {};
+    texture.Desc = desc;
+    texture.Loader = std::move(loader);
+    texture.ResidentMip = desc.MipLevels;
+    texture.TailMip = tailMip;
+    texture.RequestedMip = ~0u;
+    texture.LastNeededFrame = m_FrameNumber;
+    texture.Registered = true;
+
+    m_Stats.Textures++;
+    for (U32 mip = 0; mip < desc.MipLevels; mip++)
+        m_Stats.FullChainBytes += GetMipBytes(desc, mip);
+
+    return handle;
+}
+
+void MipStreamer::Unregister(StreamedTextureHandle handle)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (handle >= m_Textures.size() || !m_Textures[handle].Registered)
+        return;
+
+    Texture& texture = m_Textures[handle];
+
+    m_Stats.Textures--;
+    for (U32 mip = 0; mip < texture.Desc.MipLevels; mip++)
+    {
+        m_Stats.FullChainBytes -= GetMipBytes(texture.Desc, mip);
+        if (mip >= texture.ResidentMip)
+            m_Stats.ResidentBytes -= GetMipBytes(texture.Desc, mip);
+    }
+
+    SG_RELEASE(texture.pView);
+    SG_RELEASE(texture.pTexture);
+
+    texture = {};
+    m_FreeHandles.push_back(handle);
+}
+
+void MipStreamer::RequestMip(StreamedTextureHandle handle, U32 mip)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    Texture& texture = m_Textures[handle];
+    texture.RequestedMip = (std::min)(texture.RequestedMip, mip);
+}
+
+void MipStreamer::ProcessFeedback(U32 const* pFeedback, U32 count)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    count = (std::min)(count, static_cast<U32>(m_Textures.size()));
+
+    for (U32 i = 0; i < count; i++)
+    {
+        Texture& texture = m_Textures[i];
+
+        if (texture.Registered)
+            texture.RequestedMip = (std::min)(texture.RequestedMip, pFeedback[i]);
+    }
+}
+
+void MipStreamer::Update(ISGCommandList* pCommandList)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_FrameNumber++;
+
+    // The frame buffer of the retired objects has been waited by ISGExecutionContext::BeginFrame
+    auto retiredEnd = std::remove_if(m_Retired.begin(), m_Retired.end(), [&](Retired const& retired)
+    {
+        if (m_FrameNumber - retired.FrameNumber < m_FrameBuffers)
+            return false;
+
+        retired.pObject->Release();
+        return true;
+    });
+    m_Retired.erase(retiredEnd, m_Retired.end());
+
+    m_Stats.PendingMips = 0;
+    m_Stats.StreamedMips = 0;
+    m_Stats.StreamedBytes = 0;
+    m_Stats.DroppedMips = 0;
+
+    // Textures furthest from their requested mip are streamed first
+    std::vector<U32> streamed;
+
+    for (U32 i = 0; i < m_Textures.size(); i++)
+    {
+        Texture& texture = m_Textures[i];
+
+        if (!texture.Registered)
+            continue;
+
+        U32 const wantedMip = (std::min)(texture.RequestedMip, texture.TailMip);
+
+        if (wantedMip <= texture.ResidentMip)
+            texture.LastNeededFrame = m_FrameNumber;
+
+        if (wantedMip < texture.ResidentMip)
+        {
+            streamed.push_back(i);
+        }
+        else if (texture.ResidentMip < texture.TailMip && m_FrameNumber - texture.LastNeededFrame > m_DropFrames)
+        {
+            // One mip per frame, the next one drops unless it's requested again
+            Resize(texture, texture.ResidentMip + 1, pCommandList);
+            m_Stats.DroppedMips++;
+        }
+    }
+
+    std::stable_sort(streamed.begin(), streamed.end(), [&](U32 a, U32 b)
+    {
+        Texture const& ta = m_Textures[a];
+        Texture const& tb = m_Textures[b];
+
+        return ta.ResidentMip - (std::min)(ta.RequestedMip, ta.TailMip) > tb.ResidentMip - (std::min)(tb.RequestedMip, tb.TailMip);
+    });
+
+    U64 budget = m_UploadBudget;
+
+    for (U32 index : streamed)
+    {
+        Texture& texture = m_Textures[index];
+        U32 const wantedMip = (std::min)(texture.RequestedMip, texture.TailMip);
+
+        U32 residentMip = texture.ResidentMip;
+        U64 uploadBytes = 0;
+
+        // The mip tail is loaded at once regardless of the budget
+        if (residentMip > texture.TailMip)
+        {
+            for (; residentMip > texture.TailMip; residentMip--)
+                uploadBytes += GetMipBytes(texture.Desc, residentMip - 1);
+        }
+
+        while (residentMip > wantedMip)
+        {
+            U64 const mipBytes = GetMipBytes(texture.Desc, residentMip - 1);
+
+            // A mip larger than the whole budget is streamed alone
+            bool const fits = uploadBytes + mipBytes <= budget || (budget == m_UploadBudget && uploadBytes == 0);
+            if (!fits)
+                break;
+
+            uploadBytes += mipBytes;
+            residentMip--;
+        }
+
+        m_Stats.PendingMips += residentMip - wantedMip;
+
+        if (residentMip == texture.ResidentMip)
+            continue;
+
+        m_Stats.StreamedMips += texture.ResidentMip - residentMip;
+        m_Stats.StreamedBytes += uploadBytes;
+        budget -= (std::min)(budget, uploadBytes);
+
+        Resize(texture, residentMip, pCommandList);
+    }
+
+    for (Texture& texture : m_Textures)
+        texture.RequestedMip = ~0u;
+}
+
+void MipStreamer::Resize(Texture& texture, U32 residentMip, ISGCommandList* pCommandList)
+{
+    SG_TEXTURE_DESC const& fullDesc = texture.Desc;
+    U32 const oldMip = texture.ResidentMip;
+
+    SG_TEXTURE_DESC desc = fullDesc;
+    desc.Width = (std::max)(fullDesc.Width >> residentMip, 1u);
+    desc.Height = (std::max)(fullDesc.Height >> residentMip, 1u);
+    desc.MipLevels = fullDesc.MipLevels - residentMip;
+
+    ISGTexture* pTexture = SG_NULL;
+    if (m_pDevice->CreateTexture(&desc, &pTexture) != SG_OK)
+        throw std::exception("Failed to create streamed texture");
+
+    SG_SHADER_RESOURCE_VIEW_DESC const srvDesc = FastViewDesc::AsTexture(desc.Format, 0, desc.MipLevels, 0, 0);
+
+    ISGShaderResourceView* pView = SG_NULL;
+    if (m_pDevice->CreateShaderResourceView(pTexture, &srvDesc, &pView) != SG_OK)
+    {
+        pTexture->Release();
+        throw std::exception("Failed to create streamed texture view");
+    }
+
+    auto copyMip = [&](ISGTexture* pSrcTexture, U32 srcMip, U32 destMip)
+    {
+        ISGSubresource* pDestSubresource = SG_NULL;
+        ISGSubresource* pSrcSubresource = SG_NULL;
+
+        if (pTexture->GetSubresource(destMip, 0, 0, &pDestSubresource) != SG_OK ||
+            pSrcTexture->GetSubresource(srcMip, 0, 0, &pSrcSubresource) != SG_OK)
+            throw std::exception("Failed to get streamed texture subresource");
+
+        pCommandList->CopySubresource(pDestSubresource, pSrcSubresource);
+
+        pDestSubresource->Release();
+        pSrcSubresource->Release();
+    };
+
+    // Mips resident in both textures are copied on the GPU
+    for (U32 mip = (std::max)(residentMip, oldMip); mip < fullDesc.MipLevels; mip++)
+        copyMip(texture.pTexture, mip - oldMip, mip - residentMip);
+
+    // Finer mips are loaded into a staging texture with the same footprints
+    if (residentMip < oldMip)
+    {
+        SG_TEXTURE_DESC stagingDesc = desc;
+        stagingDesc.Type = SG_TEXTURE_TYPE_UPLOAD;
+        stagingDesc.BindFlags = SG_TEXTURE_BIND_FLAG_NONE;
+        stagingDesc.MipLevels = oldMip - residentMip;
+
+        ISGTexture* pStaging = SG_NULL;
+        if (m_pDevice->CreateTexture(&stagingDesc, &pStaging) != SG_OK)
+            throw std::exception("Failed to create streamed texture staging");
+
+        for (U32 mip = 0; mip < stagingDesc.MipLevels; mip++)
+        {
+            ISGSubresource* pSubresource = SG_NULL;
+            if (pStaging->GetSubresource(mip, 0, 0, &pSubresource) != SG_OK)
+                throw std::exception("Failed to get streamed texture staging subresource");
+
+            SG_MAPPED_SUBRESOURCE mappedSubresource;
+            if (pSubresource->Map(&mappedSubresource) == SG_OK)
+            {
+                texture.Loader(residentMip + mip, mappedSubresource);
+                pSubresource->Unmap();
+            }
+            pSubresource->Release();
+
+            copyMip(pStaging, mip, mip);
+        }
+
+        Retire(pStaging);
+    }
+
+    for (U32 mip = (std::min)(residentMip, oldMip); mip < (std::max)(residentMip, oldMip); mip++)
+    {
+        if (residentMip < oldMip)
+            m_Stats.ResidentBytes += GetMipBytes(fullDesc, mip);
+        else
+            m_Stats.ResidentBytes -= GetMipBytes(fullDesc, mip);
+    }
+
+    if (texture.pTexture != SG_NULL)
+    {
+        Retire(texture.pView);
+        Retire(texture.pTexture);
+    }
+
+    texture.pTexture = pTexture;
+    texture.pView = pView;
+    texture.ResidentMip = residentMip;
+}
+
+void MipStreamer::Retire(ISGObject* pObject)
+{
+    m_Retired.push_back({ pObject, m_FrameNumber });
+}
+
+ISGTexture* MipStreamer::GetTexture(StreamedTextureHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Textures[handle].pTexture;
+}
+
+ISGShaderResourceView* MipStreamer::GetView(StreamedTextureHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Textures[handle].pView;
+}
+
+U32 MipStreamer::GetResidentMip(StreamedTextureHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Textures[handle].ResidentMip;
+}
+
+MipStreamerStats MipStreamer::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
+
+U64 MipStreamer::GetMipBytes(SG_TEXTURE_DESC const& desc, U32 mip)
+{
+    U64 const width = (std::max)(desc.Width >> mip, 1u);
+    U64 const height = (std::max)(desc.Height >> mip, 1u);
+
+    // An estimate, the driver may pad rows and align the allocation
+    return width * height * SgGetFormatSizeBits(desc.Format) / 8;
+}
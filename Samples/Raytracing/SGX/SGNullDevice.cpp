@@ -0,0 +1,1618 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGNullDevice.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+namespace
+{
+    const SgU16 c_MaxTimeIndex = 65520;
+    const SgU32 c_RowPitchAlignment = 256;
+    const SgU32 c_SubresourceAlignment = 512;
+    const SgU32 c_DefaultBackBufferWidth = 1280;
+    const SgU32 c_DefaultBackBufferHeight = 720;
+    const SgU64 c_NullLocalMemory = 8ull << 30;
+    const SgU64 c_NullNonLocalMemory = 16ull << 30;
+
+    template <typename T>
+    constexpr T AlignUp(T value, T align)
+    {
+        return (value + (align - 1)) / align * align;
+    }
+
+    template <typename T>
+    SgU64 ToArg(T value) { return static_cast<SgU64>(value); }
+
+    template <typename T>
+    SgU64 ToArg(T* pValue) { return reinterpret_cast<SgU64>(pValue); }
+
+    SgU64 ToArg(float value)
+    {
+        SgU32 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    bool IsBlockCompressed(SG_FORMAT format)
+    {
+        return (format >= SG_FORMAT_BC1_TYPELESS && format <= SG_FORMAT_BC5_SNORM)
+            || (format >= SG_FORMAT_BC6H_TYPELESS && format <= SG_FORMAT_BC7_UNORM_SRGB);
+    }
+
+    // Mirrors SgGetFormatSizeBits, the null back-end doesn't link SGLib binaries.
+    SgU32 GetFormatSizeBits(SG_FORMAT format)
+    {
+        if (format >= SG_FORMAT_R32G32B32A32_TYPELESS && format <= SG_FORMAT_R32G32B32A32_SINT)   return 128;
+        if (format >= SG_FORMAT_R32G32B32_TYPELESS && format <= SG_FORMAT_R32G32B32_SINT)         return 96;
+        if (format >= SG_FORMAT_R16G16B16A16_TYPELESS && format <= SG_FORMAT_X32_TYPELESS_G8X24_UINT) return 64;
+        if (format >= SG_FORMAT_R10G10B10A2_TYPELESS && format <= SG_FORMAT_X24_TYPELESS_G8_UINT) return 32;
+        if (format >= SG_FORMAT_R8G8_TYPELESS && format <= SG_FORMAT_R16_SINT)                    return 16;
+        if (format >= SG_FORMAT_R8_TYPELESS && format <= SG_FORMAT_A8_UNORM)                      return 8;
+        if (format == SG_FORMAT_R1_UNORM)                                                         return 1;
+        if (format >= SG_FORMAT_R9G9B9E5_SHAREDEXP && format <= SG_FORMAT_G8R8_G8B8_UNORM)        return 32;
+        if (format >= SG_FORMAT_BC1_TYPELESS && format <= SG_FORMAT_BC1_UNORM_SRGB)               return 4;
+        if (format >= SG_FORMAT_BC2_TYPELESS && format <= SG_FORMAT_BC3_UNORM_SRGB)               return 8;
+        if (format >= SG_FORMAT_BC4_TYPELESS && format <= SG_FORMAT_BC4_SNORM)                    return 4;
+        if (format >= SG_FORMAT_BC5_TYPELESS && format <= SG_FORMAT_BC5_SNORM)                    return 8;
+        if (format >= SG_FORMAT_B5G6R5_UNORM && format <= SG_FORMAT_B5G5R5A1_UNORM)               return 16;
+        if (format >= SG_FORMAT_B8G8R8A8_UNORM && format <= SG_FORMAT_B8G8R8X8_UNORM_SRGB)        return 32;
+        if (format >= SG_FORMAT_BC6H_TYPELESS && format <= SG_FORMAT_BC7_UNORM_SRGB)              return 8;
+
+        return 0;
+    }
+
+    SgU32 GetQueryDataSize(SG_QUERY_TYPE type)
+    {
+        // Matches D3D12 layouts: UINT64 for occlusion and timestamps, 11 x UINT64 for pipeline statistics
+        return type == SG_QUERY_TYPE_PIPELINE_STATISTICS ? 11 * sizeof(SgU64) : sizeof(SgU64);
+    }
+}
+
+///-------------------------------------------------------------------------------------------------
+/// NullCommandStream
+///-------------------------------------------------------------------------------------------------
+NullCommandStream::NullCommandStream()
+    : m_CommandCount(0)
+{
+}
+
+void NullCommandStream::Reset()
+{
+    // Keeps capacity, streams are reused by pooled command lists every frame
+    m_Words.clear();
+    m_CommandCount = 0;
+}
+
+NullCommand* NullCommandStream::Allocate(NullCommandType type, SgU32 argCount, SgU32 dataSize)
+{
+    size_t const offset = m_Words.size();
+    size_t const words = 1 + argCount + AlignUp<SgU32>(dataSize, sizeof(SgU64)) / sizeof(SgU64);
+
+    m_Words.resize(offset + words);
+    m_CommandCount++;
+
+    NullCommand* pCommand = reinterpret_cast<NullCommand*>(m_Words.data() + offset);
+    pCommand->Type = type;
+    pCommand->ArgCount = static_cast<SgU16>(argCount);
+    pCommand->DataSize = dataSize;
+    return pCommand;
+}
+
+NullCommand const* NullCommandStream::First() const
+{
+    return m_Words.empty() ? nullptr : reinterpret_cast<NullCommand const*>(m_Words.data());
+}
+
+NullCommand const* NullCommandStream::Next(NullCommand const* pCommand) const
+{
+    SgU64 const* pNext = pCommand->GetArgs() + pCommand->ArgCount + AlignUp<SgU32>(pCommand->DataSize, sizeof(SgU64)) / sizeof(SgU64);
+    return pNext < m_Words.data() + m_Words.size() ? reinterpret_cast<NullCommand const*>(pNext) : nullptr;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Base objects
+///-------------------------------------------------------------------------------------------------
+template <typename TInterface>
+class NullObject : public TInterface
+{
+public:
+    NullObject() : m_RefCount(1) {}
+
+    SgU32 SG_CALL AddRef() override
+    {
+        return ++m_RefCount;
+    }
+
+    SgU32 SG_CALL Release() override
+    {
+        SgU32 const refCount = --m_RefCount;
+        if (refCount == 0)
+            delete this;
+
+        return refCount;
+    }
+
+protected:
+    virtual ~NullObject() {}
+
+private:
+    std::atomic<SgU32> m_RefCount;
+};
+
+// Objects without any state besides their description
+template <typename TInterface, typename TDesc>
+class NullDescObject : public NullObject<TInterface>
+{
+public:
+    NullDescObject(TDesc const& desc) : m_Desc(desc) {}
+
+    TDesc const& GetNullDesc() const { return m_Desc; }
+
+private:
+    TDesc m_Desc;
+};
+
+class NullDevice;
+
+///-------------------------------------------------------------------------------------------------
+/// Resources
+///-------------------------------------------------------------------------------------------------
+template <typename TInterface>
+class NullResource : public NullObject<TInterface>
+{
+public:
+    NullResource(NullDevice* pDevice, SgU64 sizeBytes, bool hostVisible);
+    ~NullResource() override;
+
+    void SG_CALL SetName(char const* pName) override
+    {
+        m_Name = pName != nullptr ? pName : "";
+    }
+
+    void SG_CALL GetName(SgU32* pStrLen, char* pName) override
+    {
+        if (pName != nullptr)
+            memcpy(pName, m_Name.c_str(), std::min<size_t>(*pStrLen, m_Name.size() + 1));
+
+        *pStrLen = static_cast<SgU32>(m_Name.size() + 1);
+    }
+
+    SgU8* GetHostMemory() { return m_HostMemory.empty() ? nullptr : m_HostMemory.data(); }
+
+protected:
+    NullDevice*         m_pDevice;
+    SgU64               m_SizeBytes;
+    std::vector<SgU8>   m_HostMemory;
+    std::string         m_Name;
+};
+
+class NullBuffer : public NullResource<ISGBuffer>
+{
+public:
+    NullBuffer(NullDevice* pDevice, SG_BUFFER_DESC const& desc)
+        : NullResource(pDevice, desc.Size, desc.Type != SG_BUFFER_TYPE_COMMON)
+        , m_Desc(desc)
+    {
+    }
+
+    SG_RESOURCE_TYPE SG_CALL GetType() override { return SG_RESOURCE_TYPE_BUFFER; }
+
+    SG_RESULT SG_CALL GetDesc(SG_BUFFER_DESC* pOutDesc) override
+    {
+        *pOutDesc = m_Desc;
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL Map(void** ppData) override
+    {
+        if (m_HostMemory.empty())
+            return SG_ERROR_INCOMPATIBLE_ACCESS_TYPE;
+
+        *ppData = m_HostMemory.data();
+        return SG_OK;
+    }
+
+    void SG_CALL Unmap() override {}
+
+private:
+    SG_BUFFER_DESC m_Desc;
+};
+
+struct NullSubresourceFootprint
+{
+    SgU64 Offset;
+    SgU64 RowPitch;
+    SgU64 DepthPitch;
+};
+
+class NullTexture : public NullResource<ISGTexture>
+{
+public:
+    NullTexture(NullDevice* pDevice, SG_TEXTURE_DESC const& desc, std::vector<NullSubresourceFootprint>&& footprints, SgU64 sizeBytes)
+        : NullResource(pDevice, sizeBytes, desc.Type == SG_TEXTURE_TYPE_UPLOAD || desc.Type == SG_TEXTURE_TYPE_READBACK)
+        , m_Desc(desc)
+        , m_Footprints(std::move(footprints))
+    {
+    }
+
+    SG_RESOURCE_TYPE SG_CALL GetType() override { return SG_RESOURCE_TYPE_TEXTURE; }
+
+    SG_RESULT SG_CALL GetDesc(SG_TEXTURE_DESC* pOutDesc) override
+    {
+        *pOutDesc = m_Desc;
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL GetSubresourceInfo(SG_SUBRESOURCE_INFO* pOutInfo) override
+    {
+        pOutInfo->MipLevels = m_Desc.MipLevels;
+        pOutInfo->ArraySize = m_Desc.Dimension == SG_TEXTURE_DIMENSION_3D ? 1 : m_Desc.DepthOrArraySize;
+        pOutInfo->PlaneSlices = 1;
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL GetSubresource(SgU32 mipSlice, SgU32 arraySlice, SgU32 planeSlice, ISGSubresource** ppSubresource) override;
+
+    SgU8* MapSubresource(SgU32 index, SG_MAPPED_SUBRESOURCE* pMapped)
+    {
+        if (m_HostMemory.empty())
+            return nullptr;
+
+        NullSubresourceFootprint const& footprint = m_Footprints[index];
+        pMapped->pData = m_HostMemory.data() + footprint.Offset;
+        pMapped->RowPitch = footprint.RowPitch;
+        pMapped->DepthPitch = footprint.DepthPitch;
+        return static_cast<SgU8*>(pMapped->pData);
+    }
+
+private:
+    SG_TEXTURE_DESC m_Desc;
+    std::vector<NullSubresourceFootprint> m_Footprints;
+};
+
+class NullSubresource : public NullObject<ISGSubresource>
+{
+public:
+    NullSubresource(NullTexture* pTexture, SgU32 index)
+        : m_pTexture(pTexture)
+        , m_Index(index)
+    {
+        m_pTexture->AddRef();
+    }
+
+    ~NullSubresource() override
+    {
+        m_pTexture->Release();
+    }
+
+    SG_RESULT SG_CALL Map(SG_MAPPED_SUBRESOURCE* pMappedSubresource) override
+    {
+        return m_pTexture->MapSubresource(m_Index, pMappedSubresource) != nullptr ? SG_OK : SG_ERROR_INCOMPATIBLE_ACCESS_TYPE;
+    }
+
+    void SG_CALL Unmap() override {}
+
+private:
+    NullTexture*    m_pTexture;
+    SgU32           m_Index;
+};
+
+SG_RESULT NullTexture::GetSubresource(SgU32 mipSlice, SgU32 arraySlice, SgU32 planeSlice, ISGSubresource** ppSubresource)
+{
+    SG_SUBRESOURCE_INFO info;
+    GetSubresourceInfo(&info);
+
+    if (mipSlice >= info.MipLevels || arraySlice >= info.ArraySize || planeSlice >= info.PlaneSlices)
+        return SG_ERROR_OUT_OF_RESOURCE_BOUNDS;
+
+    *ppSubresource = new NullSubresource(this, mipSlice + arraySlice * info.MipLevels);
+    return SG_OK;
+}
+
+template <typename TInterface, typename TDesc>
+class NullView : public NullObject<TInterface>
+{
+public:
+    NullView(ISGResource* pResource, TDesc const& desc)
+        : m_pResource(pResource)
+        , m_Desc(desc)
+    {
+        m_pResource->AddRef();
+    }
+
+    ~NullView() override
+    {
+        m_pResource->Release();
+    }
+
+private:
+    ISGResource*    m_pResource;
+    TDesc           m_Desc;
+};
+
+typedef NullView<ISGShaderResourceView, SG_SHADER_RESOURCE_VIEW_DESC>   NullShaderResourceView;
+typedef NullView<ISGUnorderedAccessView, SG_UNORDERED_ACCESS_VIEW_DESC> NullUnorderedAccessView;
+typedef NullView<ISGRenderTargetView, SG_RENDER_TARGET_VIEW_DESC>       NullRenderTargetView;
+typedef NullView<ISGDepthStencilView, SG_DEPTH_STENCIL_VIEW_DESC>       NullDepthStencilView;
+
+template <typename TInterface>
+class NullAccelerationStructure : public NullObject<TInterface>
+{
+public:
+    template <typename TInstanceDesc, typename TSource>
+    SG_RESULT FillImpl(SgU32 numDescs, TInstanceDesc const* pDescs, SgBool performUpdate, TSource* pSource)
+    {
+        if (numDescs > 0 && pDescs == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        if (performUpdate && pSource == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        m_NumDescs = numDescs;
+        return SG_OK;
+    }
+
+protected:
+    SgU32 m_NumDescs = 0;
+};
+
+class NullBottomLevelAS : public NullAccelerationStructure<ISGBottomLevelAS>
+{
+public:
+    SG_RESULT SG_CALL Fill(SgU32 NumDescs, const SG_AS_GEOMETRY_DESC* pGeometryDescs, SgBool performUpdate, ISGBottomLevelAS* pSourceBLAS) override
+    {
+        return FillImpl(NumDescs, pGeometryDescs, performUpdate, pSourceBLAS);
+    }
+};
+
+class NullTopLevelAS : public NullAccelerationStructure<ISGTopLevelAS>
+{
+public:
+    SG_RESULT SG_CALL Fill(SgU32 NumDescs, const SG_AS_INSTANCE_DESC* pInstanceDescs, SgBool performUpdate, ISGTopLevelAS* pSourceTLAS) override
+    {
+        return FillImpl(NumDescs, pInstanceDescs, performUpdate, pSourceTLAS);
+    }
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Pipeline states and queries
+///-------------------------------------------------------------------------------------------------
+class NullInputLayout : public NullObject<ISGInputLayout>
+{
+};
+
+class NullPipelineState : public NullObject<ISGPipelineState>
+{
+public:
+    NullPipelineState(SG_PIPELINE_STATE_TYPE type) : m_Type(type) {}
+
+    SG_PIPELINE_STATE_TYPE SG_CALL GetType() override { return m_Type; }
+
+    void SG_CALL SetDebugName(char const* pDebugName) override
+    {
+        m_Name = pDebugName != nullptr ? pDebugName : "";
+    }
+
+private:
+    SG_PIPELINE_STATE_TYPE  m_Type;
+    std::string             m_Name;
+};
+
+typedef NullDescObject<ISGBlendState, SG_BLEND_STATE_DESC>                  NullBlendState;
+typedef NullDescObject<ISGDepthStencilState, SG_DEPTH_STENCIL_STATE_DESC>   NullDepthStencilState;
+typedef NullDescObject<ISGRasterizerState, SG_RASTERIZER_STATE_DESC>        NullRasterizerState;
+typedef NullDescObject<ISGSampler, SG_SAMPLER_DESC>                         NullSampler;
+
+class NullQuery : public NullObject<ISGPredicate>
+{
+public:
+    NullQuery(SG_QUERY_TYPE type)
+        : m_Type(type)
+        , m_Data(GetQueryDataSize(type), 0)
+        , m_Executed(false)
+    {
+    }
+
+    SG_QUERY_TYPE GetQueryType() const { return m_Type; }
+
+    void OnEnd()
+    {
+        if (m_Type == SG_QUERY_TYPE_TIMESTAMP)
+        {
+            SgU64 const timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            memcpy(m_Data.data(), &timestamp, sizeof(timestamp));
+        }
+
+        m_Executed = true;
+    }
+
+    SG_RESULT GetData(void** ppData, SgU32 dataSize)
+    {
+        if (!m_Executed)
+            return SG_ERROR_QUERY_HAS_NOT_BEEN_EXECUTED;
+
+        if (dataSize < m_Data.size())
+            return SG_ERROR_INVALID_ARG;
+
+        *ppData = m_Data.data();
+        return SG_OK;
+    }
+
+private:
+    SG_QUERY_TYPE       m_Type;
+    std::vector<SgU8>   m_Data;
+    std::atomic<bool>   m_Executed;
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Command list
+///-------------------------------------------------------------------------------------------------
+class NullCommandList : public ISGCommandList
+{
+public:
+    NullCommandList()
+        : m_RefCount(0)
+        , m_QueueType(SG_QUEUE_TYPE_GRAPHICS)
+        , m_QueueIndex(0)
+        , m_TimeIndex(0)
+        , m_Finished(false)
+    {
+    }
+
+    virtual ~NullCommandList() {}
+
+    // Command lists are owned by the pool of the frame buffer, reaching zero doesn't destroy them
+    SgU32 SG_CALL AddRef() override { return ++m_RefCount; }
+    SgU32 SG_CALL Release() override { return --m_RefCount; }
+
+    void Begin(SG_QUEUE_TYPE queueType, SgU8 queueIndex, SgU16 timeIndex)
+    {
+        m_Stream.Reset();
+        m_RefCount = 1;
+        m_QueueType = queueType;
+        m_QueueIndex = queueIndex;
+        m_TimeIndex = timeIndex;
+        m_Finished = false;
+    }
+
+    SgU32 GetRefCount() const { return m_RefCount; }
+    bool IsFinished() const { return m_Finished; }
+    void SetFinished() { m_Finished = true; }
+
+    SgU8 GetQueueIndex() const { return m_QueueIndex; }
+    SgU16 GetTimeIndex() const { return m_TimeIndex; }
+    NullCommandStream const& GetStream() const { return m_Stream; }
+
+    SG_QUEUE_TYPE SG_CALL GetType() override { return m_QueueType; }
+
+    // Markers
+    void SG_CALL BeginEvent(SG_COLOR_3I color, char const* pEventName) override
+    {
+        SgU32 const nameSize = pEventName != nullptr ? static_cast<SgU32>(strlen(pEventName) + 1) : 0;
+        NullCommand* pCommand = m_Stream.Allocate(NullCommandType::BeginEvent, 1, nameSize);
+        const_cast<SgU64*>(pCommand->GetArgs())[0] = (SgU64(color.R) << 16) | (SgU64(color.G) << 8) | SgU64(color.B);
+        memcpy(const_cast<void*>(pCommand->GetData()), pEventName, nameSize);
+    }
+
+    void SG_CALL EndEvent() override { Record(NullCommandType::EndEvent); }
+
+    // Queries
+    void SG_CALL BeginQuery(ISGQuery* pQuery) override { Record(NullCommandType::BeginQuery, pQuery); }
+
+    void SG_CALL EndQuery(ISGQuery* pQuery) override
+    {
+        static_cast<NullQuery*>(pQuery)->OnEnd();
+        Record(NullCommandType::EndQuery, pQuery);
+    }
+
+    void SG_CALL TimeStamp(ISGQuery* pQuery) override
+    {
+        static_cast<NullQuery*>(pQuery)->OnEnd();
+        Record(NullCommandType::TimeStamp, pQuery);
+    }
+
+    void SG_CALL SetPredication(ISGPredicate* pPredicate, SG_PREDICATION_OP predication) override
+    {
+        Record(NullCommandType::SetPredication, pPredicate, predication);
+    }
+
+    // Render Target and Depth Stencil
+    void SG_CALL SetRenderTarget(SgU32 rtIndex, ISGRenderTargetView* pView) override
+    {
+        Record(NullCommandType::SetRenderTarget, rtIndex, pView);
+    }
+
+    void SG_CALL SetDepthStencil(ISGDepthStencilView* pView) override
+    {
+        Record(NullCommandType::SetDepthStencil, pView);
+    }
+
+    void SG_CALL ClearRenderTargetDefault(ISGRenderTargetView* pRTV) override
+    {
+        Record(NullCommandType::ClearRenderTargetDefault, pRTV);
+    }
+
+    void SG_CALL ClearRenderTarget(ISGRenderTargetView* pRTV, SG_COLOR_4F const* pColor) override
+    {
+        RecordData(NullCommandType::ClearRenderTarget, pColor, sizeof(SG_COLOR_4F), pRTV);
+    }
+
+    void SG_CALL ClearDepthStencilDefault(ISGDepthStencilView* pDSV, SG_CLEAR_FLAGS flags) override
+    {
+        Record(NullCommandType::ClearDepthStencilDefault, pDSV, flags);
+    }
+
+    void SG_CALL ClearDepthStencil(ISGDepthStencilView* pDSV, SG_CLEAR_FLAGS flags, float depthValue, SgU8 stencilValue) override
+    {
+        Record(NullCommandType::ClearDepthStencil, pDSV, flags, depthValue, stencilValue);
+    }
+
+    void SG_CALL ClearUnorderedAccessViewUint(ISGUnorderedAccessView* pUAV, const SgU32 values[4]) override
+    {
+        RecordData(NullCommandType::ClearUnorderedAccessViewUint, values, 4 * sizeof(SgU32), pUAV);
+    }
+
+    void SG_CALL ClearUnorderedAccessViewFloat(ISGUnorderedAccessView* pUAV, const float values[4]) override
+    {
+        RecordData(NullCommandType::ClearUnorderedAccessViewFloat, values, 4 * sizeof(float), pUAV);
+    }
+
+    void SG_CALL SetStencilRef(SgU8 stencilRef) override
+    {
+        Record(NullCommandType::SetStencilRef, stencilRef);
+    }
+
+    void SG_CALL SetViewports(SgU32 numViewports, SG_VIEWPORT const* pViewports) override
+    {
+        RecordData(NullCommandType::SetViewports, pViewports, numViewports * sizeof(SG_VIEWPORT), numViewports);
+    }
+
+    void SG_CALL SetScissorRects(SgU32 numRects, SG_RECT const* pRects) override
+    {
+        RecordData(NullCommandType::SetScissorRects, pRects, numRects * sizeof(SG_RECT), numRects);
+    }
+
+    // Pipeline State
+    void SG_CALL SetPipelineState(ISGPipelineState* pPipelineState) override
+    {
+        Record(NullCommandType::SetPipelineState, pPipelineState);
+    }
+
+    void SG_CALL SetInputLayout(ISGInputLayout* pInputLayout) override
+    {
+        Record(NullCommandType::SetInputLayout, pInputLayout);
+    }
+
+    void SG_CALL SetShadingRate(SG_SHADING_RATE baseShadingRate, SG_SHADING_RATE_COMBINER const* pCombiners) override
+    {
+        RecordData(NullCommandType::SetShadingRate, pCombiners, pCombiners != nullptr ? 2 * sizeof(SG_SHADING_RATE_COMBINER) : 0, baseShadingRate);
+    }
+
+    void SG_CALL SetShadingRateImage(ISGTexture* pImage) override
+    {
+        Record(NullCommandType::SetShadingRateImage, pImage);
+    }
+
+    void SG_CALL SetBlendState(ISGBlendState* pBlendState, SgU32 sampleMask) override
+    {
+        Record(NullCommandType::SetBlendState, pBlendState, sampleMask);
+    }
+
+    void SG_CALL SetBlendFactor(SG_COLOR_4F blendFactor) override
+    {
+        RecordData(NullCommandType::SetBlendFactor, &blendFactor, sizeof(blendFactor));
+    }
+
+    void SG_CALL SetDepthStencilState(ISGDepthStencilState* pDepthStencilState) override
+    {
+        Record(NullCommandType::SetDepthStencilState, pDepthStencilState);
+    }
+
+    void SG_CALL SetRasterizerState(ISGRasterizerState* pRasterizerState) override
+    {
+        Record(NullCommandType::SetRasterizerState, pRasterizerState);
+    }
+
+    // Binding
+    void SG_CALL SetConstantBuffer(SgU32 paramIdx, SgU32 bindPoint, ISGResource* pBuffer) override
+    {
+        Record(NullCommandType::SetConstantBuffer, paramIdx, bindPoint, pBuffer);
+    }
+
+    void SG_CALL SetConstantBuffers(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGResource** ppBuffers) override
+    {
+        RecordData(NullCommandType::SetConstantBuffers, ppBuffers, count * sizeof(void*), paramIdx, offset, count);
+    }
+
+    void SG_CALL SetShaderResource(SgU32 paramIdx, SgU32 bindPoint, ISGShaderResourceView* pView) override
+    {
+        Record(NullCommandType::SetShaderResource, paramIdx, bindPoint, pView);
+    }
+
+    void SG_CALL SetShaderResources(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGShaderResourceView** ppViews) override
+    {
+        RecordData(NullCommandType::SetShaderResources, ppViews, count * sizeof(void*), paramIdx, offset, count);
+    }
+
+    void SG_CALL SetUnorderedAccessView(SgU32 paramIdx, SgU32 bindPoint, ISGUnorderedAccessView* pView) override
+    {
+        Record(NullCommandType::SetUnorderedAccessView, paramIdx, bindPoint, pView);
+    }
+
+    void SG_CALL SetUnorderedAccessViews(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGUnorderedAccessView** ppViews) override
+    {
+        RecordData(NullCommandType::SetUnorderedAccessViews, ppViews, count * sizeof(void*), paramIdx, offset, count);
+    }
+
+    void SG_CALL SetAccelerationStructure(SgU32 paramIdx, SgU32 bindPoint, ISGTopLevelAS* pTLAS) override
+    {
+        Record(NullCommandType::SetAccelerationStructure, paramIdx, bindPoint, pTLAS);
+    }
+
+    void SG_CALL SetAccelerationStructures(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGTopLevelAS** pTLASes) override
+    {
+        RecordData(NullCommandType::SetAccelerationStructures, pTLASes, count * sizeof(void*), paramIdx, offset, count);
+    }
+
+    void SG_CALL SetSampler(SgU32 paramIdx, SgU32 bindPoint, ISGSampler* pState) override
+    {
+        Record(NullCommandType::SetSampler, paramIdx, bindPoint, pState);
+    }
+
+    void SG_CALL SetSamplers(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGSampler** ppStates) override
+    {
+        RecordData(NullCommandType::SetSamplers, ppStates, count * sizeof(void*), paramIdx, offset, count);
+    }
+
+    // Geometry
+    void SG_CALL SetVertexBuffer(SgU32 slot, ISGBuffer* pVertexBuffer, SgU32 offset, SgU32 stride) override
+    {
+        Record(NullCommandType::SetVertexBuffer, slot, pVertexBuffer, offset, stride);
+    }
+
+    void SG_CALL SetVertexBuffers(SgU32 startSlot, SgU32 numBuffers, ISGBuffer** ppVertexBuffers, SgU32* pOffsets, SgU32* pStrides) override
+    {
+        // Data layout: buffers[numBuffers], offsets[numBuffers], strides[numBuffers]
+        SgU32 const dataSize = numBuffers * (sizeof(void*) + 2 * sizeof(SgU32));
+        NullCommand* pCommand = m_Stream.Allocate(NullCommandType::SetVertexBuffers, 2, dataSize);
+
+        SgU64* pArgs = const_cast<SgU64*>(pCommand->GetArgs());
+        pArgs[0] = startSlot;
+        pArgs[1] = numBuffers;
+
+        SgU8* pData = static_cast<SgU8*>(const_cast<void*>(pCommand->GetData()));
+        memcpy(pData, ppVertexBuffers, numBuffers * sizeof(void*));
+        memcpy(pData + numBuffers * sizeof(void*), pOffsets, numBuffers * sizeof(SgU32));
+        memcpy(pData + numBuffers * (sizeof(void*) + sizeof(SgU32)), pStrides, numBuffers * sizeof(SgU32));
+    }
+
+    void SG_CALL SetIndexBuffer(ISGBuffer* pIndexBuffer, SgU32 offset, SG_FORMAT format) override
+    {
+        Record(NullCommandType::SetIndexBuffer, pIndexBuffer, offset, format);
+    }
+
+    void SG_CALL SetPrimitiveTopology(SG_PRIMITIVE_TOPOLOGY primitiveTopology) override
+    {
+        Record(NullCommandType::SetPrimitiveTopology, primitiveTopology);
+    }
+
+    // Graphics context
+    void SG_CALL DrawInstanced(SgU32 vertexCount, SgU32 instanceCount, SgU32 startVertexLocation, SgU32 startInstanceLocation) override
+    {
+        Record(NullCommandType::DrawInstanced, vertexCount, instanceCount, startVertexLocation, startInstanceLocation);
+    }
+
+    void SG_CALL DrawIndexedInstanced(SgU32 indexCountPerInstance, SgU32 instanceCount, SgU32 startIndexLocation, int baseVertexLocation, SgU32 startInstanceLocation) override
+    {
+        Record(NullCommandType::DrawIndexedInstanced, indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+    }
+
+    void SG_CALL DispatchMesh(SgU32 threadGroupCountX, SgU32 threadGroupCountY, SgU32 threadGroupCountZ) override
+    {
+        Record(NullCommandType::DispatchMesh, threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+    }
+
+    // Compute context
+    void SG_CALL Dispatch(SgU32 threadGroupCountX, SgU32 threadGroupCountY, SgU32 threadGroupCountZ) override
+    {
+        Record(NullCommandType::Dispatch, threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+    }
+
+    // Indirect calls
+    void SG_CALL DrawInstancedIndirect(SgU32 maxCommandCount, ISGBuffer* pArgBuffer, SgU32 argBufferOffset) override
+    {
+        Record(NullCommandType::DrawInstancedIndirect, maxCommandCount, pArgBuffer, argBufferOffset);
+    }
+
+    void SG_CALL DrawIndexedInstancedIndirect(SgU32 maxCommandCount, ISGBuffer* pArgBuffer, SgU32 argBufferOffset) override
+    {
+        Record(NullCommandType::DrawIndexedInstancedIndirect, maxCommandCount, pArgBuffer, argBufferOffset);
+    }
+
+    void SG_CALL DispatchMeshIndirect(SgU32 maxCommandCount, ISGBuffer* pArgBuffer, SgU32 argBufferOffset) override
+    {
+        Record(NullCommandType::DispatchMeshIndirect, maxCommandCount, pArgBuffer, argBufferOffset);
+    }
+
+    void SG_CALL DispatchIndirect(SgU32 maxCommandCount, ISGBuffer* pArgBuffer, SgU32 argBufferOffset) override
+    {
+        Record(NullCommandType::DispatchIndirect, maxCommandCount, pArgBuffer, argBufferOffset);
+    }
+
+    // Copy context
+    void SG_CALL CopyResource(ISGResource* pDstResource, ISGResource* pSrcResource) override
+    {
+        Record(NullCommandType::CopyResource, pDstResource, pSrcResource);
+    }
+
+    void SG_CALL CopySubresource(ISGSubresource* pDstSubresource, ISGSubresource* pSrcSubresource) override
+    {
+        Record(NullCommandType::CopySubresource, pDstSubresource, pSrcSubresource);
+    }
+
+    void SG_CALL ResolveSubresource(ISGSubresource* pDstSubresource, ISGSubresource* pSrcSubresource, SG_FORMAT format) override
+    {
+        Record(NullCommandType::ResolveSubresource, pDstSubresource, pSrcSubresource, format);
+    }
+
+    void SG_CALL CopyBufferRegion(ISGBuffer* pDstBuffer, SgU64 destOffset, ISGBuffer* pSrcBuffer, SgU64 srcOffset, SgU64 numBytes) override
+    {
+        Record(NullCommandType::CopyBufferRegion, pDstBuffer, destOffset, pSrcBuffer, srcOffset, numBytes);
+    }
+
+    void SG_CALL CopyTextureRegion(ISGTexture* pDstTexture, SG_TEXTURE_COPY_DESTINATION const* pDestRegion, ISGTexture* pSrcTexture, SG_TEXTURE_COPY_SOURCE const* pSrcRegion) override
+    {
+        // Data layout: destination, source
+        NullCommand* pCommand = m_Stream.Allocate(NullCommandType::CopyTextureRegion, 2, sizeof(SG_TEXTURE_COPY_DESTINATION) + sizeof(SG_TEXTURE_COPY_SOURCE));
+
+        SgU64* pArgs = const_cast<SgU64*>(pCommand->GetArgs());
+        pArgs[0] = ToArg(pDstTexture);
+        pArgs[1] = ToArg(pSrcTexture);
+
+        SgU8* pData = static_cast<SgU8*>(const_cast<void*>(pCommand->GetData()));
+        memcpy(pData, pDestRegion, sizeof(SG_TEXTURE_COPY_DESTINATION));
+        memcpy(pData + sizeof(SG_TEXTURE_COPY_DESTINATION), pSrcRegion, sizeof(SG_TEXTURE_COPY_SOURCE));
+    }
+
+    // Ray tracing
+    void SG_CALL BuildBottomLevelAS(ISGBottomLevelAS* pBLAS) override
+    {
+        Record(NullCommandType::BuildBottomLevelAS, pBLAS);
+    }
+
+    void SG_CALL BuildTopLevelAS(ISGTopLevelAS* pTLAS) override
+    {
+        Record(NullCommandType::BuildTopLevelAS, pTLAS);
+    }
+
+    void SG_CALL DispatchRays(SgU32 width, SgU32 height, SgU32 depth) override
+    {
+        Record(NullCommandType::DispatchRays, width, height, depth);
+    }
+
+private:
+    static void WriteArgs(SgU64*) {}
+
+    template <typename T, typename... TArgs>
+    static void WriteArgs(SgU64* pArgs, T value, TArgs... args)
+    {
+        *pArgs = ToArg(value);
+        WriteArgs(pArgs + 1, args...);
+    }
+
+    template <typename... TArgs>
+    void Record(NullCommandType type, TArgs... args)
+    {
+        NullCommand* pCommand = m_Stream.Allocate(type, sizeof...(TArgs), 0);
+        WriteArgs(const_cast<SgU64*>(pCommand->GetArgs()), args...);
+    }
+
+    template <typename... TArgs>
+    void RecordData(NullCommandType type, void const* pData, size_t dataSize, TArgs... args)
+    {
+        NullCommand* pCommand = m_Stream.Allocate(type, sizeof...(TArgs), static_cast<SgU32>(dataSize));
+        WriteArgs(const_cast<SgU64*>(pCommand->GetArgs()), args...);
+
+        if (dataSize > 0)
+            memcpy(const_cast<void*>(pCommand->GetData()), pData, dataSize);
+    }
+
+    std::atomic<SgU32>  m_RefCount;
+    SG_QUEUE_TYPE       m_QueueType;
+    SgU8                m_QueueIndex;
+    SgU16               m_TimeIndex;
+    bool                m_Finished;
+    NullCommandStream   m_Stream;
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Execution context
+///-------------------------------------------------------------------------------------------------
+class NullSwapChain;
+
+class NullExecutionContext : public NullObject<ISGExecutionContext>
+{
+public:
+    NullExecutionContext(NullDevice* pDevice, SG_EXECUTION_CONTEXT_DESC const& desc)
+        : m_pDevice(pDevice)
+        , m_Desc(desc)
+        , m_FrameBuffers(std::max<SgU8>(desc.FrameBuffers, 1))
+        , m_FrameBufferIndex(0)
+        , m_FrameNumber(0)
+        , m_FrameActive(false)
+        , m_LastRecord{}
+    {
+    }
+
+    ~NullExecutionContext() override
+    {
+        for (FrameBuffer& frameBuffer : m_FrameBuffers)
+        {
+            for (NullCommandList* pCommandList : frameBuffer.Pool)
+                delete pCommandList;
+        }
+    }
+
+    // The device owns the execution context, no reference is held back
+    NullDevice* GetDevice() const { return m_pDevice; }
+    SG_EXECUTION_CONTEXT_DESC const& GetDesc() const { return m_Desc; }
+    NullFrameRecord const& GetLastRecord() const { return m_LastRecord; }
+
+    void SG_CALL BeginFrame() override
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (m_FrameActive)
+            return;
+
+        // There is no GPU timeline, the frame buffer retires immediately
+        m_FrameBufferIndex = (m_FrameBufferIndex + 1) % m_FrameBuffers.size();
+
+        FrameBuffer& frameBuffer = m_FrameBuffers[m_FrameBufferIndex];
+        frameBuffer.UsedLists = 0;
+        frameBuffer.Finished.clear();
+
+        m_FrameActive = true;
+    }
+
+    void SG_CALL EndFrame() override
+    {
+        EndFrame1(0, nullptr);
+    }
+
+    void SG_CALL EndFrame1(SgU8 numSwapChains, ISGSwapChain* const* ppSwapChains) override;
+
+    SG_RESULT SG_CALL WaitForIdle() override
+    {
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL GetData(ISGQuery* pQuery, void** ppData, SgU32 dataSize) override
+    {
+        if (pQuery == nullptr || ppData == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        return static_cast<NullQuery*>(pQuery)->GetData(ppData, dataSize);
+    }
+
+    SG_RESULT SG_CALL ScheduleCommandList(SgU8 queueIndex, SgU16 timeIndex, ISGCommandList** ppOutCommandList) override
+    {
+        if (queueIndex >= m_Desc.QueueCount || ppOutCommandList == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        if (timeIndex == 0 || timeIndex > c_MaxTimeIndex)
+            return SG_ERROR_INVALID_TIME_INDEX;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (!m_FrameActive)
+            return SG_ERROR_NO_ACTIVE_FRAME;
+
+        FrameBuffer& frameBuffer = m_FrameBuffers[m_FrameBufferIndex];
+        if (frameBuffer.UsedLists == frameBuffer.Pool.size())
+            frameBuffer.Pool.push_back(new NullCommandList());
+
+        NullCommandList* pCommandList = frameBuffer.Pool[frameBuffer.UsedLists++];
+        pCommandList->Begin(m_Desc.QueueTypes[queueIndex], queueIndex, timeIndex);
+
+        *ppOutCommandList = pCommandList;
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL FinishCommandList(ISGCommandList* pCommandList) override
+    {
+        if (pCommandList == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        NullCommandList* pNullCommandList = static_cast<NullCommandList*>(pCommandList);
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (!m_FrameActive)
+            return SG_ERROR_NO_ACTIVE_FRAME;
+
+        if (pNullCommandList->IsFinished())
+            return SG_ERROR_CMD_LIST_ALREADY_FINISHED;
+
+        // Command list must be released by the application's side
+        if (pNullCommandList->GetRefCount() != 1)
+            return SG_ERROR_API;
+
+        pNullCommandList->Release();
+        pNullCommandList->SetFinished();
+        m_FrameBuffers[m_FrameBufferIndex].Finished.push_back(pNullCommandList);
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL GetTimestampFrequency(SgU8 queueIndex, SgU64* pOutFrequency) override
+    {
+        if (queueIndex >= m_Desc.QueueCount)
+            return SG_ERROR_INVALID_ARG;
+
+        // Timestamps are taken from the steady clock in nanoseconds
+        *pOutFrequency = 1000000000ull;
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL GetClockCalibration(SgU8 queueIndex, SG_QUEUE_CLOCK_CALIBRATION* pOutClockCalibration) override
+    {
+        if (queueIndex >= m_Desc.QueueCount)
+            return SG_ERROR_INVALID_ARG;
+
+        SgU64 const now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        pOutClockCalibration->CpuTimestamp = now;
+        pOutClockCalibration->GpuTimestamp = now;
+        return SG_OK;
+    }
+
+private:
+    struct FrameBuffer
+    {
+        std::vector<NullCommandList*>   Pool;
+        size_t                          UsedLists = 0;
+        std::vector<NullCommandList*>   Finished;
+    };
+
+    NullDevice*                 m_pDevice;
+    SG_EXECUTION_CONTEXT_DESC   m_Desc;
+    std::vector<FrameBuffer>    m_FrameBuffers;
+    size_t                      m_FrameBufferIndex;
+    SgU64                       m_FrameNumber;
+    bool                        m_FrameActive;
+    NullFrameRecord             m_LastRecord;
+    std::mutex                  m_Mutex;
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Device
+///-------------------------------------------------------------------------------------------------
+class NullDevice : public NullObject<ISGDevice>
+{
+public:
+    NullDevice(SG_DEVICE_DESC const& desc)
+        : m_pExecutionContext(nullptr)
+        , m_UsedLocalMemory(0)
+        , m_UsedNonLocalMemory(0)
+        , m_LocalBudget(c_NullLocalMemory)
+    {
+        if (desc.pMemoryDebugConfig != nullptr && desc.pMemoryDebugConfig->LocalBudgetLimit != 0)
+            m_LocalBudget = desc.pMemoryDebugConfig->LocalBudgetLimit;
+
+        if (desc.pExecutionContextDesc != nullptr)
+            m_pExecutionContext = new NullExecutionContext(this, *desc.pExecutionContextDesc);
+    }
+
+    ~NullDevice() override
+    {
+        if (m_pExecutionContext != nullptr)
+            m_pExecutionContext->Release();
+    }
+
+    void TrackMemory(SgU64 sizeBytes, bool hostVisible, bool allocate)
+    {
+        std::atomic<SgU64>& counter = hostVisible ? m_UsedNonLocalMemory : m_UsedLocalMemory;
+        if (allocate)
+            counter += sizeBytes;
+        else
+            counter -= sizeBytes;
+    }
+
+    SG_RESULT SG_CALL GetExecutionContext(ISGExecutionContext** ppExecutionContext) override
+    {
+        if (m_pExecutionContext == nullptr)
+            return SG_ERROR_NO_EXEC_CTX;
+
+        m_pExecutionContext->AddRef();
+        *ppExecutionContext = m_pExecutionContext;
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL GetMemoryUsage(SG_MEMORY_SEGMENT_GROUP memSegment, SG_MEMORY_USAGE* pMemoryUsage) override
+    {
+        if (memSegment == SG_MEMORY_SEGMENT_GROUP_LOCAL)
+        {
+            pMemoryUsage->Budget = m_LocalBudget;
+            pMemoryUsage->UsedMemory = m_UsedLocalMemory;
+        }
+        else
+        {
+            pMemoryUsage->Budget = c_NullNonLocalMemory;
+            pMemoryUsage->UsedMemory = m_UsedNonLocalMemory;
+        }
+
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL CreateBuffer(SG_BUFFER_DESC const* pDesc, ISGBuffer** ppBuffer) override
+    {
+        if (pDesc == nullptr || ppBuffer == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        if (pDesc->Size == 0)
+            return SG_ERROR_BUFFER_INVALID_SIZE;
+
+        if (pDesc->Type == SG_BUFFER_TYPE_UPLOAD && SgU32(pDesc->BindFlags & SG_BUFFER_BIND_FLAG_UNORDERED_ACCESS) != 0)
+            return SG_ERROR_BUFFER_INCOMPATIBLE_BIND_FLAG;
+
+        if (pDesc->Type == SG_BUFFER_TYPE_READBACK && pDesc->BindFlags != SG_BUFFER_BIND_FLAG_NONE)
+            return SG_ERROR_BUFFER_INCOMPATIBLE_BIND_FLAG;
+
+        if (pDesc->Type == SG_BUFFER_TYPE_COMMON && m_UsedLocalMemory + pDesc->Size > m_LocalBudget)
+            return SG_ERROR_OUT_OF_MEMORY;
+
+        *ppBuffer = new NullBuffer(this, *pDesc);
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL CreateTexture(SG_TEXTURE_DESC const* pDesc, ISGTexture** ppTexture) override
+    {
+        if (pDesc == nullptr || ppTexture == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        if (pDesc->Dimension == SG_TEXTURE_DIMENSION_UNDEFINED)
+            return SG_ERROR_TEXTURE_INVALID_DIMENSION;
+
+        if (pDesc->Width == 0 || pDesc->Height == 0 || pDesc->DepthOrArraySize == 0 || pDesc->MipLevels == 0)
+            return SG_ERROR_TEXTURE_INVALID_SIZE;
+
+        SgU32 const formatBits = GetFormatSizeBits(pDesc->Format);
+        if (formatBits == 0)
+            return SG_ERROR_INVALID_FORMAT;
+
+        bool const isTransfer = pDesc->Type == SG_TEXTURE_TYPE_UPLOAD || pDesc->Type == SG_TEXTURE_TYPE_READBACK;
+        if (isTransfer && pDesc->BindFlags != SG_TEXTURE_BIND_FLAG_NONE)
+            return SG_ERROR_TEXTURE_INCOMPATIBLE_BIND_FLAG;
+
+        // Build footprints in the same manner as D3D12 placed footprints
+        bool const is3D = pDesc->Dimension == SG_TEXTURE_DIMENSION_3D;
+        SgU32 const arraySize = is3D ? 1 : pDesc->DepthOrArraySize;
+        bool const isBC = IsBlockCompressed(pDesc->Format);
+
+        std::vector<NullSubresourceFootprint> footprints(pDesc->MipLevels * arraySize);
+        SgU64 totalSize = 0;
+
+        for (SgU32 slice = 0; slice < arraySize; slice++)
+        {
+            for (SgU32 mip = 0; mip < pDesc->MipLevels; mip++)
+            {
+                SgU32 const width = std::max(pDesc->Width >> mip, 1u);
+                SgU32 const height = std::max(pDesc->Height >> mip, 1u);
+                SgU32 const depth = is3D ? std::max(pDesc->DepthOrArraySize >> mip, 1u) : 1;
+
+                SgU32 const columns = isBC ? (width + 3) / 4 : width;
+                SgU32 const rows = isBC ? (height + 3) / 4 : height;
+                SgU64 const rowSize = isBC ? SgU64(columns) * formatBits * 2 : (SgU64(columns) * formatBits + 7) / 8;
+
+                NullSubresourceFootprint& footprint = footprints[mip + slice * pDesc->MipLevels];
+                footprint.Offset = AlignUp<SgU64>(totalSize, c_SubresourceAlignment);
+                footprint.RowPitch = AlignUp<SgU64>(rowSize, c_RowPitchAlignment);
+                footprint.DepthPitch = footprint.RowPitch * rows;
+
+                totalSize = footprint.Offset + footprint.DepthPitch * depth;
+            }
+        }
+
+        if (!isTransfer && m_UsedLocalMemory + totalSize > m_LocalBudget)
+            return SG_ERROR_OUT_OF_MEMORY;
+
+        *ppTexture = new NullTexture(this, *pDesc, std::move(footprints), totalSize);
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL CreateBottomLevelAccelerationStructure(SG_AS_BOTTOM_LEVEL_DESC const* pDesc, ISGBottomLevelAS** ppBLAS) override
+    {
+        if (pDesc == nullptr || ppBLAS == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        NullBottomLevelAS* pBLAS = new NullBottomLevelAS();
+        pBLAS->Fill(pDesc->NumDescs, pDesc->pGeometryDescs, SG_FALSE, nullptr);
+        *ppBLAS = pBLAS;
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL CreateTopLevelAccelerationStructure(SG_AS_TOP_LEVEL_DESC const* pDesc, ISGTopLevelAS** ppTLAS) override
+    {
+        if (pDesc == nullptr || ppTLAS == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        NullTopLevelAS* pTLAS = new NullTopLevelAS();
+        pTLAS->Fill(pDesc->NumDescs, pDesc->pInstanceDescs, SG_FALSE, nullptr);
+        *ppTLAS = pTLAS;
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL CreateShaderResourceView(ISGResource* pResource, SG_SHADER_RESOURCE_VIEW_DESC const* pViewDesc, ISGShaderResourceView** ppShaderResourceView) override
+    {
+        return CreateView<NullShaderResourceView>(pResource, pViewDesc, ppShaderResourceView);
+    }
+
+    SG_RESULT SG_CALL CreateUnorderedAccessView(ISGResource* pResource, SG_UNORDERED_ACCESS_VIEW_DESC const* pViewDesc, ISGUnorderedAccessView** ppUnorderedAccessView) override
+    {
+        return CreateView<NullUnorderedAccessView>(pResource, pViewDesc, ppUnorderedAccessView);
+    }
+
+    SG_RESULT SG_CALL CreateRenderTargetView(ISGResource* pResource, SG_RENDER_TARGET_VIEW_DESC const* pViewDesc, ISGRenderTargetView** ppRenderTargetView) override
+    {
+        return CreateView<NullRenderTargetView>(pResource, pViewDesc, ppRenderTargetView);
+    }
+
+    SG_RESULT SG_CALL CreateDepthStencilView(ISGResource* pResource, SG_DEPTH_STENCIL_VIEW_DESC const* pViewDesc, ISGDepthStencilView** ppDepthStencilView) override
+    {
+        return CreateView<NullDepthStencilView>(pResource, pViewDesc, ppDepthStencilView);
+    }
+
+    SG_RESULT SG_CALL CreateSampler(SG_SAMPLER_DESC const* pDesc, ISGSampler** ppSampler) override
+    {
+        return CreateDescObject<NullSampler>(pDesc, ppSampler);
+    }
+
+    SG_RESULT SG_CALL CreateQuery(SG_QUERY_TYPE type, ISGQuery** ppQuery) override
+    {
+        if (ppQuery == nullptr || type > SG_QUERY_TYPE_PIPELINE_STATISTICS)
+            return SG_ERROR_INVALID_QUERY_TYPE;
+
+        *ppQuery = new NullQuery(type);
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL CreatePredicate(SG_QUERY_TYPE type, ISGPredicate** ppPredicate) override
+    {
+        if (ppPredicate == nullptr || (type != SG_QUERY_TYPE_OCCLUSION && type != SG_QUERY_TYPE_BINARY_OCCLUSION))
+            return SG_ERROR_INVALID_QUERY_TYPE;
+
+        *ppPredicate = new NullQuery(type);
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL CreateInputLayout(SgU32 numElements, SG_INPUT_ELEMENT_DESC const* pInputElements, ISGInputLayout** ppInputLayout) override
+    {
+        if ((numElements > 0 && pInputElements == nullptr) || ppInputLayout == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        *ppInputLayout = new NullInputLayout();
+        return SG_OK;
+    }
+
+    SG_RESULT SG_CALL CreateGraphicsPipelineState(SG_GRAPHICS_PIPELINE_STATE_DESC const* pDesc, ISGPipelineState** ppPipelineState) override
+    {
+        if (pDesc == nullptr || pDesc->VS.pData == nullptr)
+            return SG_ERROR_INVALID_SHADER;
+
+        return CreatePipelineState(SG_PIPELINE_STATE_TYPE_GRAPHICS, pDesc->RootSignature, ppPipelineState);
+    }
+
+    SG_RESULT SG_CALL CreateMeshPipelineState(SG_MESH_PIPELINE_STATE_DESC const* pDesc, ISGPipelineState** ppPipelineState) override
+    {
+        if (pDesc == nullptr || pDesc->MS.pData == nullptr)
+            return SG_ERROR_INVALID_SHADER;
+
+        return CreatePipelineState(SG_PIPELINE_STATE_TYPE_MESH, pDesc->RootSignature, ppPipelineState);
+    }
+
+    SG_RESULT SG_CALL CreateComputePipelineState(SG_COMPUTE_PIPELINE_STATE_DESC const* pDesc, ISGPipelineState** ppPipelineState) override
+    {
+        if (pDesc == nullptr || pDesc->CS.pData == nullptr)
+            return SG_ERROR_INVALID_SHADER;
+
+        return CreatePipelineState(SG_PIPELINE_STATE_TYPE_COMPUTE, pDesc->RootSignature, ppPipelineState);
+    }
+
+    SG_RESULT SG_CALL CreateRaytracingPipelineState(SG_RAYTRACING_PIPELINE_DESC const* pDesc, ISGPipelineState** ppPipelineState) override
+    {
+        if (pDesc == nullptr || pDesc->RayGenShader.ByteCode.pData == nullptr)
+            return SG_ERROR_INVALID_SHADER;
+
+        return CreatePipelineState(SG_PIPELINE_STATE_TYPE_RAYTRACING, pDesc->RootSignature, ppPipelineState);
+    }
+
+    SG_RESULT SG_CALL CreateBlendState(SG_BLEND_STATE_DESC const* pDesc, ISGBlendState** ppBlendState) override
+    {
+        return CreateDescObject<NullBlendState>(pDesc, ppBlendState);
+    }
+
+    SG_RESULT SG_CALL CreateDepthStencilState(SG_DEPTH_STENCIL_STATE_DESC const* pDesc, ISGDepthStencilState** ppDepthStencilState) override
+    {
+        return CreateDescObject<NullDepthStencilState>(pDesc, ppDepthStencilState);
+    }
+
+    SG_RESULT SG_CALL CreateRasterizerState(SG_RASTERIZER_STATE_DESC const* pDesc, ISGRasterizerState** ppRasterizerState) override
+    {
+        return CreateDescObject<NullRasterizerState>(pDesc, ppRasterizerState);
+    }
+
+private:
+    template <typename TView, typename TDesc, typename TInterface>
+    SG_RESULT CreateView(ISGResource* pResource, TDesc const* pViewDesc, TInterface** ppView)
+    {
+        if (pResource == nullptr || pViewDesc == nullptr || ppView == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        *ppView = new TView(pResource, *pViewDesc);
+        return SG_OK;
+    }
+
+    template <typename TObject, typename TDesc, typename TInterface>
+    SG_RESULT CreateDescObject(TDesc const* pDesc, TInterface** ppObject)
+    {
+        if (pDesc == nullptr || ppObject == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        *ppObject = new TObject(*pDesc);
+        return SG_OK;
+    }
+
+    SG_RESULT CreatePipelineState(SG_PIPELINE_STATE_TYPE type, SG_ROOT_SIGNATURE_DESC const& rootSignature, ISGPipelineState** ppPipelineState)
+    {
+        if (ppPipelineState == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        if (rootSignature.Type != SG_ROOT_SIGNATURE_TYPE_TABULAR)
+            return SG_ERROR_INVALID_ROOT_SIGNATURE_TYPE;
+
+        if (rootSignature.Tabular.NumTables > SG_MAX_ROOT_SIGNATURE_PARAMETERS)
+            return SG_ERROR_INVALID_ARG;
+
+        *ppPipelineState = new NullPipelineState(type);
+        return SG_OK;
+    }
+
+    NullExecutionContext*   m_pExecutionContext;
+    std::atomic<SgU64>      m_UsedLocalMemory;
+    std::atomic<SgU64>      m_UsedNonLocalMemory;
+    SgU64                   m_LocalBudget;
+};
+
+template <typename TInterface>
+NullResource<TInterface>::NullResource(NullDevice* pDevice, SgU64 sizeBytes, bool hostVisible)
+    : m_pDevice(pDevice)
+    , m_SizeBytes(sizeBytes)
+{
+    if (hostVisible)
+        m_HostMemory.resize(static_cast<size_t>(sizeBytes));
+
+    m_pDevice->AddRef();
+    m_pDevice->TrackMemory(m_SizeBytes, hostVisible, true);
+}
+
+template <typename TInterface>
+NullResource<TInterface>::~NullResource()
+{
+    m_pDevice->TrackMemory(m_SizeBytes, !m_HostMemory.empty(), false);
+    m_pDevice->Release();
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Swap chain
+///-------------------------------------------------------------------------------------------------
+class NullSwapChain : public NullObject<ISGSwapChain>
+{
+public:
+    NullSwapChain(NullDevice* pDevice, SG_SWAP_CHAIN_DESC const& desc)
+        : m_pDevice(pDevice)
+        , m_Desc(desc)
+        , m_CurrentIndex(0)
+        , m_SyncInterval(0)
+    {
+        m_pDevice->AddRef();
+        m_Desc.BufferCount = std::max(m_Desc.BufferCount, 1u);
+    }
+
+    ~NullSwapChain() override
+    {
+        ReleaseBuffers();
+        m_pDevice->Release();
+    }
+
+    SG_RESULT CreateBuffers(SgU32 width, SgU32 height)
+    {
+        m_Desc.Width = width != 0 ? width : c_DefaultBackBufferWidth;
+        m_Desc.Height = height != 0 ? height : c_DefaultBackBufferHeight;
+
+        SG_TEXTURE_DESC textureDesc{};
+        textureDesc.Type = SG_TEXTURE_TYPE_COMMON;
+        textureDesc.BindFlags = SG_TEXTURE_BIND_FLAG_RENDER_TARGET;
+        textureDesc.BindFlags |= SgU32(m_Desc.Flags & SG_SWAP_CHAIN_FLAG_ALLOW_SHADER_RESOURCE) != 0 ? SG_TEXTURE_BIND_FLAG_SHADER_RESOURCE : SG_TEXTURE_BIND_FLAG_NONE;
+        textureDesc.Dimension = SG_TEXTURE_DIMENSION_2D;
+        textureDesc.Format = m_Desc.Format;
+        textureDesc.Width = m_Desc.Width;
+        textureDesc.Height = m_Desc.Height;
+        textureDesc.DepthOrArraySize = 1;
+        textureDesc.MipLevels = 1;
+        textureDesc.DefaultValue.Format = m_Desc.Format;
+
+        m_Buffers.resize(m_Desc.BufferCount);
+
+        for (BackBuffer& buffer : m_Buffers)
+        {
+            SG_RESULT result = m_pDevice->CreateTexture(&textureDesc, &buffer.pTexture);
+            if (result != SG_OK)
+                return result;
+
+            SG_RENDER_TARGET_VIEW_DESC rtvDesc{ m_Desc.Format, 0, 0, 1, 0 };
+            m_pDevice->CreateRenderTargetView(buffer.pTexture, &rtvDesc, &buffer.pRTV);
+
+            if (SgU32(m_Desc.Flags & SG_SWAP_CHAIN_FLAG_ALLOW_SHADER_RESOURCE) != 0)
+            {
+                SG_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+                srvDesc.Type = SG_SRV_TYPE_TEXTURE;
+                srvDesc.Texture = { m_Desc.Format, 0, 1, 0, 1, 0 };
+                m_pDevice->CreateShaderResourceView(buffer.pTexture, &srvDesc, &buffer.pSRV);
+            }
+        }
+
+        m_CurrentIndex = 0;
+        return SG_OK;
+    }
+
+    void Present()
+    {
+        m_CurrentIndex = (m_CurrentIndex + 1) % m_Buffers.size();
+    }
+
+    SG_RESULT SG_CALL SetFullScreenState(SgBool, SG_DISPLAY_MODE const*, ISGOutput*) override
+    {
+        return SG_ERROR_UNSUPPORTED_FEATURE;
+    }
+
+    SG_RESULT SG_CALL Resize(SgU32 width, SgU32 height) override
+    {
+        ReleaseBuffers();
+        return CreateBuffers(width, height);
+    }
+
+    void SG_CALL SetSyncInterval(SgU32 syncInterval) override { m_SyncInterval = syncInterval; }
+
+    SgU32 SG_CALL GetBackBufferWidth() override { return m_Desc.Width; }
+    SgU32 SG_CALL GetBackBufferHeight() override { return m_Desc.Height; }
+
+    ISGTexture* SG_CALL GetCurrentTexture() override { return m_Buffers[m_CurrentIndex].pTexture; }
+    ISGRenderTargetView* SG_CALL GetCurrentRTV() override { return m_Buffers[m_CurrentIndex].pRTV; }
+    ISGShaderResourceView* SG_CALL GetCurrentSRV() override { return m_Buffers[m_CurrentIndex].pSRV; }
+
+private:
+    struct BackBuffer
+    {
+        ISGTexture*             pTexture = nullptr;
+        ISGRenderTargetView*    pRTV = nullptr;
+        ISGShaderResourceView*  pSRV = nullptr;
+    };
+
+    void ReleaseBuffers()
+    {
+        for (BackBuffer& buffer : m_Buffers)
+        {
+            if (buffer.pSRV != nullptr) buffer.pSRV->Release();
+            if (buffer.pRTV != nullptr) buffer.pRTV->Release();
+            if (buffer.pTexture != nullptr) buffer.pTexture->Release();
+        }
+
+        m_Buffers.clear();
+    }
+
+    NullDevice*             m_pDevice;
+    SG_SWAP_CHAIN_DESC      m_Desc;
+    std::vector<BackBuffer> m_Buffers;
+    size_t                  m_CurrentIndex;
+    SgU32                   m_SyncInterval;
+};
+
+void NullExecutionContext::EndFrame1(SgU8 numSwapChains, ISGSwapChain* const* ppSwapChains)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (!m_FrameActive)
+        return;
+
+    FrameBuffer& frameBuffer = m_FrameBuffers[m_FrameBufferIndex];
+
+    // Lists that have been scheduled but not finished are dropped like on the real back-end
+    std::stable_sort(frameBuffer.Finished.begin(), frameBuffer.Finished.end(),
+        [](NullCommandList const* pLeft, NullCommandList const* pRight)
+        {
+            if (pLeft->GetTimeIndex() != pRight->GetTimeIndex())
+                return pLeft->GetTimeIndex() < pRight->GetTimeIndex();
+
+            return pLeft->GetQueueIndex() < pRight->GetQueueIndex();
+        });
+
+    m_LastRecord.Stats = {};
+    m_LastRecord.Stats.FrameNumber = m_FrameNumber++;
+    m_LastRecord.Lists.clear();
+
+    for (NullCommandList const* pCommandList : frameBuffer.Finished)
+    {
+        NullCommandStream const& stream = pCommandList->GetStream();
+        m_LastRecord.Lists.push_back({ pCommandList->GetQueueIndex(), pCommandList->GetTimeIndex(), &stream });
+
+        m_LastRecord.Stats.CommandLists++;
+        m_LastRecord.Stats.Commands += stream.GetCommandCount();
+        m_LastRecord.Stats.StreamBytes += stream.GetSizeBytes();
+
+        for (NullCommand const* pCommand = stream.First(); pCommand != nullptr; pCommand = stream.Next(pCommand))
+            m_LastRecord.Stats.CommandCounts[static_cast<SgU32>(pCommand->Type)]++;
+    }
+
+    for (SgU8 i = 0; i < numSwapChains; i++)
+        static_cast<NullSwapChain*>(ppSwapChains[i])->Present();
+
+    m_FrameActive = false;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Adapter
+///-------------------------------------------------------------------------------------------------
+class NullAdapter : public NullObject<ISGAdapter>
+{
+public:
+    SG_RESULT SG_CALL EnumOutputs(SgU32, ISGOutput**) override
+    {
+        return SG_ERROR_NOT_FOUND;
+    }
+
+    SG_RESULT SG_CALL GetInfo(SG_ADAPTER_INFO_CATEGORIES category, void* pOutInfo) override
+    {
+        if (pOutInfo == nullptr)
+            return SG_ERROR_INVALID_ARG;
+
+        switch (category)
+        {
+        case SG_ADAPTER_INFO_CAT_COMMON:
+            {
+                SG_ADAPTER_INFO_COMMON& info = *static_cast<SG_ADAPTER_INFO_COMMON*>(pOutInfo);
+                info = {};
+                char const name[] = "SGLib Null Adapter";
+                memcpy(info.Description, name, sizeof(name));
+            }
+            return SG_OK;
+        case SG_ADAPTER_INFO_CAT_MEMORY:
+            {
+                SG_ADAPTER_INFO_MEMORY& info = *static_cast<SG_ADAPTER_INFO_MEMORY*>(pOutInfo);
+                info.IsUMA = SG_FALSE;
+                info.LocalMemory = c_NullLocalMemory;
+                info.NonLocalMemory = c_NullNonLocalMemory;
+            }
+            return SG_OK;
+        case SG_ADAPTER_INFO_CAT_EXECUTION:
+            {
+                // Reports every feature as supported, so that any code path can be recorded
+                SG_ADAPTER_INFO_EXECUTION& info = *static_cast<SG_ADAPTER_INFO_EXECUTION*>(pOutInfo);
+                info = {};
+                info.GraphicsQueues = SG_MAX_QUEUE_COUNT;
+                info.ComputeQueues = SG_MAX_QUEUE_COUNT;
+                info.CopyQueues = SG_MAX_QUEUE_COUNT;
+                info.CopyQueueTimeStamps = SG_TRUE;
+                info.RaytracingTier = SG_RAYTRACING_TIER_1_1;
+                info.MeshShaderTier = SG_MESH_SHADER_TIER_1;
+                info.VariableShadingRateTier = SG_VARIABLE_SHADING_RATE_TIER_2;
+                info.ShadingRateImageTileSize = 16;
+                info.AdditionalShadingRates = SG_TRUE;
+                info.PerPrimitiveShadingRateWithVPIndexing = SG_TRUE;
+            }
+            return SG_OK;
+        case SG_ADAPTER_INFO_CAT_SHADERS:
+            {
+                SG_ADAPTER_INFO_SHADERS& info = *static_cast<SG_ADAPTER_INFO_SHADERS*>(pOutInfo);
+                info = {};
+                info.ShaderModel = SHADER_MODEL_6_6;
+                info.MinPrecisionSupport = SHADER_MIN_PRECISION_SUPPORT_16BITS;
+                info.WaveOps = SG_TRUE;
+                info.WaveLaneCountMin = 32;
+                info.WaveLaneCountMax = 32;
+                info.TotalLaneCount = 32;
+            }
+            return SG_OK;
+        case SG_ADAPTER_INFO_CAT_PIPELINE_STATES:
+            {
+                SG_ADAPTER_INFO_PIPELINE_STATES& info = *static_cast<SG_ADAPTER_INFO_PIPELINE_STATES*>(pOutInfo);
+                info = {};
+                info.ConservativeRasterizationTier = SG_CONSERVATIVE_RASTERIZATION_TIER_3;
+                info.MaxCBsPerStage = 14;
+                info.MaxSRVsPerStage = 128;
+                info.MaxUAVsPerPass = 64;
+                info.MaxSMPsPerStage = 16;
+            }
+            return SG_OK;
+        }
+
+        return SG_ERROR_INVALID_ARG;
+    }
+};
+
+///-------------------------------------------------------------------------------------------------
+/// Entry points
+///-------------------------------------------------------------------------------------------------
+SG_RESULT CreateNullAdapter(ISGAdapter** ppAdapter)
+{
+    if (ppAdapter == nullptr)
+        return SG_ERROR_INVALID_ARG;
+
+    *ppAdapter = new NullAdapter();
+    return SG_OK;
+}
+
+SG_RESULT CreateNullDevice(ISGAdapter* pAdapter, SG_DEVICE_DESC const* pDesc, ISGDevice** ppDevice)
+{
+    if (dynamic_cast<NullAdapter*>(pAdapter) == nullptr || pDesc == nullptr || ppDevice == nullptr)
+        return SG_ERROR_INVALID_ARG;
+
+    SG_EXECUTION_CONTEXT_DESC const* pExecCtxDesc = pDesc->pExecutionContextDesc;
+    if (pExecCtxDesc != nullptr && (pExecCtxDesc->QueueCount == 0 || pExecCtxDesc->QueueCount > SG_MAX_QUEUE_COUNT))
+        return SG_ERROR_INVALID_ARG;
+
+    *ppDevice = new NullDevice(*pDesc);
+    return SG_OK;
+}
+
+SG_RESULT CreateNullSwapChain(ISGExecutionContext* pExecutionContext, SgU8 queueIndex, SG_SWAP_CHAIN_DESC const* pDesc, ISGSwapChain** ppSwapChain)
+{
+    NullExecutionContext* pNullContext = dynamic_cast<NullExecutionContext*>(pExecutionContext);
+    if (pNullContext == nullptr || pDesc == nullptr || ppSwapChain == nullptr)
+        return SG_ERROR_INVALID_ARG;
+
+    SG_EXECUTION_CONTEXT_DESC const& ctxDesc = pNullContext->GetDesc();
+    if (queueIndex >= ctxDesc.QueueCount || ctxDesc.QueueTypes[queueIndex] != SG_QUEUE_TYPE_GRAPHICS)
+        return SG_ERROR_INVALID_ARG;
+
+    NullSwapChain* pSwapChain = new NullSwapChain(pNullContext->GetDevice(), *pDesc);
+
+    SG_RESULT result = pSwapChain->CreateBuffers(pDesc->Width, pDesc->Height);
+    if (result != SG_OK)
+    {
+        pSwapChain->Release();
+        return result;
+    }
+
+    *ppSwapChain = pSwapChain;
+    return SG_OK;
+}
+
+bool IsNullDevice(ISGDevice* pDevice)
+{
+    return dynamic_cast<NullDevice*>(pDevice) != nullptr;
+}
+
+SG_RESULT GetNullFrameRecord(ISGExecutionContext* pExecutionContext, NullFrameRecord const** ppRecord)
+{
+    NullExecutionContext* pNullContext = dynamic_cast<NullExecutionContext*>(pExecutionContext);
+    if (pNullContext == nullptr || ppRecord == nullptr)
+        return SG_ERROR_INVALID_ARG;
+
+    *ppRecord = &pNullContext->GetLastRecord();
+    return SG_OK;
+}
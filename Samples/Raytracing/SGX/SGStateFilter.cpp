@@ -0,0 +1,589 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGStateFilter.h"
+
+#include <algorithm>
+#include <cstring>
+
+StateFilterCommandList::StateFilterCommandList()
+    : m_pCommandList(nullptr)
+    , m_BindingsDirty(false)
+{
+    ResetStats();
+    Invalidate();
+}
+
+void StateFilterCommandList::Begin(ISGCommandList* pCommandList)
+{
+    m_pCommandList = pCommandList;
+
+    // A new command list starts without bindings, pending values of the previous one are discarded
+    for (auto& tables : m_Tables)
+    {
+        for (BindingTable& table : tables)
+        {
+            for (BindingSlot& slot : table.Slots)
+            {
+                slot.Set = false;
+                slot.PendingCalls = 0;
+            }
+            table.Dirty = false;
+        }
+    }
+    m_BindingsDirty = false;
+
+    Invalidate();
+}
+
+void StateFilterCommandList::End()
+{
+    m_pCommandList = nullptr;
+}
+
+void StateFilterCommandList::Invalidate()
+{
+    memset(m_StateKnown, 0, sizeof(m_StateKnown));
+    memset(m_VertexBufferKnown, 0, sizeof(m_VertexBufferKnown));
+
+    InvalidateBindings();
+}
+
+StateFilterSlotStats StateFilterCommandList::GetSlotStats(FilteredTable table, SgU32 paramIdx, SgU32 bindPoint) const
+{
+    auto const& tables = m_Tables[static_cast<SgU32>(table)];
+    if (paramIdx >= tables.size() || bindPoint >= tables[paramIdx].Slots.size())
+        return {};
+
+    return tables[paramIdx].Slots[bindPoint].Stats;
+}
+
+void StateFilterCommandList::ResetStats()
+{
+    memset(&m_Stats, 0, sizeof(m_Stats));
+
+    for (auto& tables : m_Tables)
+    {
+        for (BindingTable& table : tables)
+        {
+            for (BindingSlot& slot : table.Slots)
+                slot.Stats = {};
+        }
+    }
+}
+
+template <typename T>
+bool StateFilterCommandList::Update(FilteredState state, T& current, T const& value)
+{
+    SgU32 const index = static_cast<SgU32>(state);
+
+    if (m_StateKnown[index] && current == value)
+    {
+        ++m_Stats.FilteredStates[index];
+        return false;
+    }
+
+    m_StateKnown[index] = true;
+    current = value;
+    return true;
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Binding tables
+///-------------------------------------------------------------------------------------------------
+StateFilterCommandList::BindingSlot& StateFilterCommandList::GetSlot(FilteredTable table, SgU32 paramIdx, SgU32 bindPoint)
+{
+    auto& tables = m_Tables[static_cast<SgU32>(table)];
+    if (paramIdx >= tables.size())
+        tables.resize(paramIdx + 1, BindingTable{ {}, false });
+
+    auto& slots = tables[paramIdx].Slots;
+    if (bindPoint >= slots.size())
+        slots.resize(bindPoint + 1, BindingSlot{ nullptr, nullptr, false, false, 0, {} });
+
+    return slots[bindPoint];
+}
+
+void StateFilterCommandList::SetBinding(FilteredTable table, SgU32 paramIdx, SgU32 bindPoint, void* pValue)
+{
+    BindingSlot& slot = GetSlot(table, paramIdx, bindPoint);
+
+    slot.pPending = pValue;
+    slot.Set = true;
+    ++slot.PendingCalls;
+    ++slot.Stats.Calls;
+
+    m_Tables[static_cast<SgU32>(table)][paramIdx].Dirty = true;
+    m_BindingsDirty = true;
+}
+
+void StateFilterCommandList::InvalidateBindings()
+{
+    for (auto& tables : m_Tables)
+    {
+        for (BindingTable& table : tables)
+        {
+            for (BindingSlot& slot : table.Slots)
+                slot.Known = false;
+
+            // Slots set in this command list have to be written again
+            table.Dirty = true;
+        }
+    }
+
+    m_BindingsDirty = true;
+}
+
+void StateFilterCommandList::DropBindings()
+{
+    for (auto& tables : m_Tables)
+    {
+        for (BindingTable& table : tables)
+        {
+            for (BindingSlot& slot : table.Slots)
+            {
+                // Values set for the previous root signature are never written
+                slot.Stats.Filtered += slot.PendingCalls;
+                slot.PendingCalls = 0;
+                slot.Set = false;
+                slot.Known = false;
+            }
+
+            table.Dirty = false;
+        }
+    }
+
+    m_BindingsDirty = false;
+}
+
+void StateFilterCommandList::FlushBindings()
+{
+    if (!m_BindingsDirty)
+        return;
+
+    for (SgU32 t = 0; t < static_cast<SgU32>(FilteredTable::Count); ++t)
+    {
+        auto& tables = m_Tables[t];
+
+        for (SgU32 paramIdx = 0; paramIdx < tables.size(); ++paramIdx)
+        {
+            BindingTable& table = tables[paramIdx];
+            if (!table.Dirty)
+                continue;
+
+            // Slots to write are gathered into contiguous ranges, the values are passed from a scratch array
+            void* pRange[MaxFlushRange];
+            SgU32 rangeOffset = 0;
+            SgU32 rangeCount = 0;
+
+            auto flushRange = [&]()
+            {
+                if (rangeCount == 0)
+                    return;
+
+                if (static_cast<FilteredTable>(t) == FilteredTable::ConstantBuffers)
+                    m_pCommandList->SetConstantBuffers(paramIdx, rangeOffset, rangeCount, reinterpret_cast<ISGResource**>(pRange));
+                else
+                    m_pCommandList->SetShaderResources(paramIdx, rangeOffset, rangeCount, reinterpret_cast<ISGShaderResourceView**>(pRange));
+
+                ++m_Stats.FlushedRanges;
+                m_Stats.FlushedSlots += rangeCount;
+                rangeCount = 0;
+            };
+
+            for (SgU32 bindPoint = 0; bindPoint < table.Slots.size(); ++bindPoint)
+            {
+                BindingSlot& slot = table.Slots[bindPoint];
+                bool const write = slot.Set && (!slot.Known || slot.pBound != slot.pPending);
+
+                // Every call to a slot but the written value is filtered
+                slot.Stats.Filtered += write && slot.PendingCalls > 0 ? slot.PendingCalls - 1 : slot.PendingCalls;
+                slot.PendingCalls = 0;
+
+                if (!write || rangeCount == MaxFlushRange)
+                    flushRange();
+
+                if (write)
+                {
+                    if (rangeCount == 0)
+                        rangeOffset = bindPoint;
+
+                    pRange[rangeCount++] = slot.pPending;
+                    slot.pBound = slot.pPending;
+                    slot.Known = true;
+                }
+            }
+
+            flushRange();
+            table.Dirty = false;
+        }
+    }
+
+    m_BindingsDirty = false;
+}
+
+void StateFilterCommandList::SetConstantBuffer(SgU32 paramIdx, SgU32 bindPoint, ISGResource* pBuffer)
+{
+    SetBinding(FilteredTable::ConstantBuffers, paramIdx, bindPoint, pBuffer);
+}
+
+void StateFilterCommandList::SetConstantBuffers(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGResource** ppBuffers)
+{
+    for (SgU32 i = 0; i < count; ++i)
+        SetBinding(FilteredTable::ConstantBuffers, paramIdx, offset + i, ppBuffers[i]);
+}
+
+void StateFilterCommandList::SetShaderResource(SgU32 paramIdx, SgU32 bindPoint, ISGShaderResourceView* pView)
+{
+    SetBinding(FilteredTable::ShaderResources, paramIdx, bindPoint, pView);
+}
+
+void StateFilterCommandList::SetShaderResources(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGShaderResourceView** ppViews)
+{
+    for (SgU32 i = 0; i < count; ++i)
+        SetBinding(FilteredTable::ShaderResources, paramIdx, offset + i, ppViews[i]);
+}
+
+void StateFilterCommandList::SetUnorderedAccessView(SgU32 paramIdx, SgU32 bindPoint, ISGUnorderedAccessView* pView)
+{
+    InvalidateBindings();
+    m_pCommandList->SetUnorderedAccessView(paramIdx, bindPoint, pView);
+}
+
+void StateFilterCommandList::SetUnorderedAccessViews(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGUnorderedAccessView** ppViews)
+{
+    InvalidateBindings();
+    m_pCommandList->SetUnorderedAccessViews(paramIdx, offset, count, ppViews);
+}
+
+void StateFilterCommandList::SetAccelerationStructure(SgU32 paramIdx, SgU32 bindPoint, ISGTopLevelAS* pTLAS)
+{
+    InvalidateBindings();
+    m_pCommandList->SetAccelerationStructure(paramIdx, bindPoint, pTLAS);
+}
+
+void StateFilterCommandList::SetAccelerationStructures(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGTopLevelAS** pTLASes)
+{
+    InvalidateBindings();
+    m_pCommandList->SetAccelerationStructures(paramIdx, offset, count, pTLASes);
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Pipeline states
+///-------------------------------------------------------------------------------------------------
+void StateFilterCommandList::SetPipelineState(ISGPipelineState* pPipelineState)
+{
+    if (Update(FilteredState::PipelineState, m_pPipelineState, pPipelineState))
+    {
+        DropBindings();
+        m_pCommandList->SetPipelineState(pPipelineState);
+    }
+}
+
+void StateFilterCommandList::SetBlendState(ISGBlendState* pBlendState, SgU32 sampleMask)
+{
+    SgU32 const index = static_cast<SgU32>(FilteredState::BlendState);
+
+    if (m_StateKnown[index] && m_pBlendState == pBlendState && m_SampleMask == sampleMask)
+    {
+        ++m_Stats.FilteredStates[index];
+        return;
+    }
+
+    m_StateKnown[index] = true;
+    m_pBlendState = pBlendState;
+    m_SampleMask = sampleMask;
+    m_pCommandList->SetBlendState(pBlendState, sampleMask);
+}
+
+void StateFilterCommandList::SetDepthStencilState(ISGDepthStencilState* pDepthStencilState)
+{
+    if (Update(FilteredState::DepthStencilState, m_pDepthStencilState, pDepthStencilState))
+        m_pCommandList->SetDepthStencilState(pDepthStencilState);
+}
+
+void StateFilterCommandList::SetRasterizerState(ISGRasterizerState* pRasterizerState)
+{
+    if (Update(FilteredState::RasterizerState, m_pRasterizerState, pRasterizerState))
+        m_pCommandList->SetRasterizerState(pRasterizerState);
+}
+
+void StateFilterCommandList::SetViewports(SgU32 numViewports, SG_VIEWPORT const* pViewports)
+{
+    SgU32 const index = static_cast<SgU32>(FilteredState::Viewports);
+
+    if (m_StateKnown[index] && m_NumViewports == numViewports && memcmp(m_Viewports, pViewports, numViewports * sizeof(SG_VIEWPORT)) == 0)
+    {
+        ++m_Stats.FilteredStates[index];
+        return;
+    }
+
+    // More viewports than tracked are forwarded every time
+    m_StateKnown[index] = numViewports <= MaxViewports;
+    if (m_StateKnown[index])
+    {
+        m_NumViewports = numViewports;
+        memcpy(m_Viewports, pViewports, numViewports * sizeof(SG_VIEWPORT));
+    }
+
+    m_pCommandList->SetViewports(numViewports, pViewports);
+}
+
+void StateFilterCommandList::SetScissorRects(SgU32 numRects, SG_RECT const* pRects)
+{
+    SgU32 const index = static_cast<SgU32>(FilteredState::ScissorRects);
+
+    if (m_StateKnown[index] && m_NumScissorRects == numRects && memcmp(m_ScissorRects, pRects, numRects * sizeof(SG_RECT)) == 0)
+    {
+        ++m_Stats.FilteredStates[index];
+        return;
+    }
+
+    m_StateKnown[index] = numRects <= MaxViewports;
+    if (m_StateKnown[index])
+    {
+        m_NumScissorRects = numRects;
+        memcpy(m_ScissorRects, pRects, numRects * sizeof(SG_RECT));
+    }
+
+    m_pCommandList->SetScissorRects(numRects, pRects);
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Geometry
+///-------------------------------------------------------------------------------------------------
+void StateFilterCommandList::SetVertexBuffer(SgU32 slot, ISGBuffer* pVertexBuffer, SgU32 offset, SgU32 stride)
+{
+    if (slot < MaxVertexBuffers)
+    {
+        VertexBufferBinding& binding = m_VertexBuffers[slot];
+
+        if (m_VertexBufferKnown[slot] && binding.pBuffer == pVertexBuffer && binding.Offset == offset && binding.Stride == stride)
+        {
+            ++m_Stats.FilteredStates[static_cast<SgU32>(FilteredState::VertexBuffer)];
+            return;
+        }
+
+        m_VertexBufferKnown[slot] = true;
+        binding = { pVertexBuffer, offset, stride };
+    }
+
+    m_pCommandList->SetVertexBuffer(slot, pVertexBuffer, offset, stride);
+}
+
+void StateFilterCommandList::SetVertexBuffers(SgU32 startSlot, SgU32 numBuffers, ISGBuffer** ppVertexBuffers, SgU32* pOffsets, SgU32* pStrides)
+{
+    // Only the range between the first and the last changed slot is forwarded
+    SgU32 first = numBuffers;
+    SgU32 last = 0;
+
+    for (SgU32 i = 0; i < numBuffers; ++i)
+    {
+        SgU32 const slot = startSlot + i;
+        VertexBufferBinding const binding = { ppVertexBuffers[i], pOffsets[i], pStrides[i] };
+
+        if (slot < MaxVertexBuffers && m_VertexBufferKnown[slot] &&
+            m_VertexBuffers[slot].pBuffer == binding.pBuffer && m_VertexBuffers[slot].Offset == binding.Offset && m_VertexBuffers[slot].Stride == binding.Stride)
+        {
+            continue;
+        }
+
+        if (slot < MaxVertexBuffers)
+        {
+            m_VertexBufferKnown[slot] = true;
+            m_VertexBuffers[slot] = binding;
+        }
+
+        first = (std::min)(first, i);
+        last = i;
+    }
+
+    if (first == numBuffers)
+    {
+        ++m_Stats.FilteredStates[static_cast<SgU32>(FilteredState::VertexBuffer)];
+        return;
+    }
+
+    m_pCommandList->SetVertexBuffers(startSlot + first, last - first + 1, ppVertexBuffers + first, pOffsets + first, pStrides + first);
+}
+
+void StateFilterCommandList::SetIndexBuffer(ISGBuffer* pIndexBuffer, SgU32 offset, SG_FORMAT format)
+{
+    SgU32 const index = static_cast<SgU32>(FilteredState::IndexBuffer);
+
+    if (m_StateKnown[index] && m_pIndexBuffer == pIndexBuffer && m_IndexBufferOffset == offset && m_IndexFormat == format)
+    {
+        ++m_Stats.FilteredStates[index];
+        return;
+    }
+
+    m_StateKnown[index] = true;
+    m_pIndexBuffer = pIndexBuffer;
+    m_IndexBufferOffset = offset;
+    m_IndexFormat = format;
+    m_pCommandList->SetIndexBuffer(pIndexBuffer, offset, format);
+}
+
+void StateFilterCommandList::SetPrimitiveTopology(SG_PRIMITIVE_TOPOLOGY primitiveTopology)
+{
+    if (Update(FilteredState::PrimitiveTopology, m_PrimitiveTopology, primitiveTopology))
+        m_pCommandList->SetPrimitiveTopology(primitiveTopology);
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Commands which may change resource states
+///-------------------------------------------------------------------------------------------------
+void StateFilterCommandList::SetRenderTarget(SgU32 rtIndex, ISGRenderTargetView* pView)
+{
+    InvalidateBindings();
+    m_pCommandList->SetRenderTarget(rtIndex, pView);
+}
+
+void StateFilterCommandList::SetDepthStencil(ISGDepthStencilView* pView)
+{
+    InvalidateBindings();
+    m_pCommandList->SetDepthStencil(pView);
+}
+
+void StateFilterCommandList::ClearRenderTargetDefault(ISGRenderTargetView* pRTV)
+{
+    InvalidateBindings();
+    m_pCommandList->ClearRenderTargetDefault(pRTV);
+}
+
+void StateFilterCommandList::ClearRenderTarget(ISGRenderTargetView* pRTV, SG_COLOR_4F const* pColor)
+{
+    InvalidateBindings();
+    m_pCommandList->ClearRenderTarget(pRTV, pColor);
+}
+
+void StateFilterCommandList::ClearDepthStencilDefault(ISGDepthStencilView* pDSV, SG_CLEAR_FLAGS flags)
+{
+    InvalidateBindings();
+    m_pCommandList->ClearDepthStencilDefault(pDSV, flags);
+}
+
+void StateFilterCommandList::ClearDepthStencil(ISGDepthStencilView* pDSV, SG_CLEAR_FLAGS flags, float depthValue, SgU8 stencilValue)
+{
+    InvalidateBindings();
+    m_pCommandList->ClearDepthStencil(pDSV, flags, depthValue, stencilValue);
+}
+
+void StateFilterCommandList::ClearUnorderedAccessViewUint(ISGUnorderedAccessView* pUAV, const SgU32 values[4])
+{
+    InvalidateBindings();
+    m_pCommandList->ClearUnorderedAccessViewUint(pUAV, values);
+}
+
+void StateFilterCommandList::ClearUnorderedAccessViewFloat(ISGUnorderedAccessView* pUAV, const float values[4])
+{
+    InvalidateBindings();
+    m_pCommandList->ClearUnorderedAccessViewFloat(pUAV, values);
+}
+
+void StateFilterCommandList::CopyResource(ISGResource* pDstResource, ISGResource* pSrcResource)
+{
+    InvalidateBindings();
+    m_pCommandList->CopyResource(pDstResource, pSrcResource);
+}
+
+void StateFilterCommandList::CopySubresource(ISGSubresource* pDstSubresource, ISGSubresource* pSrcSubresource)
+{
+    InvalidateBindings();
+    m_pCommandList->CopySubresource(pDstSubresource, pSrcSubresource);
+}
+
+void StateFilterCommandList::ResolveSubresource(ISGSubresource* pDstSubresource, ISGSubresource* pSrcSubresource, SG_FORMAT format)
+{
+    InvalidateBindings();
+    m_pCommandList->ResolveSubresource(pDstSubresource, pSrcSubresource, format);
+}
+
+void StateFilterCommandList::CopyBufferRegion(ISGBuffer* pDstBuffer, SgU64 destOffset, ISGBuffer* pSrcBuffer, SgU64 srcOffset, SgU64 numBytes)
+{
+    InvalidateBindings();
+    m_pCommandList->CopyBufferRegion(pDstBuffer, destOffset, pSrcBuffer, srcOffset, numBytes);
+}
+
+void StateFilterCommandList::CopyTextureRegion(ISGTexture* pDstTexture, SG_TEXTURE_COPY_DESTINATION const* pDestRegion, ISGTexture* pSrcTexture, SG_TEXTURE_COPY_SOURCE const* pSrcRegion)
+{
+    InvalidateBindings();
+    m_pCommandList->CopyTextureRegion(pDstTexture, pDestRegion, pSrcTexture, pSrcRegion);
+}
+
+void StateFilterCommandList::BuildBottomLevelAS(ISGBottomLevelAS* pBLAS)
+{
+    InvalidateBindings();
+    m_pCommandList->BuildBottomLevelAS(pBLAS);
+}
+
+void StateFilterCommandList::BuildTopLevelAS(ISGTopLevelAS* pTLAS)
+{
+    InvalidateBindings();
+    m_pCommandList->BuildTopLevelAS(pTLAS);
+}
+
+///-------------------------------------------------------------------------------------------------
+/// Draws and dispatches write the pending bindings first
+///-------------------------------------------------------------------------------------------------
+void StateFilterCommandList::DrawInstanced(SgU32 vertexCount, SgU32 instanceCount, SgU32 startVertexLocation, SgU32 startInstanceLocation)
+{
+    FlushBindings();
+    m_pCommandList->DrawInstanced(vertexCount, instanceCount, startVertexLocation, startInstanceLocation);
+}
+
+void StateFilterCommandList::DrawIndexedInstanced(SgU32 indexCountPerInstance, SgU32 instanceCount, SgU32 startIndexLocation, int baseVertexLocation, SgU32 startInstanceLocation)
+{
+    FlushBindings();
+    m_pCommandList->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+}
+
+void StateFilterCommandList::DispatchMesh(SgU32 threadGroupCountX, SgU32 threadGroupCountY, SgU32 threadGroupCountZ)
+{
+    FlushBindings();
+    m_pCommandList->DispatchMesh(threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+}
+
+void StateFilterCommandList::Dispatch(SgU32 threadGroupCountX, SgU32 threadGroupCountY, SgU32 threadGroupCountZ)
+{
+    FlushBindings();
+    m_pCommandList->Dispatch(threadGroupCountX, threadGroupCountY, threadGroupCountZ);
+}
+
+void StateFilterCommandList::DrawInstancedIndirect(SgU32 maxCommandCount, ISGBuffer* pArgBuffer, SgU32 argBufferOffset)
+{
+    FlushBindings();
+    m_pCommandList->DrawInstancedIndirect(maxCommandCount, pArgBuffer, argBufferOffset);
+}
+
+void StateFilterCommandList::DrawIndexedInstancedIndirect(SgU32 maxCommandCount, ISGBuffer* pArgBuffer, SgU32 argBufferOffset)
+{
+    FlushBindings();
+    m_pCommandList->DrawIndexedInstancedIndirect(maxCommandCount, pArgBuffer, argBufferOffset);
+}
+
+void StateFilterCommandList::DispatchMeshIndirect(SgU32 maxCommandCount, ISGBuffer* pArgBuffer, SgU32 argBufferOffset)
+{
+    FlushBindings();
+    m_pCommandList->DispatchMeshIndirect(maxCommandCount, pArgBuffer, argBufferOffset);
+}
+
+void StateFilterCommandList::DispatchIndirect(SgU32 maxCommandCount, ISGBuffer* pArgBuffer, SgU32 argBufferOffset)
+{
+    FlushBindings();
+    m_pCommandList->DispatchIndirect(maxCommandCount, pArgBuffer, argBufferOffset);
+}
+
+void StateFilterCommandList::DispatchRays(SgU32 width, SgU32 height, SgU32 depth)
+{
+    FlushBindings();
+    m_pCommandList->DispatchRays(width, height, depth);
+}
@@ -0,0 +1,239 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <vector>
+#include <Include/SGLib.h>
+
+///-------------------------------------------------------------------------------------------------
+/// Redundant state filtering
+///
+/// StateFilterCommandList is an ISGCommandList that forwards commands to a scheduled command list
+/// and tracks the state bound to it. Pipeline, blend, rasterizer and depth stencil states,
+/// viewports, scissor rects, primitive topology, vertex and index buffers which are already bound
+/// are dropped. SetConstantBuffer(s) and SetShaderResource(s) only update a shadow copy of the
+/// parameter slots, the slots which differ from the bound ones are written by the next draw or
+/// dispatch with a single SetConstantBuffers/SetShaderResources call per contiguous range.
+///
+/// A pipeline change drops the bound tables together with the values set before it, since root
+/// parameters may change with it: constant buffers and shader resources must be set again after
+/// SetPipelineState. Commands which may move resources out of the read state that binding switched
+/// them to (copies, resolves, clears, render target, depth stencil, UAV and acceleration structure
+/// binding) drop the bound tables only, the next draw or dispatch writes the set slots again.
+/// Other commands are forwarded as is.
+///-------------------------------------------------------------------------------------------------
+
+enum class FilteredState : SgU32
+{
+    PipelineState,
+    BlendState,
+    RasterizerState,
+    DepthStencilState,
+    Viewports,
+    ScissorRects,
+    PrimitiveTopology,
+    VertexBuffer,
+    IndexBuffer,
+
+    Count
+};
+
+enum class FilteredTable : SgU32
+{
+    ConstantBuffers,
+    ShaderResources,
+
+    Count
+};
+
+struct StateFilterStats
+{
+    SgU32   FilteredStates[static_cast<SgU32>(FilteredState::Count)];
+
+    // SetConstantBuffers/SetShaderResources calls and slots written by flushes
+    SgU32   FlushedRanges;
+    SgU32   FlushedSlots;
+};
+
+// Calls to a parameter slot, filtered ones didn't lead to a write of the slot
+struct StateFilterSlotStats
+{
+    SgU32   Calls;
+    SgU32   Filtered;
+};
+
+class StateFilterCommandList : public ISGCommandList
+{
+public:
+    StateFilterCommandList();
+
+    // Starts forwarding to the command list, nothing is known to be bound to it
+    void Begin(ISGCommandList* pCommandList);
+
+    // Stops forwarding, bindings set after the last draw or dispatch are discarded
+    void End();
+
+    // Forgets the bound state, must be called if the command list was used directly
+    void Invalidate();
+
+    ISGCommandList* GetCommandList() const { return m_pCommandList; }
+
+    // Statistics are accumulated across Begin/End until reset
+    StateFilterStats const& GetStats() const { return m_Stats; }
+    StateFilterSlotStats GetSlotStats(FilteredTable table, SgU32 paramIdx, SgU32 bindPoint) const;
+    void ResetStats();
+
+    // ISGObject, references are counted by the forwarded command list
+    SgU32 SG_CALL AddRef() override { return m_pCommandList->AddRef(); }
+    SgU32 SG_CALL Release() override { return m_pCommandList->Release(); }
+
+    SG_QUEUE_TYPE SG_CALL GetType() override { return m_pCommandList->GetType(); }
+
+    // Markers
+    void SG_CALL BeginEvent(SG_COLOR_3I color, char const* pEventName) override { m_pCommandList->BeginEvent(color, pEventName); }
+    void SG_CALL EndEvent() override { m_pCommandList->EndEvent(); }
+
+    // Queries
+    void SG_CALL BeginQuery(ISGQuery* pQuery) override { m_pCommandList->BeginQuery(pQuery); }
+    void SG_CALL EndQuery(ISGQuery* pQuery) override { m_pCommandList->EndQuery(pQuery); }
+    void SG_CALL TimeStamp(ISGQuery* pQuery) override { m_pCommandList->TimeStamp(pQuery); }
+    void SG_CALL SetPredication(ISGPredicate* pPredicate, SG_PREDICATION_OP predication) override { m_pCommandList->SetPredication(pPredicate, predication); }
+
+    // Render Target and Depth Stencil
+    void SG_CALL SetRenderTarget(SgU32 rtIndex, ISGRenderTargetView* pView) override;
+    void SG_CALL SetDepthStencil(ISGDepthStencilView* pView) override;
+    void SG_CALL ClearRenderTargetDefault(ISGRenderTargetView* pRTV) override;
+    void SG_CALL ClearRenderTarget(ISGRenderTargetView* pRTV, SG_COLOR_4F const* pColor) override;
+    void SG_CALL ClearDepthStencilDefault(ISGDepthStencilView* pDSV, SG_CLEAR_FLAGS flags) override;
+    void SG_CALL ClearDepthStencil(ISGDepthStencilView* pDSV, SG_CLEAR_FLAGS flags, float depthValue, SgU8 stencilValue) override;
+    void SG_CALL ClearUnorderedAccessViewUint(ISGUnorderedAccessView* pUAV, const SgU32 values[4]) override;
+    void SG_CALL ClearUnorderedAccessViewFloat(ISGUnorderedAccessView* pUAV, const float values[4]) override;
+    void SG_CALL SetStencilRef(SgU8 stencilRef) override { m_pCommandList->SetStencilRef(stencilRef); }
+    void SG_CALL SetViewports(SgU32 numViewports, SG_VIEWPORT const* pViewports) override;
+    void SG_CALL SetScissorRects(SgU32 numRects, SG_RECT const* pRects) override;
+
+    // Pipeline State
+    void SG_CALL SetPipelineState(ISGPipelineState* pPipelineState) override;
+    void SG_CALL SetInputLayout(ISGInputLayout* pInputLayout) override { m_pCommandList->SetInputLayout(pInputLayout); }
+    void SG_CALL SetShadingRate(SG_SHADING_RATE baseShadingRate, SG_SHADING_RATE_COMBINER const* pCombiners) override { m_pCommandList->SetShadingRate(baseShadingRate, pCombiners); }
+    void SG_CALL SetShadingRateImage(ISGTexture* pImage) override { m_pCommandList->SetShadingRateImage(pImage); }
+    void SG_CALL SetBlendState(ISGBlendState* pBlendState, SgU32 sampleMask) override;
+    void SG_CALL SetBlendFactor(SG_COLOR_4F blendFactor) override { m_pCommandList->SetBlendFactor(blendFactor); }
+    void SG_CALL SetDepthStencilState(ISGDepthStencilState* pDepthStencilState) override;
+    void SG_CALL SetRasterizerState(ISGRasterizerState* pRasterizerState) override;
+
+    // Binding
+    void SG_CALL SetConstantBuffer(SgU32 paramIdx, SgU32 bindPoint, ISGResource* pBuffer) override;
+    void SG_CALL SetConstantBuffers(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGResource** ppBuffers) override;
+    void SG_CALL SetShaderResource(SgU32 paramIdx, SgU32 bindPoint, ISGShaderResourceView* pView) override;
+    void SG_CALL SetShaderResources(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGShaderResourceView** ppViews) override;
+    void SG_CALL SetUnorderedAccessView(SgU32 paramIdx, SgU32 bindPoint, ISGUnorderedAccessView* pView) override;
+    void SG_CALL SetUnorderedAccessViews(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGUnorderedAccessView** ppViews) override;
+    void SG_CALL SetAccelerationStructure(SgU32 paramIdx, SgU32 bindPoint, ISGTopLevelAS* pTLAS) override;
+    void SG_CALL SetAccelerationStructures(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGTopLevelAS** pTLASes) override;
+    void SG_CALL SetSampler(SgU32 paramIdx, SgU32 bindPoint, ISGSampler* pState) override { m_pCommandList->SetSampler(paramIdx, bindPoint, pState); }
+    void SG_CALL SetSamplers(SgU32 paramIdx, SgU32 offset, SgU32 count, ISGSampler** ppStates) override { m_pCommandList->SetSamplers(paramIdx, offset, count, ppStates); }
+
+    // Geometry
+    void SG_CALL SetVertexBuffer(SgU32 slot, ISGBuffer* pVertexBuffer, SgU32 offset, SgU32 stride) override;
+    void SG_CALL SetVertexBuffers(SgU32 startSlot, SgU32 numBuffers, ISGBuffer** ppVertexBuffers, SgU32* pOffsets, SgU32* pStrides) override;
+    void SG_CALL SetIndexBuffer(ISGBuffer* pIndexBuffer, SgU32 offset, SG_FORMAT format) override;
+    void SG_CALL SetPrimitiveTopology(SG_PRIMITIVE_TOPOLOGY primitiveTopology) override;
+
+    // Graphics context
+    void SG_CALL DrawInstanced(SgU32 vertexCount, SgU32 instanceCount, SgU32 startVertexLocation, SgU32 startInstanceLocation) override;
+    void SG_CALL DrawIndexedInstanced(SgU32 indexCountPerInstance, SgU32 instanceCount, SgU32 startIndexLocation, int baseVertexLocation, SgU32 startInstanceLocation) override;
+    void SG_CALL DispatchMesh(SgU32 threadGroupCountX, SgU32 threadGroupCountY, SgU32 threadGroupCountZ) override;
+
+    // Compute context
+    void SG_CALL Dispatch(SgU32 threadGroupCountX, SgU32 threadGroupCountY, SgU32 threadGroupCountZ) override;
+
+    // Indirect calls
+    void SG_CALL DrawInstancedIndirect(SgU32 maxCommandCount, ISGBuffer* pArgBuffer, SgU32 argBufferOffset) override;
+    void SG_CALL DrawIndexedInstancedIndirect(SgU32 maxCommandCount, ISGBuffer* pArgBuffer, SgU32 argBufferOffset) override;
+    void SG_CALL DispatchMeshIndirect(SgU32 maxCommandCount, ISGBuffer* pArgBuffer, SgU32 argBufferOffset) override;
+    void SG_CALL DispatchIndirect(SgU32 maxCommandCount, ISGBuffer* pArgBuffer, SgU32 argBufferOffset) override;
+
+    // Copy context
+    void SG_CALL CopyResource(ISGResource* pDstResource, ISGResource* pSrcResource) override;
+    void SG_CALL CopySubresource(ISGSubresource* pDstSubresource, ISGSubresource* pSrcSubresource) override;
+    void SG_CALL ResolveSubresource(ISGSubresource* pDstSubresource, ISGSubresource* pSrcSubresource, SG_FORMAT format) override;
+    void SG_CALL CopyBufferRegion(ISGBuffer* pDstBuffer, SgU64 destOffset, ISGBuffer* pSrcBuffer, SgU64 srcOffset, SgU64 numBytes) override;
+    void SG_CALL CopyTextureRegion(ISGTexture* pDstTexture, SG_TEXTURE_COPY_DESTINATION const* pDestRegion, ISGTexture* pSrcTexture, SG_TEXTURE_COPY_SOURCE const* pSrcRegion) override;
+
+    // Ray tracing
+    void SG_CALL BuildBottomLevelAS(ISGBottomLevelAS* pBLAS) override;
+    void SG_CALL BuildTopLevelAS(ISGTopLevelAS* pTLAS) override;
+    void SG_CALL DispatchRays(SgU32 width, SgU32 height, SgU32 depth) override;
+
+private:
+    static const SgU32 MaxViewports = 16;
+    static const SgU32 MaxVertexBuffers = 32;
+    static const SgU32 MaxFlushRange = 64;
+
+    struct BindingSlot
+    {
+        void*   pPending;
+        void*   pBound;
+        bool    Set;        // Pending value was set since Begin
+        bool    Known;      // Bound value is the one the command list has
+        SgU32   PendingCalls;
+        StateFilterSlotStats Stats;
+    };
+
+    struct BindingTable
+    {
+        std::vector<BindingSlot> Slots;
+        bool    Dirty;
+    };
+
+    struct VertexBufferBinding
+    {
+        ISGBuffer*  pBuffer;
+        SgU32       Offset;
+        SgU32       Stride;
+    };
+
+    // Returns true if the state differs and stores it, counts a filtered call otherwise
+    template <typename T>
+    bool Update(FilteredState state, T& current, T const& value);
+
+    BindingSlot& GetSlot(FilteredTable table, SgU32 paramIdx, SgU32 bindPoint);
+    void SetBinding(FilteredTable table, SgU32 paramIdx, SgU32 bindPoint, void* pValue);
+    void InvalidateBindings();
+    void DropBindings();
+    void FlushBindings();
+
+    ISGCommandList*         m_pCommandList;
+    StateFilterStats        m_Stats;
+
+    // Known is cleared for all of the states by Begin and Invalidate
+    bool                    m_StateKnown[static_cast<SgU32>(FilteredState::Count)];
+    ISGPipelineState*       m_pPipelineState;
+    ISGBlendState*          m_pBlendState;
+    SgU32                   m_SampleMask;
+    ISGRasterizerState*     m_pRasterizerState;
+    ISGDepthStencilState*   m_pDepthStencilState;
+    SgU32                   m_NumViewports;
+    SG_VIEWPORT             m_Viewports[MaxViewports];
+    SgU32                   m_NumScissorRects;
+    SG_RECT                 m_ScissorRects[MaxViewports];
+    SG_PRIMITIVE_TOPOLOGY   m_PrimitiveTopology;
+    VertexBufferBinding     m_VertexBuffers[MaxVertexBuffers];
+    bool                    m_VertexBufferKnown[MaxVertexBuffers];
+    ISGBuffer*              m_pIndexBuffer;
+    SgU32                   m_IndexBufferOffset;
+    SG_FORMAT               m_IndexFormat;
+
+    std::vector<BindingTable> m_Tables[static_cast<SgU32>(FilteredTable::Count)];
+    bool                    m_BindingsDirty;
+};
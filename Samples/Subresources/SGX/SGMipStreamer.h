@@ -0,0 +1,150 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "SGHelpers.h"
+
+///-------------------------------------------------------------------------------------------------
+/// Mip streaming
+///
+/// Large 2D textures are registered with the desc of their full mip chain and a function loading
+/// any mip, but only the mips requested by feedback are committed. A texture starts with the mip
+/// tail, the mips not larger than the tail size, which stays resident. Shaders report the most
+/// detailed mip of the full chain they need into a feedback buffer, which is read back and handed
+/// to the streamer:
+///
+///     // residentMip = GetResidentMip(handle), passed with the constants of the draw
+///     float lod = Texture.CalculateLevelOfDetailUnclamped(Sampler, uv) + residentMip;
+///     InterlockedMin(Feedback[textureHandle], (uint)max(lod, 0.0f));
+///
+///     streamer.ProcessFeedback(pReadbackData, textureCount);
+///     streamer.Update(pCommandList);                  // Streams finer mips within the byte budget
+///
+/// SGLib has no reserved resources, so a texture is recreated with the resident mips only whenever
+/// they change: retained mips are copied on the GPU, new ones are uploaded. Mip 0 of the texture
+/// is the most detailed resident mip, so the level of detail the hardware picks falls on the
+/// right mip without any bias. The same level of detail is relative to the resident mip, which is
+/// why the shader adds it, and it must be unclamped: the clamped one never goes below mip 0 of the
+/// texture, so finer mips would never be requested. Mips which aren't requested for several
+/// frames are dropped.
+///-------------------------------------------------------------------------------------------------
+
+typedef U32 StreamedTextureHandle;
+
+struct MipStreamerStats
+{
+    U32     Textures;
+
+    // Committed mips and what the full mip chains would take
+    U64     ResidentBytes;
+    U64     FullChainBytes;
+
+    // Requested mips still waiting for the upload budget
+    U32     PendingMips;
+
+    // Of the last Update
+    U32     StreamedMips;
+    U64     StreamedBytes;
+    U32     DroppedMips;
+};
+
+class MipStreamer
+{
+public:
+    // Fills mip of the full chain, rows are laid out with the pitch of the mapped subresource
+    typedef std::function<void(U32 mip, SG_MAPPED_SUBRESOURCE const& dest)> MipLoader;
+
+    static const U32 DefaultTailSize = 256;
+    static const U32 DefaultDropFrames = 30;
+
+    MipStreamer();
+    ~MipStreamer();
+
+    MipStreamer(MipStreamer const&) = delete;
+    MipStreamer& operator=(MipStreamer const&) = delete;
+
+    // frameBuffers must match the execution context. Update uploads up to uploadBudget bytes,
+    // at least one mip. Mips unrequested for dropFrames frames are dropped.
+    void            Init(ISGDevice* pDevice, U32 frameBuffers, U64 uploadBudget,
+                        U32 tailSize = DefaultTailSize, U32 dropFrames = DefaultDropFrames);
+
+    // Execution context must be idle
+    void            Destroy();
+
+    // Desc of a 2D texture with its full mip chain. The mip tail is loaded by the next Update. Thread-safe.
+    StreamedTextureHandle Register(SG_TEXTURE_DESC const& desc, MipLoader loader);
+
+    // The texture must not be used by frames in flight. Thread-safe.
+    void            Unregister(StreamedTextureHandle handle);
+
+    // Mip of the full chain. Requests of a frame are merged, the most detailed one wins. Thread-safe.
+    void            RequestMip(StreamedTextureHandle handle, U32 mip);
+
+    // Requests pFeedback[handle] for every registered handle below count, ~0u means not sampled.
+    // Values are mips of the full chain, not of the texture sampled by the shader.
+    void            ProcessFeedback(U32 const* pFeedback, U32 count);
+
+    // Call after ISGExecutionContext::BeginFrame. Recreates textures whose resident mips change
+    // and records the copies, the list must run before the lists sampling them. Loaders are
+    // called under the streamer's lock.
+    void            Update(ISGCommandList* pCommandList);
+
+    // Change when Update recreates the texture, null until the mip tail is loaded
+    ISGTexture*             GetTexture(StreamedTextureHandle handle) const;
+    ISGShaderResourceView*  GetView(StreamedTextureHandle handle) const;
+
+    // Mip of the full chain which is mip 0 of the texture
+    U32             GetResidentMip(StreamedTextureHandle handle) const;
+
+    MipStreamerStats GetStats() const;
+
+private:
+    struct Texture
+    {
+        SG_TEXTURE_DESC         Desc;
+        MipLoader               Loader;
+        ISGTexture*             pTexture;
+        ISGShaderResourceView*  pView;
+        U32                     ResidentMip;        // Desc.MipLevels if nothing is resident
+        U32                     TailMip;
+        U32                     RequestedMip;       // Of the current frame, ~0u if not requested
+        U64                     LastNeededFrame;
+        bool                    Registered;
+    };
+
+    struct Retired
+    {
+        ISGObject*  pObject;
+        U64         FrameNumber;
+    };
+
+    void        Resize(Texture& texture, U32 residentMip, ISGCommandList* pCommandList);
+    void        Retire(ISGObject* pObject);
+
+    static U64  GetMipBytes(SG_TEXTURE_DESC const& desc, U32 mip);
+
+    mutable std::mutex      m_Mutex;
+    ISGDevice*              m_pDevice;
+    U32                     m_FrameBuffers;
+    U64                     m_UploadBudget;
+    U32                     m_TailSize;
+    U32                     m_DropFrames;
+    U64                     m_FrameNumber;
+
+    std::vector<Texture>    m_Textures;
+    std::vector<U32>        m_FreeHandles;
+    std::vector<Retired>    m_Retired;
+    MipStreamerStats        m_Stats;
+};
@@ -0,0 +1,162 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <vector>
+#include <Include/SGLib.h>
+
+///-------------------------------------------------------------------------------------------------
+/// Null back-end
+///
+/// Headless implementation of the SGLib interfaces that doesn't need any GPU.
+/// Every ISGCommandList call is recorded into an in-memory command stream, upload and readback
+/// resources are backed by host memory. It's intended for measuring and regression testing of
+/// the CPU side of an application (frame scheduling, state setup, binding) on build machines.
+/// It depends on SGLib headers only and builds on any platform.
+///-------------------------------------------------------------------------------------------------
+
+enum class NullCommandType : SgU16
+{
+    BeginEvent,
+    EndEvent,
+    BeginQuery,
+    EndQuery,
+    TimeStamp,
+    SetPredication,
+    SetRenderTarget,
+    SetDepthStencil,
+    ClearRenderTargetDefault,
+    ClearRenderTarget,
+    ClearDepthStencilDefault,
+    ClearDepthStencil,
+    ClearUnorderedAccessViewUint,
+    ClearUnorderedAccessViewFloat,
+    SetStencilRef,
+    SetViewports,
+    SetScissorRects,
+    SetPipelineState,
+    SetInputLayout,
+    SetShadingRate,
+    SetShadingRateImage,
+    SetBlendState,
+    SetBlendFactor,
+    SetDepthStencilState,
+    SetRasterizerState,
+    SetConstantBuffer,
+    SetConstantBuffers,
+    SetShaderResource,
+    SetShaderResources,
+    SetUnorderedAccessView,
+    SetUnorderedAccessViews,
+    SetAccelerationStructure,
+    SetAccelerationStructures,
+    SetSampler,
+    SetSamplers,
+    SetVertexBuffer,
+    SetVertexBuffers,
+    SetIndexBuffer,
+    SetPrimitiveTopology,
+    DrawInstanced,
+    DrawIndexedInstanced,
+    DispatchMesh,
+    Dispatch,
+    DrawInstancedIndirect,
+    DrawIndexedInstancedIndirect,
+    DispatchMeshIndirect,
+    DispatchIndirect,
+    CopyResource,
+    CopySubresource,
+    ResolveSubresource,
+    CopyBufferRegion,
+    CopyTextureRegion,
+    BuildBottomLevelAS,
+    BuildTopLevelAS,
+    DispatchRays,
+
+    Count
+};
+
+// A recorded command: header followed by ArgCount 64-bit arguments (in the order of the
+// ISGCommandList method parameters) and DataSize bytes of inline data (arrays, colors, regions).
+struct NullCommand
+{
+    NullCommandType Type;
+    SgU16           ArgCount;
+    SgU32           DataSize;
+
+    SgU64 const*    GetArgs() const { return reinterpret_cast<SgU64 const*>(this + 1); }
+    void const*     GetData() const { return GetArgs() + ArgCount; }
+
+    template <typename T>
+    T               GetArg(SgU32 index) const { return (T)GetArgs()[index]; }
+};
+
+static_assert(sizeof(NullCommand) == sizeof(SgU64), "Command header must keep 8-byte alignment of arguments");
+
+class NullCommandStream
+{
+public:
+    NullCommandStream();
+
+    void                Reset();
+
+    // Returns the command with uninitialized arguments and data, valid until the next call
+    NullCommand*        Allocate(NullCommandType type, SgU32 argCount, SgU32 dataSize);
+
+    // Iteration, Next returns nullptr after the last command
+    NullCommand const*  First() const;
+    NullCommand const*  Next(NullCommand const* pCommand) const;
+
+    SgU32               GetCommandCount() const { return m_CommandCount; }
+    size_t              GetSizeBytes() const { return m_Words.size() * sizeof(SgU64); }
+
+private:
+    std::vector<SgU64>  m_Words;
+    SgU32               m_CommandCount;
+};
+
+struct NullScheduledList
+{
+    SgU8                        QueueIndex;
+    SgU16                       TimeIndex;
+    NullCommandStream const*    pStream;
+};
+
+struct NullFrameStats
+{
+    SgU64   FrameNumber;
+    SgU32   CommandLists;
+    SgU32   Commands;
+    SgU64   StreamBytes;
+    SgU32   CommandCounts[static_cast<SgU32>(NullCommandType::Count)];
+};
+
+struct NullFrameRecord
+{
+    NullFrameStats                  Stats;
+
+    // Command lists of the frame in the execution order (by time index, then by queue index)
+    std::vector<NullScheduledList>  Lists;
+};
+
+// Counterparts of SgEnumAdapters, SgCreateDevice and SgCreateSwapChain.
+// SGLibInitialize is not required for the null back-end.
+SG_RESULT CreateNullAdapter(ISGAdapter** ppAdapter);
+SG_RESULT CreateNullDevice(ISGAdapter* pAdapter, SG_DEVICE_DESC const* pDesc, ISGDevice** ppDevice);
+SG_RESULT CreateNullSwapChain(ISGExecutionContext* pExecutionContext, SgU8 queueIndex, SG_SWAP_CHAIN_DESC const* pDesc, ISGSwapChain** ppSwapChain);
+
+// Returns true if the object was created by the null back-end
+bool IsNullDevice(ISGDevice* pDevice);
+
+// Gets the record of the last ended frame. Command streams referenced by the record stay valid
+// until the frame buffer they belong to is reused by ISGExecutionContext::BeginFrame.
+SG_RESULT GetNullFrameRecord(ISGExecutionContext* pExecutionContext, NullFrameRecord const** ppRecord);
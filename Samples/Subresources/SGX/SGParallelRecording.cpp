@@ -0,0 +1,89 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGParallelRecording.h"
+
+namespace
+{
+    const SgU32 c_MaxTimeIndex = 65520;
+}
+
+SG_RESULT ScheduleCommandListGroup(ISGExecutionContext* pExecCtx, SgU8 queueIndex, SgU16 timeIndex, SgU16 numLists, ISGCommandList** ppOutCommandLists)
+{
+    if (pExecCtx == SG_NULL || ppOutCommandLists == SG_NULL || numLists == 0)
+        return SG_ERROR_INVALID_ARG;
+
+    if (timeIndex == 0 || SgU32(timeIndex) + numLists - 1 > c_MaxTimeIndex)
+        return SG_ERROR_INVALID_TIME_INDEX;
+
+    for (SgU16 i = 0; i < numLists; i++)
+    {
+        SG_RESULT result = pExecCtx->ScheduleCommandList(queueIndex, timeIndex + i, &ppOutCommandLists[i]);
+        if (result != SG_OK)
+        {
+            // Already scheduled lists are returned to the pool empty
+            FinishCommandListGroup(pExecCtx, i, ppOutCommandLists);
+            return result;
+        }
+    }
+
+    return SG_OK;
+}
+
+SG_RESULT FinishCommandListGroup(ISGExecutionContext* pExecCtx, SgU16 numLists, ISGCommandList** ppCommandLists)
+{
+    SG_RESULT firstError = SG_OK;
+
+    for (SgU16 i = 0; i < numLists; i++)
+    {
+        SG_RESULT result = pExecCtx->FinishCommandList(ppCommandLists[i]);
+        if (result != SG_OK && firstError == SG_OK)
+            firstError = result;
+
+        ppCommandLists[i] = SG_NULL;
+    }
+
+    return firstError;
+}
+
+SgU16 RecordCommandListGroup(ISGExecutionContext* pExecCtx, ThreadPool& threadPool, SgU8 queueIndex, SgU16 timeIndex, SgU16 numLists,
+    CommandListRecordFunc const& prologue, CommandListRecordFunc const& record)
+{
+    std::vector<ISGCommandList*> commandLists(numLists, SG_NULL);
+
+    if (ScheduleCommandListGroup(pExecCtx, queueIndex, timeIndex, numLists, commandLists.data()) != SG_OK)
+        return 0;
+
+    threadPool.ParallelFor(numLists, [&](SgU32 listIndex)
+    {
+        ISGCommandList* pCommandList = commandLists[listIndex];
+
+        if (prologue)
+            prologue(pCommandList, listIndex);
+
+        record(pCommandList, listIndex);
+    });
+
+    if (FinishCommandListGroup(pExecCtx, numLists, commandLists.data()) != SG_OK)
+        return 0;
+
+    // 65521 can't be scheduled, ScheduleCommandList rejects it as an invalid time index
+    return static_cast<SgU16>(timeIndex + numLists);
+}
+
+void GetCommandListGroupRange(SgU32 itemCount, SgU32 numLists, SgU32 listIndex, SgU32* pOutFirst, SgU32* pOutCount)
+{
+    SgU32 const baseCount = itemCount / numLists;
+    SgU32 const remainder = itemCount % numLists;
+
+    *pOutFirst = listIndex * baseCount + (listIndex < remainder ? listIndex : remainder);
+    *pOutCount = baseCount + (listIndex < remainder ? 1 : 0);
+}
@@ -0,0 +1,222 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGResidency.h"
+#include <algorithm>
+
+ResidencyManager::ResidencyManager()
+    : m_pDevice(nullptr)
+    , m_FrameBuffers(1)
+    , m_TargetUsage(1.0f)
+    , m_EvictionMargin(0.0f)
+    , m_MinIdleFrames(1)
+    , m_FrameNumber(0)
+    , m_Stats{}
+{
+}
+
+ResidencyManager::~ResidencyManager()
+{
+    Destroy();
+}
+
+void ResidencyManager::Init(ISGDevice* pDevice, U32 frameBuffers, float targetUsage, float evictionMargin, U32 minIdleFrames)
+{
+    Destroy();
+
+    m_pDevice = pDevice;
+    m_FrameBuffers = (std::max)(frameBuffers, 1u);
+    m_TargetUsage = targetUsage;
+    m_EvictionMargin = (std::min)((std::max)(evictionMargin, 0.0f), targetUsage);
+    m_MinIdleFrames = (std::max)(minIdleFrames, m_FrameBuffers);
+}
+
+void ResidencyManager::Destroy()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_Resources.clear();
+    m_FreeHandles.clear();
+    m_pDevice = nullptr;
+    m_FrameNumber = 0;
+    m_Stats = {};
+}
+
+ResidencyHandle ResidencyManager::Register(U64 sizeBytes, ResidencyPriority priority, ResidencyFunction restore, ResidencyFunction evict)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    ResidencyHandle handle;
+    if (!m_FreeHandles.empty())
+    {
+        handle = m_FreeHandles.back();
+        m_FreeHandles.pop_back();
+    }
+    else
+    {
+        handle = static_cast<ResidencyHandle>(m_Resources.size());
+        m_Resources.emplace_back();
+    }
+
+    Resource& resource = m_Resources[handle];
+    resource.SizeBytes = sizeBytes;
+    resource.Priority = priority;
+    resource.Restore = std::move(restore);
+    resource.Evict = std::move(evict);
+    resource.LastUsedFrame = m_FrameNumber;
+    resource.Registered = true;
+    resource.Resident = true;
+
+    resource.Restore();
+
+    m_Stats.Resources++;
+    m_Stats.ResidentResources++;
+    m_Stats.ResidentBytes += sizeBytes;
+
+    return handle;
+}
+
+void ResidencyManager::Unregister(ResidencyHandle handle)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (handle >= m_Resources.size() || !m_Resources[handle].Registered)
+        return;
+
+    Resource& resource = m_Resources[handle];
+
+    if (resource.Resident)
+    {
+        resource.Evict();
+
+        m_Stats.ResidentResources--;
+        m_Stats.ResidentBytes -= resource.SizeBytes;
+    }
+
+    m_Stats.Resources--;
+
+    resource = {};
+    m_FreeHandles.push_back(handle);
+}
+
+bool ResidencyManager::MakeResident(ResidencyHandle handle)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (handle >= m_Resources.size() || !m_Resources[handle].Registered)
+        throw std::exception("Residency handle isn't registered");
+
+    Resource& resource = m_Resources[handle];
+    resource.LastUsedFrame = m_FrameNumber;
+
+    if (resource.Resident)
+        return true;
+
+    resource.Restore();
+    resource.Resident = true;
+
+    m_Stats.ResidentResources++;
+    m_Stats.ResidentBytes += resource.SizeBytes;
+    m_Stats.Restores++;
+    m_Stats.RestoredBytes += resource.SizeBytes;
+
+    return false;
+}
+
+bool ResidencyManager::IsResident(ResidencyHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return handle < m_Resources.size() && m_Resources[handle].Resident;
+}
+
+void ResidencyManager::BeginFrame()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_FrameNumber++;
+
+    SG_MEMORY_USAGE usage = {};
+    if (m_pDevice->GetMemoryUsage(SG_MEMORY_SEGMENT_GROUP_LOCAL, &usage) != SG_OK)
+        return;
+
+    m_Stats.Budget = usage.Budget;
+    m_Stats.UsedMemory = usage.UsedMemory;
+
+    U64 const threshold = static_cast<U64>(static_cast<double>(usage.Budget) * m_TargetUsage);
+    if (usage.UsedMemory <= threshold)
+        return;
+
+    // Evicting below the threshold leaves room for the restores of the next frames
+    U64 const target = static_cast<U64>(static_cast<double>(usage.Budget) * (m_TargetUsage - m_EvictionMargin));
+
+    // The frame buffer of a resource's last frame has been waited by ISGExecutionContext::BeginFrame,
+    // m_MinIdleFrames is at least the number of frame buffers
+    std::vector<U32> candidates;
+    for (U32 i = 0; i < m_Resources.size(); i++)
+    {
+        Resource const& resource = m_Resources[i];
+
+        if (resource.Resident && m_FrameNumber - resource.LastUsedFrame >= m_MinIdleFrames)
+            candidates.push_back(i);
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(), [&](U32 a, U32 b)
+    {
+        Resource const& ra = m_Resources[a];
+        Resource const& rb = m_Resources[b];
+
+        if (ra.Priority != rb.Priority)
+            return ra.Priority < rb.Priority;
+
+        return ra.LastUsedFrame < rb.LastUsedFrame;
+    });
+
+    // Released memory may be reported later, the evicted bytes are subtracted from the usage instead
+    U64 excess = usage.UsedMemory - target;
+
+    for (U32 index : candidates)
+    {
+        if (excess == 0)
+            break;
+
+        Resource& resource = m_Resources[index];
+        resource.Evict();
+        resource.Resident = false;
+
+        excess -= (std::min)(excess, resource.SizeBytes);
+
+        m_Stats.ResidentResources--;
+        m_Stats.ResidentBytes -= resource.SizeBytes;
+        m_Stats.Evictions++;
+        m_Stats.EvictedBytes += resource.SizeBytes;
+    }
+
+    // Falling short of the margin is fine as long as the usage is back under the threshold
+    if (excess > threshold - target)
+        m_Stats.OverBudgetFrames++;
+}
+
+ResidencyStats ResidencyManager::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
+
+void ResidencyManager::ResetStats()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_Stats.Evictions = 0;
+    m_Stats.EvictedBytes = 0;
+    m_Stats.Restores = 0;
+    m_Stats.RestoredBytes = 0;
+    m_Stats.OverBudgetFrames = 0;
+}
@@ -34,14 +34,23 @@ public:
 
     int             Run(int nCmdShow, SG_DEBUG_LEVELS debugLevel, SG_DEBUG_TOOLS debugTools);
 
+    // Renders frameCount frames on the null back-end without a window and prints the commands
+    // recorded by every frame. Returns non-zero if a frame scheduled no command lists.
+    int             RunHeadless(U32 frameCount);
+
     U32             GetWidth() const { return m_Width; }
     U32             GetHeight() const { return m_Height; }
     wchar_t const*  GetName() const { return m_Name.c_str(); }
 
 protected:
+    // Pick the null back-end in headless runs
     SG_RESULT       GetVideoAdapter(ISGAdapter** ppAdapter);
+    SG_RESULT       CreateDevice(ISGAdapter* pAdapter, SG_DEVICE_DESC const* pDesc, ISGDevice** ppDevice);
+    SG_RESULT       CreateSwapChain(ISGExecutionContext* pExecutionContext, SgU8 queueIndex, SG_SWAP_CHAIN_DESC const* pDesc, ISGSwapChain** ppSwapChain);
 
 protected:
+    bool            m_Headless;
+    ISGDevice*      m_pHeadlessDevice;  // Not referenced, set by CreateDevice
     HWND            m_hWnd;
     U32             m_Width;
     U32             m_Height;
@@ -0,0 +1,295 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#include "SGTransientPool.h"
+#include <algorithm>
+#include <cstring>
+
+TransientPool::TransientPool()
+    : m_pDevice(nullptr)
+    , m_RetireFrames(DefaultRetireFrames)
+    , m_FrameNumber(0)
+    , m_Stats{}
+{
+}
+
+TransientPool::~TransientPool()
+{
+    Destroy();
+}
+
+void TransientPool::Init(ISGDevice* pDevice, U32 retireFrames)
+{
+    Destroy();
+
+    m_pDevice = pDevice;
+    m_RetireFrames = retireFrames;
+}
+
+void TransientPool::Destroy()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (auto& pEntry : m_Entries)
+        ReleaseEntry(*pEntry);
+
+    m_Entries.clear();
+    m_pDevice = nullptr;
+    m_FrameNumber = 0;
+    m_Stats = {};
+}
+
+void TransientPool::BeginFrame()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_FrameNumber++;
+
+    TransientPoolStats const pooled = m_Stats;
+    m_Stats = {};
+    m_Stats.PooledResources = pooled.PooledResources;
+    m_Stats.PooledBytes = pooled.PooledBytes;
+
+    for (auto it = m_Entries.begin(); it != m_Entries.end();)
+    {
+        Entry& entry = **it;
+        entry.Lifetimes.clear();
+
+        if (m_FrameNumber - entry.LastFrame > m_RetireFrames)
+        {
+            m_Stats.Released++;
+            m_Stats.PooledResources--;
+            m_Stats.PooledBytes -= entry.SizeBytes;
+
+            ReleaseEntry(entry);
+            it = m_Entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+ISGTexture* TransientPool::AcquireTexture(SG_TEXTURE_DESC const& desc, SgU16 firstTimeIndex, SgU16 lastTimeIndex)
+{
+    return static_cast<ISGTexture*>(Acquire(true, &desc, firstTimeIndex, lastTimeIndex)->pResource);
+}
+
+ISGBuffer* TransientPool::AcquireBuffer(SG_BUFFER_DESC const& desc, SgU16 firstTimeIndex, SgU16 lastTimeIndex)
+{
+    return static_cast<ISGBuffer*>(Acquire(false, &desc, firstTimeIndex, lastTimeIndex)->pResource);
+}
+
+TransientPool::Entry* TransientPool::Acquire(bool isTexture, void const* pDesc, SgU16 firstTimeIndex, SgU16 lastTimeIndex)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (m_pDevice == nullptr)
+        throw std::exception("Transient pool isn't initialized");
+
+    if (firstTimeIndex > lastTimeIndex)
+        throw std::exception("Transient resource lifetime is empty");
+
+    Entry* pFound = nullptr;
+
+    for (auto& pEntry : m_Entries)
+    {
+        Entry& entry = *pEntry;
+
+        bool const sameDesc = entry.IsTexture == isTexture && (isTexture
+            ? memcmp(&entry.TextureDesc, pDesc, sizeof(SG_TEXTURE_DESC)) == 0
+            : memcmp(&entry.BufferDesc, pDesc, sizeof(SG_BUFFER_DESC)) == 0);
+
+        if (!sameDesc)
+            continue;
+
+        bool const overlaps = std::any_of(entry.Lifetimes.begin(), entry.Lifetimes.end(), [&](Lifetime const& lifetime)
+        {
+            return lifetime.First <= lastTimeIndex && firstTimeIndex <= lifetime.Last;
+        });
+
+        if (!overlaps)
+        {
+            pFound = &entry;
+            break;
+        }
+    }
+
+    if (pFound == nullptr)
+    {
+        std::unique_ptr<Entry> pEntry(new Entry());
+        pEntry->IsTexture = isTexture;
+
+        if (isTexture)
+        {
+            memcpy(&pEntry->TextureDesc, pDesc, sizeof(SG_TEXTURE_DESC));
+            pEntry->SizeBytes = GetTextureSize(pEntry->TextureDesc);
+
+            ISGTexture* pTexture = SG_NULL;
+            if (m_pDevice->CreateTexture(&pEntry->TextureDesc, &pTexture) != SG_OK)
+                throw std::exception("Failed to create transient texture");
+
+            pEntry->pResource = pTexture;
+        }
+        else
+        {
+            memcpy(&pEntry->BufferDesc, pDesc, sizeof(SG_BUFFER_DESC));
+            pEntry->SizeBytes = pEntry->BufferDesc.Size;
+
+            ISGBuffer* pBuffer = SG_NULL;
+            if (m_pDevice->CreateBuffer(&pEntry->BufferDesc, &pBuffer) != SG_OK)
+                throw std::exception("Failed to create transient buffer");
+
+            pEntry->pResource = pBuffer;
+        }
+
+        m_Stats.Created++;
+        m_Stats.PooledResources++;
+        m_Stats.PooledBytes += pEntry->SizeBytes;
+
+        pFound = pEntry.get();
+        m_Entries.push_back(std::move(pEntry));
+    }
+
+    if (pFound->Lifetimes.empty())
+    {
+        m_Stats.UsedResources++;
+        m_Stats.UsedBytes += pFound->SizeBytes;
+    }
+
+    m_Stats.Requests++;
+    m_Stats.RequestedBytes += pFound->SizeBytes;
+
+    pFound->LastFrame = m_FrameNumber;
+    pFound->Lifetimes.push_back({ firstTimeIndex, lastTimeIndex });
+    return pFound;
+}
+
+TransientPool::Entry* TransientPool::FindEntry(ISGResource* pResource)
+{
+    for (auto& pEntry : m_Entries)
+    {
+        if (pEntry->pResource == pResource)
+            return pEntry.get();
+    }
+
+    throw std::exception("Resource isn't owned by the transient pool");
+}
+
+ISGObject* TransientPool::GetView(ISGResource* pResource, ViewType type, void const* pDesc, size_t descSize)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    Entry* pEntry = FindEntry(pResource);
+
+    for (View const& view : pEntry->Views)
+    {
+        if (view.Type == type && memcmp(view.Desc.data(), pDesc, descSize) == 0)
+            return view.pView;
+    }
+
+    SG_RESULT result = SG_ERROR_INVALID_ARG;
+    ISGObject* pView = SG_NULL;
+
+    switch (type)
+    {
+    case ViewType::ShaderResource:
+    {
+        ISGShaderResourceView* pSRV = SG_NULL;
+        result = m_pDevice->CreateShaderResourceView(pResource, static_cast<SG_SHADER_RESOURCE_VIEW_DESC const*>(pDesc), &pSRV);
+        pView = pSRV;
+        break;
+    }
+    case ViewType::UnorderedAccess:
+    {
+        ISGUnorderedAccessView* pUAV = SG_NULL;
+        result = m_pDevice->CreateUnorderedAccessView(pResource, static_cast<SG_UNORDERED_ACCESS_VIEW_DESC const*>(pDesc), &pUAV);
+        pView = pUAV;
+        break;
+    }
+    case ViewType::RenderTarget:
+    {
+        ISGRenderTargetView* pRTV = SG_NULL;
+        result = m_pDevice->CreateRenderTargetView(pResource, static_cast<SG_RENDER_TARGET_VIEW_DESC const*>(pDesc), &pRTV);
+        pView = pRTV;
+        break;
+    }
+    case ViewType::DepthStencil:
+    {
+        ISGDepthStencilView* pDSV = SG_NULL;
+        result = m_pDevice->CreateDepthStencilView(pResource, static_cast<SG_DEPTH_STENCIL_VIEW_DESC const*>(pDesc), &pDSV);
+        pView = pDSV;
+        break;
+    }
+    }
+
+    if (result != SG_OK)
+        throw std::exception("Failed to create transient resource view");
+
+    U8 const* pDescBytes = static_cast<U8 const*>(pDesc);
+    pEntry->Views.push_back({ type, std::vector<U8>(pDescBytes, pDescBytes + descSize), pView });
+    return pView;
+}
+
+ISGShaderResourceView* TransientPool::GetShaderResourceView(ISGResource* pResource, SG_SHADER_RESOURCE_VIEW_DESC const& desc)
+{
+    return static_cast<ISGShaderResourceView*>(GetView(pResource, ViewType::ShaderResource, &desc, sizeof(desc)));
+}
+
+ISGUnorderedAccessView* TransientPool::GetUnorderedAccessView(ISGResource* pResource, SG_UNORDERED_ACCESS_VIEW_DESC const& desc)
+{
+    return static_cast<ISGUnorderedAccessView*>(GetView(pResource, ViewType::UnorderedAccess, &desc, sizeof(desc)));
+}
+
+ISGRenderTargetView* TransientPool::GetRenderTargetView(ISGTexture* pTexture, SG_RENDER_TARGET_VIEW_DESC const& desc)
+{
+    return static_cast<ISGRenderTargetView*>(GetView(pTexture, ViewType::RenderTarget, &desc, sizeof(desc)));
+}
+
+ISGDepthStencilView* TransientPool::GetDepthStencilView(ISGTexture* pTexture, SG_DEPTH_STENCIL_VIEW_DESC const& desc)
+{
+    return static_cast<ISGDepthStencilView*>(GetView(pTexture, ViewType::DepthStencil, &desc, sizeof(desc)));
+}
+
+TransientPoolStats TransientPool::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
+
+void TransientPool::ReleaseEntry(Entry& entry)
+{
+    for (View& view : entry.Views)
+        view.pView->Release();
+
+    entry.Views.clear();
+    SG_RELEASE(entry.pResource);
+}
+
+U64 TransientPool::GetTextureSize(SG_TEXTURE_DESC const& desc)
+{
+    bool const is3D = desc.Dimension == SG_TEXTURE_DIMENSION_3D;
+    U32 const mipLevels = (std::max)(desc.MipLevels, 1u);
+    U32 const arraySize = is3D ? 1 : (std::max)(desc.DepthOrArraySize, 1u);
+    U64 texels = 0;
+
+    for (U32 mip = 0; mip < mipLevels; mip++)
+    {
+        U64 const width = (std::max)(desc.Width >> mip, 1u);
+        U64 const height = (std::max)(desc.Height >> mip, 1u);
+        U64 const depth = is3D ? (std::max)(desc.DepthOrArraySize >> mip, 1u) : 1;
+        texels += width * height * depth;
+    }
+
+    // An estimate, the driver may pad rows and align the allocation
+    return texels * arraySize * (std::max)(U32(desc.SampleCount), 1u) * SgGetFormatSizeBits(desc.Format) / 8;
+}
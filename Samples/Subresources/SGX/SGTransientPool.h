@@ -0,0 +1,137 @@
+//*********************************************************
+//
+// Copyright (c) 2024 Aleksei Shevchenko.
+// This code is licensed under the MIT License (MIT).
+// THIS CODE IS PROVIDED *AS IS* WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING ANY
+// IMPLIED WARRANTIES OF FITNESS FOR A PARTICULAR
+// PURPOSE, MERCHANTABILITY, OR NON-INFRINGEMENT.
+//
+//*********************************************************
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "SGHelpers.h"
+
+///-------------------------------------------------------------------------------------------------
+/// Transient resources
+///
+/// Intermediate render targets and buffers of a frame (post-processing chains, depth buffers,
+/// scratch buffers) are requested for the range of time indices they are used in. Requests with
+/// equal descs whose ranges don't overlap share one resource, so a chain of passes ping-pongs
+/// between a couple of textures instead of keeping one per pass:
+///
+///     ISGTexture* pBloom = pool.AcquireTexture(halfResDesc, 3, 4);     // Written at 3, read at 4
+///     ISGTexture* pBlur = pool.AcquireTexture(halfResDesc, 5, 6);      // Gets the same texture
+///
+/// Ranges are inclusive and compared across all queues, since lists of different queues with the
+/// same time index may run concurrently. SGLib transitions a shared resource by itself when it's
+/// bound for another access, but its content is undefined for every request: the first pass must
+/// clear or fully overwrite it.
+///
+/// Views are created once for a pooled resource and released with it. Resources which aren't
+/// requested for several frames are released by BeginFrame.
+///-------------------------------------------------------------------------------------------------
+
+struct TransientPoolStats
+{
+    // Requests of the current frame and the sizes of the resources they asked for
+    U32     Requests;
+    U64     RequestedBytes;
+
+    // Resources used by the current frame, requested bytes above these are saved by sharing
+    U32     UsedResources;
+    U64     UsedBytes;
+
+    // Resources of the pool, including the ones kept for later frames
+    U32     PooledResources;
+    U64     PooledBytes;
+
+    // Resources created by the current frame and released by its BeginFrame
+    U32     Created;
+    U32     Released;
+};
+
+class TransientPool
+{
+public:
+    static const U32 DefaultRetireFrames = 4;
+
+    TransientPool();
+    ~TransientPool();
+
+    TransientPool(TransientPool const&) = delete;
+    TransientPool& operator=(TransientPool const&) = delete;
+
+    // Resources not requested for retireFrames frames are released
+    void        Init(ISGDevice* pDevice, U32 retireFrames = DefaultRetireFrames);
+    void        Destroy();
+
+    // Starts the requests of a new frame, must follow ISGExecutionContext::BeginFrame
+    void        BeginFrame();
+
+    // Returns a resource which isn't requested by other passes of the frame within
+    // [firstTimeIndex; lastTimeIndex]. Descs are compared bytewise, they must be zero-initialized
+    // as FastTextureDesc and FastBufferDesc do. The pool keeps the reference. Thread-safe.
+    ISGTexture* AcquireTexture(SG_TEXTURE_DESC const& desc, SgU16 firstTimeIndex, SgU16 lastTimeIndex);
+    ISGBuffer*  AcquireBuffer(SG_BUFFER_DESC const& desc, SgU16 firstTimeIndex, SgU16 lastTimeIndex);
+
+    // Views of acquired resources, created by the first call with the desc. Thread-safe.
+    ISGShaderResourceView*  GetShaderResourceView(ISGResource* pResource, SG_SHADER_RESOURCE_VIEW_DESC const& desc);
+    ISGUnorderedAccessView* GetUnorderedAccessView(ISGResource* pResource, SG_UNORDERED_ACCESS_VIEW_DESC const& desc);
+    ISGRenderTargetView*    GetRenderTargetView(ISGTexture* pTexture, SG_RENDER_TARGET_VIEW_DESC const& desc);
+    ISGDepthStencilView*    GetDepthStencilView(ISGTexture* pTexture, SG_DEPTH_STENCIL_VIEW_DESC const& desc);
+
+    TransientPoolStats GetStats() const;
+
+private:
+    enum class ViewType : U32
+    {
+        ShaderResource,
+        UnorderedAccess,
+        RenderTarget,
+        DepthStencil,
+    };
+
+    struct View
+    {
+        ViewType                    Type;
+        std::vector<U8>             Desc;
+        ISGObject*                  pView;
+    };
+
+    struct Lifetime
+    {
+        SgU16   First;
+        SgU16   Last;
+    };
+
+    struct Entry
+    {
+        bool                    IsTexture;
+        SG_TEXTURE_DESC         TextureDesc;
+        SG_BUFFER_DESC          BufferDesc;
+        ISGResource*            pResource;
+        U64                     SizeBytes;
+        U64                     LastFrame;
+        std::vector<Lifetime>   Lifetimes;      // Of the current frame
+        std::vector<View>       Views;
+    };
+
+    Entry*      Acquire(bool isTexture, void const* pDesc, SgU16 firstTimeIndex, SgU16 lastTimeIndex);
+    Entry*      FindEntry(ISGResource* pResource);
+    ISGObject*  GetView(ISGResource* pResource, ViewType type, void const* pDesc, size_t descSize);
+    void        ReleaseEntry(Entry& entry);
+
+    static U64  GetTextureSize(SG_TEXTURE_DESC const& desc);
+
+    mutable std::mutex                  m_Mutex;
+    ISGDevice*                          m_pDevice;
+    U32                                 m_RetireFrames;
+    U64                                 m_FrameNumber;
+    std::vector<std::unique_ptr<Entry>> m_Entries;
+    TransientPoolStats                  m_Stats;
+};